@@ -2,13 +2,19 @@
 #include "global.hpp"
 #include "util.hpp"
 #include "hash.hpp"
+#include "chunked_seq.hpp"
+#include "reduce.hpp"
 
 namespace cleo
 {
 
+// Array:
+//   [hash | elem0 elem1 ...]
+//   hash: memoized hash of the elements or 0 if not computed yet
+
 Force create_array(const Value *elems, std::uint32_t size)
 {
-    return create_object(*type::Array, elems, size);
+    return create_object(*type::Array, nullptr, 1, elems, size);
 }
 
 Force array_seq(Value v)
@@ -32,6 +38,25 @@ Force get_array_seq_next(Value s)
     return create_static_object(*type::ArraySeq, v, i);
 }
 
+Force get_array_seq_chunk_first(Value s)
+{
+    auto v = get_static_object_element(s, 0);
+    std::uint32_t i = get_static_object_int(s, 1);
+    auto size = get_array_size(v);
+    if (i == 0 && size <= CHUNK_SIZE)
+        return v;
+    return create_array(get_array_elems(v) + i, std::min(size - i, CHUNK_SIZE));
+}
+
+Force get_array_seq_chunk_next(Value s)
+{
+    auto v = get_static_object_element(s, 0);
+    auto i = get_static_object_int(s, 1) + CHUNK_SIZE;
+    if (get_array_size(v) <= i)
+        return nil;
+    return create_static_object(*type::ArraySeq, v, i);
+}
+
 Force array_conj(Value v, Value e)
 {
     auto size = get_array_size(v);
@@ -62,11 +87,28 @@ Force array_pop(Value v)
 
 Force array_hash(Value v)
 {
-    std::uint64_t h = 0;
+    std::uint32_t h = get_array_hash(v);
+    if (h != 0)
+        return create_int64(h);
     auto size = get_array_size(v);
     for (Int64 i = 0; i < size; ++i)
-        h = h * 31 + hash_value(get_array_elem(v, i));
-    return create_int64(h * 31 + size);
+        h = h * 31 + std::uint32_t(hash_value(get_array_elem(v, i)));
+    h = h * 31 + size;
+    set_dynamic_object_int(v, 0, h);
+    return create_int64(h);
+}
+
+Force array_reduce(Value v, Value f, Value init)
+{
+    Root acc{init};
+    auto size = get_array_size(v);
+    for (decltype(size) i = 0; i < size; ++i)
+    {
+        acc = reduce_step(f, *acc, get_array_elem_unchecked(v, i));
+        if (is_reduced(*acc))
+            return reduced_deref(*acc);
+    }
+    return *acc;
 }
 
 Force transient_array(Value v)
@@ -129,6 +171,7 @@ Force transient_array_assoc_elem(Value v, std::uint32_t index, Value e)
 Force transient_array_persistent(Value v)
 {
     set_dynamic_object_size(v, get_transient_array_size(v));
+    set_dynamic_object_int(v, 0, 0);
     set_object_type(v, *type::Array);
     return v;
 }
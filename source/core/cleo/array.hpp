@@ -8,12 +8,17 @@ Force create_array(const Value *elems, std::uint32_t size);
 inline std::uint32_t get_array_size(Value v) { return get_dynamic_object_size(v); }
 inline Value get_array_elem(Value v, std::uint32_t index) { return index < get_dynamic_object_size(v) ? get_dynamic_object_element(v, index) : nil; }
 inline Value get_array_elem_unchecked(Value v, std::uint32_t index) { return get_dynamic_object_element(v, index); }
+inline const Value *get_array_elems(Value v) { return get_dynamic_object_elements(v); }
+inline std::uint32_t get_array_hash(Value v) { return get_dynamic_object_int(v, 0); }
 Force array_seq(Value v);
 Value get_array_seq_first(Value s);
 Force get_array_seq_next(Value s);
+Force get_array_seq_chunk_first(Value s);
+Force get_array_seq_chunk_next(Value s);
 Force array_conj(Value v, Value e);
 Force array_pop(Value v);
 Force array_hash(Value v);
+Force array_reduce(Value v, Value f, Value init);
 
 Force transient_array(Value other);
 inline Int64 get_transient_array_size(Value v) { return get_dynamic_object_int(v, 0); }
@@ -2,13 +2,34 @@
 #include "global.hpp"
 #include "equality.hpp"
 #include "array.hpp"
+#include "hash.hpp"
+#include "reduce.hpp"
+#include <array>
 
 namespace cleo
 {
 
+// ArrayMap:
+//   [hash | key0 value0 key1 value1 ...]
+//   hash: memoized hash of the entries or 0 if not computed yet
+
 Force create_array_map()
 {
-    return create_object(*type::ArrayMap, nullptr, 0);
+    return create_object(*type::ArrayMap, nullptr, 1, nullptr, 0);
+}
+
+Force create_array_map(const Value *kvs, std::uint32_t size)
+{
+    return create_object(*type::ArrayMap, nullptr, 1, kvs, size);
+}
+
+bool has_duplicate_keys(const Value *kvs, std::uint32_t size)
+{
+    for (std::uint32_t i = 2; i < size; i += 2)
+        for (std::uint32_t j = 0; j < i; j += 2)
+            if (are_equal(kvs[i], kvs[j]))
+                return true;
+    return false;
 }
 
 std::uint32_t get_array_map_size(Value m)
@@ -65,7 +86,7 @@ Force array_map_assoc(Value m, Value k, Value v)
         kvs.push_back(k);
         kvs.push_back(v);
     }
-    return create_object(*type::ArrayMap, kvs.data(), kvs.size());
+    return create_object(*type::ArrayMap, nullptr, 1, kvs.data(), kvs.size());
 }
 
 Force array_map_dissoc(Value m, Value k)
@@ -84,7 +105,7 @@ Force array_map_dissoc(Value m, Value k)
             kvs.push_back(get_dynamic_object_element(m, i * 2 + 1));
         }
     }
-    return create_object(*type::ArrayMap, kvs.data(), kvs.size());
+    return create_object(*type::ArrayMap, nullptr, 1, kvs.data(), kvs.size());
 }
 
 Force array_map_merge(Value l, Value r)
@@ -107,7 +128,7 @@ Force array_map_merge(Value l, Value r)
         kvs.push_back(key);
         kvs.push_back(get_array_map_val(l, i));
     }
-    return create_object(*type::ArrayMap, kvs.data(), kvs.size());
+    return create_object(*type::ArrayMap, nullptr, 1, kvs.data(), kvs.size());
 }
 
 Value array_map_contains(Value m, Value k)
@@ -121,6 +142,39 @@ Value array_map_contains(Value m, Value k)
     return nil;
 }
 
+std::uint32_t get_array_map_hash(Value m)
+{
+    return get_dynamic_object_int(m, 0);
+}
+
+Force array_map_hash(Value m)
+{
+    std::uint32_t h = get_array_map_hash(m);
+    if (h != 0)
+        return create_int64(h);
+    auto size = get_array_map_size(m);
+    for (decltype(size) i = 0; i != size; ++i)
+        h += std::uint32_t(hash_value(get_array_map_key(m, i))) * 31 + std::uint32_t(hash_value(get_array_map_val(m, i)));
+    set_dynamic_object_int(m, 0, h);
+    return create_int64(h);
+}
+
+Force array_map_reduce(Value m, Value f, Value init)
+{
+    Root acc{init};
+    Root entry;
+    auto size = get_array_map_size(m);
+    for (decltype(size) i = 0; i != size; ++i)
+    {
+        std::array<Value, 2> kv{{get_array_map_key(m, i), get_array_map_val(m, i)}};
+        entry = create_array(kv.data(), kv.size());
+        acc = reduce_step(f, *acc, *entry);
+        if (is_reduced(*acc))
+            return reduced_deref(*acc);
+    }
+    return *acc;
+}
+
 Force array_map_seq(Value m)
 {
     if (get_array_map_size(m) == 0)
@@ -4,7 +4,12 @@
 namespace cleo
 {
 
+const std::uint32_t MAX_ARRAY_MAP_SIZE = 16;
+
 Force create_array_map();
+// kvs holds size / 2 key-value pairs with distinct keys
+Force create_array_map(const Value *kvs, std::uint32_t size);
+bool has_duplicate_keys(const Value *kvs, std::uint32_t size);
 std::uint32_t get_array_map_size(Value m);
 Value get_array_map_key(Value m, std::uint32_t index);
 Value get_array_map_val(Value m, std::uint32_t index);
@@ -14,6 +19,9 @@ Force array_map_assoc(Value m, Value k, Value v);
 Force array_map_dissoc(Value m, Value k);
 Force array_map_merge(Value l, Value r);
 Value array_map_contains(Value m, Value k);
+std::uint32_t get_array_map_hash(Value m);
+Force array_map_hash(Value m);
+Force array_map_reduce(Value m, Value f, Value init);
 Force array_map_seq(Value m);
 Value get_array_map_seq_first(Value s);
 Force get_array_map_seq_next(Value s);
@@ -1,12 +1,18 @@
 #include "array_set.hpp"
 #include "global.hpp"
+#include "hash.hpp"
+#include "reduce.hpp"
 
 namespace cleo
 {
 
+// ArraySet:
+//   [hash | elem0 elem1 ...]
+//   hash: memoized hash of the elements or 0 if not computed yet
+
 Force create_array_set()
 {
-    return create_object0(*type::ArraySet);
+    return create_object(*type::ArraySet, nullptr, 1, nullptr, 0);
 }
 
 std::uint32_t get_array_set_size(Value s)
@@ -39,7 +45,7 @@ Force array_set_conj(Value s, Value k)
     for (decltype(size) i = 0; i < size; ++i)
         new_elems.push_back(get_array_set_elem(s, i));
     new_elems.push_back(k);
-    return create_object(*type::ArraySet, new_elems.data(), new_elems.size());
+    return create_object(*type::ArraySet, nullptr, 1, new_elems.data(), new_elems.size());
 }
 
 Value array_set_contains(Value s, Value k)
@@ -53,6 +59,36 @@ Value array_set_contains(Value s, Value k)
     return nil;
 }
 
+std::uint32_t get_array_set_hash(Value s)
+{
+    return get_dynamic_object_int(s, 0);
+}
+
+Force array_set_hash(Value s)
+{
+    std::uint32_t h = get_array_set_hash(s);
+    if (h != 0)
+        return create_int64(h);
+    auto size = get_array_set_size(s);
+    for (decltype(size) i = 0; i != size; ++i)
+        h += std::uint32_t(hash_value(get_array_set_elem(s, i)));
+    set_dynamic_object_int(s, 0, h);
+    return create_int64(h);
+}
+
+Force array_set_reduce(Value s, Value f, Value init)
+{
+    Root acc{init};
+    auto size = get_array_set_size(s);
+    for (decltype(size) i = 0; i != size; ++i)
+    {
+        acc = reduce_step(f, *acc, get_array_set_elem(s, i));
+        if (is_reduced(*acc))
+            return reduced_deref(*acc);
+    }
+    return *acc;
+}
+
 Force array_set_seq(Value s)
 {
     if (get_array_set_size(s) == 0)
@@ -11,6 +11,9 @@ Value array_set_get(Value s, Value k);
 Value array_set_get(Value s, Value k, Value def_v);
 Force array_set_conj(Value s, Value k);
 Value array_set_contains(Value s, Value k);
+std::uint32_t get_array_set_hash(Value s);
+Force array_set_hash(Value s);
+Force array_set_reduce(Value s, Value f, Value init);
 Force array_set_seq(Value s);
 Value get_array_set_seq_first(Value s);
 Force get_array_set_seq_next(Value s);
@@ -2,7 +2,11 @@
 #include "global.hpp"
 #include "util.hpp"
 #include "hash.hpp"
+#include "chunked_seq.hpp"
+#include "array.hpp"
+#include "reduce.hpp"
 #include <cstring>
+#include <array>
 
 namespace cleo
 {
@@ -32,6 +36,15 @@ Force create_byte_array(const Value *elems, Int64 size)
     return *a;
 }
 
+Force create_byte_array_from_bytes(const char *bytes, Int64 size)
+{
+    Root a{create_object(*type::ByteArray, nullptr, 1 + int_size(size), nullptr, 0)};
+    set_dynamic_object_int(*a, 0, size);
+    if (size > 0)
+        std::memcpy(get_dynamic_object_mut_int_ptr(*a, 1), bytes, size);
+    return *a;
+}
+
 Force byte_array_seq(Value v)
 {
     if (get_byte_array_size(v) == 0)
@@ -53,6 +66,26 @@ Force get_byte_array_seq_next(Value s)
     return create_static_object(*type::ByteArraySeq, v, i);
 }
 
+Force get_byte_array_seq_chunk_first(Value s)
+{
+    auto v = get_static_object_element(s, 0);
+    auto i = get_static_object_int(s, 1);
+    auto size = std::min(get_byte_array_size(v) - i, Int64(CHUNK_SIZE));
+    std::array<Value, CHUNK_SIZE> elems;
+    for (Int64 j = 0; j < size; ++j)
+        elems[j] = get_byte_array_elem_unchecked(v, i + j);
+    return create_array(elems.data(), size);
+}
+
+Force get_byte_array_seq_chunk_next(Value s)
+{
+    auto v = get_static_object_element(s, 0);
+    auto i = get_static_object_int(s, 1) + CHUNK_SIZE;
+    if (get_byte_array_size(v) <= i)
+        return nil;
+    return create_static_object(*type::ByteArraySeq, v, i);
+}
+
 Force byte_array_conj(Value v, Value e)
 {
     auto size = get_byte_array_size(v);
@@ -89,6 +122,19 @@ Force byte_array_hash(Value v)
     return create_int64(h * 31 + size);
 }
 
+Force byte_array_reduce(Value v, Value f, Value init)
+{
+    Root acc{init};
+    auto size = get_byte_array_size(v);
+    for (Int64 i = 0; i < size; ++i)
+    {
+        acc = reduce_step(f, *acc, get_byte_array_elem_unchecked(v, i));
+        if (is_reduced(*acc))
+            return reduced_deref(*acc);
+    }
+    return *acc;
+}
+
 Force transient_byte_array(Value v)
 {
     Int64 size = get_byte_array_size(v);
@@ -5,15 +5,20 @@ namespace cleo
 {
 
 Force create_byte_array(const Value *elems, Int64 size);
+Force create_byte_array_from_bytes(const char *bytes, Int64 size);
 inline Int64 get_byte_array_size(Value v) { return get_dynamic_object_int(v, 0); }
+inline const char *get_byte_array_ptr(Value v) { return static_cast<const char *>(get_dynamic_object_int_ptr(v, 1)); }
 inline Value get_byte_array_elem_unchecked(Value v, Int64 index) { return create_int48(get_dynamic_object_int_byte(v, index + sizeof(Int64))); }
 inline Value get_byte_array_elem(Value v, Int64 index) { return index >= 0 && index < get_byte_array_size(v) ? get_byte_array_elem_unchecked(v, index) : nil; }
 Force byte_array_seq(Value v);
 Value get_byte_array_seq_first(Value s);
 Force get_byte_array_seq_next(Value s);
+Force get_byte_array_seq_chunk_first(Value s);
+Force get_byte_array_seq_chunk_next(Value s);
 Force byte_array_conj(Value v, Value e);
 Force byte_array_pop(Value v);
 Force byte_array_hash(Value v);
+Force byte_array_reduce(Value v, Value f, Value init);
 
 Force transient_byte_array(Value other);
 inline Int64 get_transient_byte_array_size(Value v) { return get_dynamic_object_int(v, 0); }
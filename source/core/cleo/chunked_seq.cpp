@@ -0,0 +1,44 @@
+#include "chunked_seq.hpp"
+#include "global.hpp"
+#include "array.hpp"
+#include "multimethod.hpp"
+
+namespace cleo
+{
+
+Force create_chunked_cons(Value chunk, Value more)
+{
+    if (get_array_size(chunk) == 0)
+        return more;
+    return create_static_object(*type::ChunkedCons, chunk, more, Int64(0));
+}
+
+Value chunked_cons_first(Value c)
+{
+    return get_array_elem_unchecked(get_static_object_element(c, 0), get_static_object_int(c, 2));
+}
+
+Force chunked_cons_next(Value c)
+{
+    auto chunk = get_static_object_element(c, 0);
+    auto offset = get_static_object_int(c, 2) + 1;
+    if (offset < get_array_size(chunk))
+        return create_static_object(*type::ChunkedCons, chunk, get_static_object_element(c, 1), offset);
+    return call_multimethod1(*rt::seq, get_static_object_element(c, 1));
+}
+
+Force chunked_cons_chunk_first(Value c)
+{
+    auto chunk = get_static_object_element(c, 0);
+    auto offset = get_static_object_int(c, 2);
+    if (offset == 0)
+        return chunk;
+    return create_array(get_array_elems(chunk) + offset, get_array_size(chunk) - offset);
+}
+
+Force chunked_cons_chunk_next(Value c)
+{
+    return call_multimethod1(*rt::seq, get_static_object_element(c, 1));
+}
+
+}
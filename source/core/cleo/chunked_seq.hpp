@@ -0,0 +1,15 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+constexpr std::uint32_t CHUNK_SIZE = 32;
+
+Force create_chunked_cons(Value chunk, Value more);
+Value chunked_cons_first(Value c);
+Force chunked_cons_next(Value c);
+Force chunked_cons_chunk_first(Value c);
+Force chunked_cons_chunk_next(Value c);
+
+}
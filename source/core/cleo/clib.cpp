@@ -3,6 +3,7 @@
 #include "util.hpp"
 #include "error.hpp"
 #include "array.hpp"
+#include "vector.hpp"
 #include <cstring>
 #include <sys/mman.h>
 #include <dlfcn.h>
@@ -24,25 +25,6 @@ void enable_execution(char *code, std::size_t size)
     mprotect(code, size, PROT_READ | PROT_EXEC);
 }
 
-#ifndef __ARM_ARCH
-
-struct rel_addr
-{
-    void *abs_addr;
-    template <typename T>
-    rel_addr(T *p) : abs_addr(reinterpret_cast<void *>(p)) {}
-};
-
-void put1(char *& code, rel_addr val)
-{
-    auto rel_addr = reinterpret_cast<std::uintptr_t>(val.abs_addr) - (reinterpret_cast<std::uintptr_t>(code) + 4);
-    assert((rel_addr >> 32) == 0xffffffff || (rel_addr >> 32) == 0);
-    std::memcpy(code, &rel_addr, 4);
-    code += 4;
-}
-
-#endif // !__ARM_ARCH
-
 struct abs_addr
 {
     std::uintptr_t addr;
@@ -205,7 +187,8 @@ void generate_code(char *p, void *cfn, Value param_types)
             put(p, 0xff, 0x70, i * 8);                  // push   QWORD PTR [rax+i*8]
     }
     put(p,
-        0xe8, rel_addr(cfn)                             // call   cfn
+        0x49, 0xbb, abs_addr(cfn),                      // movabs r11,cfn
+        0x41, 0xff, 0xd3                                // call   r11
     );
     if (param_count > 6)
     {
@@ -217,15 +200,18 @@ void generate_code(char *p, void *cfn, Value param_types)
     put(p,
         0x48, 0x89, 0xc7,                               // mov    rdi,rax
         0x5d,                                           // pop    rbp
-        0xe9, rel_addr(create_int64)                    // jmp    create_int64
+        0x49, 0xbb, abs_addr(create_int64),             // movabs r11,create_int64
+        0x41, 0xff, 0xe3                                // jmp    r11
     );
     __builtin___clear_cache(code, p);
 }
 #endif
 
-Force create_c_fn(void *cfn, Value name, Value ret_type, Value param_types)
+Force create_c_fn(void *cfn, Value name, Value ret_type, Value param_types_)
 {
     check_type("fn name", name, *type::Symbol);
+    Root param_types_root{vector_to_array(param_types_)};
+    auto param_types = *param_types_root;
     check_type("parameter types", param_types, *type::Array);
     auto param_count = get_array_size(param_types);
     if (param_count > MAX_ARGS)
@@ -246,7 +232,7 @@ Force create_c_fn(void *cfn, Value name, Value ret_type, Value param_types)
     return create_static_object(*type::CFunction, caddr, name, param_types);
 }
 
-std::uint64_t get_arg_bit_value(Value param_types, std::uint8_t i, Value arg)
+std::uint64_t get_arg_bit_value(Value param_types, std::uint8_t i, Value arg, std::string& str)
 {
     auto arg_tag = get_value_tag(arg);
     auto expected_type = get_array_elem(param_types, i);
@@ -260,7 +246,10 @@ std::uint64_t get_arg_bit_value(Value param_types, std::uint8_t i, Value arg)
     {
         if (arg_tag != tag::UTF8STRING)
             throw_arg_type_error(arg, i);
-        return reinterpret_cast<std::uint64_t>(get_string_ptr(arg));
+        if (!is_short_string(arg) && !is_string_slice(arg))
+            return reinterpret_cast<std::uint64_t>(get_string_ptr(arg).data());
+        str.assign(get_string_ptr(arg), get_string_size(arg));
+        return reinterpret_cast<std::uint64_t>(str.c_str());
     }
 }
 
@@ -273,8 +262,9 @@ Force call_c_function(const Value *args, std::uint8_t num_args)
     if ((std::uint32_t(num_args) - 1) != get_array_size(param_types))
         throw_arity_error(name, num_args - 1);
     std::uint64_t raw_args[MAX_ARGS];
+    std::string strings[MAX_ARGS];
     for (decltype(num_args) i = 1; i < num_args; ++i)
-        raw_args[i - 1] = get_arg_bit_value(param_types, i - 1, args[i]);
+        raw_args[i - 1] = get_arg_bit_value(param_types, i - 1, args[i], strings[i - 1]);
     return Value{reinterpret_cast<CFunction>(addr)(raw_args, num_args - 1)};
 }
 
@@ -2,6 +2,7 @@
 #include "bytecode_fn.hpp"
 #include "global.hpp"
 #include "array.hpp"
+#include "vector.hpp"
 #include "byte_array.hpp"
 #include "util.hpp"
 #include "namespace.hpp"
@@ -379,6 +380,7 @@ Force check_let_bindings(Value tag, Value form)
     check_compiletime_arity(tag, form, 2, seq_count(form) - 1);
     Root bindings{seq_next(form)};
     bindings = seq_first(*bindings);
+    bindings = vector_to_array(*bindings);
     if (!get_value_type(*bindings).is(*type::Array))
         throw_compilation_error("Bad binding form, expected vector");
     if (get_array_size(*bindings) % 2)
@@ -464,6 +466,11 @@ bool is_const(Value val)
         auto type = get_value_type(val);
         if (type.is(*type::Array))
             return get_vector_const_prefix_len(val) == get_array_size(val);
+        if (type.is(*type::Vector))
+        {
+            Root a{vector_to_array(val)};
+            return is_const(*a);
+        }
         if (is_set(val))
         {
             Root ss{get_hash_set_const_subset(val)};
@@ -828,6 +835,11 @@ void Compiler::compile_value(Scope scope, Value val)
 
     if (vtype.is(*type::Array))
         return compile_vector(scope, val);
+    if (vtype.is(*type::Vector))
+    {
+        Root a{vector_to_array(val)};
+        return compile_vector(scope, *a);
+    }
     if (is_set(val))
         return compile_hash_set(scope, val);
     if (is_map(val))
@@ -839,6 +851,7 @@ void Compiler::compile_value(Scope scope, Value val)
 Compiler::Scope create_fn_body_scope(Value form, Value locals, Value parent_locals)
 {
     Root params{seq_first(form)};
+    params = vector_to_array(*params);
     auto recur_arity = std::uint16_t(std::abs(get_arity(*params)));
     return {parent_locals, locals, recur_arity, std::int16_t(-recur_arity)};
 }
@@ -851,6 +864,7 @@ Force compile_fn_body(Value name, Value form, Value parent_locals, Root& used_lo
         throw_compilation_error("Too many forms passed to " + to_string(FN));
     val = *val ? seq_first(*val) : nil;
     Root params{seq_first(form)};
+    params = vector_to_array(*params);
     Root locals{create_locals(name, *params)};
     auto arity = get_arity(*params);
     auto scope = create_fn_body_scope(form, *locals, parent_locals);
@@ -989,12 +1003,12 @@ Force serialize_fn(Value fn)
     for (Root s{seq(fn_bodies)}; *s; s = seq_next(*s))
     {
         body = seq_first(*s);
-        Value fn_et = map_get(*body, EXCEPTION_TABLE);
+        Root fn_et{vector_to_array(map_get(*body, EXCEPTION_TABLE))};
         std::vector<Int64> et_entries;
         std::vector<Value> et_types;
-        for (Int64 i = 0, size = get_array_size(fn_et); i < size; ++i)
+        for (Int64 i = 0, size = get_array_size(*fn_et); i < size; ++i)
         {
-            auto e = get_array_elem_unchecked(fn_et, i);
+            auto e = get_array_elem_unchecked(*fn_et, i);
             et_entries.push_back(get_int64_value(map_get(e, START_OFFSET)));
             et_entries.push_back(get_int64_value(map_get(e, END_OFFSET)));
             et_entries.push_back(get_int64_value(map_get(e, HANDLER_OFFSET)));
@@ -1011,10 +1025,12 @@ Force serialize_fn(Value fn)
             bytecode.push_back(get_int64_value(get_byte_array_elem_unchecked(fn_bytecode, i)));
         auto arity = get_int64_value(map_get(*body, ARITY));
         arity = map_get(*body, VARARG) ? -arity : arity;
+        Root consts{vector_to_array(map_get(*body, CONSTS))};
+        Root vars{vector_to_array(map_get(*body, VARS))};
         body_roots.set(bodies.size(),
                        create_bytecode_fn_body(arity,
-                                               map_get(*body, CONSTS),
-                                               map_get(*body, VARS),
+                                               *consts,
+                                               *vars,
                                                nil,
                                                *exception_table,
                                                map_contains(*body, LOCALS_SIZE) ? get_int64_value(map_get(*body, LOCALS_SIZE)) : 0,
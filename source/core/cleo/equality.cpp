@@ -5,17 +5,31 @@
 #include "global.hpp"
 #include "var.hpp"
 #include "multimethod.hpp"
+#include "util.hpp"
+#include <algorithm>
 #include <array>
 #include <cstring>
 
 namespace cleo
 {
 
+namespace
+{
+
+bool are_memoized_hashes_different(std::uint32_t left_hash, std::uint32_t right_hash)
+{
+    return left_hash != 0 && right_hash != 0 && left_hash != right_hash;
+}
+
+}
+
 Value are_arrays_equal(Value left, Value right)
 {
     auto size = get_array_size(left);
     if (size != get_array_size(right))
         return nil;
+    if (are_memoized_hashes_different(get_array_hash(left), get_array_hash(right)))
+        return nil;
     for (decltype(size) i = 0; i < size; ++i)
         if (!are_equal(get_array_elem(left, i), get_array_elem(right, i)))
             return nil;
@@ -49,6 +63,8 @@ Value are_array_sets_equal(Value left, Value right)
     auto size = get_array_set_size(left);
     if (size != get_array_set_size(right))
         return nil;
+    if (are_memoized_hashes_different(get_array_set_hash(left), get_array_set_hash(right)))
+        return nil;
 
     for (decltype(size) i = 0; i != size; ++i)
         if (!array_set_contains(right, get_array_set_elem(left, i)))
@@ -62,6 +78,8 @@ Value are_array_maps_equal(Value left, Value right)
     auto size = get_array_map_size(left);
     if (size != get_array_map_size(right))
         return nil;
+    if (are_memoized_hashes_different(get_array_map_hash(left), get_array_map_hash(right)))
+        return nil;
 
     for (decltype(size) i = 0; i != size; ++i)
     {
@@ -88,6 +106,22 @@ Value are_maps_equal(Value left, Value right)
     return TRUE;
 }
 
+Value are_sets_equal(Value left, Value right)
+{
+    Root left_count{call_multimethod1(*rt::count, left)};
+    Root right_count{call_multimethod1(*rt::count, right)};
+    if (*left_count != *right_count)
+        return nil;
+    for (Root seq{call_multimethod1(*rt::seq, left)}; *seq; seq = call_multimethod1(*rt::next, *seq))
+    {
+        Root e{call_multimethod1(*rt::first, *seq)};
+        Root found{call_multimethod2(*rt::contains, right, *e)};
+        if (!*found)
+            return nil;
+    }
+    return TRUE;
+}
+
 Value are_equal(Value left, Value right)
 {
     if (left.is(right))
@@ -126,4 +160,84 @@ Value are_equal(Value left, Value right)
     }
 }
 
+namespace
+{
+
+template <typename T>
+Int64 compare_ordered(T left, T right)
+{
+    return left < right ? -1 : right < left ? 1 : 0;
+}
+
+Int64 compare_strings(Value left, Value right)
+{
+    auto left_size = get_string_size(left);
+    auto right_size = get_string_size(right);
+    auto c = std::memcmp(get_string_ptr(left), get_string_ptr(right), std::min(left_size, right_size));
+    return c != 0 ? compare_ordered(c, 0) : compare_ordered(left_size, right_size);
+}
+
+Int64 compare_names(Value left_ns, Value left_name, Value right_ns, Value right_name)
+{
+    if (!left_ns.is(right_ns))
+    {
+        if (left_ns.is_nil())
+            return -1;
+        if (right_ns.is_nil())
+            return 1;
+        if (auto c = compare_strings(left_ns, right_ns))
+            return c;
+    }
+    return compare_strings(left_name, right_name);
+}
+
+bool is_number(Tag tag)
+{
+    return tag == tag::INT64 || tag == tag::FLOAT64;
+}
+
+Float64 get_number_value(Value val)
+{
+    return get_value_tag(val) == tag::INT64 ? Float64(get_int64_value(val)) : get_float64_value(val);
+}
+
+}
+
+Int64 compare_values(Value left, Value right)
+{
+    if (left.is(right))
+        return 0;
+    if (left.is_nil())
+        return -1;
+    if (right.is_nil())
+        return 1;
+
+    auto left_tag = get_value_tag(left);
+    auto right_tag = get_value_tag(right);
+
+    if (left_tag == tag::INT64 && right_tag == tag::INT64)
+        return compare_ordered(get_int64_value(left), get_int64_value(right));
+    if (is_number(left_tag) && is_number(right_tag))
+        return compare_ordered(get_number_value(left), get_number_value(right));
+
+    if (left_tag == right_tag)
+    {
+        switch (left_tag)
+        {
+            case tag::UTF8STRING:
+                return compare_strings(left, right);
+            case tag::UCHAR:
+                return compare_ordered(get_uchar_value(left), get_uchar_value(right));
+            case tag::KEYWORD:
+                return compare_names(get_keyword_namespace(left), get_keyword_name(left), get_keyword_namespace(right), get_keyword_name(right));
+            case tag::SYMBOL:
+                return compare_names(get_symbol_namespace(left), get_symbol_name(left), get_symbol_namespace(right), get_symbol_name(right));
+            default:
+                break;
+        }
+    }
+
+    throw_illegal_argument("Cannot compare " + to_string(left) + " and " + to_string(right));
+}
+
 }
@@ -8,7 +8,9 @@ Value are_seqables_equal(Value left, Value right);
 Value are_array_sets_equal(Value left, Value right);
 Value are_array_maps_equal(Value left, Value right);
 Value are_maps_equal(Value left, Value right);
+Value are_sets_equal(Value left, Value right);
 Value are_equal(Value left, Value right);
+Int64 compare_values(Value left, Value right);
 
 inline bool operator==(Value left, Value right)
 {
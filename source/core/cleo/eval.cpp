@@ -5,6 +5,7 @@
 #include "global.hpp"
 #include "error.hpp"
 #include "array.hpp"
+#include "vector.hpp"
 #include "namespace.hpp"
 #include "reader.hpp"
 #include "util.hpp"
@@ -12,7 +13,10 @@
 #include "compile.hpp"
 #include "cons.hpp"
 #include "profiler.hpp"
+#include "stack_seq.hpp"
 #include <vector>
+#include <limits>
+#include <algorithm>
 
 namespace cleo
 {
@@ -44,15 +48,21 @@ Force call_bytecode_fn(const Value *elems, std::uint32_t elems_size, std::uint8_
     StackGuard guard;
     if (arity < 0)
     {
-        auto rest = ~arity + 1;
-        stack_push(elems, elems + rest);
+        std::uint32_t rest = ~arity + 1;
         if (rest < elems_size)
         {
-            stack_push(create_array(elems + rest, elems_size - rest));
-            stack.back() = array_seq(stack.back()).value();
+            // [rest... cache fn fixed... seq]
+            std::uint32_t index = stack.size();
+            stack_push(elems + rest, elems + elems_size);
+            stack_push(create_int48(index));
+            stack_push(elems, elems + rest);
+            stack_push(create_stack_seq(index, elems_size - rest));
         }
         else
+        {
+            stack_push(elems, elems + rest);
             stack_push(nil);
+        }
     }
     else
         stack_push(elems, elems + elems_size);
@@ -159,25 +169,65 @@ Force macroexpand(Value form, Value env)
 Force apply(const Value *vals, std::uint32_t size)
 {
     assert(size >= 2);
-    auto args = vals[size - 1];
-    std::uint32_t len = 0;
-    for (Root s{call_multimethod1(*rt::seq, args)}; *s; s = call_multimethod1(*rt::next, *s))
-        ++len;
-    Roots roots{len};
-
-    std::uint32_t i = 0;
-    std::vector<Value> form(vals, vals + (size - 1));
-    for (Root s{call_multimethod1(*rt::seq, args)}; *s; s = call_multimethod1(*rt::next, *s))
+    StackGuard guard;
+    auto start = stack.size();
+    stack_push(vals, vals + (size - 1));
+    stack_push_seq(vals[size - 1], std::numeric_limits<std::uint32_t>::max());
+    auto form = &stack[start];
+    return call_fn(get_value_type(form[0]), form, stack.size() - start);
+}
+
+Force stack_push_seq(Value coll, std::uint32_t n)
+{
+    if (get_value_type(coll).is(*type::Array))
     {
-        roots.set(i, call_multimethod1(*rt::first, *s));
-        form.push_back(roots[i]);
-        ++i;
+        auto size = get_array_size(coll);
+        auto pushed = std::min(size, n);
+        stack_push(get_array_elems(coll), get_array_elems(coll) + pushed);
+        return pushed == size ? nil : create_static_object(*type::ArraySeq, coll, Int64(pushed));
+    }
+    if (get_value_type(coll).is(*type::Vector))
+    {
+        Root s{vector_seq(coll)};
+        return *s ? stack_push_vector_seq(*s, n) : nil;
     }
 
-    return call_fn(get_value_type(form.front()), form.data(), form.size());
+    Root s{call_multimethod1(*rt::seq, coll)};
+    while (*s && n > 0)
+    {
+        auto type = get_value_type(*s);
+        if (type.is(*type::ArraySeq))
+        {
+            auto v = get_static_object_element(*s, 0);
+            auto index = std::uint32_t(get_static_object_int(*s, 1));
+            auto size = get_array_size(v);
+            auto pushed = std::min(size - index, n);
+            stack_push(get_array_elems(v) + index, get_array_elems(v) + index + pushed);
+            index += pushed;
+            return index == size ? nil : create_static_object(*type::ArraySeq, v, Int64(index));
+        }
+        if (type.is(*type::VectorSeq))
+            return stack_push_vector_seq(*s, n);
+        if (type.is(*type::List))
+        {
+            stack_push(get_list_first(*s));
+            s = get_list_next(*s);
+        }
+        else if (type.is(*type::Cons))
+        {
+            stack_push(cons_first(*s));
+            s = cons_next(*s);
+        }
+        else
+        {
+            stack_push(call_multimethod1(*rt::first, *s));
+            s = call_multimethod1(*rt::next, *s);
+        }
+        --n;
+    }
+    return *s;
 }
 
-
 Force call(const Value *vals, std::uint32_t size)
 {
     return call_fn(get_value_type(vals[0]), vals, size);
@@ -203,9 +253,14 @@ Force load(Value source)
     if (get_value_tag(source) != tag::UTF8STRING)
         throw_illegal_argument("expected a string");
 
+    ReaderStream stream{source};
+    return load(stream);
+}
+
+Force load(ReaderStream& stream)
+{
     Root bindings{map_assoc(*EMPTY_MAP, CURRENT_NS, *rt::current_ns)};
     PushBindingsGuard guard{*bindings};
-    ReaderStream stream{source};
     Root form, ret;
 
     while (!stream.eos())
@@ -4,11 +4,15 @@
 namespace cleo
 {
 
+class ReaderStream;
+
 Force macroexpand1(Value form, Value env = nil);
 Force macroexpand(Value form, Value env = nil);
 Force apply(const Value *vals, std::uint32_t size);
+Force stack_push_seq(Value coll, std::uint32_t n);
 Force call(const Value *vals, std::uint32_t size);
 Force eval(Value val);
 Force load(Value source);
+Force load(ReaderStream& stream);
 
 }
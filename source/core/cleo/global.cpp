@@ -1,11 +1,16 @@
 #include "global.hpp"
 #include "array.hpp"
+#include "vector.hpp"
 #include "byte_array.hpp"
+#include "typed_array.hpp"
+#include "string_builder.hpp"
+#include "strings.hpp"
 #include "multimethod.hpp"
 #include "equality.hpp"
 #include "list.hpp"
 #include "cons.hpp"
 #include "lazy_seq.hpp"
+#include "chunked_seq.hpp"
 #include "print.hpp"
 #include "var.hpp"
 #include "error.hpp"
@@ -14,9 +19,14 @@
 #include "array_map.hpp"
 #include "persistent_hash_map.hpp"
 #include "persistent_hash_set.hpp"
+#include "persistent_queue.hpp"
+#include "persistent_tree_map.hpp"
+#include "persistent_tree_set.hpp"
 #include "namespace.hpp"
 #include "reader.hpp"
+#include "serialize.hpp"
 #include "atom.hpp"
+#include "reduce.hpp"
 #include "util.hpp"
 #include "clib.hpp"
 #include <iostream>
@@ -27,10 +37,13 @@
 #include <chrono>
 #include <cstring>
 #include <algorithm>
+#include <unistd.h>
 #include "bytecode_fn.hpp"
 #include "compile.hpp"
 #include "profiler.hpp"
+#include "vm_stats.hpp"
 #include "string_seq.hpp"
+#include "stack_seq.hpp"
 
 namespace cleo
 {
@@ -44,8 +57,8 @@ std::unique_ptr<std::ostream> gc_log;
 vm::Stack stack;
 vm::IntStack int_stack;
 
-std::unordered_map<std::string, std::unordered_map<std::string, Value>> symbols;
-std::unordered_map<std::string, std::unordered_map<std::string, Value>> keywords;
+InternTable symbols;
+InternTable keywords;
 
 std::unordered_map<Value, Value, std::hash<Value>, StdIs> vars;
 
@@ -70,6 +83,7 @@ const Value SEQ = create_symbol("cleo.core", "seq");
 const Value FIRST = create_symbol("cleo.core", "first");
 const Value NEXT = create_symbol("cleo.core", "next");
 const Value COUNT = create_symbol("cleo.core", "count");
+const Value COLL_REDUCE = create_symbol("cleo.core", "coll-reduce");
 const Value GET = create_symbol("cleo.core", "get");
 const Value CONTAINS = create_symbol("cleo.core", "contains?");
 const Value CONJ = create_symbol("cleo.core", "conj*");
@@ -241,9 +255,20 @@ const ConstRoot PersistentVector{create_protocol("cleo.core", "PersistentVector"
 const ConstRoot Array{create_dynamic_type("cleo.core", "Array")};
 const ConstRoot TransientArray{create_dynamic_type("cleo.core", "TransientArray")};
 const ConstRoot ArraySeq{create_static_type("cleo.core", "ArraySeq", {"array", {"index", Int64}})};
+const ConstRoot Vector{create_dynamic_type("cleo.core", "Vector")};
+const ConstRoot TransientVector{create_dynamic_type("cleo.core", "TransientVector")};
+const ConstRoot VectorNode{create_dynamic_type("cleo.core", "VectorNode")};
+const ConstRoot VectorSeq{create_static_type("cleo.core", "VectorSeq", {"vector", "leaf", {"index", Int64}})};
 const ConstRoot ByteArray{create_dynamic_type("cleo.core", "ByteArray")};
 const ConstRoot TransientByteArray{create_dynamic_type("cleo.core", "TransientByteArray")};
 const ConstRoot ByteArraySeq{create_static_type("cleo.core", "ByteArraySeq", {"array", {"index", Int64}})};
+const ConstRoot Int64Array{create_dynamic_type("cleo.core", "Int64Array")};
+const ConstRoot Float64Array{create_dynamic_type("cleo.core", "Float64Array")};
+const ConstRoot TransientInt64Array{create_dynamic_type("cleo.core", "TransientInt64Array")};
+const ConstRoot TransientFloat64Array{create_dynamic_type("cleo.core", "TransientFloat64Array")};
+const ConstRoot TypedArraySeq{create_static_type("cleo.core", "TypedArraySeq", {"array", {"index", Int64}})};
+const ConstRoot StringBuilder{create_dynamic_type("cleo.core", "StringBuilder")};
+const ConstRoot Reader{create_dynamic_type("cleo.core", "Reader")};
 const ConstRoot ArrayMap{create_dynamic_type("cleo.core", "ArrayMap")};
 const ConstRoot ArrayMapSeq{create_static_type("cleo.core", "ArrayMapSeq", {"first", "map", {"index", Int64}})};
 const ConstRoot PersistentSet{create_protocol("cleo.core", "PersistentSet")};
@@ -253,12 +278,15 @@ const ConstRoot Hierarchy{create_static_type("cleo.core", "Hierarchy", {"ancesto
 const ConstRoot Multimethod{create_static_type("cleo.core", "Multimethod", {"dispatch_fn", "hierarchy", "memoized_fns", "fns", "default_dispatch_val", "name"})};
 const ConstRoot Seqable{create_protocol("cleo.core", "Seqable")};
 const ConstRoot Sequence{create_protocol("cleo.core", "Sequence")};
+const ConstRoot ChunkedSeq{create_protocol("cleo.core", "ChunkedSeq")};
+const ConstRoot ChunkedCons{create_static_type("cleo.core", "ChunkedCons", {"chunk", "more", {"offset", Int64}})};
 const ConstRoot Callable{create_protocol("cleo.core", "Callable")};
 const ConstRoot BytecodeFn{create_dynamic_type("cleo.core", "BytecodeFn")};
 const ConstRoot OpenBytecodeFn{create_dynamic_type("cleo.core", "OpenBytecodeFn")};
 const ConstRoot BytecodeFnBody{create_dynamic_type("cleo.core", "BytecodeFnBody")};
 const ConstRoot BytecodeFnExceptionTable{create_dynamic_type("cleo.core", "BytecodeFnExceptionTable")};
 const ConstRoot Atom{create_static_type("cleo.core", "Atom", {"value"})};
+const ConstRoot Reduced{create_static_type("cleo.core", "Reduced", {"value"})};
 const ConstRoot PersistentMap{create_protocol("cleo.core", "PersistentMap")};
 const ConstRoot PersistentHashMap{create_dynamic_type("cleo.core", "PersistentHashMap")};
 const ConstRoot PersistentHashMapSeq{create_static_type("cleo.core", "PersistentHashMapSeq", {"first", "node", {"index", Int64}, "parent"})};
@@ -270,6 +298,19 @@ const ConstRoot PersistentHashSetSeq{create_static_type("cleo.core", "Persistent
 const ConstRoot PersistentHashSetSeqParent{create_static_type("cleo.core", "PersistentHashSetSeqParent", {{"index", Int64}, "node", "parent"})};
 const ConstRoot PersistentHashSetCollisionNode(create_dynamic_type("cleo.core", "PersistentHashSetCollisionNode"));
 const ConstRoot PersistentHashSetArrayNode(create_dynamic_type("cleo.core", "PersistentHashSetArrayNode"));
+const ConstRoot TransientHashMap{create_dynamic_type("cleo.core", "TransientHashMap")};
+const ConstRoot TransientHashSet{create_dynamic_type("cleo.core", "TransientHashSet")};
+const ConstRoot PersistentQueue{create_static_type("cleo.core", "PersistentQueue", {"front", "rear", {"size", Int64}})};
+const ConstRoot PersistentQueueSeq{create_static_type("cleo.core", "PersistentQueueSeq", {"front", "rear"})};
+const ConstRoot Sorted{create_protocol("cleo.core", "Sorted")};
+const ConstRoot PersistentTreeMap{create_static_type("cleo.core", "PersistentTreeMap", {"comparator", "root", {"size", Int64}})};
+const ConstRoot PersistentTreeMapBranch{create_dynamic_type("cleo.core", "PersistentTreeMapBranch")};
+const ConstRoot PersistentTreeMapLeaf{create_dynamic_type("cleo.core", "PersistentTreeMapLeaf")};
+const ConstRoot PersistentTreeSeq{create_static_type("cleo.core", "PersistentTreeSeq", {"leaf", "parent", {"position", Int64}})};
+const ConstRoot PersistentTreeSeqParent{create_static_type("cleo.core", "PersistentTreeSeqParent", {{"index", Int64}, "branch", "parent"})};
+const ConstRoot PersistentTreeSet{create_static_type("cleo.core", "PersistentTreeSet", {"map"})};
+const ConstRoot TransientTreeMap{create_dynamic_type("cleo.core", "TransientTreeMap")};
+const ConstRoot TransientTreeSet{create_static_type("cleo.core", "TransientTreeSet", {"map"})};
 const ConstRoot Exception{create_static_type("cleo.core", "Exception", {"msg"})};
 const ConstRoot LogicException{create_static_type("cleo.core", "LogicException", {"msg", "callstack"})};
 const ConstRoot CastError{create_static_type("cleo.core", "CastError", {"msg", "callstack"})};
@@ -286,6 +327,7 @@ const ConstRoot CompilationError{create_static_type("cleo.core", "CompilationErr
 const ConstRoot StackOverflow{create_static_type("cleo.core", "StackOverflow", {"msg", "callstack"})};
 const ConstRoot Namespace{create_static_type("cleo.core", "Namespace", {"name", "meta", "mapping", "aliases"})};
 const ConstRoot UTF8StringSeq{create_static_type("cleo.core", "UTF8StringSeq", {"str", {"offset", Int64}})};
+const ConstRoot StackSeq{create_basic_type("cleo.core", "StackSeq")};
 }
 
 namespace clib
@@ -349,6 +391,7 @@ const StaticVar first = define_var(FIRST, nil);
 const StaticVar next = define_var(NEXT, nil);
 const StaticVar seq = define_var(SEQ, nil);
 const StaticVar count = define_var(COUNT, nil);
+const StaticVar coll_reduce = define_var(COLL_REDUCE, nil);
 const StaticVar get = define_var(GET, nil);
 const StaticVar contains = define_var(CONTAINS, nil);
 const StaticVar assoc = define_var(ASSOC, nil);
@@ -373,6 +416,13 @@ const Value MACROEXPAND = create_symbol("cleo.core", "macroexpand");
 const Value REFER = create_symbol("cleo.core", "refer");
 const Value READ_STRING = create_symbol("cleo.core", "read-string");
 const Value LOAD_STRING = create_symbol("cleo.core", "load-string");
+const Value READER = create_symbol("cleo.core", "reader");
+const Value READ = create_symbol("cleo.core", "read");
+const Value CLOSE = create_symbol("cleo.core", "close");
+const Value SERIALIZE = create_symbol("cleo.core", "serialize");
+const Value SERIALIZE_TO_FILE = create_symbol("cleo.core", "serialize-to-file");
+const Value DESERIALIZE = create_symbol("cleo.core", "deserialize");
+const Value DESERIALIZE_FILE = create_symbol("cleo.core", "deserialize-file");
 const Value REQUIRE = create_symbol("cleo.core", "require*");
 const Value ALIAS = create_symbol("cleo.core", "alias");
 const Value TYPE = create_symbol("cleo.core", "type");
@@ -419,13 +469,39 @@ const Value FIND_NS = create_symbol("cleo.core", "find-ns");
 const Value RESOLVE = create_symbol("cleo.core", "resolve");
 const Value SUBS = create_symbol("cleo.core", "subs");
 const Value ASSOC_E = create_symbol("cleo.core", "assoc!");
+const Value DISSOC_E = create_symbol("cleo.core", "dissoc!");
+const Value CHUNK_FIRST = create_symbol("cleo.core", "chunk-first");
+const Value CHUNK_NEXT = create_symbol("cleo.core", "chunk-next");
+const Value CHUNK_CONS = create_symbol("cleo.core", "chunk-cons");
+const Value CHUNKED_SEQ_Q = create_symbol("cleo.core", "chunked-seq?");
+const Value REDUCED = create_symbol("cleo.core", "reduced");
+const Value REDUCED_Q = create_symbol("cleo.core", "reduced?");
+const Value COMPARE = create_symbol("cleo.core", "compare");
+const Value SORTED_MAP = create_symbol("cleo.core", "sorted-map*");
+const Value SORTED_SET = create_symbol("cleo.core", "sorted-set*");
+const Value SORTED_COMPARE = create_symbol("cleo.core", "sorted-compare");
+const Value RSEQ = create_symbol("cleo.core", "rseq");
+const Value SEQ_FROM = create_symbol("cleo.core", "seq-from");
+const Value QUEUE = create_symbol("cleo.core", "queue*");
 const Value DEFINE_VAR = create_symbol("cleo.core", "define-var");
 const Value SERIALIZE_FN = create_symbol("cleo.core", "serialize-fn");
 const Value DESERIALIZE_FN = create_symbol("cleo.core", "deserialize-fn");
 const Value CHAR = create_symbol("cleo.core", "char");
 const Value START_PROFILING = create_symbol("cleo.core", "start-profiling");
 const Value FINISH_PROFILING = create_symbol("cleo.core", "finish-profiling");
+const Value START_VM_STATS = create_symbol("cleo.core", "start-vm-stats");
+const Value STOP_VM_STATS = create_symbol("cleo.core", "stop-vm-stats");
+const Value VM_STATS = create_symbol("cleo.core", "vm-stats");
 const Value STR_STARTS_WITH = create_symbol("cleo.core", "str-starts-with?");
+const Value INDEX_OF = create_symbol("cleo.core", "index-of");
+const Value LAST_INDEX_OF = create_symbol("cleo.core", "last-index-of");
+const Value INCLUDES = create_symbol("cleo.core", "includes?");
+const Value SPLIT = create_symbol("cleo.core", "split");
+const Value REPLACE = create_symbol("cleo.core", "replace");
+const Value JOIN = create_symbol("cleo.core", "join");
+const Value TRIM = create_symbol("cleo.core", "trim");
+const Value LOWER_CASE = create_symbol("cleo.core", "lower-case");
+const Value UPPER_CASE = create_symbol("cleo.core", "upper-case");
 const Value SORT_E = create_symbol("cleo.core", "sort!");
 const Value DERIVE = create_symbol("cleo.core", "derive");
 const Value GET_TYPE_FIELD_INDEX = create_symbol("cleo.core", "get-type-field-index");
@@ -439,6 +515,19 @@ const Value FIRST_ARG = create_symbol("first-arg");
 const Value EQUAL_DISPATCH = create_symbol("equal-dispatch");
 
 const Value BYTE_ARRAY = create_symbol("cleo.core", "byte-array");
+const Value INT64_ARRAY = create_symbol("cleo.core", "int64-array");
+const Value FLOAT64_ARRAY = create_symbol("cleo.core", "float64-array");
+const Value ARRAY_SUM = create_symbol("cleo.core", "array-sum");
+const Value ARRAY_MIN = create_symbol("cleo.core", "array-min");
+const Value ARRAY_MAX = create_symbol("cleo.core", "array-max");
+const Value ARRAY_DOT = create_symbol("cleo.core", "array-dot");
+const Value ARRAY_ADD = create_symbol("cleo.core", "array-add");
+const Value ARRAY_MUL = create_symbol("cleo.core", "array-mul");
+const Value ARRAY_SCALE = create_symbol("cleo.core", "array-scale");
+const Value ARRAY_PREFIX_SUM = create_symbol("cleo.core", "array-prefix-sum");
+const Value ARRAY_SORT = create_symbol("cleo.core", "array-sort");
+const Value STRING_BUILDER = create_symbol("cleo.core", "string-builder");
+const Value APPEND_E = create_symbol("cleo.core", "append!");
 
 const Value TRANSIENT_VECTOR = create_symbol("cleo.core", "transient-vector");
 const Value PERSISTENT_VECTOR = create_symbol("cleo.core", "persistent-vector!");
@@ -612,6 +701,20 @@ Value transient_array_get(Value v, Value index)
     return get_transient_array_elem(v, i);
 }
 
+Value vector_get(Value v, Value index)
+{
+    if (get_value_tag(index) != tag::INT64)
+        return nil;
+    return get_vector_elem(v, get_int64_value(index));
+}
+
+Value transient_vector_get(Value v, Value index)
+{
+    if (get_value_tag(index) != tag::INT64)
+        return nil;
+    return get_transient_vector_elem(v, get_int64_value(index));
+}
+
 Value byte_array_get(Value v, Value index)
 {
     if (get_value_tag(index) != tag::INT64)
@@ -642,6 +745,51 @@ Force transient_array_assoc(Value v, Value index, Value e)
     return transient_array_assoc_elem(v, i, e);
 }
 
+Force array_assoc(Value v, Value index, Value e)
+{
+    if (get_value_tag(index) != tag::INT64)
+        throw_illegal_argument("Key must be integer");
+    return array_vector_assoc_elem(v, get_int64_value(index), e);
+}
+
+Force vector_assoc(Value v, Value index, Value e)
+{
+    if (get_value_tag(index) != tag::INT64)
+        throw_illegal_argument("Key must be integer");
+    return vector_assoc_elem(v, get_int64_value(index), e);
+}
+
+Force transient_vector_assoc(Value v, Value index, Value e)
+{
+    if (get_value_tag(index) != tag::INT64)
+        return nil;
+    return transient_vector_assoc_elem(v, get_int64_value(index), e);
+}
+
+Force transient_vector_literal(Value v)
+{
+    if (get_value_type(v).is(*type::Vector))
+        return transient_vector(v);
+    check_type("v", v, *type::Array);
+    return transient_array(v);
+}
+
+Force transient_vector_literal_assoc(Value v, Value index, Value e)
+{
+    if (get_value_type(v).is(*type::TransientVector))
+        return transient_vector_assoc(v, index, e);
+    check_type("v", v, *type::TransientArray);
+    return transient_array_assoc(v, index, e);
+}
+
+Force persistent_vector_literal(Value v)
+{
+    if (get_value_type(v).is(*type::TransientVector))
+        return transient_vector_persistent(v);
+    check_type("v", v, *type::TransientArray);
+    return transient_array_persistent(v);
+}
+
 Force transient_byte_array_assoc(Value v, Value index, Value e)
 {
     if (get_value_tag(index) != tag::INT64)
@@ -662,6 +810,16 @@ Value array_call(Value v, Value index)
     return get_array_elem(v, i);
 }
 
+Value vector_call(Value v, Value index)
+{
+    if (get_value_tag(index) != tag::INT64)
+        throw_illegal_argument("Key must be integer");
+    auto i = get_int64_value(index);
+    if (i < 0 || i >= get_vector_size(v))
+        throw_index_out_of_bounds();
+    return get_vector_elem(v, i);
+}
+
 Value byte_array_call(Value v, Value index)
 {
     if (get_value_tag(index) != tag::INT64)
@@ -682,6 +840,16 @@ Value transient_array_call(Value v, Value index)
     return get_transient_array_elem(v, i);
 }
 
+Value transient_vector_call(Value v, Value index)
+{
+    if (get_value_tag(index) != tag::INT64)
+        throw_illegal_argument("Key must be integer");
+    auto i = get_int64_value(index);
+    if (i < 0 || i >= get_transient_vector_size(v))
+        throw_index_out_of_bounds();
+    return get_transient_vector_elem(v, i);
+}
+
 Value transient_byte_array_call(Value v, Value index)
 {
     if (get_value_tag(index) != tag::INT64)
@@ -699,59 +867,76 @@ Force var_call(const Value *args, std::uint8_t n)
     return call(vargs.data(), vargs.size());
 }
 
-Force pr(const Value *args, std::uint8_t n)
+void print_values(void (*print)(Output&, Value), const Value *args, std::uint8_t n, bool newline)
 {
-    Root s;
+    std::cout.flush();
+    Output out{STDOUT_FILENO};
     for (decltype(n) i = 0; i < n; ++i)
     {
-        s = pr_str(args[i]);
         if (i > 0)
-            std::cout << ' ';
-        std::cout << std::string(get_string_ptr(*s), get_string_size(*s));
+            out += ' ';
+        print(out, args[i]);
     }
-    std::cout << std::flush;
+    if (newline)
+        out += '\n';
+    out.flush();
+}
+
+Force pr(const Value *args, std::uint8_t n)
+{
+    print_values(pr_str, args, n, false);
     return force(nil);
 }
 
 Force prn(const Value *args, std::uint8_t n)
 {
-    pr(args, n);
-    std::cout << std::endl;
+    print_values(pr_str, args, n, true);
     return nil;
 }
 
 Force print(const Value *args, std::uint8_t n)
 {
-    Root s;
-    for (decltype(n) i = 0; i < n; ++i)
-    {
-        s = print_str(args[i]);
-        if (i > 0)
-            std::cout << ' ';
-        std::cout << std::string(get_string_ptr(*s), get_string_size(*s));
-    }
-    std::cout << std::flush;
+    print_values(print_str, args, n, false);
     return nil;
 }
 
 Force println(const Value *args, std::uint8_t n)
 {
-    print(args, n);
-    std::cout << std::endl;
+    print_values(print_str, args, n, true);
     return nil;
 }
 
+Force pr_str_values(const Value *args, std::uint8_t n)
+{
+    if (n == 1)
+        return pr_str(args[0]);
+    std::string out;
+    for (decltype(n) i = 0; i < n; ++i)
+    {
+        if (i > 0)
+            out += ' ';
+        pr_str(out, args[i]);
+    }
+    return create_string(out);
+}
+
 Force str(const Value *args, std::uint8_t n)
 {
-    Root s;
-    std::string str;
+    if (n == 1 && get_value_tag(args[0]) == tag::UTF8STRING)
+        return args[0];
+    std::string out;
     for (decltype(n) i = 0; i < n; ++i)
         if (auto arg = args[i])
-        {
-            s = print_str(arg);
-            str.append(get_string_ptr(*s), get_string_size(*s));
-        }
-    return create_string(str);
+            print_str(out, arg);
+    return create_string(out);
+}
+
+Force string_builder(const Value *args, std::uint8_t n)
+{
+    Root sb{create_string_builder(0)};
+    for (decltype(n) i = 0; i < n; ++i)
+        sb = string_builder_append(*sb, args[i]);
+    return *sb;
 }
 
 Force macroexpand_noenv(Value val)
@@ -776,6 +961,11 @@ Force get_seqable_next(Value val)
     return call_multimethod1(*rt::next, *s);
 }
 
+Value is_chunked_seq(Value val)
+{
+    return isa(get_value_type(val), *type::ChunkedSeq);
+}
+
 void define_type(Value type)
 {
     define(get_object_type_name(type), type, *CONST_META);
@@ -811,6 +1001,26 @@ Force pr_str_multimethod(Value m)
 Force merge_maps(Value m1, Value m2)
 {
     Root m{m1}, kv;
+    if (get_value_type(m1).is(*type::PersistentHashMap))
+    {
+        m = transient_hash_map(m1);
+        for (Root seq{call_multimethod1(*rt::seq, m2)}; *seq; seq = call_multimethod1(*rt::next, *seq))
+        {
+            kv = call_multimethod1(*rt::first, *seq);
+            m = transient_hash_map_assoc(*m, get_array_elem(*kv, 0), get_array_elem(*kv, 1));
+        }
+        return transient_hash_map_persistent(*m);
+    }
+    if (get_value_type(m1).is(*type::PersistentTreeMap))
+    {
+        m = transient_tree_map(m1);
+        for (Root seq{call_multimethod1(*rt::seq, m2)}; *seq; seq = call_multimethod1(*rt::next, *seq))
+        {
+            kv = call_multimethod1(*rt::first, *seq);
+            m = transient_tree_map_assoc(*m, get_array_elem(*kv, 0), get_array_elem(*kv, 1));
+        }
+        return transient_tree_map_persistent(*m);
+    }
     for (Root seq{call_multimethod1(*rt::seq, m2)}; *seq; seq = call_multimethod1(*rt::next, *seq))
     {
         kv = call_multimethod1(*rt::first, *seq);
@@ -854,6 +1064,16 @@ Force byte_array(const Value *args, std::uint8_t n)
     return create_byte_array(args, n);
 }
 
+Force int64_array(const Value *args, std::uint8_t n)
+{
+    return create_int64_array(args, n);
+}
+
+Force float64_array(const Value *args, std::uint8_t n)
+{
+    return create_float64_array(args, n);
+}
+
 Force hash_map(const Value *args, std::uint8_t n)
 {
     Root m{*EMPTY_MAP};
@@ -1004,6 +1224,17 @@ Force nil_conj(Value, Value x)
     return create_list(&x, 1);
 }
 
+template <Force assoc(Value, Value, Value)>
+struct MapConjFn
+{
+    static Force fn(Value m, Value entry)
+    {
+        if (!get_value_type(entry).is(*type::Array) || get_array_size(entry) != 2)
+            throw_illegal_argument("Vector arg to map conj must be a pair");
+        return assoc(m, get_array_elem(entry, 0), get_array_elem(entry, 1));
+    }
+};
+
 Force nil_assoc(Value, Value k, Value v)
 {
     return map_assoc(*EMPTY_MAP, k, v);
@@ -1034,6 +1265,21 @@ Value nil_count(Value)
     return *ZERO;
 }
 
+Force compare(Value left, Value right)
+{
+    return create_int64(compare_values(left, right));
+}
+
+Force sorted_compare(Value sc, Value left, Value right)
+{
+    auto sc_type = get_value_type(sc);
+    if (sc_type.is(*type::PersistentTreeSet))
+        sc = get_persistent_tree_set_map(sc);
+    else if (!sc_type.is(*type::PersistentTreeMap))
+        throw_illegal_argument("Not a sorted collection: " + to_string(sc));
+    return create_int64(persistent_tree_map_compare(sc, left, right));
+}
+
 Force seq_count(Value s)
 {
     Root sn{call_multimethod1(*rt::seq, s)};
@@ -1068,6 +1314,16 @@ Value transient_array_peek(Value v)
     return size > 0 ? get_transient_array_elem(v, size - 1) : nil;
 }
 
+Value vector_peek(Value v)
+{
+    return get_vector_elem(v, get_vector_size(v) - 1);
+}
+
+Value transient_vector_peek(Value v)
+{
+    return get_transient_vector_elem(v, get_transient_vector_size(v) - 1);
+}
+
 Force mk_keyword(Value val)
 {
     auto t = get_value_tag(val);
@@ -1142,20 +1398,22 @@ Force protocol(Value name)
     return create_protocol(name);
 }
 
-Force create_type(Value name, Value field_names, Value field_types)
+Force create_type(Value name, Value field_names_, Value field_types_)
 {
     check_type("name", name, *type::Symbol);
-    check_type("field-names", field_names, *type::Array);
-    check_type("field-types", field_types, *type::Array);
-    auto size = get_array_size(field_names);
-    if (get_array_size(field_types) != size)
+    Root field_names{vector_to_array(field_names_)};
+    Root field_types{vector_to_array(field_types_)};
+    check_type("field-names", *field_names, *type::Array);
+    check_type("field-types", *field_types, *type::Array);
+    auto size = get_array_size(*field_names);
+    if (get_array_size(*field_types) != size)
         throw_illegal_argument("mismatched field names/types");
     std::vector<Value> names(size);
     std::vector<Value> types(size);
     for (Int64 i = 0; i < size; ++i)
     {
-        auto name = get_array_elem(field_names, i);
-        auto type = get_array_elem(field_types, i);
+        auto name = get_array_elem(*field_names, i);
+        auto type = get_array_elem(*field_types, i);
         check_type("field-name", name, *type::Symbol);
         if (type && !get_value_type(type).is(*type::Protocol))
             check_type("field-type", type, *type::Type);
@@ -1212,17 +1470,17 @@ Force disasm_bytes(const vm::Byte *bytes, Int64 size, Value consts, Value vars)
             os << std::hex << std::setfill('0') << std::setw(2) << unsigned(std::uint8_t(p[i]));
         return os.str();
     };
-    auto mk = [&p, bytes, hex_bytes](const std::string& oc, unsigned size = 1, Value arg0 = *SENTINEL)
+    auto mk = [&p, bytes, hex_bytes](const std::string& oc, unsigned size = 1, Value arg0 = *SENTINEL, Value arg1 = *SENTINEL, Value arg2 = *SENTINEL)
     {
         Root offset{create_int64(p - bytes)};
         Root bytes{create_string(hex_bytes(p, size))};
-        std::array<Value, 4> s{{*offset, *bytes, create_symbol(oc), arg0}};
-        std::uint32_t n = 4;
-        if (arg0 == *SENTINEL)
-            n = 3;
+        std::array<Value, 6> s{{*offset, *bytes, create_symbol(oc), arg0, arg1, arg2}};
+        std::uint32_t n = 3;
+        while (n < s.size() && s[n] != *SENTINEL)
+            ++n;
         return create_array(s.data(), n);
     };
-    Root oc, x;
+    Root oc, x, y, z;
     while (p != endp)
     {
         switch (*p)
@@ -1238,6 +1496,19 @@ Force disasm_bytes(const vm::Byte *bytes, Int64 size, Value consts, Value vars)
             dbs = transient_array_conj(*dbs, *oc);
             p += 3;
             break;
+        case vm::LDLL:
+            x = create_int64(read_i16(p + 1));
+            y = create_int64(read_i16(p + 4));
+            oc = mk("LDLL", 6, *x, *y);
+            dbs = transient_array_conj(*dbs, *oc);
+            p += 6;
+            break;
+        case vm::LDVL:
+            x = create_int64(read_i16(p + 4));
+            oc = mk("LDVL", 6, get_array_elem(vars, read_u16(p + 1)), *x);
+            dbs = transient_array_conj(*dbs, *oc);
+            p += 6;
+            break;
         case vm::LDDV:
             oc = mk("LDDV", 3, get_array_elem(vars, read_u16(p + 1)));
             dbs = transient_array_conj(*dbs, *oc);
@@ -1315,6 +1586,35 @@ Force disasm_bytes(const vm::Byte *bytes, Int64 size, Value consts, Value vars)
             dbs = transient_array_conj(*dbs, *oc);
             p += 2;
             break;
+        case vm::LCALL:
+            x = create_int64(read_i16(p + 1));
+            y = create_int64(std::uint8_t(p[4]));
+            oc = mk("LCALL", 5, *x, *y);
+            dbs = transient_array_conj(*dbs, *oc);
+            p += 5;
+            break;
+        case vm::LLCALL:
+            x = create_int64(read_i16(p + 1));
+            y = create_int64(read_i16(p + 4));
+            z = create_int64(std::uint8_t(p[7]));
+            oc = mk("LLCALL", 8, *x, *y, *z);
+            dbs = transient_array_conj(*dbs, *oc);
+            p += 8;
+            break;
+        case vm::VLCALL:
+            x = create_int64(read_i16(p + 4));
+            y = create_int64(std::uint8_t(p[7]));
+            oc = mk("VLCALL", 8, get_array_elem(vars, read_u16(p + 1)), *x, *y);
+            dbs = transient_array_conj(*dbs, *oc);
+            p += 8;
+            break;
+        case vm::CALLSTL:
+            x = create_int64(std::uint8_t(p[1]));
+            y = create_int64(read_i16(p + 3));
+            oc = mk("CALLSTL", 5, *x, *y);
+            dbs = transient_array_conj(*dbs, *oc);
+            p += 5;
+            break;
         case vm::APPLY:
             x = create_int64(std::uint8_t(p[1]));
             oc = mk("APPLY", 2, *x);
@@ -1409,6 +1709,9 @@ Force disasm(Value fn)
         Root det{disasm_exception_table(get_bytecode_fn_body_exception_table(body))};
         if (*det)
             dbody = map_assoc(*dbody, create_keyword("exception-table"), *det);
+        Root hits{vm::stats::get_body_hits(body)};
+        if (*hits)
+            dbody = map_assoc(*dbody, create_keyword("hits"), *hits);
         bodies = array_conj(*bodies, *dbody);
         for (Int64 j = 0; j < get_array_size(consts); ++j)
             if (isa(get_value_type(get_array_elem(consts, j)), *type::OpenBytecodeFn))
@@ -1493,8 +1796,7 @@ Force subs(Value s, Value start)
     if (start_ < 0 ||
         start_ > get_string_len(s))
         throw_illegal_argument("Invalid substring start: " + std::to_string(start_));
-    auto start_offset = get_string_char_offset(s, start_);
-    return create_string(get_string_ptr(s) + start_offset, get_string_size(s) - start_offset);
+    return create_substring(s, start_, get_string_len(s));
 }
 
 Force subs(Value s, Value start, Value end)
@@ -1509,9 +1811,7 @@ Force subs(Value s, Value start, Value end)
         end_ > get_string_len(s) ||
         start_ > end_)
         throw_illegal_argument("Invalid substring bounds: " + std::to_string(start_) + " " + std::to_string(end_));
-    auto start_offset = get_string_char_offset(s, start_);
-    auto end_offset = get_string_char_offset(s, end_);
-    return create_string(get_string_ptr(s) + start_offset, end_offset - start_offset);
+    return create_substring(s, start_, end_);
 }
 
 Value string_get(Value s, Value idx, Value def)
@@ -1548,7 +1848,7 @@ Value str_starts_with(Value s, Value ss)
 {
     check_type("s", s, *type::UTF8String);
     check_type("ss", ss, *type::UTF8String);
-    return std::strncmp(get_string_ptr(s), get_string_ptr(ss), get_string_size(ss)) == 0 ? TRUE : nil;
+    return get_string_size(s) >= get_string_size(ss) && std::memcmp(get_string_ptr(s), get_string_ptr(ss), get_string_size(ss)) == 0 ? TRUE : nil;
 }
 
 Force sort_transient(Value pred, Value array)
@@ -1645,10 +1945,23 @@ struct Initialize
         define_type(*type::Array);
         derive(*type::Array, *type::PersistentVector);
         define_type(*type::ArraySeq);
+        define_type(*type::Vector);
+        derive(*type::Vector, *type::PersistentVector);
+        define_type(*type::VectorNode);
+        define_type(*type::VectorSeq);
         define_type(*type::ByteArray);
         derive(*type::ByteArray, *type::PersistentVector);
         define_type(*type::ByteArraySeq);
         define_type(*type::TransientByteArray);
+        define_type(*type::Int64Array);
+        derive(*type::Int64Array, *type::PersistentVector);
+        define_type(*type::Float64Array);
+        derive(*type::Float64Array, *type::PersistentVector);
+        define_type(*type::TypedArraySeq);
+        define_type(*type::TransientInt64Array);
+        define_type(*type::TransientFloat64Array);
+        define_type(*type::StringBuilder);
+        define_type(*type::Reader);
         define_type(*type::ArrayMap);
         define_type(*type::ArrayMapSeq);
         define_protocol(*type::PersistentSet);
@@ -1660,6 +1973,9 @@ struct Initialize
         define_protocol(*type::Seqable);
         derive(*type::PersistentVector, *type::Seqable);
         define_protocol(*type::Sequence);
+        define_protocol(*type::ChunkedSeq);
+        derive(*type::ChunkedSeq, *type::Sequence);
+        define_type(*type::ChunkedCons);
         define_protocol(*type::Callable);
         define_type(*type::OpenBytecodeFn);
         define_type(*type::BytecodeFn);
@@ -1667,6 +1983,7 @@ struct Initialize
         define_type(*type::BytecodeFnBody);
         define_type(*type::BytecodeFnExceptionTable);
         define_type(*type::Atom);
+        define_type(*type::Reduced);
         define_protocol(*type::PersistentMap);
         define_type(*type::PersistentHashMap);
         define_type(*type::PersistentHashMapCollisionNode);
@@ -1676,7 +1993,23 @@ struct Initialize
         define_type(*type::PersistentHashSetCollisionNode);
         define_type(*type::PersistentHashSetArrayNode);
         define_type(*type::PersistentHashSetSeqParent);
+        define_type(*type::TransientHashMap);
+        define_type(*type::TransientHashSet);
         derive(*type::PersistentHashSet, *type::PersistentSet);
+        define_protocol(*type::Sorted);
+        define_type(*type::PersistentQueue);
+        define_type(*type::PersistentQueueSeq);
+        define_type(*type::PersistentTreeMap);
+        define_type(*type::PersistentTreeMapBranch);
+        define_type(*type::PersistentTreeMapLeaf);
+        define_type(*type::PersistentTreeSeq);
+        define_type(*type::PersistentTreeSeqParent);
+        define_type(*type::PersistentTreeSet);
+        define_type(*type::TransientTreeMap);
+        define_type(*type::TransientTreeSet);
+        derive(*type::PersistentTreeMap, *type::Sorted);
+        derive(*type::PersistentTreeSet, *type::Sorted);
+        derive(*type::PersistentTreeSet, *type::PersistentSet);
         define_type(*type::Exception);
         define_type(*type::LogicException);
         derive(*type::LogicException, *type::Exception);
@@ -1707,6 +2040,8 @@ struct Initialize
 
         define_type(*type::Namespace);
         define_type(*type::TransientArray);
+        define_type(*type::TransientVector);
+        define_type(*type::StackSeq);
 
         define(SHOULD_RECOMPILE, TRUE);
 
@@ -1732,6 +2067,25 @@ struct Initialize
 
         f = create_native_function1<array_hash, &HASH_OBJ>();
         define_method(HASH_OBJ, *type::Array, *f);
+        f = create_native_function1<vector_hash, &HASH_OBJ>();
+        define_method(HASH_OBJ, *type::Vector, *f);
+        f = create_native_function1<persistent_queue_hash, &HASH_OBJ>();
+        define_method(HASH_OBJ, *type::PersistentQueue, *f);
+        f = create_native_function1<typed_array_hash, &HASH_OBJ>();
+        define_method(HASH_OBJ, *type::Int64Array, *f);
+        define_method(HASH_OBJ, *type::Float64Array, *f);
+        f = create_native_function1<array_map_hash, &HASH_OBJ>();
+        define_method(HASH_OBJ, *type::ArrayMap, *f);
+        f = create_native_function1<persistent_hash_map_hash, &HASH_OBJ>();
+        define_method(HASH_OBJ, *type::PersistentHashMap, *f);
+        f = create_native_function1<array_set_hash, &HASH_OBJ>();
+        define_method(HASH_OBJ, *type::ArraySet, *f);
+        f = create_native_function1<persistent_hash_set_hash, &HASH_OBJ>();
+        define_method(HASH_OBJ, *type::PersistentHashSet, *f);
+        f = create_native_function1<persistent_tree_map_hash, &HASH_OBJ>();
+        define_method(HASH_OBJ, *type::PersistentTreeMap, *f);
+        f = create_native_function1<persistent_tree_set_hash, &HASH_OBJ>();
+        define_method(HASH_OBJ, *type::PersistentTreeSet, *f);
 
         define(CURRENT_NS, get_ns(CLEO_CORE), *DYNAMIC_META);
         f = create_native_function1or2<in_ns, in_ns, &IN_NS>();
@@ -1833,9 +2187,20 @@ struct Initialize
         define_method(NEXT, *type::ArraySeq, *f);
         f = create_native_function1<array_peek, &PEEK>();
         define_method(PEEK, *type::Array, *f);
-        f = create_native_function1<array_pop, &POP>();
+        f = create_native_function1<array_vector_pop, &POP>();
         define_method(POP, *type::Array, *f);
 
+        f = create_native_function1<vector_seq, &SEQ>();
+        define_method(SEQ, *type::Vector, *f);
+        f = create_native_function1<get_vector_seq_first, &FIRST>();
+        define_method(FIRST, *type::VectorSeq, *f);
+        f = create_native_function1<get_vector_seq_next, &NEXT>();
+        define_method(NEXT, *type::VectorSeq, *f);
+        f = create_native_function1<vector_peek, &PEEK>();
+        define_method(PEEK, *type::Vector, *f);
+        f = create_native_function1<vector_pop, &POP>();
+        define_method(POP, *type::Vector, *f);
+
         f = create_native_function(byte_array, BYTE_ARRAY);
         define(BYTE_ARRAY, *f);
         f = create_native_function1<byte_array_seq, &SEQ>();
@@ -1847,8 +2212,50 @@ struct Initialize
         f = create_native_function1<byte_array_pop, &POP>();
         define_method(POP, *type::ByteArray, *f);
 
+        f = create_native_function(int64_array, INT64_ARRAY);
+        define(INT64_ARRAY, *f);
+        f = create_native_function(float64_array, FLOAT64_ARRAY);
+        define(FLOAT64_ARRAY, *f);
+        f = create_native_function1<typed_array_seq, &SEQ>();
+        define_method(SEQ, *type::Int64Array, *f);
+        define_method(SEQ, *type::Float64Array, *f);
+        f = create_native_function1<get_typed_array_seq_first, &FIRST>();
+        define_method(FIRST, *type::TypedArraySeq, *f);
+        f = create_native_function1<get_typed_array_seq_next, &NEXT>();
+        define_method(NEXT, *type::TypedArraySeq, *f);
+        f = create_native_function1<typed_array_pop, &POP>();
+        define_method(POP, *type::Int64Array, *f);
+        define_method(POP, *type::Float64Array, *f);
+        define_function(ARRAY_SUM, create_native_function1<typed_array_sum, &ARRAY_SUM>());
+        define_function(ARRAY_MIN, create_native_function1<typed_array_min, &ARRAY_MIN>());
+        define_function(ARRAY_MAX, create_native_function1<typed_array_max, &ARRAY_MAX>());
+        define_function(ARRAY_DOT, create_native_function2<typed_array_dot, &ARRAY_DOT>());
+        define_function(ARRAY_ADD, create_native_function2<typed_array_add, &ARRAY_ADD>());
+        define_function(ARRAY_MUL, create_native_function2<typed_array_mul, &ARRAY_MUL>());
+        define_function(ARRAY_SCALE, create_native_function2<typed_array_scale, &ARRAY_SCALE>());
+        define_function(ARRAY_PREFIX_SUM, create_native_function1<typed_array_prefix_sum, &ARRAY_PREFIX_SUM>());
+        define_function(ARRAY_SORT, create_native_function1<typed_array_sort, &ARRAY_SORT>());
+
+        define_function(STRING_BUILDER, create_native_function(string_builder, STRING_BUILDER));
+        define_function(APPEND_E, create_native_function2<string_builder_append, &APPEND_E>());
+
         f = create_native_function1<transient_array_peek, &PEEK>();
         define_method(PEEK, *type::TransientArray, *f);
+        f = create_native_function1<transient_vector_peek, &PEEK>();
+        define_method(PEEK, *type::TransientVector, *f);
+
+        derive(*type::PersistentQueue, *type::Seqable);
+        f = create_native_function1<persistent_queue_seq, &SEQ>();
+        define_method(SEQ, *type::PersistentQueue, *f);
+        f = create_native_function1<get_persistent_queue_seq_first, &FIRST>();
+        define_method(FIRST, *type::PersistentQueueSeq, *f);
+        f = create_native_function1<get_persistent_queue_seq_next, &NEXT>();
+        define_method(NEXT, *type::PersistentQueueSeq, *f);
+        f = create_native_function1<persistent_queue_peek, &PEEK>();
+        define_method(PEEK, *type::PersistentQueue, *f);
+        f = create_native_function1<persistent_queue_pop, &POP>();
+        define_method(POP, *type::PersistentQueue, *f);
+        define_function(QUEUE, create_native_function0<create_persistent_queue, &QUEUE>());
 
         derive(*type::ArraySet, *type::Seqable);
         f = create_native_function1<array_set_seq, &SEQ>();
@@ -1882,6 +2289,34 @@ struct Initialize
         f = create_native_function1<get_persistent_hash_set_seq_next, &NEXT>();
         define_method(NEXT, *type::PersistentHashSetSeq, *f);
 
+        derive(*type::PersistentTreeMap, *type::Seqable);
+        f = create_native_function1<persistent_tree_map_seq, &SEQ>();
+        define_method(SEQ, *type::PersistentTreeMap, *f);
+        derive(*type::PersistentTreeSet, *type::Seqable);
+        f = create_native_function1<persistent_tree_set_seq, &SEQ>();
+        define_method(SEQ, *type::PersistentTreeSet, *f);
+        f = create_native_function1<get_persistent_tree_seq_first, &FIRST>();
+        define_method(FIRST, *type::PersistentTreeSeq, *f);
+        f = create_native_function1<get_persistent_tree_seq_next, &NEXT>();
+        define_method(NEXT, *type::PersistentTreeSeq, *f);
+
+        define_multimethod(RSEQ, *first_type, undefined);
+        f = create_native_function1<persistent_tree_map_rseq, &RSEQ>();
+        define_method(RSEQ, *type::PersistentTreeMap, *f);
+        f = create_native_function1<persistent_tree_set_rseq, &RSEQ>();
+        define_method(RSEQ, *type::PersistentTreeSet, *f);
+
+        define_multimethod(SEQ_FROM, *first_type, undefined);
+        f = create_native_function3<persistent_tree_map_seq_from, &SEQ_FROM>();
+        define_method(SEQ_FROM, *type::PersistentTreeMap, *f);
+        f = create_native_function3<persistent_tree_set_seq_from, &SEQ_FROM>();
+        define_method(SEQ_FROM, *type::PersistentTreeSet, *f);
+
+        define_function(SORTED_MAP, create_native_function1<create_persistent_tree_map, &SORTED_MAP>());
+        define_function(SORTED_SET, create_native_function1<create_persistent_tree_set, &SORTED_SET>());
+        define_function(SORTED_COMPARE, create_native_function3<sorted_compare, &SORTED_COMPARE>());
+        define_function(COMPARE, create_native_function2<compare, &COMPARE>());
+
         derive(*type::UTF8String, *type::Seqable);
         f = create_native_function1<string_seq, &SEQ>();
         define_method(SEQ, *type::UTF8String, *f);
@@ -1890,13 +2325,32 @@ struct Initialize
         f = create_native_function1<string_seq_next, &NEXT>();
         define_method(NEXT, *type::UTF8StringSeq, *f);
 
+        f = create_native_function1<get_stack_seq_first, &FIRST>();
+        define_method(FIRST, *type::StackSeq, *f);
+        f = create_native_function1<get_stack_seq_next, &NEXT>();
+        define_method(NEXT, *type::StackSeq, *f);
+
         derive(*type::ArraySeq, *type::Sequence);
+        derive(*type::VectorSeq, *type::Sequence);
         derive(*type::ByteArraySeq, *type::Sequence);
+        derive(*type::TypedArraySeq, *type::Sequence);
         derive(*type::ArraySetSeq, *type::Sequence);
         derive(*type::ArrayMapSeq, *type::Sequence);
         derive(*type::PersistentHashMapSeq, *type::Sequence);
         derive(*type::PersistentHashSetSeq, *type::Sequence);
+        derive(*type::PersistentQueueSeq, *type::Sequence);
+        derive(*type::PersistentTreeSeq, *type::Sequence);
         derive(*type::UTF8StringSeq, *type::Sequence);
+        derive(*type::StackSeq, *type::Sequence);
+        derive(*type::ArraySeq, *type::ChunkedSeq);
+        derive(*type::VectorSeq, *type::ChunkedSeq);
+        derive(*type::ByteArraySeq, *type::ChunkedSeq);
+        derive(*type::TypedArraySeq, *type::ChunkedSeq);
+        derive(*type::PersistentHashMapSeq, *type::ChunkedSeq);
+        derive(*type::PersistentHashSetSeq, *type::ChunkedSeq);
+        derive(*type::PersistentTreeSeq, *type::ChunkedSeq);
+        derive(*type::UTF8StringSeq, *type::ChunkedSeq);
+        derive(*type::ChunkedCons, *type::ChunkedSeq);
         derive(*type::Sequence, *type::Seqable);
         f = create_native_function1<identity, &SEQ>();
         define_method(SEQ, *type::Sequence, *f);
@@ -1906,6 +2360,89 @@ struct Initialize
         f = create_native_function1<get_seqable_next, &NEXT>();
         define_method(NEXT, *type::Seqable, *f);
 
+        f = create_native_function1<chunked_cons_first, &FIRST>();
+        define_method(FIRST, *type::ChunkedCons, *f);
+        f = create_native_function1<chunked_cons_next, &NEXT>();
+        define_method(NEXT, *type::ChunkedCons, *f);
+        f = create_native_function2<create_chunked_cons, &CHUNK_CONS>();
+        define(CHUNK_CONS, *f);
+        f = create_native_function1<is_chunked_seq, &CHUNKED_SEQ_Q>();
+        define(CHUNKED_SEQ_Q, *f);
+
+        define_multimethod(CHUNK_FIRST, *first_type, undefined);
+        define_multimethod(CHUNK_NEXT, *first_type, undefined);
+        f = create_native_function1<get_array_seq_chunk_first, &CHUNK_FIRST>();
+        define_method(CHUNK_FIRST, *type::ArraySeq, *f);
+        f = create_native_function1<get_array_seq_chunk_next, &CHUNK_NEXT>();
+        define_method(CHUNK_NEXT, *type::ArraySeq, *f);
+        f = create_native_function1<get_vector_seq_chunk_first, &CHUNK_FIRST>();
+        define_method(CHUNK_FIRST, *type::VectorSeq, *f);
+        f = create_native_function1<get_vector_seq_chunk_next, &CHUNK_NEXT>();
+        define_method(CHUNK_NEXT, *type::VectorSeq, *f);
+        f = create_native_function1<get_byte_array_seq_chunk_first, &CHUNK_FIRST>();
+        define_method(CHUNK_FIRST, *type::ByteArraySeq, *f);
+        f = create_native_function1<get_byte_array_seq_chunk_next, &CHUNK_NEXT>();
+        define_method(CHUNK_NEXT, *type::ByteArraySeq, *f);
+        f = create_native_function1<get_typed_array_seq_chunk_first, &CHUNK_FIRST>();
+        define_method(CHUNK_FIRST, *type::TypedArraySeq, *f);
+        f = create_native_function1<get_typed_array_seq_chunk_next, &CHUNK_NEXT>();
+        define_method(CHUNK_NEXT, *type::TypedArraySeq, *f);
+        f = create_native_function1<get_persistent_hash_map_seq_chunk_first, &CHUNK_FIRST>();
+        define_method(CHUNK_FIRST, *type::PersistentHashMapSeq, *f);
+        f = create_native_function1<get_persistent_hash_map_seq_chunk_next, &CHUNK_NEXT>();
+        define_method(CHUNK_NEXT, *type::PersistentHashMapSeq, *f);
+        f = create_native_function1<get_persistent_hash_set_seq_chunk_first, &CHUNK_FIRST>();
+        define_method(CHUNK_FIRST, *type::PersistentHashSetSeq, *f);
+        f = create_native_function1<get_persistent_hash_set_seq_chunk_next, &CHUNK_NEXT>();
+        define_method(CHUNK_NEXT, *type::PersistentHashSetSeq, *f);
+        f = create_native_function1<get_persistent_tree_seq_chunk_first, &CHUNK_FIRST>();
+        define_method(CHUNK_FIRST, *type::PersistentTreeSeq, *f);
+        f = create_native_function1<get_persistent_tree_seq_chunk_next, &CHUNK_NEXT>();
+        define_method(CHUNK_NEXT, *type::PersistentTreeSeq, *f);
+        f = create_native_function1<string_seq_chunk_first, &CHUNK_FIRST>();
+        define_method(CHUNK_FIRST, *type::UTF8StringSeq, *f);
+        f = create_native_function1<string_seq_chunk_next, &CHUNK_NEXT>();
+        define_method(CHUNK_NEXT, *type::UTF8StringSeq, *f);
+        f = create_native_function1<chunked_cons_chunk_first, &CHUNK_FIRST>();
+        define_method(CHUNK_FIRST, *type::ChunkedCons, *f);
+        f = create_native_function1<chunked_cons_chunk_next, &CHUNK_NEXT>();
+        define_method(CHUNK_NEXT, *type::ChunkedCons, *f);
+
+        define_multimethod(COLL_REDUCE, *first_type, nil);
+        f = create_native_function3<array_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::Array, *f);
+        f = create_native_function3<vector_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::Vector, *f);
+        f = create_native_function3<byte_array_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::ByteArray, *f);
+        f = create_native_function3<typed_array_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::Int64Array, *f);
+        define_method(COLL_REDUCE, *type::Float64Array, *f);
+        f = create_native_function3<persistent_queue_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::PersistentQueue, *f);
+        f = create_native_function3<list_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::List, *f);
+        f = create_native_function3<array_map_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::ArrayMap, *f);
+        f = create_native_function3<persistent_hash_map_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::PersistentHashMap, *f);
+        f = create_native_function3<array_set_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::ArraySet, *f);
+        f = create_native_function3<persistent_hash_set_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::PersistentHashSet, *f);
+        f = create_native_function3<persistent_tree_map_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::PersistentTreeMap, *f);
+        f = create_native_function3<persistent_tree_set_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::PersistentTreeSet, *f);
+        f = create_native_function3<string_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::UTF8String, *f);
+        f = create_native_function3<stack_seq_reduce, &COLL_REDUCE>();
+        define_method(COLL_REDUCE, *type::StackSeq, *f);
+        f = create_native_function1<create_reduced, &REDUCED>();
+        define(REDUCED, *f);
+        f = create_native_function1<is_reduced, &REDUCED_Q>();
+        define(REDUCED_Q, *f);
+
         define_multimethod(COUNT, *first_type, undefined);
         f = create_native_function1<WrapUInt32Fn<get_array_map_size>::fn, &COUNT>();
         define_method(COUNT, *type::ArrayMap, *f);
@@ -1915,6 +2452,12 @@ struct Initialize
         define_method(COUNT, *type::ArraySet, *f);
         f = create_native_function1<WrapInt64Fn<get_persistent_hash_set_size>::fn, &COUNT>();
         define_method(COUNT, *type::PersistentHashSet, *f);
+        f = create_native_function1<WrapInt64Fn<get_persistent_tree_map_size>::fn, &COUNT>();
+        define_method(COUNT, *type::PersistentTreeMap, *f);
+        f = create_native_function1<WrapInt64Fn<get_persistent_tree_set_size>::fn, &COUNT>();
+        define_method(COUNT, *type::PersistentTreeSet, *f);
+        f = create_native_function1<WrapInt64Fn<get_persistent_queue_size>::fn, &COUNT>();
+        define_method(COUNT, *type::PersistentQueue, *f);
         f = create_native_function1<WrapInt64Fn<get_list_size>::fn, &COUNT>();
         define_method(COUNT, *type::List, *f);
         f = create_native_function1<cons_size, &COUNT>();
@@ -1923,12 +2466,32 @@ struct Initialize
         define_method(COUNT, *type::Sequence, *f);
         f = create_native_function1<WrapUInt32Fn<get_array_size>::fn, &COUNT>();
         define_method(COUNT, *type::Array, *f);
+        f = create_native_function1<WrapInt64Fn<get_vector_size>::fn, &COUNT>();
+        define_method(COUNT, *type::Vector, *f);
         f = create_native_function1<WrapInt64Fn<get_byte_array_size>::fn, &COUNT>();
         define_method(COUNT, *type::ByteArray, *f);
+        f = create_native_function1<WrapInt64Fn<get_typed_array_size>::fn, &COUNT>();
+        define_method(COUNT, *type::Int64Array, *f);
+        define_method(COUNT, *type::Float64Array, *f);
         f = create_native_function1<WrapInt64Fn<get_transient_array_size>::fn, &COUNT>();
         define_method(COUNT, *type::TransientArray, *f);
+        f = create_native_function1<WrapInt64Fn<get_transient_vector_size>::fn, &COUNT>();
+        define_method(COUNT, *type::TransientVector, *f);
         f = create_native_function1<WrapInt64Fn<get_transient_byte_array_size>::fn, &COUNT>();
         define_method(COUNT, *type::TransientByteArray, *f);
+        f = create_native_function1<WrapInt64Fn<get_transient_typed_array_size>::fn, &COUNT>();
+        define_method(COUNT, *type::TransientInt64Array, *f);
+        define_method(COUNT, *type::TransientFloat64Array, *f);
+        f = create_native_function1<WrapInt64Fn<get_transient_hash_map_size>::fn, &COUNT>();
+        define_method(COUNT, *type::TransientHashMap, *f);
+        f = create_native_function1<WrapInt64Fn<get_transient_hash_set_size>::fn, &COUNT>();
+        define_method(COUNT, *type::TransientHashSet, *f);
+        f = create_native_function1<WrapInt64Fn<get_transient_tree_map_size>::fn, &COUNT>();
+        define_method(COUNT, *type::TransientTreeMap, *f);
+        f = create_native_function1<WrapInt64Fn<get_transient_tree_set_size>::fn, &COUNT>();
+        define_method(COUNT, *type::TransientTreeSet, *f);
+        f = create_native_function1<WrapUInt32Fn<get_stack_seq_size>::fn, &COUNT>();
+        define_method(COUNT, *type::StackSeq, *f);
         f = create_native_function1<WrapUInt32Fn<get_string_len>::fn, &COUNT>();
         define_method(COUNT, *type::UTF8String, *f);
         f = create_native_function1<nil_count, &COUNT>();
@@ -1948,17 +2511,47 @@ struct Initialize
         f = create_native_function2or3<persistent_hash_set_get, persistent_hash_set_get, &GET>();
         define_method(GET, *type::PersistentHashSet, *f);
 
+        f = create_native_function2or3<transient_hash_map_get, transient_hash_map_get, &GET>();
+        define_method(GET, *type::TransientHashMap, *f);
+
+        f = create_native_function2or3<transient_hash_set_get, transient_hash_set_get, &GET>();
+        define_method(GET, *type::TransientHashSet, *f);
+
+        f = create_native_function2or3<persistent_tree_map_get, persistent_tree_map_get, &GET>();
+        define_method(GET, *type::PersistentTreeMap, *f);
+
+        f = create_native_function2or3<persistent_tree_set_get, persistent_tree_set_get, &GET>();
+        define_method(GET, *type::PersistentTreeSet, *f);
+
+        f = create_native_function2or3<transient_tree_map_get, transient_tree_map_get, &GET>();
+        define_method(GET, *type::TransientTreeMap, *f);
+
+        f = create_native_function2or3<transient_tree_set_get, transient_tree_set_get, &GET>();
+        define_method(GET, *type::TransientTreeSet, *f);
+
         f = create_native_function2<array_get, &GET>();
         define_method(GET, *type::Array, *f);
 
         f = create_native_function2<transient_array_get, &GET>();
         define_method(GET, *type::TransientArray, *f);
 
+        f = create_native_function2<vector_get, &GET>();
+        define_method(GET, *type::Vector, *f);
+
+        f = create_native_function2<transient_vector_get, &GET>();
+        define_method(GET, *type::TransientVector, *f);
+
         f = create_native_function2<byte_array_get, &GET>();
         define_method(GET, *type::ByteArray, *f);
 
         f = create_native_function2<transient_byte_array_get, &GET>();
         define_method(GET, *type::TransientByteArray, *f);
+        f = create_native_function2<typed_array_get, &GET>();
+        define_method(GET, *type::Int64Array, *f);
+        define_method(GET, *type::Float64Array, *f);
+        f = create_native_function2<transient_typed_array_get, &GET>();
+        define_method(GET, *type::TransientInt64Array, *f);
+        define_method(GET, *type::TransientFloat64Array, *f);
 
         f = create_native_function2or3<nil_get, nil_get, &GET>();
         define_method(GET, nil, *f);
@@ -1980,16 +2573,40 @@ struct Initialize
         f = create_native_function2<persistent_hash_set_contains, &CONTAINS>();
         define_method(CONTAINS, *type::PersistentHashSet, *f);
 
+        f = create_native_function2<transient_hash_map_contains, &CONTAINS>();
+        define_method(CONTAINS, *type::TransientHashMap, *f);
+
+        f = create_native_function2<transient_hash_set_contains, &CONTAINS>();
+        define_method(CONTAINS, *type::TransientHashSet, *f);
+
+        f = create_native_function2<persistent_tree_map_contains, &CONTAINS>();
+        define_method(CONTAINS, *type::PersistentTreeMap, *f);
+
+        f = create_native_function2<persistent_tree_set_contains, &CONTAINS>();
+        define_method(CONTAINS, *type::PersistentTreeSet, *f);
+
+        f = create_native_function2<transient_tree_map_contains, &CONTAINS>();
+        define_method(CONTAINS, *type::TransientTreeMap, *f);
+
+        f = create_native_function2<transient_tree_set_contains, &CONTAINS>();
+        define_method(CONTAINS, *type::TransientTreeSet, *f);
+
         f = create_native_function2<nil_contains, &CONTAINS>();
         define_method(CONTAINS, nil, *f);
 
         define_multimethod(CONJ, *first_type, undefined);
 
-        f = create_native_function2<array_conj, &CONJ>();
+        f = create_native_function2<array_vector_conj, &CONJ>();
         define_method(CONJ, *type::Array, *f);
 
+        f = create_native_function2<vector_conj, &CONJ>();
+        define_method(CONJ, *type::Vector, *f);
+
         f = create_native_function2<byte_array_conj, &CONJ>();
         define_method(CONJ, *type::ByteArray, *f);
+        f = create_native_function2<typed_array_conj, &CONJ>();
+        define_method(CONJ, *type::Int64Array, *f);
+        define_method(CONJ, *type::Float64Array, *f);
 
         f = create_native_function2<cons_conj, &CONJ>();
         define_method(CONJ, *type::ArraySeq, *f);
@@ -1999,6 +2616,21 @@ struct Initialize
         f = create_native_function2<persistent_hash_set_conj, &CONJ>();
         define_method(CONJ, *type::PersistentHashSet, *f);
 
+        f = create_native_function2<persistent_tree_set_conj, &CONJ>();
+        define_method(CONJ, *type::PersistentTreeSet, *f);
+
+        f = create_native_function2<MapConjFn<map_assoc>::fn, &CONJ>();
+        define_method(CONJ, *type::ArrayMap, *f);
+
+        f = create_native_function2<MapConjFn<persistent_hash_map_assoc>::fn, &CONJ>();
+        define_method(CONJ, *type::PersistentHashMap, *f);
+
+        f = create_native_function2<MapConjFn<persistent_tree_map_assoc>::fn, &CONJ>();
+        define_method(CONJ, *type::PersistentTreeMap, *f);
+
+        f = create_native_function2<persistent_queue_conj, &CONJ>();
+        define_method(CONJ, *type::PersistentQueue, *f);
+
         f = create_native_function2<list_conj, &CONJ>();
         define_method(CONJ, *type::List, *f);
 
@@ -2027,12 +2659,31 @@ struct Initialize
         f = create_native_function3<persistent_hash_map_assoc, &ASSOC>();
         define_method(ASSOC, *type::PersistentHashMap, *f);
 
+        derive(*type::PersistentTreeMap, *type::PersistentMap);
+        f = create_native_function3<persistent_tree_map_assoc, &ASSOC>();
+        define_method(ASSOC, *type::PersistentTreeMap, *f);
+
+        f = create_native_function3<array_assoc, &ASSOC>();
+        define_method(ASSOC, *type::Array, *f);
+
+        f = create_native_function3<vector_assoc, &ASSOC>();
+        define_method(ASSOC, *type::Vector, *f);
+
         define_multimethod(ASSOC_E, *first_type, undefined);
 
         f = create_native_function3<transient_array_assoc, &ASSOC_E>();
         define_method(ASSOC_E, *type::TransientArray, *f);
+        f = create_native_function3<transient_vector_assoc, &ASSOC_E>();
+        define_method(ASSOC_E, *type::TransientVector, *f);
         f = create_native_function3<transient_byte_array_assoc, &ASSOC_E>();
         define_method(ASSOC_E, *type::TransientByteArray, *f);
+        f = create_native_function3<transient_typed_array_assoc, &ASSOC_E>();
+        define_method(ASSOC_E, *type::TransientInt64Array, *f);
+        define_method(ASSOC_E, *type::TransientFloat64Array, *f);
+        f = create_native_function3<transient_hash_map_assoc, &ASSOC_E>();
+        define_method(ASSOC_E, *type::TransientHashMap, *f);
+        f = create_native_function3<transient_tree_map_assoc, &ASSOC_E>();
+        define_method(ASSOC_E, *type::TransientTreeMap, *f);
 
         f = create_native_function3<nil_assoc, &ASSOC>();
         define_method(ASSOC, nil, *f);
@@ -2045,9 +2696,20 @@ struct Initialize
         f = create_native_function2<persistent_hash_map_dissoc, &DISSOC>();
         define_method(DISSOC, *type::PersistentHashMap, *f);
 
+        f = create_native_function2<persistent_tree_map_dissoc, &DISSOC>();
+        define_method(DISSOC, *type::PersistentTreeMap, *f);
+
         f = create_native_function2<nil_dissoc, &DISSOC>();
         define_method(DISSOC, nil, *f);
 
+        define_multimethod(DISSOC_E, *first_type, undefined);
+
+        f = create_native_function2<transient_hash_map_dissoc, &DISSOC_E>();
+        define_method(DISSOC_E, *type::TransientHashMap, *f);
+
+        f = create_native_function2<transient_tree_map_dissoc, &DISSOC_E>();
+        define_method(DISSOC_E, *type::TransientTreeMap, *f);
+
         f = create_native_function0<create_array_map, &ARRAY_MAP>();
         define(ARRAY_MAP, *f);
 
@@ -2077,6 +2739,14 @@ struct Initialize
         f = create_native_function2or3<persistent_hash_map_get, persistent_hash_map_get, &OBJ_CALL>();
         define_method(OBJ_CALL, *type::PersistentHashMap, *f);
 
+        derive(*type::PersistentTreeMap, *type::Callable);
+        f = create_native_function2or3<persistent_tree_map_get, persistent_tree_map_get, &OBJ_CALL>();
+        define_method(OBJ_CALL, *type::PersistentTreeMap, *f);
+
+        derive(*type::PersistentTreeSet, *type::Callable);
+        f = create_native_function2or3<persistent_tree_set_get, persistent_tree_set_get, &OBJ_CALL>();
+        define_method(OBJ_CALL, *type::PersistentTreeSet, *f);
+
         derive(*type::Keyword, *type::Callable);
         f = create_native_function2<keyword_get, &KEYWORD_TYPE_NAME>();
         define_method(OBJ_CALL, *type::Keyword, *f);
@@ -2085,6 +2755,10 @@ struct Initialize
         f = create_native_function2<array_call, &OBJ_CALL>();
         define_method(OBJ_CALL, *type::Array, *f);
 
+        derive(*type::Vector, *type::Callable);
+        f = create_native_function2<vector_call, &OBJ_CALL>();
+        define_method(OBJ_CALL, *type::Vector, *f);
+
         derive(*type::ByteArray, *type::Callable);
         f = create_native_function2<byte_array_call, &OBJ_CALL>();
         define_method(OBJ_CALL, *type::ByteArray, *f);
@@ -2093,9 +2767,27 @@ struct Initialize
         f = create_native_function2<transient_array_call, &OBJ_CALL>();
         define_method(OBJ_CALL, *type::TransientArray, *f);
 
+        derive(*type::TransientVector, *type::Callable);
+        f = create_native_function2<transient_vector_call, &OBJ_CALL>();
+        define_method(OBJ_CALL, *type::TransientVector, *f);
+
         derive(*type::TransientByteArray, *type::Callable);
         f = create_native_function2<transient_byte_array_call, &OBJ_CALL>();
         define_method(OBJ_CALL, *type::TransientByteArray, *f);
+        derive(*type::Int64Array, *type::Callable);
+        derive(*type::Float64Array, *type::Callable);
+        f = create_native_function2<typed_array_call, &OBJ_CALL>();
+        define_method(OBJ_CALL, *type::Int64Array, *f);
+        define_method(OBJ_CALL, *type::Float64Array, *f);
+        derive(*type::TransientInt64Array, *type::Callable);
+        derive(*type::TransientFloat64Array, *type::Callable);
+        f = create_native_function2<transient_typed_array_call, &OBJ_CALL>();
+        define_method(OBJ_CALL, *type::TransientInt64Array, *f);
+        define_method(OBJ_CALL, *type::TransientFloat64Array, *f);
+
+        derive(*type::TransientHashMap, *type::Callable);
+        f = create_native_function2or3<transient_hash_map_get, transient_hash_map_get, &OBJ_CALL>();
+        define_method(OBJ_CALL, *type::TransientHashMap, *f);
 
         derive(*type::CFunction, *type::Callable);
         f = create_native_function(call_c_function, OBJ_CALL);
@@ -2125,12 +2817,38 @@ struct Initialize
         define_seq_eq(*type::Array, *type::ByteArray);
         define_seq_eq(*type::Array, *type::List);
         define_seq_eq(*type::Array, *type::Sequence);
+        define_seq_eq(*type::Vector, *type::Vector);
+        define_seq_eq(*type::Vector, *type::Array);
+        define_seq_eq(*type::Vector, *type::ByteArray);
+        define_seq_eq(*type::Vector, *type::List);
+        define_seq_eq(*type::Vector, *type::Sequence);
         define_seq_eq(*type::ByteArray, *type::ByteArray);
         define_seq_eq(*type::ByteArray, *type::List);
         define_seq_eq(*type::ByteArray, *type::Sequence);
         define_seq_eq(*type::Sequence, *type::List);
         define_seq_eq(*type::Sequence, *type::Sequence);
         define_seq_eq(*type::List, *type::List);
+        define_seq_eq(*type::PersistentQueue, *type::PersistentQueue);
+        define_seq_eq(*type::PersistentQueue, *type::Array);
+        define_seq_eq(*type::PersistentQueue, *type::Vector);
+        define_seq_eq(*type::PersistentQueue, *type::ByteArray);
+        define_seq_eq(*type::PersistentQueue, *type::List);
+        define_seq_eq(*type::PersistentQueue, *type::Sequence);
+        define_seq_eq(*type::Int64Array, *type::Int64Array);
+        define_seq_eq(*type::Int64Array, *type::Float64Array);
+        define_seq_eq(*type::Float64Array, *type::Float64Array);
+        define_seq_eq(*type::Int64Array, *type::Array);
+        define_seq_eq(*type::Int64Array, *type::Vector);
+        define_seq_eq(*type::Int64Array, *type::ByteArray);
+        define_seq_eq(*type::Int64Array, *type::PersistentQueue);
+        define_seq_eq(*type::Int64Array, *type::List);
+        define_seq_eq(*type::Int64Array, *type::Sequence);
+        define_seq_eq(*type::Float64Array, *type::Array);
+        define_seq_eq(*type::Float64Array, *type::Vector);
+        define_seq_eq(*type::Float64Array, *type::ByteArray);
+        define_seq_eq(*type::Float64Array, *type::PersistentQueue);
+        define_seq_eq(*type::Float64Array, *type::List);
+        define_seq_eq(*type::Float64Array, *type::Sequence);
 
         std::array<Value, 2> two_array_sets{{*type::ArraySet, *type::ArraySet}};
         v = create_array(two_array_sets.data(), two_array_sets.size());
@@ -2155,25 +2873,34 @@ struct Initialize
         f = create_native_function2<are_maps_equal, &OBJ_EQ>();
         define_method(OBJ_EQ, *v, *f);
 
+        std::array<Value, 2> two_sets{{*type::PersistentSet, *type::PersistentSet}};
+        v = create_array(two_sets.data(), two_sets.size());
+        f = create_native_function2<are_sets_equal, &OBJ_EQ>();
+        define_method(OBJ_EQ, *v, *f);
+
         define(PRINT_READABLY, TRUE, *DYNAMIC_META);
 
         define_multimethod(PR_STR_OBJ, *first_type, nil);
 
-        f = create_native_function1<pr_str_array, &PR_STR_OBJ>();
+        f = create_native_function(pr_str_array, PR_STR_OBJ);
         define_method(PR_STR_OBJ, *type::Array, *f);
-        f = create_native_function1<pr_str_array_set, &PR_STR_OBJ>();
+        f = create_native_function(pr_str_array_set, PR_STR_OBJ);
         define_method(PR_STR_OBJ, *type::ArraySet, *f);
-        f = create_native_function1<pr_str_persistent_hash_set, &PR_STR_OBJ>();
+        f = create_native_function(pr_str_persistent_hash_set, PR_STR_OBJ);
         define_method(PR_STR_OBJ, *type::PersistentHashSet, *f);
-        f = create_native_function1<pr_str_array_map, &PR_STR_OBJ>();
+        f = create_native_function(pr_str_array_map, PR_STR_OBJ);
         define_method(PR_STR_OBJ, *type::ArrayMap, *f);
-        f = create_native_function1<pr_str_persistent_hash_map, &PR_STR_OBJ>();
+        f = create_native_function(pr_str_persistent_hash_map, PR_STR_OBJ);
         define_method(PR_STR_OBJ, *type::PersistentHashMap, *f);
-        f = create_native_function1<pr_str_seqable, &PR_STR_OBJ>();
+        f = create_native_function(pr_str_persistent_tree_set, PR_STR_OBJ);
+        define_method(PR_STR_OBJ, *type::PersistentTreeSet, *f);
+        f = create_native_function(pr_str_persistent_tree_map, PR_STR_OBJ);
+        define_method(PR_STR_OBJ, *type::PersistentTreeMap, *f);
+        f = create_native_function(pr_str_seqable, PR_STR_OBJ);
         define_method(PR_STR_OBJ, *type::Seqable, *f);
-        f = create_native_function1<pr_str_vector, &PR_STR_OBJ>();
+        f = create_native_function(pr_str_vector, PR_STR_OBJ);
         define_method(PR_STR_OBJ, *type::PersistentVector, *f);
-        f = create_native_function1<pr_str_object, &PR_STR_OBJ>();
+        f = create_native_function(pr_str_object, PR_STR_OBJ);
         define_method(PR_STR_OBJ, nil, *f);
 
         f = create_native_function1<pr_str_var, &PR_STR_OBJ>();
@@ -2215,6 +2942,27 @@ struct Initialize
         f = create_native_function1<read, &READ_STRING>();
         define(READ_STRING, *f);
 
+        f = create_native_function1<create_reader, &READER>();
+        define(READER, *f);
+
+        f = create_native_function2<read_next, &READ>();
+        define(READ, *f);
+
+        f = create_native_function1<close_reader, &CLOSE>();
+        define(CLOSE, *f);
+
+        f = create_native_function1or2<serialize, serialize, &SERIALIZE>();
+        define(SERIALIZE, *f);
+
+        f = create_native_function2or3<serialize_to_file, serialize_to_file, &SERIALIZE_TO_FILE>();
+        define(SERIALIZE_TO_FILE, *f);
+
+        f = create_native_function1<deserialize, &DESERIALIZE>();
+        define(DESERIALIZE, *f);
+
+        f = create_native_function1<deserialize_file, &DESERIALIZE_FILE>();
+        define(DESERIALIZE_FILE, *f);
+
         f = create_native_function1<load, &LOAD_STRING>();
         define(LOAD_STRING, *f);
 
@@ -2233,6 +2981,9 @@ struct Initialize
         f = create_native_function1<get_var_value, &DEREF>();
         define_method(DEREF, *type::Var, *f);
 
+        f = create_native_function1<reduced_deref, &DEREF>();
+        define_method(DEREF, *type::Reduced, *f);
+
         define_multimethod(RESET, *first_type, nil);
         f = create_native_function2<atom_reset, &RESET>();
         define_method(RESET, *type::Atom, *f);
@@ -2243,7 +2994,7 @@ struct Initialize
         f = create_native_function(apply_wrapped, APPLY);
         define(APPLY, *f);
 
-        f = create_native_function1<pr_str, &PR_STR>();
+        f = create_native_function(pr_str_values, PR_STR);
         define(PR_STR, *f);
 
         f = create_native_function(pr, create_symbol("cleo.core", "pr"));
@@ -2306,31 +3057,81 @@ struct Initialize
 
         define_multimethod(CONJ_E, *first_type, undefined);
 
-        define_function(TRANSIENT_VECTOR, create_native_function1<transient_array, &TRANSIENT_VECTOR>(), *CONST_META);
-        define_function(PERSISTENT_VECTOR, create_native_function1<transient_array_persistent, &PERSISTENT_VECTOR>(), *CONST_META);
-        define_function(TRANSIENT_VECTOR_ASSOC, create_native_function3<transient_array_assoc, &TRANSIENT_VECTOR_ASSOC>(), *CONST_META);
+        define_function(TRANSIENT_VECTOR, create_native_function1<transient_vector_literal, &TRANSIENT_VECTOR>(), *CONST_META);
+        define_function(PERSISTENT_VECTOR, create_native_function1<persistent_vector_literal, &PERSISTENT_VECTOR>(), *CONST_META);
+        define_function(TRANSIENT_VECTOR_ASSOC, create_native_function3<transient_vector_literal_assoc, &TRANSIENT_VECTOR_ASSOC>(), *CONST_META);
 
         define_method(CONJ_E, *type::TransientArray, *rt::transient_array_conj);
+        f = create_native_function2<transient_vector_conj, &CONJ_E>();
+        define_method(CONJ_E, *type::TransientVector, *f);
         f = create_native_function2<transient_byte_array_conj, &CONJ_E>();
         define_method(CONJ_E, *type::TransientByteArray, *f);
+        f = create_native_function2<transient_typed_array_conj, &CONJ_E>();
+        define_method(CONJ_E, *type::TransientInt64Array, *f);
+        define_method(CONJ_E, *type::TransientFloat64Array, *f);
+        f = create_native_function2<transient_hash_set_conj, &CONJ_E>();
+        define_method(CONJ_E, *type::TransientHashSet, *f);
+        f = create_native_function2<transient_tree_set_conj, &CONJ_E>();
+        define_method(CONJ_E, *type::TransientTreeSet, *f);
+        f = create_native_function2<MapConjFn<transient_hash_map_assoc>::fn, &CONJ_E>();
+        define_method(CONJ_E, *type::TransientHashMap, *f);
+        f = create_native_function2<MapConjFn<transient_tree_map_assoc>::fn, &CONJ_E>();
+        define_method(CONJ_E, *type::TransientTreeMap, *f);
 
         define_multimethod(POP_E, *first_type, undefined);
 
         define_method(POP_E, *type::TransientArray, *rt::transient_array_pop);
+        f = create_native_function1<transient_vector_pop, &POP_E>();
+        define_method(POP_E, *type::TransientVector, *f);
         f = create_native_function1<transient_byte_array_pop, &POP_E>();
         define_method(POP_E, *type::TransientByteArray, *f);
+        f = create_native_function1<transient_typed_array_pop, &POP_E>();
+        define_method(POP_E, *type::TransientInt64Array, *f);
+        define_method(POP_E, *type::TransientFloat64Array, *f);
 
         define_multimethod(TRANSIENT, *first_type, undefined);
 
         define_method(TRANSIENT, *type::Array, *rt::transient_array);
+        f = create_native_function1<transient_vector, &TRANSIENT>();
+        define_method(TRANSIENT, *type::Vector, *f);
         f = create_native_function1<transient_byte_array, &TRANSIENT>();
         define_method(TRANSIENT, *type::ByteArray, *f);
+        f = create_native_function1<transient_typed_array, &TRANSIENT>();
+        define_method(TRANSIENT, *type::Int64Array, *f);
+        define_method(TRANSIENT, *type::Float64Array, *f);
+        f = create_native_function1<array_map_to_transient_hash_map, &TRANSIENT>();
+        define_method(TRANSIENT, *type::ArrayMap, *f);
+        f = create_native_function1<transient_hash_map, &TRANSIENT>();
+        define_method(TRANSIENT, *type::PersistentHashMap, *f);
+        f = create_native_function1<array_set_to_transient_hash_set, &TRANSIENT>();
+        define_method(TRANSIENT, *type::ArraySet, *f);
+        f = create_native_function1<transient_hash_set, &TRANSIENT>();
+        define_method(TRANSIENT, *type::PersistentHashSet, *f);
+        f = create_native_function1<transient_tree_map, &TRANSIENT>();
+        define_method(TRANSIENT, *type::PersistentTreeMap, *f);
+        f = create_native_function1<transient_tree_set, &TRANSIENT>();
+        define_method(TRANSIENT, *type::PersistentTreeSet, *f);
 
         define_multimethod(PERSISTENT, *first_type, undefined);
 
         define_method(PERSISTENT, *type::TransientArray, *rt::transient_array_persistent);
+        f = create_native_function1<transient_vector_persistent, &PERSISTENT>();
+        define_method(PERSISTENT, *type::TransientVector, *f);
         f = create_native_function1<transient_byte_array_persistent, &PERSISTENT>();
         define_method(PERSISTENT, *type::TransientByteArray, *f);
+        f = create_native_function1<transient_typed_array_persistent, &PERSISTENT>();
+        define_method(PERSISTENT, *type::TransientInt64Array, *f);
+        define_method(PERSISTENT, *type::TransientFloat64Array, *f);
+        f = create_native_function1<string_builder_persistent, &PERSISTENT>();
+        define_method(PERSISTENT, *type::StringBuilder, *f);
+        f = create_native_function1<transient_hash_map_persistent, &PERSISTENT>();
+        define_method(PERSISTENT, *type::TransientHashMap, *f);
+        f = create_native_function1<transient_hash_set_persistent, &PERSISTENT>();
+        define_method(PERSISTENT, *type::TransientHashSet, *f);
+        f = create_native_function1<transient_tree_map_persistent, &PERSISTENT>();
+        define_method(PERSISTENT, *type::TransientTreeMap, *f);
+        f = create_native_function1<transient_tree_set_persistent, &PERSISTENT>();
+        define_method(PERSISTENT, *type::TransientTreeSet, *f);
 
         define_function(DEFMULTI, create_native_function3<defmulti, &DEFMULTI>());
         define_function(DEFMETHOD, create_native_function3<defmethod, &DEFMETHOD>());
@@ -2349,7 +3150,20 @@ struct Initialize
         define_function(START_PROFILING, create_native_function0<prof::start, &START_PROFILING>());
         define_function(FINISH_PROFILING, create_native_function0<prof::finish, &FINISH_PROFILING>());
 
+        define_function(START_VM_STATS, create_native_function0<vm::stats::start, &START_VM_STATS>());
+        define_function(STOP_VM_STATS, create_native_function0<vm::stats::stop, &STOP_VM_STATS>());
+        define_function(VM_STATS, create_native_function0<vm::stats::get, &VM_STATS>());
+
         define_function(STR_STARTS_WITH, create_native_function2<str_starts_with, &STR_STARTS_WITH>());
+        define_function(INDEX_OF, create_native_function2or3<string_index_of, string_index_of, &INDEX_OF>());
+        define_function(LAST_INDEX_OF, create_native_function2or3<string_last_index_of, string_last_index_of, &LAST_INDEX_OF>());
+        define_function(INCLUDES, create_native_function2<string_includes, &INCLUDES>());
+        define_function(SPLIT, create_native_function2<string_split, &SPLIT>());
+        define_function(REPLACE, create_native_function3<string_replace, &REPLACE>());
+        define_function(JOIN, create_native_function1or2<string_join, string_join, &JOIN>());
+        define_function(TRIM, create_native_function1<string_trim, &TRIM>());
+        define_function(LOWER_CASE, create_native_function1<string_lower_case, &LOWER_CASE>());
+        define_function(UPPER_CASE, create_native_function1<string_upper_case, &UPPER_CASE>());
 
         define_function(SORT_E, create_native_function2<sort_transient, &SORT_E>());
 
@@ -6,14 +6,17 @@
 #include "memory.hpp"
 #include "vm.hpp"
 #include "error.hpp"
+#include "intern_table.hpp"
 #include <unordered_map>
 #include <unordered_set>
+#include <algorithm>
 #include <string>
 #include <array>
 #include <vector>
 #include <cassert>
 #include <ostream>
 #include <memory>
+#include <limits>
 #include <thread>
 #include <atomic>
 
@@ -98,6 +101,28 @@ private:
     const std::size_t int_stack_size;
 };
 
+// Multiplies the number of allocations between collections for its lifetime.
+// For building large values whose allocations mostly stay reachable, so that
+// collections do not mark the growing value over and over again, while the
+// garbage made on the way is still collected.
+class ScaleGCIntervalGuard
+{
+public:
+    explicit ScaleGCIntervalGuard(unsigned scale) : frequency(gc_frequency)
+    {
+        auto max = std::numeric_limits<unsigned>::max();
+        gc_frequency = frequency > max / scale ? max : frequency * scale;
+    }
+    ScaleGCIntervalGuard(const ScaleGCIntervalGuard& ) = delete;
+    ~ScaleGCIntervalGuard()
+    {
+        gc_frequency = frequency;
+        gc_counter = std::min(gc_counter, frequency);
+    }
+private:
+    const unsigned frequency;
+};
+
 class Root
 {
 public:
@@ -170,8 +195,8 @@ private:
     Value var;
 };
 
-extern std::unordered_map<std::string, std::unordered_map<std::string, Value>> symbols;
-extern std::unordered_map<std::string, std::unordered_map<std::string, Value>> keywords;
+extern InternTable symbols;
+extern InternTable keywords;
 
 extern std::unordered_map<Value, Value, std::hash<Value>, StdIs> vars;
 
@@ -297,9 +322,20 @@ extern const ConstRoot LazySeq;
 extern const ConstRoot Array;
 extern const ConstRoot TransientArray;
 extern const ConstRoot ArraySeq;
+extern const ConstRoot Vector;
+extern const ConstRoot TransientVector;
+extern const ConstRoot VectorNode;
+extern const ConstRoot VectorSeq;
 extern const ConstRoot ByteArray;
 extern const ConstRoot TransientByteArray;
 extern const ConstRoot ByteArraySeq;
+extern const ConstRoot Int64Array;
+extern const ConstRoot Float64Array;
+extern const ConstRoot TransientInt64Array;
+extern const ConstRoot TransientFloat64Array;
+extern const ConstRoot TypedArraySeq;
+extern const ConstRoot StringBuilder;
+extern const ConstRoot Reader;
 extern const ConstRoot ArrayMap;
 extern const ConstRoot ArrayMapSeq;
 extern const ConstRoot ArraySet;
@@ -308,12 +344,15 @@ extern const ConstRoot Hierarchy;
 extern const ConstRoot Multimethod;
 extern const ConstRoot Seqable;
 extern const ConstRoot Sequence;
+extern const ConstRoot ChunkedSeq;
+extern const ConstRoot ChunkedCons;
 extern const ConstRoot Callable;
 extern const ConstRoot BytecodeFn;
 extern const ConstRoot OpenBytecodeFn;
 extern const ConstRoot BytecodeFnBody;
 extern const ConstRoot BytecodeFnExceptionTable;
 extern const ConstRoot Atom;
+extern const ConstRoot Reduced;
 extern const ConstRoot PersistentMap;
 extern const ConstRoot PersistentHashMap;
 extern const ConstRoot PersistentHashMapSeq;
@@ -325,6 +364,19 @@ extern const ConstRoot PersistentHashSetSeq;
 extern const ConstRoot PersistentHashSetSeqParent;
 extern const ConstRoot PersistentHashSetCollisionNode;
 extern const ConstRoot PersistentHashSetArrayNode;
+extern const ConstRoot TransientHashMap;
+extern const ConstRoot TransientHashSet;
+extern const ConstRoot Sorted;
+extern const ConstRoot PersistentQueue;
+extern const ConstRoot PersistentQueueSeq;
+extern const ConstRoot PersistentTreeMap;
+extern const ConstRoot PersistentTreeMapBranch;
+extern const ConstRoot PersistentTreeMapLeaf;
+extern const ConstRoot PersistentTreeSeq;
+extern const ConstRoot PersistentTreeSeqParent;
+extern const ConstRoot PersistentTreeSet;
+extern const ConstRoot TransientTreeMap;
+extern const ConstRoot TransientTreeSet;
 extern const ConstRoot Exception;
 extern const ConstRoot LogicException;
 extern const ConstRoot CastError;
@@ -341,6 +393,7 @@ extern const ConstRoot CompilationError;
 extern const ConstRoot StackOverflow;
 extern const ConstRoot Namespace;
 extern const ConstRoot UTF8StringSeq;
+extern const ConstRoot StackSeq;
 }
 
 namespace clib
@@ -383,6 +436,7 @@ extern const StaticVar first;
 extern const StaticVar next;
 extern const StaticVar seq;
 extern const StaticVar count;
+extern const StaticVar coll_reduce;
 extern const StaticVar get;
 extern const StaticVar contains;
 extern const StaticVar assoc;
@@ -408,6 +462,7 @@ inline Value get_value_type(Value val)
     case tag::UTF8STRING: return *type::UTF8String;
     case tag::OBJECT_TYPE: return *type::Type;
     case tag::PROTOCOL: return *type::Protocol;
+    case tag::STACK_SEQ: return *type::StackSeq;
     default: return nil;
     }
 }
@@ -1,6 +1,12 @@
 #include "hash.hpp"
 #include "global.hpp"
 #include "multimethod.hpp"
+#include "array.hpp"
+#include "array_map.hpp"
+#include "array_set.hpp"
+#include "persistent_hash_map.hpp"
+#include "persistent_hash_set.hpp"
+#include "vector.hpp"
 
 namespace cleo
 {
@@ -35,6 +41,13 @@ std::uint32_t hash_keyword(Value k)
     return std::uint32_t(hash_value(get_keyword_namespace(k)) * 31 + hash_value(get_keyword_name(k)));
 }
 
+template <Force hash(Value)>
+Int64 hash_object(Value val)
+{
+    Root h{hash(val)};
+    return get_int64_value(*h);
+}
+
 }
 
 Int64 hash_value(Value val)
@@ -61,6 +74,19 @@ Int64 hash_value(Value val)
         {
             if (val.is_nil())
                 return 0;
+            auto type = get_object_type(val);
+            if (type.is(*type::Array))
+                return hash_object<array_hash>(val);
+            if (type.is(*type::Vector))
+                return hash_object<vector_hash>(val);
+            if (type.is(*type::ArrayMap))
+                return hash_object<array_map_hash>(val);
+            if (type.is(*type::ArraySet))
+                return hash_object<array_set_hash>(val);
+            if (type.is(*type::PersistentHashMap))
+                return hash_object<persistent_hash_map_hash>(val);
+            if (type.is(*type::PersistentHashSet))
+                return hash_object<persistent_hash_set_hash>(val);
             Root h{call_multimethod1(*rt::hash_obj, val)};
             return get_int64_value(*h);
         }
@@ -0,0 +1,91 @@
+#include "intern_table.hpp"
+#include <cstring>
+
+namespace cleo
+{
+
+namespace
+{
+
+const std::size_t INITIAL_CAPACITY = 1024;
+
+std::uint64_t mix(std::uint64_t h, std::uint64_t w)
+{
+    h = (h ^ w) * 0x9e3779b97f4a7c15ull;
+    return h ^ (h >> 32);
+}
+
+std::uint64_t hash_bytes(std::uint64_t h, const char *p, std::uint32_t size)
+{
+    auto n = size;
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        h = mix(h, w);
+    }
+    std::uint64_t w = 0;
+    if (n)
+        std::memcpy(&w, p, n);
+    return mix(h, w ^ (std::uint64_t(size) << 56));
+}
+
+}
+
+InternTable::InternTable() : entries(INITIAL_CAPACITY) { }
+
+std::uint32_t InternTable::hash_key(const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size)
+{
+    return hash_bytes(hash_bytes(0, ns, ns_size), name, name_size);
+}
+
+bool InternTable::matches(const Entry& e, std::uint32_t hash, const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size) const
+{
+    return
+        e.hash == hash && e.ns_size == ns_size && e.name_size == name_size &&
+        (ns_size == 0 || std::memcmp(keys.data() + e.offset, ns, ns_size) == 0) &&
+        (name_size == 0 || std::memcmp(keys.data() + e.offset + ns_size, name, name_size) == 0);
+}
+
+Value InternTable::find(const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size) const
+{
+    auto hash = hash_key(ns, ns_size, name, name_size);
+    auto mask = entries.size() - 1;
+    for (auto i = hash & mask; entries[i].val; i = (i + 1) & mask)
+        if (matches(entries[i], hash, ns, ns_size, name, name_size))
+            return entries[i].val;
+    return nil;
+}
+
+void InternTable::insert(const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size, Value val)
+{
+    if ((count + 1) * 2 > entries.size())
+        grow();
+    auto hash = hash_key(ns, ns_size, name, name_size);
+    auto mask = entries.size() - 1;
+    auto i = hash & mask;
+    while (entries[i].val)
+        i = (i + 1) & mask;
+    entries[i] = {keys.size(), hash, ns_size, name_size, val};
+    keys.insert(keys.end(), ns, ns + ns_size);
+    keys.insert(keys.end(), name, name + name_size);
+    ++count;
+}
+
+void InternTable::grow()
+{
+    std::vector<Entry> old(entries.size() * 2);
+    old.swap(entries);
+    auto mask = entries.size() - 1;
+    for (auto& e : old)
+    {
+        if (!e.val)
+            continue;
+        auto i = e.hash & mask;
+        while (entries[i].val)
+            i = (i + 1) & mask;
+        entries[i] = e;
+    }
+}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "value.hpp"
+#include <vector>
+
+namespace cleo
+{
+
+// Interned symbols or keywords keyed by namespace and name. The table uses
+// open addressing with linear probing and keeps a copy of every key in one
+// arena, so lookups take the key as pointers and sizes and never allocate.
+// An empty namespace means no namespace. Empty keys may be null.
+class InternTable
+{
+public:
+    InternTable();
+    InternTable(const InternTable& ) = delete;
+    InternTable& operator=(const InternTable& ) = delete;
+
+    Value find(const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size) const;
+    void insert(const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size, Value val);
+    std::size_t size() const { return count; }
+
+private:
+    struct Entry
+    {
+        std::size_t offset;
+        std::uint32_t hash;
+        std::uint32_t ns_size, name_size;
+        Value val;
+    };
+
+    static std::uint32_t hash_key(const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size);
+    bool matches(const Entry& e, std::uint32_t hash, const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size) const;
+    void grow();
+
+    std::vector<Entry> entries;
+    std::vector<char> keys;
+    std::size_t count = 0;
+};
+
+}
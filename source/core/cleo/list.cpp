@@ -1,5 +1,6 @@
 #include "list.hpp"
 #include "global.hpp"
+#include "reduce.hpp"
 #include <array>
 
 namespace cleo
@@ -43,4 +44,18 @@ Value list_seq(Value list)
     return get_list_size(list) == 0 ? nil : list;
 }
 
+Force list_reduce(Value list, Value f, Value init)
+{
+    Root acc{init};
+    if (get_list_size(list) == 0)
+        return *acc;
+    for (; list; list = get_list_next(list))
+    {
+        acc = reduce_step(f, *acc, get_list_first(list));
+        if (is_reduced(*acc))
+            return reduced_deref(*acc);
+    }
+    return *acc;
+}
+
 }
@@ -10,5 +10,6 @@ Value get_list_first(Value list);
 Value get_list_next(Value list);
 Force list_conj(Value list, Value elem);
 Value list_seq(Value list);
+Force list_reduce(Value list, Value f, Value init);
 
 }
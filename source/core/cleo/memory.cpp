@@ -71,6 +71,10 @@ void mark_value(Value val)
                         vals.push_back(get_object_type_field_type(val, i));
                 }
                 break;
+            case tag::UTF8STRING:
+                if (is_string_slice(val))
+                    vals.push_back(get_string_slice_parent(val));
+                break;
             default: break;
         }
     }
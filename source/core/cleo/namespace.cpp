@@ -7,6 +7,7 @@
 #include "multimethod.hpp"
 #include "persistent_hash_map.hpp"
 #include "print.hpp"
+#include "reader.hpp"
 #include <fstream>
 
 namespace cleo
@@ -203,15 +204,14 @@ Value require(Value ns, Value opts)
     if (ns != CLEO_CORE && map_contains(*namespaces, ns) && !map_get(opts, *RELOAD))
         return nil;
     std::string path = locate_source({get_string_ptr(ns_name), get_string_size(ns_name)});
-    std::ifstream f(path);
+    MappedFile f{path};
     if (!f)
     {
         Root msg{create_string("Could not locate " + path)};
         throw_exception(new_file_not_found(*msg));
     }
-    std::string source{std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
-    Root ssource{create_string(source)};
-    load(*ssource);
+    ReaderStream stream{f.data(), f.size()};
+    load(stream);
     return nil;
 }
 
@@ -1,6 +1,9 @@
 #include "persistent_hash_map.hpp"
 #include "global.hpp"
 #include "array.hpp"
+#include "error.hpp"
+#include "chunked_seq.hpp"
+#include "reduce.hpp"
 
 namespace cleo
 {
@@ -13,7 +16,13 @@ namespace cleo
 // CollisionNode:
 //   [hash | key0 value0 key1 value1 key2? value2? ...]
 // ArrayNode:
-//   [(value-map node-map) | key0? value0? key1? value1? ... node2? node1? node0?]
+//   [(value-map node-map) edit (count hash) capacity? | key0? value0? key1? value1? ... node2? node1? node0?]
+//   edit: 0 or the edit of the TransientHashMap which owns the node and can update it in place
+//   capacity: only in nodes created with an edit, number of allocated elements, so that they can grow in place
+//   count: number of keys in the subtree, hash: memoized hash of the subtree or 0 if not computed yet
+// TransientHashMap:
+//   [size edit | SENTINEL nil], [size edit | value key], [size edit | node nil]
+//   edit: 0 after persistent!
 // HashMapSeq:
 //   size 1: [[first-key first-value] nil 0 nil]
 //   size>1: [[first-key first-value] collision-node 0 #SeqParent[index array-node parent-or-nil]-or-nil]
@@ -77,14 +86,14 @@ Value collision_node_get(Value node, Value key, std::uint32_t key_hash, Value de
     return collision_node_get(node, key, def_val);
 }
 
-Force create_array_node(std::uint8_t shift, Value key0, std::uint32_t key0_hash, Value val0, std::uint32_t node_hash, Value node);
+Force create_array_node(std::uint8_t shift, Int64 edit, Value key0, std::uint32_t key0_hash, Value val0, std::uint32_t node_hash, Value node);
 
-Force collision_node_assoc(Value node, std::uint8_t shift, Value key, std::uint32_t key_hash, Value val, bool& replaced)
+Force collision_node_assoc(Value node, std::uint8_t shift, Int64 edit, Value key, std::uint32_t key_hash, Value val, bool& replaced)
 {
     assert(get_value_type(node).is(*type::PersistentHashMapCollisionNode));
     auto node_hash = get_dynamic_object_int(node, 0);
     if (key_hash != node_hash)
-        return create_array_node(shift, key, key_hash, val, node_hash, node);
+        return create_array_node(shift, edit, key, key_hash, val, node_hash, node);
     auto node_size = get_dynamic_object_size(node);
     bool should_replace = !collision_node_get(node, key, *SENTINEL).is(*SENTINEL);
     if (should_replace)
@@ -113,7 +122,7 @@ Force collision_node_assoc(Value node, std::uint8_t shift, Value key, std::uint3
     }
 }
 
-std::pair<Force, Value> collision_node_dissoc(Value node, Value key, std::uint32_t key_hash)
+std::pair<Force, Value> collision_node_dissoc(Value node, Value key, std::uint32_t key_hash, bool& removed)
 {
     assert(get_value_type(node).is(*type::PersistentHashMapCollisionNode));
     auto node_hash = get_dynamic_object_int(node, 0);
@@ -125,6 +134,7 @@ std::pair<Force, Value> collision_node_dissoc(Value node, Value key, std::uint32
         index += 2;
     if (index >= node_size)
         return {node, *SENTINEL};
+    removed = true;
     if (node_size == 4) // two KVs
         return {get_dynamic_object_element(node, 3 - index), get_dynamic_object_element(node, 2 - index)};
     Root new_node{create_object(*type::PersistentHashMapCollisionNode, &node_hash, 1, nullptr, node_size - 2)};
@@ -137,6 +147,8 @@ Value collision_node_equal(Value left, Value right)
 {
     assert(get_value_type(left).is(*type::PersistentHashMapCollisionNode));
     assert(get_value_type(right).is(*type::PersistentHashMapCollisionNode));
+    if (left.is(right))
+        return TRUE;
     auto size = get_dynamic_object_size(left);
     if (size != get_dynamic_object_size(right))
         return nil;
@@ -169,7 +181,80 @@ Int64 combine_maps(std::uint32_t value_map, std::uint32_t node_map)
     return value_map | (std::uint64_t(node_map) << 32);
 }
 
-Force create_array_node(std::uint8_t shift, Value key0, std::uint32_t key0_hash, Value val0, Value key1, std::uint32_t key1_hash, Value val1)
+std::uint32_t get_array_node_count(Value node)
+{
+    return std::uint32_t(get_dynamic_object_int(node, 2));
+}
+
+void set_array_node_count(Value node, std::uint32_t count)
+{
+    set_dynamic_object_int(node, 2, count);
+}
+
+std::uint32_t get_array_node_hash(Value node)
+{
+    return std::uint32_t(std::uint64_t(get_dynamic_object_int(node, 2)) >> 32);
+}
+
+void set_array_node_hash(Value node, std::uint32_t hash)
+{
+    set_dynamic_object_int(node, 2, get_array_node_count(node) | (std::uint64_t(hash) << 32));
+}
+
+std::uint32_t get_node_count(Value node)
+{
+    if (get_value_type(node).is(*type::PersistentHashMapCollisionNode))
+        return get_dynamic_object_size(node) / 2;
+    return get_array_node_count(node);
+}
+
+const std::uint32_t MAX_ARRAY_NODE_SIZE = 64;
+const std::uint32_t ARRAY_NODE_SLACK = 8;
+
+Force create_array_node(Int64 map, Int64 edit, std::uint32_t count, const Value *elems, std::uint32_t node_size)
+{
+    if (edit == 0)
+    {
+        std::array<Int64, 3> ints{{map, edit, count}};
+        return create_object(*type::PersistentHashMapArrayNode, ints.data(), ints.size(), elems, node_size);
+    }
+    auto capacity = std::min(node_size + ARRAY_NODE_SLACK, MAX_ARRAY_NODE_SIZE);
+    std::array<Int64, 4> ints{{map, edit, count, capacity}};
+    Root node{create_object(*type::PersistentHashMapArrayNode, ints.data(), ints.size(), nullptr, capacity)};
+    if (elems)
+        for (std::uint32_t i = 0; i < node_size; ++i)
+            set_dynamic_object_element(*node, i, elems[i]);
+    set_dynamic_object_size(*node, node_size);
+    return *node;
+}
+
+Force create_array_node(Int64 map, Int64 edit, std::uint32_t count, std::uint32_t node_size)
+{
+    return create_array_node(map, edit, count, nullptr, node_size);
+}
+
+bool is_array_node_editable(Value node, Int64 edit)
+{
+    return edit != 0 && get_dynamic_object_int(node, 1) == edit;
+}
+
+void resize_editable_array_node(Value node, std::uint32_t node_size)
+{
+    assert(node_size <= get_dynamic_object_int(node, 3));
+    set_dynamic_object_size(node, node_size);
+}
+
+Force edit_array_node(Value node, Int64 edit)
+{
+    if (is_array_node_editable(node, edit))
+        return node;
+    auto node_size = get_dynamic_object_size(node);
+    Root new_node{create_array_node(get_dynamic_object_int(node, 0), edit, get_array_node_count(node), node_size)};
+    copy_object_elements(*new_node, 0, node, 0, node_size);
+    return *new_node;
+}
+
+Force create_array_node(std::uint8_t shift, Int64 edit, Value key0, std::uint32_t key0_hash, Value val0, Value key1, std::uint32_t key1_hash, Value val1)
 {
     assert(key0_hash != key1_hash);
     auto key0_bit = map_bit(shift, key0_hash);
@@ -178,21 +263,22 @@ Force create_array_node(std::uint8_t shift, Value key0, std::uint32_t key0_hash,
     {
         std::uint32_t node_map = key0_bit;
         auto map_val = combine_maps(0, node_map);
-        Root child_node{create_array_node(shift + 5, key0, key0_hash, val0, key1, key1_hash, val1)};
-        return create_object1_1(*type::PersistentHashMapArrayNode, map_val, *child_node);
+        Root child_node{create_array_node(shift + 5, edit, key0, key0_hash, val0, key1, key1_hash, val1)};
+        std::array<Value, 1> elems{{*child_node}};
+        return create_array_node(map_val, edit, 2, elems.data(), elems.size());
     }
     else
     {
         std::uint32_t value_map = key0_bit | key1_bit;
         auto map_val = combine_maps(value_map, 0);
-        if (key0_bit < key1_bit)
-            return create_object1_4(*type::PersistentHashMapArrayNode, map_val, key0, val0, key1, val1);
-        else
-            return create_object1_4(*type::PersistentHashMapArrayNode, map_val, key1, val1, key0, val0);
+        std::array<Value, 4> elems{{key0, val0, key1, val1}};
+        if (key1_bit < key0_bit)
+            elems = {{key1, val1, key0, val0}};
+        return create_array_node(map_val, edit, 2, elems.data(), elems.size());
     }
 }
 
-Force create_array_node(std::uint8_t shift, Value key0, std::uint32_t key0_hash, Value val0, std::uint32_t node_hash, Value node)
+Force create_array_node(std::uint8_t shift, Int64 edit, Value key0, std::uint32_t key0_hash, Value val0, std::uint32_t node_hash, Value node)
 {
     assert(key0_hash != node_hash);
     auto key0_bit = map_bit(shift, key0_hash);
@@ -201,24 +287,21 @@ Force create_array_node(std::uint8_t shift, Value key0, std::uint32_t key0_hash,
     {
         std::uint32_t node_map = key0_bit;
         auto map_val = combine_maps(0, node_map);
-        Root child_node{create_array_node(shift + 5, key0, key0_hash, val0, node_hash, node)};
-        return create_object1_1(*type::PersistentHashMapArrayNode, map_val, *child_node);
+        Root child_node{create_array_node(shift + 5, edit, key0, key0_hash, val0, node_hash, node)};
+        std::array<Value, 1> elems{{*child_node}};
+        return create_array_node(map_val, edit, 1 + get_node_count(node), elems.data(), elems.size());
     }
     else
     {
         auto map_val = combine_maps(key0_bit, node_bit);
-        return create_object1_3(*type::PersistentHashMapArrayNode, map_val, key0, val0, node);
+        std::array<Value, 3> elems{{key0, val0, node}};
+        return create_array_node(map_val, edit, 1 + get_node_count(node), elems.data(), elems.size());
     }
 }
 
-Force create_array_node(Int64 map, std::uint32_t node_size)
-{
-    return create_object(*type::PersistentHashMapArrayNode, &map, 1, nullptr, node_size);
-}
-
 Force create_array_map(Value key0, std::uint32_t key0_hash, Value val0, Value key1, std::uint32_t key1_hash, Value val1)
 {
-    Root node{create_array_node(0, key0, key0_hash, val0, key1, key1_hash, val1)};
+    Root node{create_array_node(0, 0, key0, key0_hash, val0, key1, key1_hash, val1)};
     return create_map(2, *node);
 }
 
@@ -248,7 +331,7 @@ Value array_node_get(Value node, std::uint8_t shift, Value key, std::uint32_t ke
     return def_val;
 }
 
-Value array_node_assoc(Value node, std::uint8_t shift, Value key, std::uint32_t key_hash, Value val, bool& replaced)
+Force array_node_assoc(Value node, std::uint8_t shift, Int64 edit, Value key, std::uint32_t key_hash, Value val, bool& replaced)
 {
     assert(get_value_type(node).is(*type::PersistentHashMapArrayNode));
     std::uint64_t value_node_map = get_dynamic_object_int(node, 0);
@@ -257,82 +340,112 @@ Value array_node_assoc(Value node, std::uint8_t shift, Value key, std::uint32_t
     std::uint32_t key_bit = map_bit(shift, key_hash);
     auto key_index = map_key_index(value_map, key_bit);
     auto node_size = get_dynamic_object_size(node);
+    auto count = get_array_node_count(node);
     if (value_map & key_bit)
     {
         auto key0 = get_dynamic_object_element(node, key_index);
         if (key0 == key)
         {
-            Root new_node{create_array_node(value_node_map, node_size)};
+            replaced = true;
+            if (get_dynamic_object_element(node, key_index + 1).is(val))
+                return node;
 
-            copy_object_elements(*new_node, 0, node, 0, key_index);
+            Root new_node{edit_array_node(node, edit)};
             set_dynamic_object_element(*new_node, key_index, key);
             set_dynamic_object_element(*new_node, key_index + 1, val);
-            copy_object_elements(*new_node, key_index + 2, node, key_index + 2, node_size);
-
-            replaced = true;
+            set_array_node_count(*new_node, count);
             return *new_node;
         }
         else
         {
             auto new_value_map = combine_maps(value_map ^ key_bit, node_map ^ key_bit);
-            Root new_node{create_array_node(new_value_map, node_size - 1)};
             auto node_index = map_node_index(node_map, node_size, key_bit);
             auto val0 = get_dynamic_object_element(node, key_index + 1);
             std::uint32_t key0_hash = hash_value(key0);
             Root new_child{
                 (key0_hash == key_hash) ?
                 create_collision_node(key_hash, key0, val0, key, val) :
-                create_array_node(shift + 5, key0, key0_hash, val0, key, key_hash, val)};
+                create_array_node(shift + 5, edit, key0, key0_hash, val0, key, key_hash, val)};
+            replaced = false;
 
+            if (is_array_node_editable(node, edit))
+            {
+                copy_object_elements(node, key_index, node, key_index + 2, node_index + 1);
+                set_dynamic_object_element(node, node_index - 1, *new_child);
+                copy_object_elements(node, node_index, node, node_index + 1, node_size);
+                resize_editable_array_node(node, node_size - 1);
+                set_dynamic_object_int(node, 0, new_value_map);
+                set_array_node_count(node, count + 1);
+                return node;
+            }
+
+            Root new_node{create_array_node(new_value_map, edit, count + 1, node_size - 1)};
             copy_object_elements(*new_node, 0, node, 0, key_index);
             copy_object_elements(*new_node, key_index, node, key_index + 2, node_index + 1);
             set_dynamic_object_element(*new_node, node_index - 1, *new_child);
             copy_object_elements(*new_node, node_index, node, node_index + 1, node_size);
-
-            replaced = false;
             return *new_node;
         }
     }
     else if (node_map & key_bit)
     {
-        Root new_node{create_array_node(value_node_map, node_size)};
         auto node_index = map_node_index(node_map, node_size, key_bit);
         auto child_node = get_dynamic_object_element(node, node_index);
         Root new_child{
             get_value_type(child_node).is(*type::PersistentHashMapCollisionNode) ?
-            collision_node_assoc(child_node, shift + 5, key, key_hash, val, replaced) :
-            array_node_assoc(child_node, shift + 5, key, key_hash, val, replaced)};
-        copy_object_elements(*new_node, 0, node, 0, node_index);
+            collision_node_assoc(child_node, shift + 5, edit, key, key_hash, val, replaced) :
+            array_node_assoc(child_node, shift + 5, edit, key, key_hash, val, replaced)};
+        auto new_count = replaced ? count : (count + 1);
+        if (new_child->is(child_node))
+        {
+            if (is_array_node_editable(node, edit))
+                set_array_node_count(node, new_count);
+            return node;
+        }
+        Root new_node{edit_array_node(node, edit)};
         set_dynamic_object_element(*new_node, node_index, *new_child);
-        copy_object_elements(*new_node, node_index + 1, node, node_index + 1, node_size);
+        set_array_node_count(*new_node, new_count);
         return *new_node;
     }
     else
     {
         Int64 new_value_map = combine_maps(value_map | key_bit, node_map);
-        Root new_node{create_array_node(new_value_map, node_size + 2)};
+        replaced = false;
+        if (is_array_node_editable(node, edit) && node_size + 2 <= get_dynamic_object_int(node, 3))
+        {
+            resize_editable_array_node(node, node_size + 2);
+            for (auto i = node_size; i != key_index; --i)
+                set_dynamic_object_element(node, i + 1, get_dynamic_object_element(node, i - 1));
+            set_dynamic_object_element(node, key_index, key);
+            set_dynamic_object_element(node, key_index + 1, val);
+            set_dynamic_object_int(node, 0, new_value_map);
+            set_array_node_count(node, count + 1);
+            return node;
+        }
+
+        Root new_node{create_array_node(new_value_map, edit, count + 1, node_size + 2)};
         copy_object_elements(*new_node, 0, node, 0, key_index);
         set_dynamic_object_element(*new_node, key_index, key);
         set_dynamic_object_element(*new_node, key_index + 1, val);
         copy_object_elements(*new_node, key_index + 2, node, key_index, node_size);
-
-        replaced = false;
         return *new_node;
     }
 }
 
-std::pair<Force, Value> array_node_dissoc(Value node, std::uint8_t shift, Value key, std::uint32_t key_hash)
+std::pair<Force, Value> array_node_dissoc(Value node, std::uint8_t shift, Int64 edit, Value key, std::uint32_t key_hash, bool& removed)
 {
     std::uint64_t value_node_map = get_dynamic_object_int(node, 0);
     std::uint32_t value_map{static_cast<std::uint32_t>(value_node_map)};
     std::uint32_t node_map{static_cast<std::uint32_t>(value_node_map >> 32)};
     std::uint32_t key_bit = map_bit(shift, key_hash);
+    auto count = get_array_node_count(node);
     if (value_map & key_bit)
     {
         auto key_index = map_key_index(value_map, key_bit);
         auto key0 = get_dynamic_object_element(node, key_index);
         if (key0 != key)
             return {node, *SENTINEL};
+        removed = true;
         auto node_size = get_dynamic_object_size(node);
         auto value_count = popcount(value_map);
         if (value_count == 2 && node_map == 0)
@@ -344,7 +457,15 @@ std::pair<Force, Value> array_node_dissoc(Value node, std::uint8_t shift, Value
                 return {other_child_node, *SENTINEL};
         }
         auto new_value_node_map = combine_maps(value_map ^ key_bit, node_map);
-        Root new_node{create_array_node(new_value_node_map, node_size - 2)};
+        if (is_array_node_editable(node, edit))
+        {
+            copy_object_elements(node, key_index, node, key_index + 2, node_size);
+            set_dynamic_object_size(node, node_size - 2);
+            set_dynamic_object_int(node, 0, new_value_node_map);
+            set_array_node_count(node, count - 1);
+            return {node, *SENTINEL};
+        }
+        Root new_node{create_array_node(new_value_node_map, edit, count - 1, node_size - 2)};
         copy_object_elements(*new_node, 0, node, 0, key_index);
         copy_object_elements(*new_node, key_index, node, key_index + 2, node_size);
         return {*new_node, *SENTINEL};
@@ -356,17 +477,30 @@ std::pair<Force, Value> array_node_dissoc(Value node, std::uint8_t shift, Value
         auto child_node = get_dynamic_object_element(node, node_index);
         std::pair<Root, Value> new_child{
             get_value_type(child_node).is(*type::PersistentHashMapCollisionNode) ?
-            collision_node_dissoc(child_node, key, key_hash) :
-            array_node_dissoc(child_node, shift + 5, key, key_hash)};
-        if (*new_child.first == child_node)
+            collision_node_dissoc(child_node, key, key_hash, removed) :
+            array_node_dissoc(child_node, shift + 5, edit, key, key_hash, removed)};
+        if (!removed)
             return {node, *SENTINEL};
         if (!new_child.second.is(*SENTINEL))
         {
             if (value_map == 0 && node_map == key_bit)
                 return {*new_child.first, new_child.second};
             auto new_value_node_map = combine_maps(value_map ^ key_bit, node_map ^ key_bit);
-            Root new_node{create_array_node(new_value_node_map, node_size + 1)};
             auto key_index = map_key_index(value_map, key_bit);
+            if (is_array_node_editable(node, edit) && node_size + 1 <= get_dynamic_object_int(node, 3))
+            {
+                resize_editable_array_node(node, node_size + 1);
+                for (auto i = node_size; i != node_index + 1; --i)
+                    set_dynamic_object_element(node, i, get_dynamic_object_element(node, i - 1));
+                for (auto i = node_index + 1; i != key_index + 1; --i)
+                    set_dynamic_object_element(node, i, get_dynamic_object_element(node, i - 2));
+                set_dynamic_object_element(node, key_index, new_child.second);
+                set_dynamic_object_element(node, key_index + 1, *new_child.first);
+                set_dynamic_object_int(node, 0, new_value_node_map);
+                set_array_node_count(node, count - 1);
+                return {node, *SENTINEL};
+            }
+            Root new_node{create_array_node(new_value_node_map, edit, count - 1, node_size + 1)};
             copy_object_elements(*new_node, 0, node, 0, key_index);
             set_dynamic_object_element(*new_node, key_index, new_child.second);
             set_dynamic_object_element(*new_node, key_index + 1, *new_child.first);
@@ -374,10 +508,15 @@ std::pair<Force, Value> array_node_dissoc(Value node, std::uint8_t shift, Value
             copy_object_elements(*new_node, node_index + 2, node, node_index + 1, node_size);
             return {*new_node, *SENTINEL};
         }
-        Root new_node{create_array_node(value_node_map, node_size)};
-        copy_object_elements(*new_node, 0, node, 0, node_index);
+        if (new_child.first->is(child_node))
+        {
+            if (is_array_node_editable(node, edit))
+                set_array_node_count(node, count - 1);
+            return {node, *SENTINEL};
+        }
+        Root new_node{edit_array_node(node, edit)};
         set_dynamic_object_element(*new_node, node_index, *new_child.first);
-        copy_object_elements(*new_node, node_index + 1, node, node_index + 1, node_size);
+        set_array_node_count(*new_node, count - 1);
         return {*new_node, *SENTINEL};
     }
     else
@@ -388,6 +527,14 @@ Value array_node_equal(Value left, Value right)
 {
     assert(get_value_type(left).is(*type::PersistentHashMapArrayNode));
     assert(get_value_type(right).is(*type::PersistentHashMapArrayNode));
+    if (left.is(right))
+        return TRUE;
+    if (get_array_node_count(left) != get_array_node_count(right))
+        return nil;
+    auto left_hash = get_array_node_hash(left);
+    auto right_hash = get_array_node_hash(right);
+    if (left_hash != 0 && right_hash != 0 && left_hash != right_hash)
+        return nil;
 
     std::uint64_t value_node_map = get_dynamic_object_int(left, 0);
     if (std::uint64_t(get_dynamic_object_int(right, 0)) != value_node_map)
@@ -402,17 +549,59 @@ Value array_node_equal(Value left, Value right)
     {
         auto left_child = get_dynamic_object_element(left, i);
         auto right_child = get_dynamic_object_element(right, i);
+        if (left_child.is(right_child))
+            continue;
         auto left_child_type = get_object_type(left_child);
         if (!left_child_type.is(get_object_type(right_child)))
             return nil;
-        if (left_child_type.is(*type::PersistentHashMapCollisionNode) && !collision_node_equal(get_dynamic_object_element(left, i), get_dynamic_object_element(right, i)))
+        if (left_child_type.is(*type::PersistentHashMapCollisionNode) && !collision_node_equal(left_child, right_child))
             return nil;
-        if (left_child_type.is(*type::PersistentHashMapArrayNode) && !array_node_equal(get_dynamic_object_element(left, i), get_dynamic_object_element(right, i)))
+        if (left_child_type.is(*type::PersistentHashMapArrayNode) && !array_node_equal(left_child, right_child))
             return nil;
     }
     return TRUE;
 }
 
+std::uint32_t entry_hash(Value key, Value val)
+{
+    return std::uint32_t(hash_value(key)) * 31 + std::uint32_t(hash_value(val));
+}
+
+std::uint32_t collision_node_hash(Value node)
+{
+    std::uint32_t h = 0;
+    auto size = get_dynamic_object_size(node);
+    for (decltype(size) i = 0; i < size; i += 2)
+        h += entry_hash(get_dynamic_object_element(node, i), get_dynamic_object_element(node, i + 1));
+    return h;
+}
+
+std::uint32_t array_node_hash(Value node)
+{
+    auto h = get_array_node_hash(node);
+    if (h != 0)
+        return h;
+    std::uint32_t value_map{static_cast<std::uint32_t>(get_dynamic_object_int(node, 0))};
+    auto value_count = popcount(value_map);
+    for (std::uint32_t i = 0; i < std::uint32_t(value_count * 2); i += 2)
+        h += entry_hash(get_dynamic_object_element(node, i), get_dynamic_object_element(node, i + 1));
+    auto node_size = get_dynamic_object_size(node);
+    for (std::uint32_t i = value_count * 2; i < node_size; ++i)
+    {
+        auto child = get_dynamic_object_element(node, i);
+        h += get_value_type(child).is(*type::PersistentHashMapCollisionNode) ? collision_node_hash(child) : array_node_hash(child);
+    }
+    set_array_node_hash(node, h);
+    return h;
+}
+
+Force create_seq_parent(Value node, Int64 index, Value parent)
+{
+    if (index == get_dynamic_object_size(node))
+        return parent;
+    return create_static_object(*type::PersistentHashMapSeqParent, index, node, parent);
+}
+
 Force collision_node_seq(Value node, Value parent)
 {
     std::array<Value, 2> kv{{get_dynamic_object_element(node, 0), get_dynamic_object_element(node, 1)}};
@@ -430,7 +619,7 @@ Force array_node_seq(Value node, Value parent)
         Root entry{create_array(kv.data(), kv.size())};
         return create_static_object(*type::PersistentHashMapSeq, *entry, node, 2, parent);
     }
-    Root child_parent{create_static_object(*type::PersistentHashMapSeqParent, 1, node, parent)};
+    Root child_parent{create_seq_parent(node, 1, parent)};
     auto child = get_dynamic_object_element(node, 0);
     if (get_value_type(child).is(*type::PersistentHashMapCollisionNode))
         return collision_node_seq(child, *child_parent);
@@ -441,13 +630,13 @@ Force collision_node_next(Value node, Value child, Value parent, Int64 index)
 {
     std::array<Value, 2> kv{{get_dynamic_object_element(child, 0), get_dynamic_object_element(child, 1)}};
     Root entry{create_array(kv.data(), kv.size())};
-    Root child_parent{create_static_object(*type::PersistentHashMapSeqParent, index + 1, node, parent)};
+    Root child_parent{create_seq_parent(node, index + 1, parent)};
     return create_static_object(*type::PersistentHashMapSeq, *entry, child, 2, *child_parent);
 }
 
 Force array_node_next(Value node, Value child, Value parent, Int64 index)
 {
-    Root child_parent{create_static_object(*type::PersistentHashMapSeqParent, index + 1, node, parent)};
+    Root child_parent{create_seq_parent(node, index + 1, parent)};
 
     std::uint64_t value_node_map = get_dynamic_object_int(child, 0);
     std::uint32_t value_map{static_cast<std::uint32_t>(value_node_map)};
@@ -461,6 +650,160 @@ Force array_node_next(Value node, Value child, Value parent, Int64 index)
     return array_node_seq(child, *child_parent);
 }
 
+Value hash_map_get(Value map, Value key, Value def_val)
+{
+    auto node_or_val = get_dynamic_object_element(map, 0);
+    if (node_or_val.is(*SENTINEL))
+        return def_val;
+    auto node_or_val_type = get_value_type(node_or_val);
+    if (node_or_val_type.is(*type::PersistentHashMapCollisionNode))
+    {
+        std::uint32_t key_hash = hash_value(key);
+        return collision_node_get(node_or_val, key, key_hash, def_val);
+    }
+    if (node_or_val_type.is(*type::PersistentHashMapArrayNode))
+    {
+        std::uint32_t key_hash = hash_value(key);
+        return array_node_get(node_or_val, 0, key, key_hash, def_val);
+    }
+    return get_dynamic_object_element(map, 1) == key ? node_or_val : def_val;
+}
+
+Int64 get_transient_hash_map_edit(Value m)
+{
+    return get_dynamic_object_int(m, 1);
+}
+
+Int64 check_transient_hash_map_edit(Value m)
+{
+    auto edit = get_transient_hash_map_edit(m);
+    if (edit == 0)
+    {
+        Root msg{create_string("Transient used after persistent! call")};
+        throw_exception(new_illegal_state(*msg));
+    }
+    return edit;
+}
+
+Force seq_at(Value node, Int64 index, Value parent)
+{
+    while (index == get_dynamic_object_size(node))
+    {
+        if (!parent)
+            return nil;
+        index = get_static_object_int(parent, 0);
+        node = get_static_object_element(parent, 1);
+        parent = get_static_object_element(parent, 2);
+    }
+    auto child = get_dynamic_object_element(node, index);
+    if (get_value_type(child).is(*type::PersistentHashMapCollisionNode))
+        return collision_node_next(node, child, parent, index);
+    if (get_value_type(child).is(*type::PersistentHashMapArrayNode))
+        return array_node_next(node, child, parent, index);
+    std::array<Value, 2> kv{{child, get_dynamic_object_element(node, index + 1)}};
+    Root entry{create_array(kv.data(), kv.size())};
+    return create_static_object(*type::PersistentHashMapSeq, *entry, node, index + 2, parent);
+}
+
+struct SeqPosition
+{
+    Value node;
+    Int64 index = 0;
+    std::vector<std::pair<Value, Int64>> frames;
+    Value parent;
+};
+
+void walk_seq(Value s, std::uint32_t n, std::vector<Value>& elems, SeqPosition& pos)
+{
+    pos.node = get_static_object_element(s, 1);
+    if (pos.node.is_nil())
+        return;
+    pos.index = get_static_object_int(s, 2);
+    pos.parent = get_static_object_element(s, 3);
+    auto limit = elems.size() + 2 * n;
+    while (elems.size() < limit)
+    {
+        auto& node = pos.node;
+        auto& index = pos.index;
+        if (index == get_dynamic_object_size(node))
+        {
+            if (!pos.frames.empty())
+            {
+                node = pos.frames.back().first;
+                index = pos.frames.back().second;
+                pos.frames.pop_back();
+            }
+            else if (pos.parent)
+            {
+                index = get_static_object_int(pos.parent, 0);
+                node = get_static_object_element(pos.parent, 1);
+                pos.parent = get_static_object_element(pos.parent, 2);
+            }
+            else
+            {
+                node = nil;
+                return;
+            }
+            continue;
+        }
+        auto child = get_dynamic_object_element(node, index);
+        auto child_type = get_value_type(child);
+        if (child_type.is(*type::PersistentHashMapCollisionNode) || child_type.is(*type::PersistentHashMapArrayNode))
+        {
+            if (index + 1 < get_dynamic_object_size(node))
+                pos.frames.emplace_back(node, index + 1);
+            node = child;
+            index = 0;
+            continue;
+        }
+        elems.push_back(child);
+        elems.push_back(get_dynamic_object_element(node, index + 1));
+        index += 2;
+    }
+}
+
+bool collision_node_reduce(Value node, Value f, Root& acc)
+{
+    Root entry;
+    auto size = get_dynamic_object_size(node);
+    for (decltype(size) i = 0; i < size; i += 2)
+    {
+        std::array<Value, 2> kv{{get_dynamic_object_element(node, i), get_dynamic_object_element(node, i + 1)}};
+        entry = create_array(kv.data(), kv.size());
+        acc = reduce_step(f, *acc, *entry);
+        if (is_reduced(*acc))
+            return true;
+    }
+    return false;
+}
+
+bool array_node_reduce(Value node, Value f, Root& acc)
+{
+    std::uint32_t value_map{static_cast<std::uint32_t>(get_dynamic_object_int(node, 0))};
+    auto value_count = popcount(value_map);
+    Root entry;
+    for (std::uint32_t i = 0; i < std::uint32_t(value_count * 2); i += 2)
+    {
+        std::array<Value, 2> kv{{get_dynamic_object_element(node, i), get_dynamic_object_element(node, i + 1)}};
+        entry = create_array(kv.data(), kv.size());
+        acc = reduce_step(f, *acc, *entry);
+        if (is_reduced(*acc))
+            return true;
+    }
+    auto node_size = get_dynamic_object_size(node);
+    for (std::uint32_t i = value_count * 2; i < node_size; ++i)
+    {
+        auto child = get_dynamic_object_element(node, i);
+        if (get_value_type(child).is(*type::PersistentHashMapCollisionNode) ?
+            collision_node_reduce(child, f, acc) :
+            array_node_reduce(child, f, acc))
+            return true;
+    }
+    return false;
+}
+
+Int64 last_edit = 0;
+
 }
 
 Force create_persistent_hash_map()
@@ -480,21 +823,7 @@ Value persistent_hash_map_get(Value m, Value k)
 
 Value persistent_hash_map_get(Value map, Value key, Value def_val)
 {
-    auto node_or_val = get_dynamic_object_element(map, 0);
-    if (node_or_val.is(*SENTINEL))
-        return def_val;
-    auto node_or_val_type = get_value_type(node_or_val);
-    if (node_or_val_type.is(*type::PersistentHashMapCollisionNode))
-    {
-        std::uint32_t key_hash = hash_value(key);
-        return collision_node_get(node_or_val, key, key_hash, def_val);
-    }
-    if (node_or_val_type.is(*type::PersistentHashMapArrayNode))
-    {
-        std::uint32_t key_hash = hash_value(key);
-        return array_node_get(node_or_val, 0, key, key_hash, def_val);
-    }
-    return get_dynamic_object_element(map, 1) == key ? node_or_val : def_val;
+    return hash_map_get(map, key, def_val);
 }
 
 Force persistent_hash_map_assoc(Value map, Value key, Value val)
@@ -508,7 +837,7 @@ Force persistent_hash_map_assoc(Value map, Value key, Value val)
     {
         std::uint32_t key_hash = hash_value(key);
         auto replaced = false;
-        Root new_node{collision_node_assoc(node_or_val, 0, key, key_hash, val, replaced)};
+        Root new_node{collision_node_assoc(node_or_val, 0, 0, key, key_hash, val, replaced)};
         auto size = get_persistent_hash_map_size(map);
         return create_map(replaced ? size : (size + 1), *new_node);
     }
@@ -516,7 +845,7 @@ Force persistent_hash_map_assoc(Value map, Value key, Value val)
     {
         std::uint32_t key_hash = hash_value(key);
         auto replaced = false;
-        Root new_node{array_node_assoc(node_or_val, 0, key, key_hash, val, replaced)};
+        Root new_node{array_node_assoc(node_or_val, 0, 0, key, key_hash, val, replaced)};
         auto size = get_persistent_hash_map_size(map);
         return create_map(replaced ? size : (size + 1), *new_node);
     }
@@ -541,8 +870,9 @@ Force persistent_hash_map_dissoc(Value map, Value key)
     if (node_or_val_type.is(*type::PersistentHashMapCollisionNode))
     {
         std::uint32_t key_hash = hash_value(key);
-        std::pair<Root, Value> new_node{collision_node_dissoc(node_or_val, key, key_hash)};
-        if (new_node.first->is(node_or_val))
+        auto removed = false;
+        std::pair<Root, Value> new_node{collision_node_dissoc(node_or_val, key, key_hash, removed)};
+        if (!removed)
             return map;
         if (!new_node.second.is(*SENTINEL))
             return create_single_value_map(new_node.second, *new_node.first);
@@ -552,8 +882,9 @@ Force persistent_hash_map_dissoc(Value map, Value key)
     if (node_or_val_type.is(*type::PersistentHashMapArrayNode))
     {
         std::uint32_t key_hash = hash_value(key);
-        std::pair<Root, Value> new_node{array_node_dissoc(node_or_val, 0, key, key_hash)};
-        if (new_node.first->is(node_or_val))
+        auto removed = false;
+        std::pair<Root, Value> new_node{array_node_dissoc(node_or_val, 0, 0, key, key_hash, removed)};
+        if (!removed)
             return map;
         if (!new_node.second.is(*SENTINEL))
             return create_single_value_map(new_node.second, *new_node.first);
@@ -574,6 +905,8 @@ Value persistent_hash_map_contains(Value m, Value k)
 
 Value are_persistent_hash_maps_equal(Value left, Value right)
 {
+    if (left.is(right))
+        return TRUE;
     if (get_persistent_hash_map_size(left) != get_persistent_hash_map_size(right))
         return nil;
     auto left_node_or_val = get_dynamic_object_element(left, 0);
@@ -599,6 +932,41 @@ Value are_persistent_hash_maps_equal(Value left, Value right)
     return (left_node_or_val == right_node_or_val && left_key == right_key) ? TRUE : nil;
 }
 
+Force persistent_hash_map_hash(Value m)
+{
+    auto node_or_val = get_dynamic_object_element(m, 0);
+    if (node_or_val.is(*SENTINEL))
+        return create_int64(0);
+    auto node_type = get_value_type(node_or_val);
+    if (node_type.is(*type::PersistentHashMapCollisionNode))
+        return create_int64(collision_node_hash(node_or_val));
+    if (node_type.is(*type::PersistentHashMapArrayNode))
+        return create_int64(array_node_hash(node_or_val));
+    return create_int64(entry_hash(get_dynamic_object_element(m, 1), node_or_val));
+}
+
+Force persistent_hash_map_reduce(Value m, Value f, Value init)
+{
+    Root acc{init};
+    auto node_or_val = get_dynamic_object_element(m, 0);
+    if (node_or_val.is(*SENTINEL))
+        return *acc;
+    auto node_type = get_value_type(node_or_val);
+    bool reduced = false;
+    if (node_type.is(*type::PersistentHashMapCollisionNode))
+        reduced = collision_node_reduce(node_or_val, f, acc);
+    else if (node_type.is(*type::PersistentHashMapArrayNode))
+        reduced = array_node_reduce(node_or_val, f, acc);
+    else
+    {
+        std::array<Value, 2> kv{{get_dynamic_object_element(m, 1), node_or_val}};
+        Root entry{create_array(kv.data(), kv.size())};
+        acc = reduce_step(f, *acc, *entry);
+        reduced = !is_reduced(*acc).is_nil();
+    }
+    return reduced ? reduced_deref(*acc) : *acc;
+}
+
 Force persistent_hash_map_seq(Value m)
 {
     auto node_or_val = get_dynamic_object_element(m, 0);
@@ -624,24 +992,162 @@ Force get_persistent_hash_map_seq_next(Value s)
     auto node = get_static_object_element(s, 1);
     if (node.is_nil())
         return nil;
-    auto index = get_static_object_int(s, 2);
-    auto parent = get_static_object_element(s, 3);
-    while (index == get_dynamic_object_size(node))
+    return seq_at(node, get_static_object_int(s, 2), get_static_object_element(s, 3));
+}
+
+Force get_persistent_hash_map_seq_chunk_first(Value s)
+{
+    std::vector<Value> elems{get_static_object_element(s, 0)};
+    SeqPosition pos;
+    walk_seq(s, CHUNK_SIZE - 1, elems, pos);
+    Roots entries(elems.size() / 2);
+    std::vector<Value> chunk{elems.front()};
+    for (std::size_t i = 1; i < elems.size(); i += 2)
     {
-        if (!parent)
-            return nil;
-        index = get_static_object_int(parent, 0);
-        node = get_static_object_element(parent, 1);
-        parent = get_static_object_element(parent, 2);
+        entries.set(i / 2, create_array(&elems[i], 2));
+        chunk.push_back(entries[i / 2]);
     }
-    auto child = get_dynamic_object_element(node, index);
-    if (get_value_type(child).is(*type::PersistentHashMapCollisionNode))
-        return collision_node_next(node, child, parent, index);
-    if (get_value_type(child).is(*type::PersistentHashMapArrayNode))
-        return array_node_next(node, child, parent, index);
-    std::array<Value, 2> kv{{child, get_dynamic_object_element(node, index + 1)}};
-    Root entry{create_array(kv.data(), kv.size())};
-    return create_static_object(*type::PersistentHashMapSeq, *entry, node, index + 2, parent);
+    return create_array(chunk.data(), chunk.size());
+}
+
+Force get_persistent_hash_map_seq_chunk_next(Value s)
+{
+    std::vector<Value> elems;
+    SeqPosition pos;
+    walk_seq(s, CHUNK_SIZE - 1, elems, pos);
+    if (pos.node.is_nil())
+        return nil;
+    Root parent{pos.parent};
+    for (auto& frame : pos.frames)
+        parent = create_static_object(*type::PersistentHashMapSeqParent, frame.second, frame.first, *parent);
+    return seq_at(pos.node, pos.index, *parent);
+}
+
+
+Force transient_hash_map(Value m)
+{
+    std::array<Int64, 2> ints{{get_persistent_hash_map_size(m), ++last_edit}};
+    auto key = get_dynamic_object_size(m) > 1 ? get_dynamic_object_element(m, 1) : nil;
+    std::array<Value, 2> elems{{get_dynamic_object_element(m, 0), key}};
+    return create_object(*type::TransientHashMap, ints.data(), ints.size(), elems.data(), elems.size());
+}
+
+Int64 get_transient_hash_map_size(Value m)
+{
+    return get_dynamic_object_int(m, 0);
+}
+
+Value transient_hash_map_get(Value m, Value k)
+{
+    return transient_hash_map_get(m, k, nil);
+}
+
+Value transient_hash_map_get(Value m, Value k, Value def_v)
+{
+    check_transient_hash_map_edit(m);
+    return hash_map_get(m, k, def_v);
+}
+
+Value transient_hash_map_contains(Value m, Value k)
+{
+    auto val = transient_hash_map_get(m, k, *SENTINEL);
+    return val.is(*SENTINEL) ? nil : TRUE;
+}
+
+Force transient_hash_map_assoc(Value m, Value key, Value val)
+{
+    auto edit = check_transient_hash_map_edit(m);
+    auto size = get_transient_hash_map_size(m);
+    auto node_or_val = get_dynamic_object_element(m, 0);
+    if (node_or_val.is(*SENTINEL))
+    {
+        set_dynamic_object_element(m, 0, val);
+        set_dynamic_object_element(m, 1, key);
+        set_dynamic_object_int(m, 0, 1);
+        return m;
+    }
+
+    auto node_or_val_type = get_value_type(node_or_val);
+    auto is_collision_node = node_or_val_type.is(*type::PersistentHashMapCollisionNode);
+    if (is_collision_node || node_or_val_type.is(*type::PersistentHashMapArrayNode))
+    {
+        std::uint32_t key_hash = hash_value(key);
+        auto replaced = false;
+        Root new_node{
+            is_collision_node ?
+            collision_node_assoc(node_or_val, 0, edit, key, key_hash, val, replaced) :
+            array_node_assoc(node_or_val, 0, edit, key, key_hash, val, replaced)};
+        set_dynamic_object_element(m, 0, *new_node);
+        if (!replaced)
+            set_dynamic_object_int(m, 0, size + 1);
+        return m;
+    }
+
+    Value key0 = get_dynamic_object_element(m, 1);
+    if (key0 == key)
+    {
+        set_dynamic_object_element(m, 0, val);
+        set_dynamic_object_element(m, 1, key);
+        return m;
+    }
+    std::uint32_t key_hash = hash_value(key);
+    std::uint32_t key0_hash = hash_value(key0);
+    Root new_node{
+        (key_hash == key0_hash) ?
+        create_collision_node(key_hash, key0, node_or_val, key, val) :
+        create_array_node(0, edit, key0, key0_hash, node_or_val, key, key_hash, val)};
+    set_dynamic_object_element(m, 0, *new_node);
+    set_dynamic_object_element(m, 1, nil);
+    set_dynamic_object_int(m, 0, 2);
+    return m;
+}
+
+Force transient_hash_map_dissoc(Value m, Value key)
+{
+    auto edit = check_transient_hash_map_edit(m);
+    auto size = get_transient_hash_map_size(m);
+    auto node_or_val = get_dynamic_object_element(m, 0);
+    if (node_or_val.is(*SENTINEL))
+        return m;
+
+    auto node_or_val_type = get_value_type(node_or_val);
+    auto is_collision_node = node_or_val_type.is(*type::PersistentHashMapCollisionNode);
+    if (is_collision_node || node_or_val_type.is(*type::PersistentHashMapArrayNode))
+    {
+        std::uint32_t key_hash = hash_value(key);
+        auto removed = false;
+        std::pair<Root, Value> new_node{
+            is_collision_node ?
+            collision_node_dissoc(node_or_val, key, key_hash, removed) :
+            array_node_dissoc(node_or_val, 0, edit, key, key_hash, removed)};
+        if (!removed)
+            return m;
+        set_dynamic_object_element(m, 0, *new_node.first);
+        if (!new_node.second.is(*SENTINEL))
+            set_dynamic_object_element(m, 1, new_node.second);
+        set_dynamic_object_int(m, 0, size - 1);
+        return m;
+    }
+
+    if (get_dynamic_object_element(m, 1) == key)
+    {
+        set_dynamic_object_element(m, 0, *SENTINEL);
+        set_dynamic_object_element(m, 1, nil);
+        set_dynamic_object_int(m, 0, 0);
+    }
+    return m;
+}
+
+Force transient_hash_map_persistent(Value m)
+{
+    check_transient_hash_map_edit(m);
+    set_dynamic_object_int(m, 1, 0);
+    auto size = get_transient_hash_map_size(m);
+    if (size == 0)
+        return *EMPTY_HASH_MAP;
+    if (size == 1)
+        return create_single_value_map(get_dynamic_object_element(m, 1), get_dynamic_object_element(m, 0));
+    return create_map(size, get_dynamic_object_element(m, 0));
 }
 
 }
@@ -12,8 +12,21 @@ Force persistent_hash_map_assoc(Value map, Value key, Value val);
 Force persistent_hash_map_dissoc(Value map, Value key);
 Value persistent_hash_map_contains(Value m, Value k);
 Value are_persistent_hash_maps_equal(Value left, Value right);
+Force persistent_hash_map_hash(Value m);
+Force persistent_hash_map_reduce(Value m, Value f, Value init);
 Force persistent_hash_map_seq(Value m);
 Value get_persistent_hash_map_seq_first(Value s);
 Force get_persistent_hash_map_seq_next(Value s);
+Force get_persistent_hash_map_seq_chunk_first(Value s);
+Force get_persistent_hash_map_seq_chunk_next(Value s);
+
+Force transient_hash_map(Value m);
+Int64 get_transient_hash_map_size(Value m);
+Value transient_hash_map_get(Value m, Value k);
+Value transient_hash_map_get(Value m, Value k, Value def_v);
+Value transient_hash_map_contains(Value m, Value k);
+Force transient_hash_map_assoc(Value m, Value key, Value val);
+Force transient_hash_map_dissoc(Value m, Value key);
+Force transient_hash_map_persistent(Value m);
 
 }
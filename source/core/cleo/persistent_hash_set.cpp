@@ -1,6 +1,9 @@
 #include "persistent_hash_set.hpp"
 #include "global.hpp"
 #include "array.hpp"
+#include "error.hpp"
+#include "chunked_seq.hpp"
+#include "reduce.hpp"
 
 namespace cleo
 {
@@ -13,7 +16,12 @@ namespace cleo
 // CollisionNode:
 //   [hash | key0 key1 key2? ...]
 // ArrayNode:
-//   [(value-map node-map) | key0? key1? ... node2? node1? node0?]
+//   [(value-map node-map) edit (count hash) | key0? key1? ... node2? node1? node0?]
+//   edit: 0 or the edit of the TransientHashSet which owns the node and can update it in place
+//   count: number of keys in the subtree, hash: memoized hash of the subtree or 0 if not computed yet
+// TransientHashSet:
+//   [size edit | SENTINEL], [size edit | key], [size edit | node]
+//   edit: 0 after persistent!
 // HashSetSeq:
 //   size 1: [first-key nil 0 nil]
 //   size>1: [first-key collision-node 0 #SeqParent[index array-node parent-or-nil]-or-nil]
@@ -77,14 +85,14 @@ Value collision_node_get(Value node, Value key, std::uint32_t key_hash, Value de
     return collision_node_get(node, key, def_val);
 }
 
-Force create_array_node(std::uint8_t shift, Value key0, std::uint32_t key0_hash, std::uint32_t node_hash, Value node);
+Force create_array_node(std::uint8_t shift, Int64 edit, Value key0, std::uint32_t key0_hash, std::uint32_t node_hash, Value node);
 
-Force collision_node_conj(Value node, std::uint8_t shift, Value key, std::uint32_t key_hash)
+Force collision_node_conj(Value node, std::uint8_t shift, Int64 edit, Value key, std::uint32_t key_hash)
 {
     assert(get_value_type(node).is(*type::PersistentHashSetCollisionNode));
     auto node_hash = get_dynamic_object_int(node, 0);
     if (key_hash != node_hash)
-        return create_array_node(shift, key, key_hash, node_hash, node);
+        return create_array_node(shift, edit, key, key_hash, node_hash, node);
     auto node_size = get_dynamic_object_size(node);
     if (!collision_node_get(node, key, *SENTINEL).is(*SENTINEL))
         return node;
@@ -95,7 +103,7 @@ Force collision_node_conj(Value node, std::uint8_t shift, Value key, std::uint32
     return *new_node;
 }
 
-std::pair<Force, bool> collision_node_disj(Value node, Value key, std::uint32_t key_hash)
+std::pair<Force, bool> collision_node_disj(Value node, Value key, std::uint32_t key_hash, bool& removed)
 {
     assert(get_value_type(node).is(*type::PersistentHashSetCollisionNode));
     auto node_hash = get_dynamic_object_int(node, 0);
@@ -107,6 +115,7 @@ std::pair<Force, bool> collision_node_disj(Value node, Value key, std::uint32_t
         ++index;
     if (index == node_size)
         return {node, true};
+    removed = true;
     if (node_size == 2)
         return {get_dynamic_object_element(node, 1 - index), false};
     Root new_node{create_object(*type::PersistentHashSetCollisionNode, &node_hash, 1, nullptr, node_size - 1)};
@@ -119,6 +128,8 @@ Value collision_node_equal(Value left, Value right)
 {
     assert(get_value_type(left).is(*type::PersistentHashSetCollisionNode));
     assert(get_value_type(right).is(*type::PersistentHashSetCollisionNode));
+    if (left.is(right))
+        return TRUE;
     auto size = get_dynamic_object_size(left);
     if (size != get_dynamic_object_size(right))
         return nil;
@@ -154,7 +165,60 @@ Int64 combine_maps(std::uint32_t value_set, std::uint32_t node_set)
     return value_set | (std::uint64_t(node_set) << 32);
 }
 
-Force create_array_node(std::uint8_t shift, Value key0, std::uint32_t key0_hash, Value key1, std::uint32_t key1_hash)
+std::uint32_t get_array_node_count(Value node)
+{
+    return std::uint32_t(get_dynamic_object_int(node, 2));
+}
+
+void set_array_node_count(Value node, std::uint32_t count)
+{
+    set_dynamic_object_int(node, 2, count);
+}
+
+std::uint32_t get_array_node_hash(Value node)
+{
+    return std::uint32_t(std::uint64_t(get_dynamic_object_int(node, 2)) >> 32);
+}
+
+void set_array_node_hash(Value node, std::uint32_t hash)
+{
+    set_dynamic_object_int(node, 2, get_array_node_count(node) | (std::uint64_t(hash) << 32));
+}
+
+std::uint32_t get_node_count(Value node)
+{
+    if (get_value_type(node).is(*type::PersistentHashSetCollisionNode))
+        return get_dynamic_object_size(node);
+    return get_array_node_count(node);
+}
+
+Force create_array_node(Int64 map, Int64 edit, std::uint32_t count, const Value *elems, std::uint32_t node_size)
+{
+    std::array<Int64, 3> ints{{map, edit, count}};
+    return create_object(*type::PersistentHashSetArrayNode, ints.data(), ints.size(), elems, node_size);
+}
+
+Force create_array_node(Int64 map, Int64 edit, std::uint32_t count, std::uint32_t node_size)
+{
+    return create_array_node(map, edit, count, nullptr, node_size);
+}
+
+bool is_array_node_editable(Value node, Int64 edit)
+{
+    return edit != 0 && get_dynamic_object_int(node, 1) == edit;
+}
+
+Force edit_array_node(Value node, Int64 edit)
+{
+    if (is_array_node_editable(node, edit))
+        return node;
+    auto node_size = get_dynamic_object_size(node);
+    Root new_node{create_array_node(get_dynamic_object_int(node, 0), edit, get_array_node_count(node), node_size)};
+    copy_object_elements(*new_node, 0, node, 0, node_size);
+    return *new_node;
+}
+
+Force create_array_node(std::uint8_t shift, Int64 edit, Value key0, std::uint32_t key0_hash, Value key1, std::uint32_t key1_hash)
 {
     assert(key0_hash != key1_hash);
     auto key0_bit = map_bit(shift, key0_hash);
@@ -163,21 +227,22 @@ Force create_array_node(std::uint8_t shift, Value key0, std::uint32_t key0_hash,
     {
         std::uint32_t node_set = key0_bit;
         auto map_val = combine_maps(0, node_set);
-        Root child_node{create_array_node(shift + 5, key0, key0_hash, key1, key1_hash)};
-        return create_object1_1(*type::PersistentHashSetArrayNode, map_val, *child_node);
+        Root child_node{create_array_node(shift + 5, edit, key0, key0_hash, key1, key1_hash)};
+        std::array<Value, 1> elems{{*child_node}};
+        return create_array_node(map_val, edit, 2, elems.data(), elems.size());
     }
     else
     {
         std::uint32_t value_set = key0_bit | key1_bit;
         auto map_val = combine_maps(value_set, 0);
-        if (key0_bit < key1_bit)
-            return create_object1_2(*type::PersistentHashSetArrayNode, map_val, key0, key1);
-        else
-            return create_object1_2(*type::PersistentHashSetArrayNode, map_val, key1, key0);
+        std::array<Value, 2> elems{{key0, key1}};
+        if (key1_bit < key0_bit)
+            elems = {{key1, key0}};
+        return create_array_node(map_val, edit, 2, elems.data(), elems.size());
     }
 }
 
-Force create_array_node(std::uint8_t shift, Value key0, std::uint32_t key0_hash, std::uint32_t node_hash, Value node)
+Force create_array_node(std::uint8_t shift, Int64 edit, Value key0, std::uint32_t key0_hash, std::uint32_t node_hash, Value node)
 {
     assert(key0_hash != node_hash);
     auto key0_bit = map_bit(shift, key0_hash);
@@ -186,24 +251,21 @@ Force create_array_node(std::uint8_t shift, Value key0, std::uint32_t key0_hash,
     {
         std::uint32_t node_set = key0_bit;
         auto map_val = combine_maps(0, node_set);
-        Root child_node{create_array_node(shift + 5, key0, key0_hash, node_hash, node)};
-        return create_object1_1(*type::PersistentHashSetArrayNode, map_val, *child_node);
+        Root child_node{create_array_node(shift + 5, edit, key0, key0_hash, node_hash, node)};
+        std::array<Value, 1> elems{{*child_node}};
+        return create_array_node(map_val, edit, 1 + get_node_count(node), elems.data(), elems.size());
     }
     else
     {
         auto map_val = combine_maps(key0_bit, node_bit);
-        return create_object1_2(*type::PersistentHashSetArrayNode, map_val, key0, node);
+        std::array<Value, 2> elems{{key0, node}};
+        return create_array_node(map_val, edit, 1 + get_node_count(node), elems.data(), elems.size());
     }
 }
 
-Force create_array_node(Int64 map, std::uint32_t node_size)
-{
-    return create_object(*type::PersistentHashSetArrayNode, &map, 1, nullptr, node_size);
-}
-
 Force create_array_set(Value key0, std::uint32_t key0_hash, Value key1, std::uint32_t key1_hash)
 {
-    Root node{create_array_node(0, key0, key0_hash, key1, key1_hash)};
+    Root node{create_array_node(0, 0, key0, key0_hash, key1, key1_hash)};
     return create_set(2, *node);
 }
 
@@ -231,7 +293,7 @@ Value array_node_get(Value node, std::uint8_t shift, Value key, std::uint32_t ke
     return def_val;
 }
 
-Value array_node_conj(Value node, std::uint8_t shift, Value key, std::uint32_t key_hash)
+Force array_node_conj(Value node, std::uint8_t shift, Int64 edit, Value key, std::uint32_t key_hash, bool& added)
 {
     assert(get_value_type(node).is(*type::PersistentHashSetArrayNode));
     std::uint64_t value_node_set = get_dynamic_object_int(node, 0);
@@ -240,6 +302,7 @@ Value array_node_conj(Value node, std::uint8_t shift, Value key, std::uint32_t k
     std::uint32_t key_bit = map_bit(shift, key_hash);
     auto key_index = map_key_index(value_set, key_bit);
     auto node_size = get_dynamic_object_size(node);
+    auto count = get_array_node_count(node);
     if (value_set & key_bit)
     {
         auto key0 = get_dynamic_object_element(node, key_index);
@@ -247,61 +310,73 @@ Value array_node_conj(Value node, std::uint8_t shift, Value key, std::uint32_t k
             return node;
 
         auto new_value_set = combine_maps(value_set ^ key_bit, node_set ^ key_bit);
-        Root new_node{create_array_node(new_value_set, node_size)};
+        Root new_node{create_array_node(new_value_set, edit, count + 1, node_size)};
         auto node_index = map_node_index(node_set, node_size, key_bit);
         std::uint32_t key0_hash = hash_value(key0);
         Root new_child{
             (key0_hash == key_hash) ?
             create_collision_node(key_hash, key0, key) :
-            create_array_node(shift + 5, key0, key0_hash, key, key_hash)};
+            create_array_node(shift + 5, edit, key0, key0_hash, key, key_hash)};
 
         copy_object_elements(*new_node, 0, node, 0, key_index);
         copy_object_elements(*new_node, key_index, node, key_index + 1, node_index + 1);
         set_dynamic_object_element(*new_node, node_index, *new_child);
         copy_object_elements(*new_node, node_index + 1, node, node_index + 1, node_size);
 
+        added = true;
         return *new_node;
     }
     else if (node_set & key_bit)
     {
         auto node_index = map_node_index(node_set, node_size, key_bit);
         auto child_node = get_dynamic_object_element(node, node_index);
-        Root new_child{
-            get_value_type(child_node).is(*type::PersistentHashSetCollisionNode) ?
-            collision_node_conj(child_node, shift + 5, key, key_hash) :
-            array_node_conj(child_node, shift + 5, key, key_hash)};
+        Root new_child;
+        if (get_value_type(child_node).is(*type::PersistentHashSetCollisionNode))
+        {
+            new_child = collision_node_conj(child_node, shift + 5, edit, key, key_hash);
+            added = !new_child->is(child_node);
+        }
+        else
+            new_child = array_node_conj(child_node, shift + 5, edit, key, key_hash, added);
+        auto new_count = added ? (count + 1) : count;
         if (new_child->is(child_node))
+        {
+            if (is_array_node_editable(node, edit))
+                set_array_node_count(node, new_count);
             return node;
-        Root new_node{create_array_node(value_node_set, node_size)};
-        copy_object_elements(*new_node, 0, node, 0, node_index);
+        }
+        Root new_node{edit_array_node(node, edit)};
         set_dynamic_object_element(*new_node, node_index, *new_child);
-        copy_object_elements(*new_node, node_index + 1, node, node_index + 1, node_size);
+        set_array_node_count(*new_node, new_count);
         return *new_node;
     }
     else
     {
         Int64 new_value_set = combine_maps(value_set | key_bit, node_set);
-        Root new_node{create_array_node(new_value_set, node_size + 1)};
+        Root new_node{create_array_node(new_value_set, edit, count + 1, node_size + 1)};
         copy_object_elements(*new_node, 0, node, 0, key_index);
         set_dynamic_object_element(*new_node, key_index, key);
         copy_object_elements(*new_node, key_index + 1, node, key_index, node_size);
 
+        added = true;
         return *new_node;
     }
 }
 
-std::pair<Force, bool> array_node_disj(Value node, std::uint8_t shift, Value key, std::uint32_t key_hash)
+std::pair<Force, bool> array_node_disj(Value node, std::uint8_t shift, Int64 edit, Value key, std::uint32_t key_hash, bool& removed)
 {
     std::uint64_t value_node_set = get_dynamic_object_int(node, 0);
     std::uint32_t value_set{static_cast<std::uint32_t>(value_node_set)};
     std::uint32_t node_set{static_cast<std::uint32_t>(value_node_set >> 32)};
     std::uint32_t key_bit = map_bit(shift, key_hash);
+    auto count = get_array_node_count(node);
     if (value_set & key_bit)
     {
         auto key_index = map_key_index(value_set, key_bit);
         auto key0 = get_dynamic_object_element(node, key_index);
         if (key0 != key)
             return {node, true};
+        removed = true;
         auto node_size = get_dynamic_object_size(node);
         auto value_count = popcount(value_set);
         if (value_count == 2 && node_set == 0)
@@ -313,7 +388,15 @@ std::pair<Force, bool> array_node_disj(Value node, std::uint8_t shift, Value key
                 return {other_child_node, true};
         }
         auto new_value_node_set = combine_maps(value_set ^ key_bit, node_set);
-        Root new_node{create_array_node(new_value_node_set, node_size - 1)};
+        if (is_array_node_editable(node, edit))
+        {
+            copy_object_elements(node, key_index, node, key_index + 1, node_size);
+            set_dynamic_object_size(node, node_size - 1);
+            set_dynamic_object_int(node, 0, new_value_node_set);
+            set_array_node_count(node, count - 1);
+            return {node, true};
+        }
+        Root new_node{create_array_node(new_value_node_set, edit, count - 1, node_size - 1)};
         copy_object_elements(*new_node, 0, node, 0, key_index);
         copy_object_elements(*new_node, key_index, node, key_index + 1, node_size);
         return {*new_node, true};
@@ -325,16 +408,16 @@ std::pair<Force, bool> array_node_disj(Value node, std::uint8_t shift, Value key
         auto child_node = get_dynamic_object_element(node, node_index);
         std::pair<Root, bool> new_child{
             get_value_type(child_node).is(*type::PersistentHashSetCollisionNode) ?
-            collision_node_disj(child_node, key, key_hash) :
-            array_node_disj(child_node, shift + 5, key, key_hash)};
-        if (*new_child.first == child_node)
+            collision_node_disj(child_node, key, key_hash, removed) :
+            array_node_disj(child_node, shift + 5, edit, key, key_hash, removed)};
+        if (!removed)
             return {node, true};
         if (!new_child.second)
         {
             if (value_set == 0 && node_set == key_bit)
                 return {*new_child.first, new_child.second};
             auto new_value_node_set = combine_maps(value_set ^ key_bit, node_set ^ key_bit);
-            Root new_node{create_array_node(new_value_node_set, node_size)};
+            Root new_node{create_array_node(new_value_node_set, edit, count - 1, node_size)};
             auto key_index = map_key_index(value_set, key_bit);
             copy_object_elements(*new_node, 0, node, 0, key_index);
             set_dynamic_object_element(*new_node, key_index, *new_child.first);
@@ -342,10 +425,14 @@ std::pair<Force, bool> array_node_disj(Value node, std::uint8_t shift, Value key
             copy_object_elements(*new_node, node_index + 1, node, node_index + 1, node_size);
             return {*new_node, true};
         }
-        Root new_node{create_array_node(value_node_set, node_size)};
-        copy_object_elements(*new_node, 0, node, 0, node_index);
+        if (new_child.first->is(child_node))
+        {
+            set_array_node_count(node, count - 1);
+            return {node, true};
+        }
+        Root new_node{edit_array_node(node, edit)};
         set_dynamic_object_element(*new_node, node_index, *new_child.first);
-        copy_object_elements(*new_node, node_index + 1, node, node_index + 1, node_size);
+        set_array_node_count(*new_node, count - 1);
         return {*new_node, true};
     }
     else
@@ -356,6 +443,14 @@ Value array_node_equal(Value left, Value right)
 {
     assert(get_value_type(left).is(*type::PersistentHashSetArrayNode));
     assert(get_value_type(right).is(*type::PersistentHashSetArrayNode));
+    if (left.is(right))
+        return TRUE;
+    if (get_array_node_count(left) != get_array_node_count(right))
+        return nil;
+    auto left_hash = get_array_node_hash(left);
+    auto right_hash = get_array_node_hash(right);
+    if (left_hash != 0 && right_hash != 0 && left_hash != right_hash)
+        return nil;
 
     std::uint64_t value_node_set = get_dynamic_object_int(left, 0);
     if (std::uint64_t(get_dynamic_object_int(right, 0)) != value_node_set)
@@ -370,17 +465,54 @@ Value array_node_equal(Value left, Value right)
     {
         auto left_child = get_dynamic_object_element(left, i);
         auto right_child = get_dynamic_object_element(right, i);
+        if (left_child.is(right_child))
+            continue;
         auto left_child_type = get_object_type(left_child);
         if (!left_child_type.is(get_object_type(right_child)))
             return nil;
-        if (left_child_type.is(*type::PersistentHashSetCollisionNode) && !collision_node_equal(get_dynamic_object_element(left, i), get_dynamic_object_element(right, i)))
+        if (left_child_type.is(*type::PersistentHashSetCollisionNode) && !collision_node_equal(left_child, right_child))
             return nil;
-        if (left_child_type.is(*type::PersistentHashSetArrayNode) && !array_node_equal(get_dynamic_object_element(left, i), get_dynamic_object_element(right, i)))
+        if (left_child_type.is(*type::PersistentHashSetArrayNode) && !array_node_equal(left_child, right_child))
             return nil;
     }
     return TRUE;
 }
 
+std::uint32_t collision_node_hash(Value node)
+{
+    std::uint32_t h = 0;
+    auto size = get_dynamic_object_size(node);
+    for (decltype(size) i = 0; i < size; ++i)
+        h += std::uint32_t(hash_value(get_dynamic_object_element(node, i)));
+    return h;
+}
+
+std::uint32_t array_node_hash(Value node)
+{
+    auto h = get_array_node_hash(node);
+    if (h != 0)
+        return h;
+    std::uint32_t value_set{static_cast<std::uint32_t>(get_dynamic_object_int(node, 0))};
+    auto value_count = popcount(value_set);
+    for (std::uint32_t i = 0; i < std::uint32_t(value_count); ++i)
+        h += std::uint32_t(hash_value(get_dynamic_object_element(node, i)));
+    auto node_size = get_dynamic_object_size(node);
+    for (std::uint32_t i = value_count; i < node_size; ++i)
+    {
+        auto child = get_dynamic_object_element(node, i);
+        h += get_value_type(child).is(*type::PersistentHashSetCollisionNode) ? collision_node_hash(child) : array_node_hash(child);
+    }
+    set_array_node_hash(node, h);
+    return h;
+}
+
+Force create_seq_parent(Value node, Int64 index, Value parent)
+{
+    if (index == get_dynamic_object_size(node))
+        return parent;
+    return create_static_object(*type::PersistentHashSetSeqParent, index, node, parent);
+}
+
 Force collision_node_seq(Value node, Value parent)
 {
     auto k = get_dynamic_object_element(node, 0);
@@ -396,7 +528,7 @@ Force array_node_seq(Value node, Value parent)
         auto k = get_dynamic_object_element(node, 0);
         return create_static_object(*type::PersistentHashSetSeq, k, node, 1, parent);
     }
-    Root child_parent{create_static_object(*type::PersistentHashSetSeqParent, 1, node, parent)};
+    Root child_parent{create_seq_parent(node, 1, parent)};
     auto child = get_dynamic_object_element(node, 0);
     if (get_value_type(child).is(*type::PersistentHashSetCollisionNode))
         return collision_node_seq(child, *child_parent);
@@ -406,13 +538,13 @@ Force array_node_seq(Value node, Value parent)
 Force collision_node_next(Value node, Value child, Value parent, Int64 index)
 {
     auto k = get_dynamic_object_element(child, 0);
-    Root child_parent{create_static_object(*type::PersistentHashSetSeqParent, index + 1, node, parent)};
+    Root child_parent{create_seq_parent(node, index + 1, parent)};
     return create_static_object(*type::PersistentHashSetSeq, k, child, 1, *child_parent);
 }
 
 Force array_node_next(Value node, Value child, Value parent, Int64 index)
 {
-    Root child_parent{create_static_object(*type::PersistentHashSetSeqParent, index + 1, node, parent)};
+    Root child_parent{create_seq_parent(node, index + 1, parent)};
 
     std::uint64_t value_node_set = get_dynamic_object_int(child, 0);
     std::uint32_t value_set{static_cast<std::uint32_t>(value_node_set)};
@@ -425,6 +557,150 @@ Force array_node_next(Value node, Value child, Value parent, Int64 index)
     return array_node_seq(child, *child_parent);
 }
 
+Value hash_set_get(Value node_or_key, Value key, Value def_val)
+{
+    if (node_or_key.is(*SENTINEL))
+        return def_val;
+    auto node_or_key_type = get_value_type(node_or_key);
+    if (node_or_key_type.is(*type::PersistentHashSetCollisionNode))
+    {
+        std::uint32_t key_hash = hash_value(key);
+        return collision_node_get(node_or_key, key, key_hash, def_val);
+    }
+    if (node_or_key_type.is(*type::PersistentHashSetArrayNode))
+    {
+        std::uint32_t key_hash = hash_value(key);
+        return array_node_get(node_or_key, 0, key, key_hash, def_val);
+    }
+    return node_or_key == key ? key : def_val;
+}
+
+Int64 get_transient_hash_set_edit(Value s)
+{
+    return get_dynamic_object_int(s, 1);
+}
+
+Int64 check_transient_hash_set_edit(Value s)
+{
+    auto edit = get_transient_hash_set_edit(s);
+    if (edit == 0)
+    {
+        Root msg{create_string("Transient used after persistent! call")};
+        throw_exception(new_illegal_state(*msg));
+    }
+    return edit;
+}
+
+Force seq_at(Value node, Int64 index, Value parent)
+{
+    while (index == get_dynamic_object_size(node))
+    {
+        if (!parent)
+            return nil;
+        index = get_static_object_int(parent, 0);
+        node = get_static_object_element(parent, 1);
+        parent = get_static_object_element(parent, 2);
+    }
+    auto child = get_dynamic_object_element(node, index);
+    if (get_value_type(child).is(*type::PersistentHashSetCollisionNode))
+        return collision_node_next(node, child, parent, index);
+    if (get_value_type(child).is(*type::PersistentHashSetArrayNode))
+        return array_node_next(node, child, parent, index);
+    return create_static_object(*type::PersistentHashSetSeq, child, node, index + 1, parent);
+}
+
+struct SeqPosition
+{
+    Value node;
+    Int64 index = 0;
+    std::vector<std::pair<Value, Int64>> frames;
+    Value parent;
+};
+
+void walk_seq(Value s, std::uint32_t n, std::vector<Value>& elems, SeqPosition& pos)
+{
+    pos.node = get_static_object_element(s, 1);
+    if (pos.node.is_nil())
+        return;
+    pos.index = get_static_object_int(s, 2);
+    pos.parent = get_static_object_element(s, 3);
+    auto limit = elems.size() + n;
+    while (elems.size() < limit)
+    {
+        auto& node = pos.node;
+        auto& index = pos.index;
+        if (index == get_dynamic_object_size(node))
+        {
+            if (!pos.frames.empty())
+            {
+                node = pos.frames.back().first;
+                index = pos.frames.back().second;
+                pos.frames.pop_back();
+            }
+            else if (pos.parent)
+            {
+                index = get_static_object_int(pos.parent, 0);
+                node = get_static_object_element(pos.parent, 1);
+                pos.parent = get_static_object_element(pos.parent, 2);
+            }
+            else
+            {
+                node = nil;
+                return;
+            }
+            continue;
+        }
+        auto child = get_dynamic_object_element(node, index);
+        auto child_type = get_value_type(child);
+        if (child_type.is(*type::PersistentHashSetCollisionNode) || child_type.is(*type::PersistentHashSetArrayNode))
+        {
+            if (index + 1 < get_dynamic_object_size(node))
+                pos.frames.emplace_back(node, index + 1);
+            node = child;
+            index = 0;
+            continue;
+        }
+        elems.push_back(child);
+        ++index;
+    }
+}
+
+bool collision_node_reduce(Value node, Value f, Root& acc)
+{
+    auto size = get_dynamic_object_size(node);
+    for (decltype(size) i = 0; i < size; ++i)
+    {
+        acc = reduce_step(f, *acc, get_dynamic_object_element(node, i));
+        if (is_reduced(*acc))
+            return true;
+    }
+    return false;
+}
+
+bool array_node_reduce(Value node, Value f, Root& acc)
+{
+    std::uint32_t value_set{static_cast<std::uint32_t>(get_dynamic_object_int(node, 0))};
+    auto value_count = popcount(value_set);
+    for (std::uint32_t i = 0; i < std::uint32_t(value_count); ++i)
+    {
+        acc = reduce_step(f, *acc, get_dynamic_object_element(node, i));
+        if (is_reduced(*acc))
+            return true;
+    }
+    auto node_size = get_dynamic_object_size(node);
+    for (std::uint32_t i = value_count; i < node_size; ++i)
+    {
+        auto child = get_dynamic_object_element(node, i);
+        if (get_value_type(child).is(*type::PersistentHashSetCollisionNode) ?
+            collision_node_reduce(child, f, acc) :
+            array_node_reduce(child, f, acc))
+            return true;
+    }
+    return false;
+}
+
+Int64 last_edit = 0;
+
 }
 
 Force create_persistent_hash_set()
@@ -444,21 +720,7 @@ Value persistent_hash_set_get(Value set, Value k)
 
 Value persistent_hash_set_get(Value set, Value key, Value def_val)
 {
-    auto node_or_key = get_static_object_element(set, 1);
-    if (node_or_key.is(*SENTINEL))
-        return def_val;
-    auto node_or_key_type = get_value_type(node_or_key);
-    if (node_or_key_type.is(*type::PersistentHashSetCollisionNode))
-    {
-        std::uint32_t key_hash = hash_value(key);
-        return collision_node_get(node_or_key, key, key_hash, def_val);
-    }
-    if (node_or_key_type.is(*type::PersistentHashSetArrayNode))
-    {
-        std::uint32_t key_hash = hash_value(key);
-        return array_node_get(node_or_key, 0, key, key_hash, def_val);
-    }
-    return node_or_key == key ? key : def_val;
+    return hash_set_get(get_static_object_element(set, 1), key, def_val);
 }
 
 Force persistent_hash_set_conj(Value set, Value key)
@@ -471,7 +733,7 @@ Force persistent_hash_set_conj(Value set, Value key)
     if (node_or_key_type.is(*type::PersistentHashSetCollisionNode))
     {
         std::uint32_t key_hash = hash_value(key);
-        Root new_node{collision_node_conj(node_or_key, 0, key, key_hash)};
+        Root new_node{collision_node_conj(node_or_key, 0, 0, key, key_hash)};
         if (new_node->is(node_or_key))
             return set;
         auto size = get_persistent_hash_set_size(set);
@@ -480,8 +742,9 @@ Force persistent_hash_set_conj(Value set, Value key)
     if (node_or_key_type.is(*type::PersistentHashSetArrayNode))
     {
         std::uint32_t key_hash = hash_value(key);
-        Root new_node{array_node_conj(node_or_key, 0, key, key_hash)};
-        if (new_node->is(node_or_key))
+        auto added = false;
+        Root new_node{array_node_conj(node_or_key, 0, 0, key, key_hash, added)};
+        if (!added)
             return set;
         auto size = get_persistent_hash_set_size(set);
         return create_set(size + 1, *new_node);
@@ -505,8 +768,9 @@ Force persistent_hash_set_disj(Value set, Value key)
     if (node_or_key_type.is(*type::PersistentHashSetCollisionNode))
     {
         std::uint32_t key_hash = hash_value(key);
-        Root new_node{collision_node_disj(node_or_key, key, key_hash).first};
-        if (new_node->is(node_or_key))
+        auto removed = false;
+        Root new_node{collision_node_disj(node_or_key, key, key_hash, removed).first};
+        if (!removed)
             return set;
         auto size = get_persistent_hash_set_size(set);
         return create_set(size - 1, *new_node);
@@ -514,8 +778,9 @@ Force persistent_hash_set_disj(Value set, Value key)
     if (node_or_key_type.is(*type::PersistentHashSetArrayNode))
     {
         std::uint32_t key_hash = hash_value(key);
-        Root new_node{array_node_disj(node_or_key, 0, key, key_hash).first};
-        if (new_node->is(node_or_key))
+        auto removed = false;
+        Root new_node{array_node_disj(node_or_key, 0, 0, key, key_hash, removed).first};
+        if (!removed)
             return set;
         auto size = get_persistent_hash_set_size(set);
         return create_set(size - 1, *new_node);
@@ -533,6 +798,8 @@ Value persistent_hash_set_contains(Value m, Value k)
 
 Value are_persistent_hash_sets_equal(Value left, Value right)
 {
+    if (left.is(right))
+        return TRUE;
     if (get_persistent_hash_set_size(left) != get_persistent_hash_set_size(right))
         return nil;
     auto left_node_or_key = get_static_object_element(left, 1);
@@ -556,6 +823,39 @@ Value are_persistent_hash_sets_equal(Value left, Value right)
     return left_node_or_key == right_node_or_key ? TRUE : nil;
 }
 
+Force persistent_hash_set_hash(Value set)
+{
+    auto node_or_key = get_static_object_element(set, 1);
+    if (node_or_key.is(*SENTINEL))
+        return create_int64(0);
+    auto node_type = get_value_type(node_or_key);
+    if (node_type.is(*type::PersistentHashSetCollisionNode))
+        return create_int64(collision_node_hash(node_or_key));
+    if (node_type.is(*type::PersistentHashSetArrayNode))
+        return create_int64(array_node_hash(node_or_key));
+    return create_int64(std::uint32_t(hash_value(node_or_key)));
+}
+
+Force persistent_hash_set_reduce(Value set, Value f, Value init)
+{
+    Root acc{init};
+    auto node_or_key = get_static_object_element(set, 1);
+    if (node_or_key.is(*SENTINEL))
+        return *acc;
+    auto node_type = get_value_type(node_or_key);
+    bool reduced = false;
+    if (node_type.is(*type::PersistentHashSetCollisionNode))
+        reduced = collision_node_reduce(node_or_key, f, acc);
+    else if (node_type.is(*type::PersistentHashSetArrayNode))
+        reduced = array_node_reduce(node_or_key, f, acc);
+    else
+    {
+        acc = reduce_step(f, *acc, node_or_key);
+        reduced = !is_reduced(*acc).is_nil();
+    }
+    return reduced ? reduced_deref(*acc) : *acc;
+}
+
 Force persistent_hash_set_seq(Value set)
 {
     auto node_or_key = get_static_object_element(set, 1);
@@ -579,22 +879,148 @@ Force get_persistent_hash_set_seq_next(Value s)
     auto node = get_static_object_element(s, 1);
     if (node.is_nil())
         return nil;
-    auto index = get_static_object_int(s, 2);
-    auto parent = get_static_object_element(s, 3);
-    while (index == get_dynamic_object_size(node))
+    return seq_at(node, get_static_object_int(s, 2), get_static_object_element(s, 3));
+}
+
+Force get_persistent_hash_set_seq_chunk_first(Value s)
+{
+    std::vector<Value> elems{get_static_object_element(s, 0)};
+    SeqPosition pos;
+    walk_seq(s, CHUNK_SIZE - 1, elems, pos);
+    return create_array(elems.data(), elems.size());
+}
+
+Force get_persistent_hash_set_seq_chunk_next(Value s)
+{
+    std::vector<Value> elems;
+    SeqPosition pos;
+    walk_seq(s, CHUNK_SIZE - 1, elems, pos);
+    if (pos.node.is_nil())
+        return nil;
+    Root parent{pos.parent};
+    for (auto& frame : pos.frames)
+        parent = create_static_object(*type::PersistentHashSetSeqParent, frame.second, frame.first, *parent);
+    return seq_at(pos.node, pos.index, *parent);
+}
+
+
+Force transient_hash_set(Value set)
+{
+    std::array<Int64, 2> ints{{get_persistent_hash_set_size(set), ++last_edit}};
+    auto node_or_key = get_static_object_element(set, 1);
+    return create_object(*type::TransientHashSet, ints.data(), ints.size(), &node_or_key, 1);
+}
+
+Int64 get_transient_hash_set_size(Value s)
+{
+    return get_dynamic_object_int(s, 0);
+}
+
+Value transient_hash_set_get(Value s, Value k)
+{
+    return transient_hash_set_get(s, k, nil);
+}
+
+Value transient_hash_set_get(Value s, Value k, Value def_v)
+{
+    check_transient_hash_set_edit(s);
+    return hash_set_get(get_dynamic_object_element(s, 0), k, def_v);
+}
+
+Value transient_hash_set_contains(Value s, Value k)
+{
+    auto val = transient_hash_set_get(s, k, *SENTINEL);
+    return val.is(*SENTINEL) ? nil : TRUE;
+}
+
+Force transient_hash_set_conj(Value s, Value key)
+{
+    auto edit = check_transient_hash_set_edit(s);
+    auto size = get_transient_hash_set_size(s);
+    auto node_or_key = get_dynamic_object_element(s, 0);
+    if (node_or_key.is(*SENTINEL))
     {
-        if (!parent)
-            return nil;
-        index = get_static_object_int(parent, 0);
-        node = get_static_object_element(parent, 1);
-        parent = get_static_object_element(parent, 2);
+        set_dynamic_object_element(s, 0, key);
+        set_dynamic_object_int(s, 0, 1);
+        return s;
     }
-    auto child = get_dynamic_object_element(node, index);
-    if (get_value_type(child).is(*type::PersistentHashSetCollisionNode))
-        return collision_node_next(node, child, parent, index);
-    if (get_value_type(child).is(*type::PersistentHashSetArrayNode))
-        return array_node_next(node, child, parent, index);
-    return create_static_object(*type::PersistentHashSetSeq, child, node, index + 1, parent);
+
+    auto node_or_key_type = get_value_type(node_or_key);
+    if (node_or_key_type.is(*type::PersistentHashSetCollisionNode))
+    {
+        std::uint32_t key_hash = hash_value(key);
+        Root new_node{collision_node_conj(node_or_key, 0, edit, key, key_hash)};
+        if (new_node->is(node_or_key))
+            return s;
+        set_dynamic_object_element(s, 0, *new_node);
+        set_dynamic_object_int(s, 0, size + 1);
+        return s;
+    }
+    if (node_or_key_type.is(*type::PersistentHashSetArrayNode))
+    {
+        std::uint32_t key_hash = hash_value(key);
+        auto added = false;
+        Root new_node{array_node_conj(node_or_key, 0, edit, key, key_hash, added)};
+        set_dynamic_object_element(s, 0, *new_node);
+        if (added)
+            set_dynamic_object_int(s, 0, size + 1);
+        return s;
+    }
+    if (node_or_key == key)
+        return s;
+
+    std::uint32_t key_hash = hash_value(key);
+    std::uint32_t key0_hash = hash_value(node_or_key);
+    Root new_node{
+        (key_hash == key0_hash) ?
+        create_collision_node(key_hash, node_or_key, key) :
+        create_array_node(0, edit, node_or_key, key0_hash, key, key_hash)};
+    set_dynamic_object_element(s, 0, *new_node);
+    set_dynamic_object_int(s, 0, 2);
+    return s;
+}
+
+Force transient_hash_set_disj(Value s, Value key)
+{
+    auto edit = check_transient_hash_set_edit(s);
+    auto size = get_transient_hash_set_size(s);
+    auto node_or_key = get_dynamic_object_element(s, 0);
+    if (node_or_key.is(*SENTINEL))
+        return s;
+
+    auto node_or_key_type = get_value_type(node_or_key);
+    auto is_collision_node = node_or_key_type.is(*type::PersistentHashSetCollisionNode);
+    if (is_collision_node || node_or_key_type.is(*type::PersistentHashSetArrayNode))
+    {
+        std::uint32_t key_hash = hash_value(key);
+        auto removed = false;
+        Root new_node{
+            is_collision_node ?
+            collision_node_disj(node_or_key, key, key_hash, removed).first :
+            array_node_disj(node_or_key, 0, edit, key, key_hash, removed).first};
+        if (!removed)
+            return s;
+        set_dynamic_object_element(s, 0, *new_node);
+        set_dynamic_object_int(s, 0, size - 1);
+        return s;
+    }
+
+    if (node_or_key == key)
+    {
+        set_dynamic_object_element(s, 0, *SENTINEL);
+        set_dynamic_object_int(s, 0, 0);
+    }
+    return s;
+}
+
+Force transient_hash_set_persistent(Value s)
+{
+    check_transient_hash_set_edit(s);
+    set_dynamic_object_int(s, 1, 0);
+    auto size = get_transient_hash_set_size(s);
+    if (size == 0)
+        return *EMPTY_HASH_SET;
+    return create_set(size, get_dynamic_object_element(s, 0));
 }
 
 }
@@ -12,8 +12,21 @@ Force persistent_hash_set_conj(Value map, Value key);
 Force persistent_hash_set_disj(Value map, Value key);
 Value persistent_hash_set_contains(Value m, Value k);
 Value are_persistent_hash_sets_equal(Value left, Value right);
+Force persistent_hash_set_hash(Value set);
+Force persistent_hash_set_reduce(Value set, Value f, Value init);
 Force persistent_hash_set_seq(Value m);
 Value get_persistent_hash_set_seq_first(Value s);
 Force get_persistent_hash_set_seq_next(Value s);
+Force get_persistent_hash_set_seq_chunk_first(Value s);
+Force get_persistent_hash_set_seq_chunk_next(Value s);
+
+Force transient_hash_set(Value set);
+Int64 get_transient_hash_set_size(Value s);
+Value transient_hash_set_get(Value s, Value k);
+Value transient_hash_set_get(Value s, Value k, Value def_v);
+Value transient_hash_set_contains(Value s, Value k);
+Force transient_hash_set_conj(Value s, Value key);
+Force transient_hash_set_disj(Value s, Value key);
+Force transient_hash_set_persistent(Value s);
 
 }
@@ -0,0 +1,132 @@
+#include "persistent_queue.hpp"
+#include "global.hpp"
+#include "hash.hpp"
+#include "list.hpp"
+#include "multimethod.hpp"
+#include "reduce.hpp"
+#include "vector.hpp"
+
+namespace cleo
+{
+
+// Queue:
+//   [front rear size]
+//   front: nil or a seq of the oldest elements, popped from the front
+//   rear: vector of the newest elements, conjed at the end and turned into the front when the front runs out
+// QueueSeq:
+//   [front rear]
+//   rear: nil or a seq of the rear vector
+
+namespace
+{
+
+Value get_front(Value q)
+{
+    return get_static_object_element(q, 0);
+}
+
+Value get_rear(Value q)
+{
+    return get_static_object_element(q, 1);
+}
+
+Force create_queue(Value front, Value rear, Int64 size)
+{
+    return create_static_object(*type::PersistentQueue, front, rear, size);
+}
+
+}
+
+Force create_persistent_queue()
+{
+    return create_queue(nil, *EMPTY_VECTOR, 0);
+}
+
+Int64 get_persistent_queue_size(Value q)
+{
+    return get_static_object_int(q, 2);
+}
+
+Force persistent_queue_peek(Value q)
+{
+    auto front = get_front(q);
+    if (front.is_nil())
+        return nil;
+    return call_multimethod1(*rt::first, front);
+}
+
+Force persistent_queue_pop(Value q)
+{
+    auto front = get_front(q);
+    if (front.is_nil())
+        return q;
+    Root next{call_multimethod1(*rt::next, front)};
+    if (*next)
+        return create_queue(*next, get_rear(q), get_persistent_queue_size(q) - 1);
+    next = call_multimethod1(*rt::seq, get_rear(q));
+    return create_queue(*next, *EMPTY_VECTOR, get_persistent_queue_size(q) - 1);
+}
+
+Force persistent_queue_conj(Value q, Value e)
+{
+    auto size = get_persistent_queue_size(q);
+    if (get_front(q).is_nil())
+    {
+        Root front{list_conj(*EMPTY_LIST, e)};
+        return create_queue(*front, get_rear(q), size + 1);
+    }
+    Root rear{get_rear(q)};
+    rear = get_value_type(*rear).is(*type::Array) ? array_vector_conj(*rear, e) : vector_conj(*rear, e);
+    return create_queue(get_front(q), *rear, size + 1);
+}
+
+Force persistent_queue_hash(Value q)
+{
+    std::uint32_t h = 0;
+    for (Root s{persistent_queue_seq(q)}; *s; s = get_persistent_queue_seq_next(*s))
+    {
+        Root e{get_persistent_queue_seq_first(*s)};
+        h = h * 31 + std::uint32_t(hash_value(*e));
+    }
+    return create_int64(std::uint32_t(h * 31 + get_persistent_queue_size(q)));
+}
+
+Force persistent_queue_reduce(Value q, Value f, Value init)
+{
+    Root acc{init};
+    for (Root s{get_front(q)}; *s; s = call_multimethod1(*rt::next, *s))
+    {
+        Root e{call_multimethod1(*rt::first, *s)};
+        acc = reduce_step(f, *acc, *e);
+        if (is_reduced(*acc))
+            return reduced_deref(*acc);
+    }
+    return call_multimethod3(*rt::coll_reduce, get_rear(q), f, *acc);
+}
+
+Force persistent_queue_seq(Value q)
+{
+    auto front = get_front(q);
+    if (front.is_nil())
+        return nil;
+    Root rear{call_multimethod1(*rt::seq, get_rear(q))};
+    return create_static_object(*type::PersistentQueueSeq, front, *rear);
+}
+
+Force get_persistent_queue_seq_first(Value s)
+{
+    return call_multimethod1(*rt::first, get_static_object_element(s, 0));
+}
+
+Force get_persistent_queue_seq_next(Value s)
+{
+    Root front{call_multimethod1(*rt::next, get_static_object_element(s, 0))};
+    auto rear = get_static_object_element(s, 1);
+    if (*front)
+        return create_static_object(*type::PersistentQueueSeq, *front, rear);
+    if (rear.is_nil())
+        return nil;
+    return create_static_object(*type::PersistentQueueSeq, rear, nil);
+}
+
+}
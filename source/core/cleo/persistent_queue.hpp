@@ -0,0 +1,18 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+Force create_persistent_queue();
+Int64 get_persistent_queue_size(Value q);
+Force persistent_queue_peek(Value q);
+Force persistent_queue_pop(Value q);
+Force persistent_queue_conj(Value q, Value e);
+Force persistent_queue_hash(Value q);
+Force persistent_queue_reduce(Value q, Value f, Value init);
+Force persistent_queue_seq(Value q);
+Force get_persistent_queue_seq_first(Value s);
+Force get_persistent_queue_seq_next(Value s);
+
+}
@@ -0,0 +1,722 @@
+#include "persistent_tree_map.hpp"
+#include "global.hpp"
+#include "array.hpp"
+#include "equality.hpp"
+#include "error.hpp"
+#include "eval.hpp"
+#include "hash.hpp"
+#include "reduce.hpp"
+#include <array>
+#include <vector>
+
+namespace cleo
+{
+
+// TreeMap:
+//   [comparator root size]
+//   comparator: nil for compare or a fn returning an Int64 or a boolean less-than
+//   root: nil, leaf or branch
+// Leaf (B+tree):
+//   [edit | key0 val0 key1 val1 ...]
+// Branch:
+//   [edit | sep0 child0 sep1 child1 ...]
+//   keys in childN are >= sepN and < sepN+1, sep0 is not used for lookups
+//   edit: 0 or the edit of the TransientTreeMap which owns the node and can update it in place
+//   non-root nodes hold between MIN_NODE_SIZE and MAX_NODE_SIZE entries or children
+// TransientTreeMap:
+//   [size edit | comparator root]
+//   edit: 0 after persistent!
+// TreeSeq:
+//   [leaf #TreeSeqParent[index branch parent]-or-nil (index << 2 | ASCENDING | KEYS)]
+
+namespace
+{
+
+constexpr std::uint32_t MAX_NODE_SIZE = 32;
+constexpr std::uint32_t MIN_NODE_SIZE = MAX_NODE_SIZE / 2;
+
+enum : Int64
+{
+    ASCENDING = 1,
+    KEYS = 2
+};
+
+Int64 compare_keys(Value comparator, Value left, Value right)
+{
+    if (comparator.is_nil())
+        return compare_values(left, right);
+    std::array<Value, 3> args{{comparator, left, right}};
+    Root result{call(args.data(), args.size())};
+    if (get_value_tag(*result) == tag::INT64)
+        return get_int64_value(*result);
+    if (*result)
+        return -1;
+    std::swap(args[1], args[2]);
+    result = call(args.data(), args.size());
+    return *result ? 1 : 0;
+}
+
+bool is_leaf(Value node)
+{
+    return get_object_type(node).is(*type::PersistentTreeMapLeaf);
+}
+
+std::uint32_t get_node_size(Value node)
+{
+    return get_dynamic_object_size(node) / 2;
+}
+
+Value get_node_key(Value node, std::uint32_t i)
+{
+    return get_dynamic_object_element(node, i * 2);
+}
+
+Value get_node_val(Value node, std::uint32_t i)
+{
+    return get_dynamic_object_element(node, i * 2 + 1);
+}
+
+void set_node_key(Value node, std::uint32_t i, Value key)
+{
+    set_dynamic_object_element(node, i * 2, key);
+}
+
+void set_node_val(Value node, std::uint32_t i, Value val)
+{
+    set_dynamic_object_element(node, i * 2 + 1, val);
+}
+
+bool is_node_editable(Value node, Int64 edit)
+{
+    return edit != 0 && get_dynamic_object_int(node, 0) == edit;
+}
+
+void copy_node_elements(Value dst, std::uint32_t dst_index, Value src, std::uint32_t src_index, std::uint32_t src_end)
+{
+    for (auto i = src_index * 2, j = dst_index * 2; i != src_end * 2; ++i, ++j)
+        set_dynamic_object_element(dst, j, get_dynamic_object_element(src, i));
+}
+
+Force create_node(Value type, Int64 edit, std::uint32_t size)
+{
+    return create_object(type, &edit, 1, nullptr, size * 2);
+}
+
+Force slice_node(Value node, Int64 edit, std::uint32_t begin, std::uint32_t end)
+{
+    Root n{create_node(get_object_type(node), edit, end - begin)};
+    copy_node_elements(*n, 0, node, begin, end);
+    return *n;
+}
+
+Force edit_node(Value node, Int64 edit)
+{
+    if (is_node_editable(node, edit))
+        return node;
+    return slice_node(node, edit, 0, get_node_size(node));
+}
+
+Force insert_node_entry(Value node, Int64 edit, std::uint32_t i, Value key, Value val)
+{
+    auto size = get_node_size(node);
+    Root n{create_node(get_object_type(node), edit, size + 1)};
+    copy_node_elements(*n, 0, node, 0, i);
+    set_node_key(*n, i, key);
+    set_node_val(*n, i, val);
+    copy_node_elements(*n, i + 1, node, i, size);
+    return *n;
+}
+
+Force remove_node_entry(Value node, Int64 edit, std::uint32_t i)
+{
+    auto size = get_node_size(node);
+    Root n{create_node(get_object_type(node), edit, size - 1)};
+    copy_node_elements(*n, 0, node, 0, i);
+    copy_node_elements(*n, i, node, i + 1, size);
+    return *n;
+}
+
+Force concat_nodes(Int64 edit, Value left, Value right, Value sep)
+{
+    auto left_size = get_node_size(left);
+    auto right_size = get_node_size(right);
+    Root n{create_node(get_object_type(left), edit, left_size + right_size)};
+    copy_node_elements(*n, 0, left, 0, left_size);
+    copy_node_elements(*n, left_size, right, 0, right_size);
+    if (!is_leaf(left))
+        set_node_key(*n, left_size, sep);
+    return *n;
+}
+
+std::uint32_t find_key(Value comparator, Value leaf, Value key, bool& found)
+{
+    std::uint32_t lo = 0, hi = get_node_size(leaf);
+    while (lo < hi)
+    {
+        auto mid = (lo + hi) / 2;
+        auto c = compare_keys(comparator, get_node_key(leaf, mid), key);
+        if (c == 0)
+        {
+            found = true;
+            return mid;
+        }
+        if (c < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    found = false;
+    return lo;
+}
+
+std::uint32_t find_child(Value comparator, Value branch, Value key)
+{
+    std::uint32_t lo = 1, hi = get_node_size(branch);
+    while (lo < hi)
+    {
+        auto mid = (lo + hi) / 2;
+        if (compare_keys(comparator, key, get_node_key(branch, mid)) < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo - 1;
+}
+
+Value tree_get(Value comparator, Value node, Value key, Value def_val)
+{
+    if (node.is_nil())
+        return def_val;
+    while (!is_leaf(node))
+        node = get_node_val(node, find_child(comparator, node, key));
+    bool found;
+    auto i = find_key(comparator, node, key, found);
+    return found ? get_node_val(node, i) : def_val;
+}
+
+Force split_node(Value node, Int64 edit, std::uint32_t inserted, bool rightmost, Root& right)
+{
+    auto size = get_node_size(node);
+    auto half = rightmost && inserted == size - 1 ? MAX_NODE_SIZE : (size + 1) / 2;
+    right = slice_node(node, edit, half, size);
+    return slice_node(node, edit, 0, half);
+}
+
+Force node_assoc(Value comparator, Int64 edit, Value node, Value key, Value val, bool rightmost, bool& added, Root& right)
+{
+    if (is_leaf(node))
+    {
+        bool found;
+        auto i = find_key(comparator, node, key, found);
+        if (found)
+        {
+            if (get_node_val(node, i).is(val))
+                return node;
+            Root n{edit_node(node, edit)};
+            set_node_val(*n, i, val);
+            return *n;
+        }
+        added = true;
+        auto size = get_node_size(node);
+        if (rightmost && i == size && size == MAX_NODE_SIZE)
+        {
+            right = create_node(*type::PersistentTreeMapLeaf, edit, 1);
+            set_node_key(*right, 0, key);
+            set_node_val(*right, 0, val);
+            return node;
+        }
+        Root n{insert_node_entry(node, edit, i, key, val)};
+        if (size < MAX_NODE_SIZE)
+            return *n;
+        return split_node(*n, edit, i, rightmost, right);
+    }
+
+    auto size = get_node_size(node);
+    auto i = find_child(comparator, node, key);
+    auto child = get_node_val(node, i);
+    Root child_right;
+    Root new_child{node_assoc(comparator, edit, child, key, val, rightmost && i == size - 1, added, child_right)};
+    if (child_right->is_nil())
+    {
+        if (new_child->is(child))
+            return node;
+        Root n{edit_node(node, edit)};
+        set_node_val(*n, i, *new_child);
+        return *n;
+    }
+    Root n{insert_node_entry(node, edit, i + 1, get_node_key(*child_right, 0), *child_right)};
+    set_node_val(*n, i, *new_child);
+    if (size < MAX_NODE_SIZE)
+        return *n;
+    return split_node(*n, edit, i + 1, rightmost, right);
+}
+
+Force node_dissoc(Value comparator, Int64 edit, Value node, Value key, bool& removed)
+{
+    if (is_leaf(node))
+    {
+        bool found;
+        auto i = find_key(comparator, node, key, found);
+        if (!found)
+            return node;
+        removed = true;
+        return remove_node_entry(node, edit, i);
+    }
+
+    auto i = find_child(comparator, node, key);
+    Root new_child{node_dissoc(comparator, edit, get_node_val(node, i), key, removed)};
+    if (!removed)
+        return node;
+    if (get_node_size(*new_child) >= MIN_NODE_SIZE)
+    {
+        Root n{edit_node(node, edit)};
+        set_node_val(*n, i, *new_child);
+        return *n;
+    }
+
+    auto l = i > 0 ? i - 1 : i;
+    auto left = l == i ? *new_child : get_node_val(node, l);
+    auto right = l == i ? get_node_val(node, l + 1) : *new_child;
+    Root merged{concat_nodes(edit, left, right, get_node_key(node, l + 1))};
+    auto merged_size = get_node_size(*merged);
+    if (merged_size <= MAX_NODE_SIZE)
+    {
+        Root n{remove_node_entry(node, edit, l + 1)};
+        set_node_val(*n, l, *merged);
+        return *n;
+    }
+    auto half = (merged_size + 1) / 2;
+    Root new_left{slice_node(*merged, edit, 0, half)};
+    Root new_right{slice_node(*merged, edit, half, merged_size)};
+    Root n{edit_node(node, edit)};
+    set_node_val(*n, l, *new_left);
+    set_node_key(*n, l + 1, get_node_key(*new_right, 0));
+    set_node_val(*n, l + 1, *new_right);
+    return *n;
+}
+
+Force tree_assoc(Value comparator, Int64 edit, Value root, Value key, Value val, bool& added)
+{
+    Root right;
+    if (root.is_nil())
+    {
+        added = true;
+        right = create_node(*type::PersistentTreeMapLeaf, edit, 1);
+        set_node_key(*right, 0, key);
+        set_node_val(*right, 0, val);
+        return *right;
+    }
+    Root left{node_assoc(comparator, edit, root, key, val, true, added, right)};
+    if (right->is_nil())
+        return *left;
+    Root n{create_node(*type::PersistentTreeMapBranch, edit, 2)};
+    set_node_val(*n, 0, *left);
+    set_node_key(*n, 1, get_node_key(*right, 0));
+    set_node_val(*n, 1, *right);
+    return *n;
+}
+
+Force tree_dissoc(Value comparator, Int64 edit, Value root, Value key, bool& removed)
+{
+    if (root.is_nil())
+        return nil;
+    Root n{node_dissoc(comparator, edit, root, key, removed)};
+    if (!removed)
+        return root;
+    if (get_node_size(*n) == 0)
+        return nil;
+    if (!is_leaf(*n) && get_node_size(*n) == 1)
+        return get_node_val(*n, 0);
+    return *n;
+}
+
+Force create_entry(Value leaf, std::uint32_t i)
+{
+    std::array<Value, 2> kv{{get_node_key(leaf, i), get_node_val(leaf, i)}};
+    return create_array(kv.data(), kv.size());
+}
+
+std::uint32_t node_hash(Value node, Int64 flags)
+{
+    std::uint32_t h = 0;
+    auto size = get_node_size(node);
+    if (!is_leaf(node))
+    {
+        for (decltype(size) i = 0; i < size; ++i)
+            h += node_hash(get_node_val(node, i), flags);
+        return h;
+    }
+    for (decltype(size) i = 0; i < size; ++i)
+        h += (flags & KEYS) ?
+            std::uint32_t(hash_value(get_node_key(node, i))) :
+            std::uint32_t(hash_value(get_node_key(node, i))) * 31 + std::uint32_t(hash_value(get_node_val(node, i)));
+    return h;
+}
+
+bool node_reduce(Value node, Int64 flags, Value f, Root& acc)
+{
+    auto size = get_node_size(node);
+    if (!is_leaf(node))
+    {
+        for (decltype(size) i = 0; i < size; ++i)
+            if (node_reduce(get_node_val(node, i), flags, f, acc))
+                return true;
+        return false;
+    }
+    for (decltype(size) i = 0; i < size; ++i)
+    {
+        if (flags & KEYS)
+            acc = reduce_step(f, *acc, get_node_key(node, i));
+        else
+        {
+            Root entry{create_entry(node, i)};
+            acc = reduce_step(f, *acc, *entry);
+        }
+        if (is_reduced(*acc))
+        {
+            acc = reduced_deref(*acc);
+            return true;
+        }
+    }
+    return false;
+}
+
+Force create_seq(Value leaf, Value parent, Int64 index, Int64 flags)
+{
+    return create_static_object(*type::PersistentTreeSeq, leaf, parent, (index << 2) | flags);
+}
+
+Force create_seq_parent(Value branch, Int64 index, Value parent)
+{
+    return create_static_object(*type::PersistentTreeSeqParent, index, branch, parent);
+}
+
+Force leaf_seq(Value node, Value parent, Int64 flags)
+{
+    bool ascending = flags & ASCENDING;
+    Root p{parent};
+    while (!is_leaf(node))
+    {
+        Int64 i = ascending ? 0 : get_node_size(node) - 1;
+        p = create_seq_parent(node, i, *p);
+        node = get_node_val(node, i);
+    }
+    return create_seq(node, *p, ascending ? 0 : get_node_size(node) - 1, flags);
+}
+
+Force next_leaf_seq(Value parent, Int64 flags)
+{
+    bool ascending = flags & ASCENDING;
+    for (; !parent.is_nil(); parent = get_static_object_element(parent, 2))
+    {
+        auto branch = get_static_object_element(parent, 1);
+        auto i = get_static_object_int(parent, 0) + (ascending ? 1 : -1);
+        if (i >= 0 && i < get_node_size(branch))
+        {
+            Root p{create_seq_parent(branch, i, get_static_object_element(parent, 2))};
+            return leaf_seq(get_node_val(branch, i), *p, flags);
+        }
+    }
+    return nil;
+}
+
+Force tree_seq(Value root, Int64 flags)
+{
+    if (root.is_nil())
+        return nil;
+    return leaf_seq(root, nil, flags);
+}
+
+Force tree_seq_from(Value comparator, Value root, Value key, Int64 flags)
+{
+    if (root.is_nil())
+        return nil;
+    Root parent;
+    auto node = root;
+    while (!is_leaf(node))
+    {
+        auto i = find_child(comparator, node, key);
+        parent = create_seq_parent(node, i, *parent);
+        node = get_node_val(node, i);
+    }
+    bool found;
+    Int64 i = find_key(comparator, node, key, found);
+    if (!(flags & ASCENDING) && !found)
+        --i;
+    if (i >= 0 && i < get_node_size(node))
+        return create_seq(node, *parent, i, flags);
+    return next_leaf_seq(*parent, flags);
+}
+
+Value get_seq_leaf(Value s)
+{
+    return get_static_object_element(s, 0);
+}
+
+Value get_seq_parent(Value s)
+{
+    return get_static_object_element(s, 1);
+}
+
+Int64 get_seq_index(Value s)
+{
+    return get_static_object_int(s, 2) >> 2;
+}
+
+Int64 get_seq_flags(Value s)
+{
+    return get_static_object_int(s, 2) & (ASCENDING | KEYS);
+}
+
+Value get_root(Value m)
+{
+    return get_static_object_element(m, 1);
+}
+
+Force create_map(Value comparator, Value root, Int64 size)
+{
+    return create_static_object(*type::PersistentTreeMap, comparator, root, size);
+}
+
+Value get_transient_comparator(Value m)
+{
+    return get_dynamic_object_element(m, 0);
+}
+
+Value get_transient_root(Value m)
+{
+    return get_dynamic_object_element(m, 1);
+}
+
+Int64 check_transient_tree_map_edit(Value m)
+{
+    auto edit = get_dynamic_object_int(m, 1);
+    if (edit == 0)
+    {
+        Root msg{create_string("Transient used after persistent! call")};
+        throw_exception(new_illegal_state(*msg));
+    }
+    return edit;
+}
+
+Int64 last_edit = 0;
+
+}
+
+Force create_persistent_tree_map(Value comparator)
+{
+    return create_map(comparator, nil, 0);
+}
+
+Value get_persistent_tree_map_comparator(Value m)
+{
+    return get_static_object_element(m, 0);
+}
+
+Int64 get_persistent_tree_map_size(Value m)
+{
+    return get_static_object_int(m, 2);
+}
+
+Int64 persistent_tree_map_compare(Value m, Value left, Value right)
+{
+    return compare_keys(get_persistent_tree_map_comparator(m), left, right);
+}
+
+Value persistent_tree_map_get(Value m, Value k)
+{
+    return persistent_tree_map_get(m, k, nil);
+}
+
+Value persistent_tree_map_get(Value m, Value k, Value def_v)
+{
+    return tree_get(get_persistent_tree_map_comparator(m), get_root(m), k, def_v);
+}
+
+Value persistent_tree_map_contains(Value m, Value k)
+{
+    return tree_get(get_persistent_tree_map_comparator(m), get_root(m), k, *SENTINEL).is(*SENTINEL) ? nil : TRUE;
+}
+
+Force persistent_tree_map_assoc(Value m, Value k, Value v)
+{
+    auto comparator = get_persistent_tree_map_comparator(m);
+    auto added = false;
+    Root root{tree_assoc(comparator, 0, get_root(m), k, v, added)};
+    if (root->is(get_root(m)))
+        return m;
+    return create_map(comparator, *root, get_persistent_tree_map_size(m) + (added ? 1 : 0));
+}
+
+Force persistent_tree_map_dissoc(Value m, Value k)
+{
+    auto comparator = get_persistent_tree_map_comparator(m);
+    auto removed = false;
+    Root root{tree_dissoc(comparator, 0, get_root(m), k, removed)};
+    if (!removed)
+        return m;
+    return create_map(comparator, *root, get_persistent_tree_map_size(m) - 1);
+}
+
+Force persistent_tree_map_hash(Value m)
+{
+    auto root = get_root(m);
+    return create_int64(root.is_nil() ? 0 : node_hash(root, 0));
+}
+
+Force persistent_tree_map_key_hash(Value m)
+{
+    auto root = get_root(m);
+    return create_int64(root.is_nil() ? 0 : node_hash(root, KEYS));
+}
+
+Force persistent_tree_map_reduce(Value m, Value f, Value init)
+{
+    Root acc{init};
+    if (!get_root(m).is_nil())
+        node_reduce(get_root(m), 0, f, acc);
+    return *acc;
+}
+
+Force persistent_tree_map_key_reduce(Value m, Value f, Value init)
+{
+    Root acc{init};
+    if (!get_root(m).is_nil())
+        node_reduce(get_root(m), KEYS, f, acc);
+    return *acc;
+}
+
+Force persistent_tree_map_seq(Value m)
+{
+    return tree_seq(get_root(m), ASCENDING);
+}
+
+Force persistent_tree_map_rseq(Value m)
+{
+    return tree_seq(get_root(m), 0);
+}
+
+Force persistent_tree_map_seq_from(Value m, Value k, Value ascending)
+{
+    return tree_seq_from(get_persistent_tree_map_comparator(m), get_root(m), k, ascending ? ASCENDING : 0);
+}
+
+Force persistent_tree_map_key_seq(Value m, bool ascending)
+{
+    return tree_seq(get_root(m), KEYS | (ascending ? ASCENDING : 0));
+}
+
+Force persistent_tree_map_key_seq_from(Value m, Value k, bool ascending)
+{
+    return tree_seq_from(get_persistent_tree_map_comparator(m), get_root(m), k, KEYS | (ascending ? ASCENDING : 0));
+}
+
+Force get_persistent_tree_seq_first(Value s)
+{
+    auto leaf = get_seq_leaf(s);
+    auto i = get_seq_index(s);
+    if (get_seq_flags(s) & KEYS)
+        return get_node_key(leaf, i);
+    return create_entry(leaf, i);
+}
+
+Force get_persistent_tree_seq_next(Value s)
+{
+    auto flags = get_seq_flags(s);
+    auto leaf = get_seq_leaf(s);
+    auto i = get_seq_index(s) + ((flags & ASCENDING) ? 1 : -1);
+    if (i >= 0 && i < get_node_size(leaf))
+        return create_seq(leaf, get_seq_parent(s), i, flags);
+    return next_leaf_seq(get_seq_parent(s), flags);
+}
+
+Force get_persistent_tree_seq_chunk_first(Value s)
+{
+    auto flags = get_seq_flags(s);
+    auto leaf = get_seq_leaf(s);
+    Int64 i = get_seq_index(s);
+    bool ascending = flags & ASCENDING;
+    std::uint32_t size = ascending ? get_node_size(leaf) - i : i + 1;
+    if (flags & KEYS)
+    {
+        std::vector<Value> keys;
+        keys.reserve(size);
+        for (; i >= 0 && i < get_node_size(leaf); i += ascending ? 1 : -1)
+            keys.push_back(get_node_key(leaf, i));
+        return create_array(keys.data(), keys.size());
+    }
+    Root chunk{create_array(nullptr, 0)};
+    chunk = transient_array(*chunk);
+    Root entry;
+    for (; i >= 0 && i < get_node_size(leaf); i += ascending ? 1 : -1)
+    {
+        entry = create_entry(leaf, i);
+        chunk = transient_array_conj(*chunk, *entry);
+    }
+    return transient_array_persistent(*chunk);
+}
+
+Force get_persistent_tree_seq_chunk_next(Value s)
+{
+    return next_leaf_seq(get_seq_parent(s), get_seq_flags(s));
+}
+
+Force transient_tree_map(Value m)
+{
+    std::array<Int64, 2> ints{{get_persistent_tree_map_size(m), ++last_edit}};
+    std::array<Value, 2> elems{{get_persistent_tree_map_comparator(m), get_root(m)}};
+    return create_object(*type::TransientTreeMap, ints.data(), ints.size(), elems.data(), elems.size());
+}
+
+Int64 get_transient_tree_map_size(Value m)
+{
+    return get_dynamic_object_int(m, 0);
+}
+
+Value transient_tree_map_get(Value m, Value k)
+{
+    return transient_tree_map_get(m, k, nil);
+}
+
+Value transient_tree_map_get(Value m, Value k, Value def_v)
+{
+    check_transient_tree_map_edit(m);
+    return tree_get(get_transient_comparator(m), get_transient_root(m), k, def_v);
+}
+
+Value transient_tree_map_contains(Value m, Value k)
+{
+    return transient_tree_map_get(m, k, *SENTINEL).is(*SENTINEL) ? nil : TRUE;
+}
+
+Force transient_tree_map_assoc(Value m, Value k, Value v)
+{
+    auto edit = check_transient_tree_map_edit(m);
+    auto added = false;
+    Root root{tree_assoc(get_transient_comparator(m), edit, get_transient_root(m), k, v, added)};
+    set_dynamic_object_element(m, 1, *root);
+    if (added)
+        set_dynamic_object_int(m, 0, get_transient_tree_map_size(m) + 1);
+    return m;
+}
+
+Force transient_tree_map_dissoc(Value m, Value k)
+{
+    auto edit = check_transient_tree_map_edit(m);
+    auto removed = false;
+    Root root{tree_dissoc(get_transient_comparator(m), edit, get_transient_root(m), k, removed)};
+    if (!removed)
+        return m;
+    set_dynamic_object_element(m, 1, *root);
+    set_dynamic_object_int(m, 0, get_transient_tree_map_size(m) - 1);
+    return m;
+}
+
+Force transient_tree_map_persistent(Value m)
+{
+    check_transient_tree_map_edit(m);
+    set_dynamic_object_int(m, 1, 0);
+    return create_map(get_transient_comparator(m), get_transient_root(m), get_transient_tree_map_size(m));
+}
+
+}
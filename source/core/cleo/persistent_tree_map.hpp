@@ -0,0 +1,39 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+Force create_persistent_tree_map(Value comparator);
+Value get_persistent_tree_map_comparator(Value m);
+Int64 get_persistent_tree_map_size(Value m);
+Int64 persistent_tree_map_compare(Value m, Value left, Value right);
+Value persistent_tree_map_get(Value m, Value k);
+Value persistent_tree_map_get(Value m, Value k, Value def_v);
+Value persistent_tree_map_contains(Value m, Value k);
+Force persistent_tree_map_assoc(Value m, Value k, Value v);
+Force persistent_tree_map_dissoc(Value m, Value k);
+Force persistent_tree_map_hash(Value m);
+Force persistent_tree_map_key_hash(Value m);
+Force persistent_tree_map_reduce(Value m, Value f, Value init);
+Force persistent_tree_map_key_reduce(Value m, Value f, Value init);
+Force persistent_tree_map_seq(Value m);
+Force persistent_tree_map_rseq(Value m);
+Force persistent_tree_map_seq_from(Value m, Value k, Value ascending);
+Force persistent_tree_map_key_seq(Value m, bool ascending);
+Force persistent_tree_map_key_seq_from(Value m, Value k, bool ascending);
+Force get_persistent_tree_seq_first(Value s);
+Force get_persistent_tree_seq_next(Value s);
+Force get_persistent_tree_seq_chunk_first(Value s);
+Force get_persistent_tree_seq_chunk_next(Value s);
+
+Force transient_tree_map(Value m);
+Int64 get_transient_tree_map_size(Value m);
+Value transient_tree_map_get(Value m, Value k);
+Value transient_tree_map_get(Value m, Value k, Value def_v);
+Value transient_tree_map_contains(Value m, Value k);
+Force transient_tree_map_assoc(Value m, Value k, Value v);
+Force transient_tree_map_dissoc(Value m, Value k);
+Force transient_tree_map_persistent(Value m);
+
+}
@@ -0,0 +1,147 @@
+#include "persistent_tree_set.hpp"
+#include "persistent_tree_map.hpp"
+#include "global.hpp"
+
+namespace cleo
+{
+
+// TreeSet:
+//   [map]
+//   map: TreeMap with the elements as keys and nil values
+// TransientTreeSet:
+//   [transient-map]
+
+namespace
+{
+
+Force create_set(Value map)
+{
+    return create_static_object(*type::PersistentTreeSet, map);
+}
+
+Value get_transient_map(Value s)
+{
+    return get_static_object_element(s, 0);
+}
+
+}
+
+Force create_persistent_tree_set(Value comparator)
+{
+    Root map{create_persistent_tree_map(comparator)};
+    return create_set(*map);
+}
+
+Value get_persistent_tree_set_map(Value s)
+{
+    return get_static_object_element(s, 0);
+}
+
+Int64 get_persistent_tree_set_size(Value s)
+{
+    return get_persistent_tree_map_size(get_persistent_tree_set_map(s));
+}
+
+Value persistent_tree_set_get(Value s, Value k)
+{
+    return persistent_tree_set_get(s, k, nil);
+}
+
+Value persistent_tree_set_get(Value s, Value k, Value def_v)
+{
+    return persistent_tree_map_contains(get_persistent_tree_set_map(s), k) ? k : def_v;
+}
+
+Value persistent_tree_set_contains(Value s, Value k)
+{
+    return persistent_tree_map_contains(get_persistent_tree_set_map(s), k);
+}
+
+Force persistent_tree_set_conj(Value s, Value k)
+{
+    auto map = get_persistent_tree_set_map(s);
+    Root new_map{persistent_tree_map_assoc(map, k, nil)};
+    if (new_map->is(map))
+        return s;
+    return create_set(*new_map);
+}
+
+Force persistent_tree_set_disj(Value s, Value k)
+{
+    auto map = get_persistent_tree_set_map(s);
+    Root new_map{persistent_tree_map_dissoc(map, k)};
+    if (new_map->is(map))
+        return s;
+    return create_set(*new_map);
+}
+
+Force persistent_tree_set_hash(Value s)
+{
+    return persistent_tree_map_key_hash(get_persistent_tree_set_map(s));
+}
+
+Force persistent_tree_set_reduce(Value s, Value f, Value init)
+{
+    return persistent_tree_map_key_reduce(get_persistent_tree_set_map(s), f, init);
+}
+
+Force persistent_tree_set_seq(Value s)
+{
+    return persistent_tree_map_key_seq(get_persistent_tree_set_map(s), true);
+}
+
+Force persistent_tree_set_rseq(Value s)
+{
+    return persistent_tree_map_key_seq(get_persistent_tree_set_map(s), false);
+}
+
+Force persistent_tree_set_seq_from(Value s, Value k, Value ascending)
+{
+    return persistent_tree_map_key_seq_from(get_persistent_tree_set_map(s), k, bool(ascending));
+}
+
+Force transient_tree_set(Value s)
+{
+    Root map{transient_tree_map(get_persistent_tree_set_map(s))};
+    return create_static_object(*type::TransientTreeSet, *map);
+}
+
+Int64 get_transient_tree_set_size(Value s)
+{
+    return get_transient_tree_map_size(get_transient_map(s));
+}
+
+Value transient_tree_set_get(Value s, Value k)
+{
+    return transient_tree_set_get(s, k, nil);
+}
+
+Value transient_tree_set_get(Value s, Value k, Value def_v)
+{
+    return transient_tree_map_contains(get_transient_map(s), k) ? k : def_v;
+}
+
+Value transient_tree_set_contains(Value s, Value k)
+{
+    return transient_tree_map_contains(get_transient_map(s), k);
+}
+
+Force transient_tree_set_conj(Value s, Value k)
+{
+    transient_tree_map_assoc(get_transient_map(s), k, nil);
+    return s;
+}
+
+Force transient_tree_set_disj(Value s, Value k)
+{
+    transient_tree_map_dissoc(get_transient_map(s), k);
+    return s;
+}
+
+Force transient_tree_set_persistent(Value s)
+{
+    Root map{transient_tree_map_persistent(get_transient_map(s))};
+    return create_set(*map);
+}
+
+}
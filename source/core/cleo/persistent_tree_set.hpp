@@ -0,0 +1,30 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+Force create_persistent_tree_set(Value comparator);
+Value get_persistent_tree_set_map(Value s);
+Int64 get_persistent_tree_set_size(Value s);
+Value persistent_tree_set_get(Value s, Value k);
+Value persistent_tree_set_get(Value s, Value k, Value def_v);
+Value persistent_tree_set_contains(Value s, Value k);
+Force persistent_tree_set_conj(Value s, Value k);
+Force persistent_tree_set_disj(Value s, Value k);
+Force persistent_tree_set_hash(Value s);
+Force persistent_tree_set_reduce(Value s, Value f, Value init);
+Force persistent_tree_set_seq(Value s);
+Force persistent_tree_set_rseq(Value s);
+Force persistent_tree_set_seq_from(Value s, Value k, Value ascending);
+
+Force transient_tree_set(Value s);
+Int64 get_transient_tree_set_size(Value s);
+Value transient_tree_set_get(Value s, Value k);
+Value transient_tree_set_get(Value s, Value k, Value def_v);
+Value transient_tree_set_contains(Value s, Value k);
+Force transient_tree_set_conj(Value s, Value k);
+Force transient_tree_set_disj(Value s, Value k);
+Force transient_tree_set_persistent(Value s);
+
+}
@@ -7,51 +7,92 @@
 #include "array_map.hpp"
 #include "persistent_hash_map.hpp"
 #include "persistent_hash_set.hpp"
+#include "persistent_tree_map.hpp"
+#include "persistent_tree_set.hpp"
+#include "vector.hpp"
 #include "error.hpp"
+#include "eval.hpp"
 #include "util.hpp"
-#include <sstream>
+#include "string_builder.hpp"
+#include <array>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
 
 namespace cleo
 {
+
+void Output::flush()
+{
+    if (&buf != &own)
+        return;
+    if (sb)
+        *sb = string_builder_append(**sb, own.data(), own.size());
+    else
+    {
+        for (std::size_t written = 0; written < own.size();)
+        {
+            auto r = ::write(fd, own.data() + written, own.size() - written);
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r <= 0)
+            {
+                auto err = r < 0 ? errno : EIO;
+                own.clear();
+                Root msg{create_string(std::string("Write failed: ") + std::strerror(err))};
+                throw_exception(new_illegal_state(*msg));
+            }
+            written += r;
+        }
+    }
+    own.clear();
+}
+
 namespace
 {
 
-Force pr_str_native_function(Value fn)
+void append_hex(Output& out, Value val)
 {
-    std::ostringstream os;
-    os << "#cleo.core/NativeFunction[" << to_string(get_native_function_name(fn)) << " 0x" << std::hex << fn.bits() << "]";
-    return create_string(os.str());
+    char hex[24];
+    auto n = std::snprintf(hex, sizeof(hex), "0x%" PRIx64, std::uint64_t(val.bits()));
+    out.append(hex, n);
 }
 
-Force pr_str_symbol(Value sym)
+void append_string(Output& out, Value s)
 {
-    auto ns = get_keyword_namespace(sym);
-    auto name = get_keyword_name(sym);
-    std::string s;
-    s.reserve(1 + (!ns ? 0 : get_string_size(ns)) + get_string_size(name));
-    if (ns)
-    {
-        s.append(get_string_ptr(ns), get_string_size(ns));
-        s += '/';
-    }
-    s.append(get_string_ptr(name), get_string_size(name));
-    return create_string(s);
+    out.append(get_string_ptr(s), get_string_size(s));
+}
+
+void pr_str_native_function(Output& out, Value fn)
+{
+    out += "#cleo.core/NativeFunction[";
+    pr_str(out, get_native_function_name(fn));
+    out += ' ';
+    append_hex(out, fn);
+    out += ']';
 }
 
-Force pr_str_keyword(Value kw)
+void pr_str_name(Output& out, Value ns, Value name)
 {
-    auto ns = get_keyword_namespace(kw);
-    auto name = get_keyword_name(kw);
-    std::string s;
-    s.reserve(1 + (!ns ? 0 : get_string_size(ns)) + get_string_size(name));
-    s += ':';
     if (ns)
     {
-        s.append(get_string_ptr(ns), get_string_size(ns));
-        s += '/';
+        append_string(out, ns);
+        out += '/';
     }
-    s.append(get_string_ptr(name), get_string_size(name));
-    return create_string(s);
+    append_string(out, name);
+}
+
+void pr_str_symbol(Output& out, Value sym)
+{
+    pr_str_name(out, get_symbol_namespace(sym), get_symbol_name(sym));
+}
+
+void pr_str_keyword(Output& out, Value kw)
+{
+    out += ':';
+    pr_str_name(out, get_keyword_namespace(kw), get_keyword_name(kw));
 }
 
 char hex_digit(int x)
@@ -59,284 +100,419 @@ char hex_digit(int x)
     return "0123456789abcdef"[x & 0xf];
 }
 
-Force print_utf_char(Char32 ch)
+void print_utf_char(Output& out, Char32 ch)
 {
     if (ch < 0x80)
     {
-        char c = static_cast<unsigned char>(ch);
-        return create_string(&c, 1);
+        out += char(static_cast<unsigned char>(ch));
+        return;
     }
     if (ch < 0x800)
     {
-        std::array<char, 2> s{{char(static_cast<unsigned char>(0xc0 | (ch >> 6))),
-                               char(static_cast<unsigned char>(0x80 | (ch & 0x3f)))}};
-        return create_string(s.data(), s.size());
+        out += char(static_cast<unsigned char>(0xc0 | (ch >> 6)));
+        out += char(static_cast<unsigned char>(0x80 | (ch & 0x3f)));
+        return;
     }
     if (ch < 0x10000)
     {
-        std::array<char, 3> s{{char(static_cast<unsigned char>(0xe0 | (ch >> 12))),
-                               char(static_cast<unsigned char>(0x80 | ((ch >> 6) & 0x3f))),
-                               char(static_cast<unsigned char>(0x80 | (ch & 0x3f)))}};
-        return create_string(s.data(), s.size());
+        out += char(static_cast<unsigned char>(0xe0 | (ch >> 12)));
+        out += char(static_cast<unsigned char>(0x80 | ((ch >> 6) & 0x3f)));
+        out += char(static_cast<unsigned char>(0x80 | (ch & 0x3f)));
+        return;
     }
 
-    std::array<char, 4> s{{char(static_cast<unsigned char>(0xf0 | (ch >> 18))),
-                char(static_cast<unsigned char>(0x80 | ((ch >> 12) & 0x3f))),
-                char(static_cast<unsigned char>(0x80 | ((ch >> 6) & 0x3f))),
-                char(static_cast<unsigned char>(0x80 | (ch & 0x3f)))}};
-    return create_string(s.data(), s.size());
+    out += char(static_cast<unsigned char>(0xf0 | (ch >> 18)));
+    out += char(static_cast<unsigned char>(0x80 | ((ch >> 12) & 0x3f)));
+    out += char(static_cast<unsigned char>(0x80 | ((ch >> 6) & 0x3f)));
+    out += char(static_cast<unsigned char>(0x80 | (ch & 0x3f)));
 }
 
-Force pr_str_char(Value val)
+void pr_str_char(Output& out, Value val)
 {
     auto ch = get_uchar_value(val);
     if (!*rt::print_readably)
-        return print_utf_char(ch);
+        return print_utf_char(out, ch);
     if (ch >= 0x10000)
     {
         std::array<char, 8> hex{{'\\', 'u', hex_digit(ch >> 20), hex_digit(ch >> 16), hex_digit(ch >> 12), hex_digit(ch >> 8), hex_digit(ch >> 4), hex_digit(ch)}};
-        return create_string(hex.data(), hex.size());
+        out.append(hex.data(), hex.size());
+        return;
     }
     if (ch >= 0x100)
     {
         std::array<char, 6> hex{{'\\', 'u', hex_digit(ch >> 12), hex_digit(ch >> 8), hex_digit(ch >> 4), hex_digit(ch)}};
-        return create_string(hex.data(), hex.size());
+        out.append(hex.data(), hex.size());
+        return;
     }
     switch (ch)
     {
-    case 8: return create_string("\\backspace");
-    case 9: return create_string("\\tab");
-    case 10: return create_string("\\newline");
-    case 12: return create_string("\\formfeed");
-    case 13: return create_string("\\return");
-    case 32: return create_string("\\space");
+    case 8: out += "\\backspace"; return;
+    case 9: out += "\\tab"; return;
+    case 10: out += "\\newline"; return;
+    case 12: out += "\\formfeed"; return;
+    case 13: out += "\\return"; return;
+    case 32: out += "\\space"; return;
     }
     if (ch < 32 || ch >= 127)
     {
         std::array<char, 4> hex{{'\\', 'u', hex_digit(ch >> 4), hex_digit(ch)}};
-        return create_string(hex.data(), hex.size());
+        out.append(hex.data(), hex.size());
+        return;
     }
-    std::array<char, 2> escaped{{'\\', char(static_cast<unsigned char>(ch))}};
-    return create_string(escaped.data(), escaped.size());
-}
-
-Force pr_str_float(Value val)
-{
-    std::ostringstream os;
-    os << get_float64_value(val);
-    auto s = os.str();
-    if (s.find('.') == std::string::npos && s.find('e') == std::string::npos)
-        s += ".0";
-    return create_string(s);
+    out += '\\';
+    out += char(static_cast<unsigned char>(ch));
 }
 
-Force pr_str_string(Value val)
+void pr_str_string(Output& out, Value val)
 {
     if (!*rt::print_readably)
-        return val;
-    std::string s;
-    s.reserve(2 * get_string_size(val) + 2);
-    s += '\"';
-    auto p = get_string_ptr(val);
+        return append_string(out, val);
+    out.reserve(2 * get_string_size(val) + 2);
+    out += '\"';
+    auto s = get_string_ptr(val);
+    auto p = s.data();
     auto e = p + get_string_size(val);
     for (; p != e; ++p)
         switch (*p)
         {
-            case '\t': s += "\\t"; break;
-            case '\r': s += "\\r"; break;
-            case '\n': s += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            case '\r': out += "\\r"; break;
+            case '\n': out += "\\n"; break;
             case '\\':
             case '\"':
             case '\'':
-                s += '\\';
-                s += *p;
+                out += '\\';
+                out += *p;
                 break;
-            case '\0': s += "\\0"; break;
+            case '\0': out += "\\0"; break;
             default:
                 if (*p < 0x20 || std::uint8_t(*p) >= 0x7f)
                 {
-                    s += "\\x";
-                    s += hex_digit(*p >> 4);
-                    s += hex_digit(*p);
+                    out += "\\x";
+                    out += hex_digit(*p >> 4);
+                    out += hex_digit(*p);
                 }
                 else
-                    s += *p;
+                    out += *p;
         }
-    s += '\"';
-    return create_string(s);
+    out += '\"';
 }
 
-}
-
-Force pr_str_object(Value val)
+void pr_str_object(Output& out, Value val)
 {
     if (get_value_tag(val) != tag::OBJECT)
     {
         Root msg{create_string("expected an object")};
         throw_exception(new_illegal_argument(*msg));
     }
-    Root type{pr_str(get_object_type(val))};
-    std::ostringstream os;
-    os << '#' << std::string(get_string_ptr(*type), get_string_size(*type)) << "[0x" << std::hex << val.bits() << "]";
-    return create_string(os.str());
+    out += '#';
+    pr_str(out, get_object_type(val));
+    out += '[';
+    append_hex(out, val);
+    out += ']';
 }
 
-Force pr_str_array(Value v)
+void pr_str_array(Output& out, Value v)
 {
-    std::string str;
-    str += '[';
+    out += '[';
     auto size = get_array_size(v);
     for (decltype(size) i = 0; i != size; ++i)
     {
         if (i > 0)
-            str += ' ';
-        Root s{pr_str(get_array_elem(v, i))};
-        str.append(get_string_ptr(*s), get_string_size(*s));
+            out += ' ';
+        pr_str(out, get_array_elem(v, i));
     }
-    str += ']';
-    return create_string(str);
+    out += ']';
 }
 
-Force pr_str_array_set(Value s)
+void pr_str_array_set(Output& out, Value s)
 {
-    std::string str;
-    str += "#{";
+    out += "#{";
     auto size = get_array_set_size(s);
     for (decltype(size) i = 0; i != size; ++i)
     {
         if (i > 0)
-            str += ' ';
-        Root ss{pr_str(get_array_set_elem(s, i))};
-        str.append(get_string_ptr(*ss), get_string_size(*ss));
+            out += ' ';
+        pr_str(out, get_array_set_elem(s, i));
     }
-    str += '}';
-    return create_string(str);
+    out += '}';
 }
 
-Force pr_str_persistent_hash_set(Value val)
+void pr_str_persistent_hash_set(Output& out, Value val)
 {
-    std::string str;
-    str += "#{";
+    out += "#{";
+    bool first_elem = true;
     for (Root seq{persistent_hash_set_seq(val)}; *seq; seq = get_persistent_hash_set_seq_next(*seq))
     {
-        if (str.back() != '{')
-            str += ' ';
-        Root ss{pr_str(get_persistent_hash_set_seq_first(*seq))};
-        str.append(get_string_ptr(*ss), get_string_size(*ss));
+        if (first_elem)
+            first_elem = false;
+        else
+            out += ' ';
+        pr_str(out, get_persistent_hash_set_seq_first(*seq));
     }
-    str += '}';
-    return create_string(str);
+    out += '}';
 }
 
-Force pr_str_array_map(Value m)
+void pr_str_array_map(Output& out, Value m)
 {
-    std::string str;
-    str += '{';
+    out += '{';
     auto size = get_array_map_size(m);
     for (decltype(size) i = 0; i != size; ++i)
     {
         if (i > 0)
-            str += ", ";
-        Root s{pr_str(get_array_map_key(m, i))};
-        str.append(get_string_ptr(*s), get_string_size(*s));
-        str += ' ';
-        s = pr_str(get_array_map_val(m, i));
-        str.append(get_string_ptr(*s), get_string_size(*s));
+            out += ", ";
+        pr_str(out, get_array_map_key(m, i));
+        out += ' ';
+        pr_str(out, get_array_map_val(m, i));
     }
-    str += '}';
-    return create_string(str);
+    out += '}';
 }
 
-Force pr_str_persistent_hash_map(Value val)
+void pr_str_persistent_hash_map(Output& out, Value val)
 {
-    std::string str;
-    str += '{';
+    out += '{';
+    bool first_elem = true;
     for (Root seq{persistent_hash_map_seq(val)}; *seq; seq = get_persistent_hash_map_seq_next(*seq))
     {
         auto kv = get_persistent_hash_map_seq_first(*seq);
-        if (str.back() != '{')
-            str += ", ";
-        Root s{pr_str(get_array_elem(kv, 0))};
-        str.append(get_string_ptr(*s), get_string_size(*s));
-        str += ' ';
-        s = pr_str(get_array_elem(kv, 1));
-        str.append(get_string_ptr(*s), get_string_size(*s));
+        if (first_elem)
+            first_elem = false;
+        else
+            out += ", ";
+        pr_str(out, get_array_elem(kv, 0));
+        out += ' ';
+        pr_str(out, get_array_elem(kv, 1));
     }
-    str += '}';
-    return create_string(str);
+    out += '}';
 }
 
-namespace
+void pr_str_persistent_tree_set(Output& out, Value val)
 {
-Force pr_str_seqable(Value v, char open_char, char close_char)
+    out += "#{";
+    bool first_elem = true;
+    for (Root seq{persistent_tree_set_seq(val)}; *seq; seq = get_persistent_tree_seq_next(*seq))
+    {
+        if (first_elem)
+            first_elem = false;
+        else
+            out += ' ';
+        Root e{get_persistent_tree_seq_first(*seq)};
+        pr_str(out, *e);
+    }
+    out += '}';
+}
+
+void pr_str_persistent_tree_map(Output& out, Value val)
 {
-    std::string str;
-    str += open_char;
+    out += '{';
+    bool first_elem = true;
+    for (Root seq{persistent_tree_map_seq(val)}; *seq; seq = get_persistent_tree_seq_next(*seq))
+    {
+        Root kv{get_persistent_tree_seq_first(*seq)};
+        if (first_elem)
+            first_elem = false;
+        else
+            out += ", ";
+        pr_str(out, get_array_elem(*kv, 0));
+        out += ' ';
+        pr_str(out, get_array_elem(*kv, 1));
+    }
+    out += '}';
+}
+
+void pr_str_seqable(Output& out, Value v, char open_char, char close_char)
+{
+    out += open_char;
     bool first_elem = true;
     for (Root s{call_multimethod1(*rt::seq, v)}; *s; s = call_multimethod1(*rt::next, *s))
     {
         if (first_elem)
             first_elem = false;
         else
-            str += ' ';
+            out += ' ';
 
         Root f{call_multimethod1(*rt::first, *s)};
-        Root ss{pr_str(*f)};
-        str.append(get_string_ptr(*ss), get_string_size(*ss));
+        pr_str(out, *f);
     }
-    str += close_char;
-    return create_string(str);
+    out += close_char;
 }
+
+void pr_str_seqable(Output& out, Value v)
+{
+    pr_str_seqable(out, v, '(', ')');
 }
 
-Force pr_str_seqable(Value v)
+void pr_str_vector(Output& out, Value v)
 {
-    return pr_str_seqable(v, '(', ')');
+    // Byte and typed arrays are persistent vectors too and go through their seqs
+    if (!get_value_type(v).is(*type::Vector))
+        return pr_str_seqable(out, v, '[', ']');
+    out += '[';
+    auto size = get_vector_size(v);
+    for (decltype(size) i = 0; i != size; ++i)
+    {
+        if (i > 0)
+            out += ' ';
+        pr_str(out, get_vector_elem(v, i));
+    }
+    out += ']';
 }
 
-Force pr_str_vector(Value v)
+using Printer = void (*)(Output& out, Value val);
+
+template <Printer print>
+Force native_pr_str_obj(const Value *args, std::uint8_t num_args)
 {
-    return pr_str_seqable(v, '[', ']');
+    if (num_args != 1)
+        throw_arity_error(PR_STR_OBJ, num_args);
+    std::string str;
+    Output out{str};
+    print(out, args[0]);
+    return create_string(str);
 }
 
-Force pr_str_object_type(Value v)
+}
+
+Force pr_str_object(const Value *args, std::uint8_t num_args) { return native_pr_str_obj<pr_str_object>(args, num_args); }
+Force pr_str_array(const Value *args, std::uint8_t num_args) { return native_pr_str_obj<pr_str_array>(args, num_args); }
+Force pr_str_array_set(const Value *args, std::uint8_t num_args) { return native_pr_str_obj<pr_str_array_set>(args, num_args); }
+Force pr_str_persistent_hash_set(const Value *args, std::uint8_t num_args) { return native_pr_str_obj<pr_str_persistent_hash_set>(args, num_args); }
+Force pr_str_array_map(const Value *args, std::uint8_t num_args) { return native_pr_str_obj<pr_str_array_map>(args, num_args); }
+Force pr_str_persistent_hash_map(const Value *args, std::uint8_t num_args) { return native_pr_str_obj<pr_str_persistent_hash_map>(args, num_args); }
+Force pr_str_persistent_tree_set(const Value *args, std::uint8_t num_args) { return native_pr_str_obj<pr_str_persistent_tree_set>(args, num_args); }
+Force pr_str_persistent_tree_map(const Value *args, std::uint8_t num_args) { return native_pr_str_obj<pr_str_persistent_tree_map>(args, num_args); }
+Force pr_str_seqable(const Value *args, std::uint8_t num_args) { return native_pr_str_obj<pr_str_seqable>(args, num_args); }
+Force pr_str_vector(const Value *args, std::uint8_t num_args) { return native_pr_str_obj<pr_str_vector>(args, num_args); }
+
+namespace
+{
+
+struct NativePrinter
 {
-    return pr_str(get_object_type_name(v));
+    NativeFunction fn;
+    Printer print;
+};
+
+const std::array<NativePrinter, 10> native_printers{{
+    {cleo::pr_str_object, pr_str_object},
+    {cleo::pr_str_array, pr_str_array},
+    {cleo::pr_str_array_set, pr_str_array_set},
+    {cleo::pr_str_persistent_hash_set, pr_str_persistent_hash_set},
+    {cleo::pr_str_array_map, pr_str_array_map},
+    {cleo::pr_str_persistent_hash_map, pr_str_persistent_hash_map},
+    {cleo::pr_str_persistent_tree_set, pr_str_persistent_tree_set},
+    {cleo::pr_str_persistent_tree_map, pr_str_persistent_tree_map},
+    {cleo::pr_str_seqable, pr_str_seqable},
+    {cleo::pr_str_vector, pr_str_vector}}};
+
+Printer find_native_printer(Value method)
+{
+    if (get_value_tag(method) != tag::NATIVE_FUNCTION)
+        return nullptr;
+    auto fn = get_native_function_ptr(method);
+    for (auto& p : native_printers)
+        if (p.fn == fn)
+            return p.print;
+    return nullptr;
 }
 
-Force pr_str_protocol(Value v)
+void pr_str_float(Output& out, Value val)
 {
-    return pr_str(get_protocol_name(v));
+    char s[32];
+    auto n = std::snprintf(s, sizeof(s), "%g", get_float64_value(val));
+    out.append(s, n);
+    if (!std::memchr(s, '.', n) && !std::memchr(s, 'e', n))
+        out += ".0";
 }
 
-Force pr_str(Value val)
+void pr_str_obj(Output& out, Value val)
+{
+    // One method lookup per object: native printers append straight into out,
+    // only methods defined elsewhere produce an intermediate string
+    auto method = get_method(*rt::pr_str_obj, get_value_type(val));
+    if (!method)
+        throw_illegal_argument("multimethod not matched: " + to_string(PR_STR_OBJ));
+    if (auto print = find_native_printer(method))
+        return print(out, val);
+    std::array<Value, 2> fcall{{method, val}};
+    Root s{call(fcall.data(), fcall.size())};
+    append_string(out, *s);
+}
+
+}
+
+void pr_str(Output& out, Value val)
 {
     switch (get_value_tag(val))
     {
-        case tag::NATIVE_FUNCTION: return pr_str_native_function(val);
-        case tag::SYMBOL: return pr_str_symbol(val);
-        case tag::KEYWORD: return pr_str_keyword(val);
-        case tag::INT64: return create_string(std::to_string(get_int64_value(val)));
-        case tag::UCHAR: return pr_str_char(val);
-        case tag::FLOAT64: return pr_str_float(val);
-        case tag::UTF8STRING: return pr_str_string(val);
-        case tag::OBJECT_TYPE: return pr_str_object_type(val);
-        case tag::PROTOCOL: return pr_str_protocol(val);
+        case tag::NATIVE_FUNCTION: return pr_str_native_function(out, val);
+        case tag::SYMBOL: return pr_str_symbol(out, val);
+        case tag::KEYWORD: return pr_str_keyword(out, val);
+        case tag::INT64: out += std::to_string(get_int64_value(val)); return;
+        case tag::UCHAR: return pr_str_char(out, val);
+        case tag::FLOAT64: return pr_str_float(out, val);
+        case tag::UTF8STRING: return pr_str_string(out, val);
+        case tag::OBJECT_TYPE: return pr_str(out, get_object_type_name(val));
+        case tag::PROTOCOL: return pr_str(out, get_protocol_name(val));
         default: // tag::OBJECT
             if (val.is_nil())
-                return create_string("nil");
-            if (val.is(TRUE))
-                return create_string("true");
-            return call_multimethod(*rt::pr_str_obj, &val, 1);
+                out += "nil";
+            else if (val.is(TRUE))
+                out += "true";
+            else
+                pr_str_obj(out, val);
     }
 }
 
+Force pr_str(Value val)
+{
+    if (get_value_tag(val) == tag::UTF8STRING && !*rt::print_readably)
+        return val;
+    std::string str;
+    pr_str(str, val);
+    return create_string(str);
+}
+
+void pr_str(std::string& str, Value val)
+{
+    Output out{str};
+    pr_str(out, val);
+}
+
+void print_str(Output& out, Value val)
+{
+    switch (get_value_tag(val))
+    {
+        case tag::UTF8STRING: return append_string(out, val);
+        case tag::UCHAR: return print_utf_char(out, get_uchar_value(val));
+        case tag::OBJECT:
+            if (*rt::print_readably && !val.is_nil() && !val.is(TRUE))
+            {
+                Root bindings{*EMPTY_MAP};
+                bindings = map_assoc(*bindings, PRINT_READABLY, nil);
+                PushBindingsGuard guard{*bindings};
+                return pr_str(out, val);
+            }
+            break;
+        default:
+            break;
+    }
+    pr_str(out, val);
+}
+
 Force print_str(Value val)
 {
-    Root bindings{*EMPTY_MAP};
-    bindings = map_assoc(*bindings, PRINT_READABLY, nil);
-    PushBindingsGuard guard{*bindings};
-    return pr_str(val);
+    if (get_value_tag(val) == tag::UTF8STRING)
+        return val;
+    std::string str;
+    print_str(str, val);
+    return create_string(str);
+}
+
+void print_str(std::string& str, Value val)
+{
+    Output out{str};
+    print_str(out, val);
 }
 
 }
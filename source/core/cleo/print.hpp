@@ -1,20 +1,66 @@
 #pragma once
 #include "value.hpp"
+#include <string>
 
 namespace cleo
 {
 
-Force pr_str_object(Value val);
-Force pr_str_array(Value val);
-Force pr_str_array_set(Value s);
-Force pr_str_persistent_hash_set(Value val);
-Force pr_str_array_map(Value val);
-Force pr_str_persistent_hash_map(Value val);
-Force pr_str_seqable(Value v);
-Force pr_str_vector(Value v);
+class Root;
 
+// Where printers write. Printing into a std::string appends to it directly.
+// Printing to a file descriptor or a StringBuilder collects the output in a
+// buffer which is written out whenever it fills up and on flush(), so large
+// values are printed in constant memory. Buffered output which is not flushed
+// is discarded.
+class Output
+{
+public:
+    explicit Output(std::string& str) : buf(str) { }
+    explicit Output(int fd) : buf(own), fd(fd) { }
+    explicit Output(Root& sb) : buf(own), sb(&sb) { }
+    Output(const Output& ) = delete;
+    Output& operator=(const Output& ) = delete;
+
+    Output& operator+=(char c) { buf += c; return *this; }
+    Output& operator+=(const char *s) { return append(s, std::char_traits<char>::length(s)); }
+    Output& operator+=(const std::string& s) { return append(s.data(), s.size()); }
+    Output& append(const char *s, std::size_t size)
+    {
+        buf.append(s, size);
+        if (buf.size() >= FLUSH_SIZE && &buf == &own)
+            flush();
+        return *this;
+    }
+    void reserve(std::size_t extra) { buf.reserve(buf.size() + extra); }
+    void flush();
+
+private:
+    static const std::size_t FLUSH_SIZE = 65536;
+
+    std::string own;
+    std::string& buf;
+    int fd = -1;
+    Root *sb = nullptr;
+};
+
+Force pr_str_object(const Value *args, std::uint8_t num_args);
+Force pr_str_array(const Value *args, std::uint8_t num_args);
+Force pr_str_array_set(const Value *args, std::uint8_t num_args);
+Force pr_str_persistent_hash_set(const Value *args, std::uint8_t num_args);
+Force pr_str_array_map(const Value *args, std::uint8_t num_args);
+Force pr_str_persistent_hash_map(const Value *args, std::uint8_t num_args);
+Force pr_str_persistent_tree_set(const Value *args, std::uint8_t num_args);
+Force pr_str_persistent_tree_map(const Value *args, std::uint8_t num_args);
+Force pr_str_seqable(const Value *args, std::uint8_t num_args);
+Force pr_str_vector(const Value *args, std::uint8_t num_args);
+
+// Appends the printed representation of val to out
+void pr_str(Output& out, Value val);
+void pr_str(std::string& out, Value val);
 Force pr_str(Value val);
 
+void print_str(Output& out, Value val);
+void print_str(std::string& out, Value val);
 Force print_str(Value val);
 
 }
@@ -1,18 +1,205 @@
 #include "reader.hpp"
 #include "list.hpp"
 #include "array.hpp"
+#include "array_map.hpp"
 #include "global.hpp"
 #include "error.hpp"
 #include "print.hpp"
 #include "namespace.hpp"
 #include "util.hpp"
 #include "multimethod.hpp"
+#include "byte_array.hpp"
+#include "simd.hpp"
+#include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <cstring>
 #include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace cleo
 {
 
+// Reader:
+//   [fd start end line col | buffer]
+// where buffer is a ByteArray holding the unread input between start and end.
+// fd is -1 once the whole file has been read or the reader has been closed.
+
+namespace
+{
+
+const Int64 READER_BUFFER_SIZE = 65536;
+
+enum ReaderField { FD, START, END, LINE, COL };
+
+char *get_buffer_data(Value buffer)
+{
+    return static_cast<char *>(get_dynamic_object_mut_int_ptr(buffer, 1));
+}
+
+Force create_buffer(Int64 size)
+{
+    Root b{create_object(*type::ByteArray, nullptr, 1 + (size + sizeof(Int64) - 1) / sizeof(Int64), nullptr, 0)};
+    set_dynamic_object_int(*b, 0, size);
+    return *b;
+}
+
+}
+
+ReaderStream::ReaderStream(Value source)
+{
+    if (get_value_tag(source) == tag::UTF8STRING)
+    {
+        text = get_string_ptr(source);
+        base = cur = text;
+        end = cur + get_string_size(source);
+        return;
+    }
+    reader = source;
+    auto data = get_buffer_data(get_dynamic_object_element(reader, 0));
+    base = cur = data + get_dynamic_object_int(reader, START);
+    end = data + get_dynamic_object_int(reader, END);
+    line = get_dynamic_object_int(reader, LINE);
+    col = get_dynamic_object_int(reader, COL);
+}
+
+ReaderStream::~ReaderStream()
+{
+    if (!reader)
+        return;
+    auto p = pos();
+    auto data = get_buffer_data(get_dynamic_object_element(reader, 0));
+    set_dynamic_object_int(reader, START, cur - data);
+    set_dynamic_object_int(reader, END, end - data);
+    set_dynamic_object_int(reader, LINE, p.line);
+    set_dynamic_object_int(reader, COL, p.col);
+}
+
+ReaderStream::Position ReaderStream::pos(Mark m) const
+{
+    Position p{line, col};
+    auto last = base + m;
+    for (auto q = base; q != last;)
+    {
+        auto nl = static_cast<const char *>(std::memchr(q, '\n', last - q));
+        if (!nl)
+        {
+            p.col += last - q;
+            break;
+        }
+        ++p.line;
+        p.col = 1;
+        q = nl + 1;
+    }
+    return p;
+}
+
+bool ReaderStream::refill(std::uint32_t n)
+{
+    if (!reader)
+        return false;
+    auto fd = get_dynamic_object_int(reader, FD);
+    if (fd < 0)
+        return false;
+    auto buffer = get_dynamic_object_element(reader, 0);
+    auto capacity = get_byte_array_size(buffer);
+    Int64 offset = cur - base;
+    Int64 left = end - base;
+    auto needed = std::max(offset + n, left) + 1;
+    if (needed > capacity)
+    {
+        Root bigger{create_buffer(std::max(capacity * 2, needed))};
+        set_dynamic_object_element(reader, 0, *bigger);
+        buffer = *bigger;
+        capacity = get_byte_array_size(buffer);
+    }
+    auto data = get_buffer_data(buffer);
+    std::memmove(data, base, left);
+    base = data;
+    cur = data + offset;
+    end = data + left;
+    while (end - cur <= std::ptrdiff_t(n))
+    {
+        auto r = ::read(fd, data + left, capacity - left);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+        {
+            ::close(fd);
+            set_dynamic_object_int(reader, FD, -1);
+            break;
+        }
+        left += r;
+        end = data + left;
+    }
+    return end - cur > std::ptrdiff_t(n);
+}
+
+MappedFile::MappedFile(const std::string& path)
+{
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+    size_ = st.st_size;
+    if (size_ == 0)
+        return;
+    addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        addr = nullptr;
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+    ::madvise(addr, size_, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+    if (addr)
+        ::munmap(addr, size_);
+    if (fd >= 0)
+        ::close(fd);
+}
+
+Force create_reader(Value path)
+{
+    check_type("path", path, *type::UTF8String);
+    std::string p{get_string_ptr(path), get_string_size(path)};
+    auto fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        Root msg{create_string("Could not open " + p + ": " + std::strerror(errno))};
+        throw_exception(new_file_not_found(*msg));
+    }
+    Root buffer{create_buffer(READER_BUFFER_SIZE)};
+    Int64 ints[] = {fd, 0, 0, 1, 1};
+    Value elems[] = {*buffer};
+    return create_object(*type::Reader, ints, 5, elems, 1);
+}
+
+Value close_reader(Value reader)
+{
+    check_type("reader", reader, *type::Reader);
+    auto fd = get_dynamic_object_int(reader, FD);
+    if (fd >= 0)
+        ::close(fd);
+    set_dynamic_object_int(reader, FD, -1);
+    set_dynamic_object_int(reader, START, 0);
+    set_dynamic_object_int(reader, END, 0);
+    return nil;
+}
+
 namespace
 {
 
@@ -28,9 +215,9 @@ using Stream = ReaderStream;
 bool is_symbol_char(char c)
 {
     return
-        std::isalpha(c) || std::isdigit(c) || c == '-' || c == '+' ||
-        c == '.' || c == '*' || c == '=' || c == '<' || c == '>' || c == '&' ||
-        c == '!' || c == '?' || c == '#' || c == '_';
+        (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+        c == '-' || c == '+' || c == '.' || c == '*' || c == '=' || c == '<' || c == '>' ||
+        c == '&' || c == '!' || c == '?' || c == '#' || c == '_';
 }
 
 bool is_char_char(char c)
@@ -43,109 +230,273 @@ bool is_ws(char c)
     return c <= ' ' || c == ',';
 }
 
-Force read_integer(const std::string& n, Stream::Position pos)
+// Whitespace, symbols, numbers and string bodies are skipped 16 bytes at a
+// time with SSE2 on x86-64 and one byte at a time elsewhere. Each kernel
+// returns the first byte of [p, end) which ends the run.
+
+namespace scalar
+{
+
+const char *skip_ws(const char *p, const char *end)
+{
+    while (p != end && is_ws(*p))
+        ++p;
+    return p;
+}
+
+const char *find_token_end(const char *p, const char *end, bool slash)
+{
+    while (p != end && (is_symbol_char(*p) || (slash && *p == '/')))
+        ++p;
+    return p;
+}
+
+const char *find_string_end(const char *p, const char *end)
+{
+    while (p != end && *p != '\"' && *p != '\\')
+        ++p;
+    return p;
+}
+
+}
+
+#ifdef __x86_64__
+
+namespace sse2
+{
+
+__m128i in_range(__m128i b, char lo, char hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(b, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), b));
+}
+
+__m128i load(const char *p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+const char *skip_ws(const char *p, const char *end)
+{
+    auto space = _mm_set1_epi8(' ');
+    auto comma = _mm_set1_epi8(',');
+    for (; end - p >= 16; p += 16)
+    {
+        auto b = load(p);
+        unsigned mask = _mm_movemask_epi8(_mm_andnot_si128(_mm_cmpeq_epi8(b, comma), _mm_cmpgt_epi8(b, space)));
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+    return scalar::skip_ws(p, end);
+}
+
+const char *find_token_end(const char *p, const char *end, bool slash)
+{
+    auto lower = _mm_set1_epi8(0x20);
+    for (; end - p >= 16; p += 16)
+    {
+        auto b = load(p);
+        auto sym = _mm_or_si128(
+            _mm_or_si128(
+                _mm_or_si128(in_range(_mm_or_si128(b, lower), 'a', 'z'), in_range(b, '0', '9')),
+                _mm_or_si128(in_range(b, '<', '?'), in_range(b, '*', '+'))),
+            _mm_or_si128(
+                _mm_or_si128(in_range(b, '-', slash ? '/' : '.'), _mm_cmpeq_epi8(b, _mm_set1_epi8('!'))),
+                _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(b, _mm_set1_epi8('#')), _mm_cmpeq_epi8(b, _mm_set1_epi8('&'))),
+                    _mm_cmpeq_epi8(b, _mm_set1_epi8('_')))));
+        unsigned mask = ~_mm_movemask_epi8(sym) & 0xffff;
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+    return scalar::find_token_end(p, end, slash);
+}
+
+const char *find_string_end(const char *p, const char *end)
+{
+    auto quote = _mm_set1_epi8('\"');
+    auto backslash = _mm_set1_epi8('\\');
+    for (; end - p >= 16; p += 16)
+    {
+        auto b = load(p);
+        unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(b, quote), _mm_cmpeq_epi8(b, backslash)));
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+    return scalar::find_string_end(p, end);
+}
+
+}
+
+#endif
+
+const char *find_line_end(const char *p, const char *end)
+{
+    auto nl = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    return nl ? nl : end;
+}
+
+const char *find_symbol_end(const char *p, const char *end)
+{
+    return CLEO_SSE2(find_token_end)(p, end, false);
+}
+
+const char *find_name_end(const char *p, const char *end)
+{
+    return CLEO_SSE2(find_token_end)(p, end, true);
+}
+
+// Returns the offset of the end of the run starting at offset n,
+// refilling the stream while the run reaches the end of the buffer.
+template <typename Scan>
+std::size_t scan(Stream& s, std::size_t n, Scan scan)
+{
+    for (;;)
+    {
+        auto p = s.data();
+        auto end = p + s.available();
+        if (n < s.available())
+            n = scan(p + n, end) - p;
+        if (n < s.available() || s.eos(n))
+            return n;
+    }
+}
+
+bool parse_decimal(const char *p, std::size_t size, Int64& val)
+{
+    std::size_t i = (*p == '-');
+    if (size - i > 18 || (p[i] == '0' && size - i > 1))
+        return false;
+    Int64 n = 0;
+    for (; i < size; ++i)
+    {
+        if (p[i] < '0' || p[i] > '9')
+            return false;
+        n = n * 10 + (p[i] - '0');
+    }
+    val = *p == '-' ? -n : n;
+    return true;
+}
+
+Force read_integer(const std::string& n, Stream& s)
 {
     char *end = nullptr;
     errno = 0;
     auto val = std::strtoll(n.c_str(), &end, 0);
     if (errno)
-        throw_read_error("integer out of range: " + n, pos);
+        throw_read_error("integer out of range: " + n, s.pos());
     if (end != n.c_str() + n.length())
-        throw_read_error("malformed number: " + n, pos);
+        throw_read_error("malformed number: " + n, s.pos());
     return create_int64(val);
 }
 
-Force read_float(const std::string& n, Stream::Position pos)
+Force read_float(const std::string& n, Stream& s)
 {
     char *end = nullptr;
     errno = 0;
     auto val = std::strtod(n.c_str(), &end);
     if (errno)
-        throw_read_error("floating-point value out of range: " + n, pos);
+        throw_read_error("floating-point value out of range: " + n, s.pos());
     if (end != n.c_str() + n.length())
-        throw_read_error("malformed number: " + n, pos);
+        throw_read_error("malformed number: " + n, s.pos());
     return create_float64(val);
 }
 
+bool is_float(const char *p, std::size_t size)
+{
+    auto end = p + size;
+    if (std::find(p, end, '.') != end)
+        return true;
+    if (size > 1 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+        return false;
+    return std::find(p, end, 'e') != end || std::find(p, end, 'E') != end;
+}
+
 Force read_number(Stream& s)
 {
-    auto pos = s.pos();
-    std::string n;
-    while (is_symbol_char(s.peek()))
-        n += s.next();
-    return
-        n.find('.') != std::string::npos ||
-        (n.find("0x") != 0 &&
-         n.find("0X") != 0 &&
-         (n.find('e') != std::string::npos || n.find('E') != std::string::npos)) ?
-        read_float(n, pos) :
-        read_integer(n, pos);
+    auto size = scan(s, 0, find_symbol_end);
+    auto p = s.data();
+    Int64 n;
+    Root val{
+        is_float(p, size) ? read_float({p, size}, s) :
+        parse_decimal(p, size, n) ? create_int64(n) :
+        read_integer({p, size}, s)};
+    s.skip(size);
+    return *val;
 }
 
-std::pair<std::string, std::string> read_raw_symbol(Stream& s)
+struct RawSymbol
+{
+    const char *ns;
+    std::uint32_t ns_size;
+    const char *name;
+    std::uint32_t name_size;
+};
+
+RawSymbol scan_raw_symbol(Stream& s, std::size_t& size)
 {
-    std::string str;
     if (s.peek() == '/')
     {
-        s.next();
-        return {{}, "/"};
+        size = 1;
+        return {nullptr, 0, s.data(), 1};
     }
-    while (is_symbol_char(s.peek()))
-        str += s.next();
-    if (s.peek() == '/')
+    auto ns_size = scan(s, 0, find_symbol_end);
+    if (s.peek(ns_size) != '/')
     {
-        s.next();
-        std::string name;
-        while (is_symbol_char(s.peek()) || s.peek() == '/')
-            name += s.next();
-        return {str, name};
+        size = ns_size;
+        return {nullptr, 0, s.data(), std::uint32_t(ns_size)};
     }
-    return {{}, str};
+    size = scan(s, ns_size + 1, find_name_end);
+    auto p = s.data();
+    return {p, std::uint32_t(ns_size), p + ns_size + 1, std::uint32_t(size - ns_size - 1)};
+}
+
+bool span_equals(const char *p, std::size_t size, const char *lit, std::size_t lit_size)
+{
+    return size == lit_size && std::memcmp(p, lit, size) == 0;
 }
 
 Force read_symbol(Stream& s)
 {
-    auto rs = read_raw_symbol(s);
-    if (!rs.first.empty())
-        return create_symbol(rs.first, rs.second);
-    if (rs.second == "nil")
-        return nil;
-    if (rs.second == "true")
-        return TRUE;
-    return create_symbol(rs.second);
+    std::size_t size;
+    auto rs = scan_raw_symbol(s, size);
+    Value sym =
+        rs.ns ? create_symbol(rs.ns, rs.ns_size, rs.name, rs.name_size) :
+        span_equals(rs.name, rs.name_size, "nil", 3) ? nil :
+        span_equals(rs.name, rs.name_size, "true", 4) ? TRUE :
+        create_symbol(nullptr, 0, rs.name, rs.name_size);
+    s.skip(size);
+    return sym;
 }
 
 Force read_keyword(Stream& s)
 {
     s.next(); // ':'
+    std::size_t size;
     if (s.peek() == ':')
     {
         s.next(); // ':'
-        auto rs = read_raw_symbol(s);
-        auto ns = rs.first.empty() ?
+        auto rs = scan_raw_symbol(s, size);
+        auto ns = !rs.ns ?
             get_symbol_name(ns_name(*rt::current_ns)) :
-            get_symbol_name(ns_name(map_get(ns_aliases(ns_name(*rt::current_ns)), create_symbol(rs.first))));
-        return create_keyword({get_string_ptr(ns), get_string_size(ns)}, rs.second);
+            get_symbol_name(ns_name(map_get(ns_aliases(ns_name(*rt::current_ns)), create_symbol(nullptr, 0, rs.ns, rs.ns_size))));
+        auto kw = create_keyword(get_string_ptr(ns), get_string_size(ns), rs.name, rs.name_size);
+        s.skip(size);
+        return kw;
     }
-    auto rs = read_raw_symbol(s);
-    if (rs.first.empty())
-        return create_keyword(rs.second);
-    return create_keyword(rs.first, rs.second);
+    auto rs = scan_raw_symbol(s, size);
+    auto kw = create_keyword(rs.ns, rs.ns_size, rs.name, rs.name_size);
+    s.skip(size);
+    return kw;
 }
 
 void eat_ws(Stream& s)
 {
-    while (!s.eos() && (is_ws(s.peek()) || s.peek() == ';'))
+    for (;;)
     {
-        if (s.peek() == ';')
-        {
-            while (!s.eos() && s.peek() != '\n')
-                s.next();
-            if (!s.eos())
-                s.next();
-        }
-        while (!s.eos() && is_ws(s.peek()))
-            s.next();
+        s.skip(scan(s, 0, CLEO_SSE2(skip_ws)));
+        if (s.peek() != ';')
+            return;
+        s.skip(scan(s, 1, find_line_end));
     }
 }
 
@@ -155,74 +506,71 @@ void eat_ws(Stream& s)
     throw_exception(new_unexpected_end_of_input(*linev, *colv));
 }
 
-Force read_list(Stream& s)
+// Collections are read onto the VM stack, where the GC can see them, and built
+// in one allocation. Elements beyond SPILL_SIZE are moved to a transient array
+// so that large collections do not overflow the stack.
+const std::uint32_t SPILL_SIZE = 4096;
+
+template <typename Build>
+Force read_coll(Stream& s, char close, Build build)
 {
-    s.next(); // '('
+    s.next(); // opening
     eat_ws(s);
-    Root l{*EMPTY_LIST};
-
-    while (!s.eos() && s.peek() != ')')
+    StackGuard guard;
+    auto first = stack.size();
+    Root spill;
+    while (!s.eos() && s.peek() != close)
     {
-        Root e{read(s)};
-        l = list_conj(*l, *e);
-        eat_ws(s);
+        stack_push(read(s));
+        if (stack.size() - first == SPILL_SIZE)
+        {
+            if (!*spill)
+                spill = transient_array(*EMPTY_VECTOR);
+            for (auto i = first; i < stack.size(); ++i)
+                spill = transient_array_conj(*spill, stack[i]);
+            stack.resize(first);
+        }
     }
     if (s.eos())
         throw_unexpected_end_of_input(s.pos());
-    s.next(); // ')'
-    l = list_seq(*l);
-    Root lr{*EMPTY_LIST};
-    while (*l)
+    s.next(); // close
+    if (!*spill)
+        return build(stack.data() + first, std::uint32_t(stack.size() - first));
+    for (auto i = first; i < stack.size(); ++i)
+        spill = transient_array_conj(*spill, stack[i]);
+    stack.resize(first);
+    return build(get_dynamic_object_elements(*spill), std::uint32_t(get_transient_array_size(*spill)));
+}
+
+Force read_list(Stream& s)
+{
+    return read_coll(s, ')', [](const Value *elems, std::uint32_t size) -> Force
     {
-        lr = list_conj(*lr, get_list_first(*l));
-        l = get_list_next(*l);
-    }
-    return *lr;
+        return size == 0 ? *EMPTY_LIST : create_list(elems, size);
+    });
 }
 
 Force read_vector(Stream& s)
 {
-    s.next(); // '['
-    eat_ws(s);
-    Root v{transient_array(*EMPTY_VECTOR)};
-
-    while (!s.eos() && s.peek() != ']')
-    {
-        Root e{read(s)};
-        v = transient_array_conj(*v, *e);
-        eat_ws(s);
-    }
-    if (s.eos())
-        throw_unexpected_end_of_input(s.pos());
-    s.next(); // ']'
-    v = transient_array_persistent(*v);
-    return *v;
+    return read_coll(s, ']', create_array);
 }
 
 Force read_map(Stream& s)
 {
-    auto brace_pos = s.pos();
-    s.next(); // '{'
-    eat_ws(s);
-    Root m{*EMPTY_MAP};
-
-    while (!s.eos() && s.peek() != '}')
+    auto brace = s.mark();
+    return read_coll(s, '}', [&](const Value *kvs, std::uint32_t size) -> Force
     {
-        Root k{read(s)};
-        eat_ws(s);
-
-        if (s.peek() == '}')
-            throw_read_error("map literal must contain an even number of forms", brace_pos);
-
-        Root v{read(s)};
-        eat_ws(s);
-
-        m = map_assoc(*m, *k, *v);
-    }
-    if (s.eos())
-        throw_unexpected_end_of_input(s.pos());
-    s.next(); // '}'
-    return *m;
+        if (size % 2)
+            throw_read_error("map literal must contain an even number of forms", s.pos(brace));
+        if (size == 0)
+            return *EMPTY_MAP;
+        if (size <= MAX_ARRAY_MAP_SIZE * 2 && !has_duplicate_keys(kvs, size))
+            return create_array_map(kvs, size);
+        Root m{*EMPTY_MAP};
+        for (std::uint32_t i = 0; i < size; i += 2)
+            m = map_assoc(*m, kvs[i], kvs[i + 1]);
+        return *m;
+    });
 }
 
 std::uint32_t parse_hex_digit(char c)
@@ -238,14 +586,14 @@ std::uint32_t parse_hex_digit(char c)
 
 std::uint32_t read_hex_digit(Stream& s, int n)
 {
-    auto pos = s.pos();
+    auto m = s.mark();
     try
     {
         return parse_hex_digit(s.next());
     }
     catch (const std::invalid_argument& )
     {
-        throw_read_error(std::string("invalid character length: ") + std::to_string(n), pos);
+        throw_read_error(std::string("invalid character length: ") + std::to_string(n), s.pos(m));
     }
 }
 
@@ -269,31 +617,36 @@ void append_utf8(std::string& s, std::uint32_t c)
 
 Force read_string(Stream& s)
 {
-    std::string str;
-    s.next();
+    auto size = scan(s, 1, CLEO_SSE2(find_string_end));
+    if (s.peek(size) == '\"')
+    {
+        Root str{create_string(s.data() + 1, std::uint32_t(size - 1))};
+        s.skip(size + 1);
+        return *str;
+    }
+    std::string str(s.data() + 1, size - 1);
+    s.skip(size);
     while (!s.eos() && s.peek() != '\"')
     {
-        if (s.peek() == '\\')
+        s.next(); // '\\'
+        char c = s.next();
+        switch (c) {
+        case 'n': str += '\n'; break;
+        case 'u':
         {
-            s.next();
-            char c = s.next();
-            switch (c) {
-            case 'n': str += '\n'; break;
-            case 'u':
-            {
-                std::uint32_t code = read_hex_digit(s, 0) << 12;
-                code |= read_hex_digit(s, 1) << 8;
-                code |= read_hex_digit(s, 2) << 4;
-                code |= read_hex_digit(s, 3);
-                append_utf8(str, code);
-                break;
-            }
-            default:
-                str += c;
-            }
+            std::uint32_t code = read_hex_digit(s, 0) << 12;
+            code |= read_hex_digit(s, 1) << 8;
+            code |= read_hex_digit(s, 2) << 4;
+            code |= read_hex_digit(s, 3);
+            append_utf8(str, code);
+            break;
         }
-        else
-            str += s.next();
+        default:
+            str += c;
+        }
+        size = scan(s, 0, CLEO_SSE2(find_string_end));
+        str.append(s.data(), size);
+        s.skip(size);
     }
     if (s.eos())
         throw_unexpected_end_of_input(s.pos());
@@ -303,7 +656,7 @@ Force read_string(Stream& s)
 
 Value read_char(Stream& s)
 {
-    auto pos = s.pos();
+    auto start = s.mark();
     s.next();
     if (s.eos())
         throw_unexpected_end_of_input(s.pos());
@@ -354,7 +707,7 @@ Value read_char(Stream& s)
         }
         catch (const std::invalid_argument& ) { }
     }
-    throw_read_error("invalid character: \\" + ch, pos);
+    throw_read_error("invalid character: \\" + ch, s.pos(start));
 }
 
 Force quote(Value val)
@@ -541,12 +894,12 @@ Force read_set(Stream& s)
 
     while (!s.eos() && s.peek() != '}')
     {
-        auto key_pos = s.pos();
+        auto key = s.mark();
         Root e{read(s)};
         if (set_contains(*set, *e))
         {
             Root text{pr_str(*e)};
-            throw_read_error("duplicate key: " + std::string(get_string_ptr(*text), get_string_size(*text)), key_pos);
+            throw_read_error("duplicate key: " + std::string(get_string_ptr(*text), get_string_size(*text)), s.pos(key));
         }
         set = set_conj(*set, *e);
         eat_ws(s);
@@ -564,11 +917,11 @@ Force read_var(Stream& s)
     eat_ws(s);
     if (s.eos())
         throw_unexpected_end_of_input(s.pos());
-    auto sym_pos = s.pos();
-    Root sym{read(s)};
-    if (get_value_tag(*sym) != tag::SYMBOL)
-        throw_read_error("expected a symbol", sym_pos);
-    return resolve_var(*sym);
+    auto sym = s.mark();
+    Root val{read(s)};
+    if (get_value_tag(*val) != tag::SYMBOL)
+        throw_read_error("expected a symbol", s.pos(sym));
+    return resolve_var(*val);
 }
 
 [[noreturn]] void throw_unexpected(char c, Stream::Position pos)
@@ -619,6 +972,16 @@ Force read(ReaderStream& stream)
     return *form;
 }
 
+Force read_next(Value reader, Value eof)
+{
+    check_type("reader", reader, *type::Reader);
+    Stream s(reader);
+    eat_ws(s);
+    if (s.eos())
+        return eof;
+    return read(s);
+}
+
 Force read(Value source)
 {
     if (get_value_tag(source) != tag::UTF8STRING)
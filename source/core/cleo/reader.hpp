@@ -5,6 +5,16 @@
 namespace cleo
 {
 
+// Reads from a string, from bytes owned by the caller (e.g. a mapped file) or
+// from a Reader. A Reader keeps its file descriptor and its buffer, which is
+// refilled as the stream advances, so files of any size are read in constant
+// memory. The stream saves its position back into the Reader when destroyed.
+//
+// Tokens are scanned as spans of the buffer. Lines and columns are not tracked
+// while reading: a Mark is the offset from the start of the stream and it is
+// turned into a Position only when an error is reported. A Reader stream
+// keeps the bytes it has read in its buffer until it is destroyed, so marks
+// stay valid across refills.
 class ReaderStream
 {
 public:
@@ -13,37 +23,61 @@ public:
         std::uint32_t line{}, col{};
     };
 
-    ReaderStream(Value text) : text(text) { }
+    using Mark = std::size_t;
 
-    char peek(std::uint32_t n = 0) const { return eos(n) ? 0 : get_string_ptr(text)[index + n]; }
-    bool eos(std::uint32_t n = 0) const { return (index + n) >= get_string_size(text); }
-    char next()
-    {
-        char c = peek();
-        if (c == '\n')
-        {
-            ++line;
-            col = 1;
-        }
-        else
-            ++col;
-        if (!eos())
-            index++;
-        return c;
-    }
-
-    Position pos() const
-    {
-        return {line, col};
-    }
+    explicit ReaderStream(Value source);
+    ReaderStream(const char *data, std::size_t size) : base(data), cur(data), end(data + size) { }
+    ReaderStream(const ReaderStream& ) = delete;
+    ReaderStream& operator=(const ReaderStream& ) = delete;
+    ~ReaderStream();
+
+    char peek(std::uint32_t n = 0) { return eos(n) ? 0 : cur[n]; }
+    bool eos(std::uint32_t n = 0) { return end - cur <= std::ptrdiff_t(n) && !refill(n); }
+    char next() { return eos() ? 0 : *cur++; }
+
+    const char *data() const { return cur; }
+    std::size_t available() const { return end - cur; }
+    void skip(std::size_t n) { cur += n; }
+
+    Mark mark() const { return cur - base; }
+    Position pos() const { return pos(mark()); }
+    Position pos(Mark m) const;
 
 private:
-    std::uint32_t index = 0;
+    bool refill(std::uint32_t n);
+
+    const char *base = nullptr, *cur = nullptr, *end = nullptr;
     std::uint32_t line = 1, col = 1;
-    Value text{nil};
+    // base, cur and end may point into the bytes of a short string kept here,
+    // which is why streams cannot be copied
+    StringPtr text{nullptr};
+    Value reader{nil};
+};
+
+// A read-only mapping of a whole file
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile& ) = delete;
+    MappedFile& operator=(const MappedFile& ) = delete;
+    ~MappedFile();
+
+    explicit operator bool() const { return fd >= 0; }
+    const char *data() const { return static_cast<const char *>(addr); }
+    std::size_t size() const { return size_; }
+
+private:
+    int fd = -1;
+    void *addr = nullptr;
+    std::size_t size_ = 0;
 };
 
+Force create_reader(Value path);
+// Closes the file and drops any buffered input, later reads return eof
+Value close_reader(Value reader);
 Force read(ReaderStream& stream);
 Force read(Value source);
+Force read_next(Value reader, Value eof);
 
 }
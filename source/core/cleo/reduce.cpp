@@ -0,0 +1,30 @@
+#include "reduce.hpp"
+#include "global.hpp"
+#include "eval.hpp"
+#include <array>
+
+namespace cleo
+{
+
+Force create_reduced(Value val)
+{
+    return create_object1(*type::Reduced, val);
+}
+
+Value is_reduced(Value val)
+{
+    return get_value_type(val).is(*type::Reduced) ? TRUE : nil;
+}
+
+Value reduced_deref(Value r)
+{
+    return get_static_object_element(r, 0);
+}
+
+Force reduce_step(Value f, Value acc, Value elem)
+{
+    std::array<Value, 3> call{{f, acc, elem}};
+    return cleo::call(call.data(), call.size());
+}
+
+}
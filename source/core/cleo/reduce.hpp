@@ -0,0 +1,12 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+Force create_reduced(Value val);
+Value is_reduced(Value val);
+Value reduced_deref(Value r);
+Force reduce_step(Value f, Value acc, Value elem);
+
+}
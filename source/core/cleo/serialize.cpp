@@ -0,0 +1,716 @@
+#include "serialize.hpp"
+#include "global.hpp"
+#include "print.hpp"
+#include "reader.hpp"
+#include "multimethod.hpp"
+#include "array.hpp"
+#include "array_map.hpp"
+#include "array_set.hpp"
+#include "byte_array.hpp"
+#include "list.hpp"
+#include "vector.hpp"
+#include "persistent_hash_map.hpp"
+#include "persistent_hash_set.hpp"
+#include "persistent_tree_map.hpp"
+#include "persistent_tree_set.hpp"
+#include "persistent_queue.hpp"
+#include "typed_array.hpp"
+#include "error.hpp"
+#include "util.hpp"
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace cleo
+{
+
+namespace
+{
+
+const char MAGIC[] = {'C', 'L', 'B'};
+const unsigned char VERSION = 1;
+const unsigned char CACHE_NAMES = 1;
+const std::size_t HEADER_SIZE = sizeof(MAGIC) + 2;
+const std::uint32_t STACK_SIZE = 4096;
+const std::size_t GC_SCALE_BYTES = 4096;
+const std::uint32_t MAX_DEPTH = 1024;
+
+namespace code
+{
+enum : unsigned char
+{
+    NIL, TRUE, INT, FLOAT, CHAR, STRING, SYMBOL, KEYWORD, LIST, ARRAY, MAP, SET, BYTES, REF, QUEUE, INT64S, FLOAT64S,
+    SORTED_MAP, SORTED_SET
+};
+}
+
+class Encoder
+{
+public:
+    Encoder(Output& out, bool cache_names) : out(out), cache_names(cache_names) { }
+
+    void header()
+    {
+        out.append(MAGIC, sizeof(MAGIC));
+        out += char(VERSION);
+        out += char(cache_names ? CACHE_NAMES : 0);
+    }
+
+    void encode(Value val)
+    {
+        switch (get_value_tag(val))
+        {
+            case tag::SYMBOL: return encode_name(code::SYMBOL, val, get_symbol_namespace(val), get_symbol_name(val));
+            case tag::KEYWORD: return encode_name(code::KEYWORD, val, get_keyword_namespace(val), get_keyword_name(val));
+            case tag::INT64:
+            {
+                auto n = get_int64_value(val);
+                put(code::INT);
+                put_varint((std::uint64_t(n) << 1) ^ std::uint64_t(n >> 63));
+                return;
+            }
+            case tag::FLOAT64:
+            {
+                auto f = get_float64_value(val);
+                std::uint64_t bits;
+                std::memcpy(&bits, &f, sizeof(bits));
+                put(code::FLOAT);
+                put_u64(bits);
+                return;
+            }
+            case tag::UCHAR:
+                put(code::CHAR);
+                put_varint(get_uchar_value(val));
+                return;
+            case tag::UTF8STRING: return encode_string(val);
+            case tag::OBJECT:
+                if (val.is_nil())
+                    return put(code::NIL);
+                if (val.is(TRUE))
+                    return put(code::TRUE);
+                return encode_object(val);
+            default:
+                throw_unsupported(val);
+        }
+    }
+
+private:
+    Output& out;
+    bool cache_names;
+    std::unordered_map<ValueBits, std::uint64_t> names;
+    std::unordered_map<std::string, std::uint64_t> strings;
+    std::uint64_t next_ref = 0;
+
+    [[noreturn]] static void throw_unsupported(Value val)
+    {
+        throw_illegal_argument("cannot serialize " + to_string(get_value_type(val)));
+    }
+
+    // only the default order can be restored
+    static void check_comparator(Value val, Value comparator)
+    {
+        if (comparator)
+            throw_illegal_argument("cannot serialize " + to_string(get_value_type(val)) + " with a custom comparator");
+    }
+
+    void put(unsigned char c)
+    {
+        out += char(c);
+    }
+
+    void put_varint(std::uint64_t n)
+    {
+        char buf[10];
+        std::size_t size = 0;
+        for (; n >= 0x80; n >>= 7)
+            buf[size++] = char(n | 0x80);
+        buf[size++] = char(n);
+        out.append(buf, size);
+    }
+
+    void put_u64(std::uint64_t n)
+    {
+        char le[sizeof(n)];
+        for (std::size_t i = 0; i < sizeof(n); ++i)
+            le[i] = char(n >> (i * 8));
+        out.append(le, sizeof(le));
+    }
+
+    // Int64 and Float64 arrays store 8-byte words
+    void put_words(unsigned char c, const void *words, Int64 size)
+    {
+        put(c);
+        put_varint(size);
+        for (Int64 i = 0; i < size; ++i)
+        {
+            std::uint64_t n;
+            std::memcpy(&n, static_cast<const char *>(words) + i * sizeof(n), sizeof(n));
+            put_u64(n);
+        }
+    }
+
+    void put_bytes(const char *data, std::size_t size)
+    {
+        put_varint(size);
+        out.append(data, size);
+    }
+
+    // Numbers key on first use; true when a back-reference was written instead
+    template <typename Key>
+    bool put_ref(std::unordered_map<Key, std::uint64_t>& refs, Key key)
+    {
+        auto inserted = refs.emplace(std::move(key), next_ref);
+        if (inserted.second)
+        {
+            ++next_ref;
+            return false;
+        }
+        put(code::REF);
+        put_varint(inserted.first->second);
+        return true;
+    }
+
+    void encode_name(unsigned char c, Value val, Value ns, Value name)
+    {
+        // symbols and keywords are interned, so identity is enough
+        if (cache_names && put_ref(names, val.bits()))
+            return;
+        put(c);
+        if (ns)
+            put_bytes(get_string_ptr(ns), get_string_size(ns));
+        else
+            put_varint(0);
+        put_bytes(get_string_ptr(name), get_string_size(name));
+    }
+
+    void encode_string(Value s)
+    {
+        auto ptr = get_string_ptr(s);
+        auto size = get_string_size(s);
+        if (cache_names && size <= MAX_CACHED_STRING && put_ref(strings, std::string(ptr, size)))
+            return;
+        put(code::STRING);
+        put_bytes(ptr, size);
+    }
+
+    void encode_seq(unsigned char c, Int64 count, Value coll)
+    {
+        put(c);
+        put_varint(count);
+        for (Root s{call_multimethod1(*rt::seq, coll)}; *s; s = call_multimethod1(*rt::next, *s))
+        {
+            Root e{call_multimethod1(*rt::first, *s)};
+            encode(*e);
+        }
+    }
+
+    void encode_kvs(Value kv)
+    {
+        encode(get_array_elem(kv, 0));
+        encode(get_array_elem(kv, 1));
+    }
+
+    void encode_object(Value val)
+    {
+        auto type = get_value_type(val);
+        if (type.is(*type::Array))
+        {
+            auto size = get_array_size(val);
+            put(code::ARRAY);
+            put_varint(size);
+            for (decltype(size) i = 0; i != size; ++i)
+                encode(get_array_elem_unchecked(val, i));
+        }
+        else if (type.is(*type::Vector))
+        {
+            auto size = get_vector_size(val);
+            put(code::ARRAY);
+            put_varint(size);
+            for (decltype(size) i = 0; i != size; ++i)
+                encode(get_vector_elem(val, i));
+        }
+        else if (type.is(*type::List))
+        {
+            auto size = get_list_size(val);
+            put(code::LIST);
+            put_varint(size);
+            for (auto l = val; size > 0; --size, l = get_list_next(l))
+                encode(get_list_first(l));
+        }
+        else if (type.is(*type::ArrayMap))
+        {
+            auto size = get_array_map_size(val);
+            put(code::MAP);
+            put_varint(size);
+            for (decltype(size) i = 0; i != size; ++i)
+            {
+                encode(get_array_map_key(val, i));
+                encode(get_array_map_val(val, i));
+            }
+        }
+        else if (type.is(*type::PersistentHashMap))
+        {
+            put(code::MAP);
+            put_varint(get_persistent_hash_map_size(val));
+            for (Root s{persistent_hash_map_seq(val)}; *s; s = get_persistent_hash_map_seq_next(*s))
+                encode_kvs(get_persistent_hash_map_seq_first(*s));
+        }
+        else if (type.is(*type::PersistentTreeMap))
+        {
+            check_comparator(val, get_persistent_tree_map_comparator(val));
+            put(code::SORTED_MAP);
+            put_varint(get_persistent_tree_map_size(val));
+            for (Root s{persistent_tree_map_seq(val)}; *s; s = get_persistent_tree_seq_next(*s))
+            {
+                Root kv{get_persistent_tree_seq_first(*s)};
+                encode_kvs(*kv);
+            }
+        }
+        else if (type.is(*type::ArraySet))
+        {
+            auto size = get_array_set_size(val);
+            put(code::SET);
+            put_varint(size);
+            for (decltype(size) i = 0; i != size; ++i)
+                encode(get_array_set_elem(val, i));
+        }
+        else if (type.is(*type::PersistentHashSet))
+            encode_seq(code::SET, get_persistent_hash_set_size(val), val);
+        else if (type.is(*type::PersistentTreeSet))
+        {
+            check_comparator(val, get_persistent_tree_map_comparator(get_persistent_tree_set_map(val)));
+            encode_seq(code::SORTED_SET, get_persistent_tree_set_size(val), val);
+        }
+        else if (type.is(*type::ByteArray))
+        {
+            put(code::BYTES);
+            put_bytes(get_byte_array_ptr(val), get_byte_array_size(val));
+        }
+        else if (type.is(*type::Int64Array))
+            put_words(code::INT64S, get_int64_array_elems(val), get_typed_array_size(val));
+        else if (type.is(*type::Float64Array))
+            put_words(code::FLOAT64S, get_float64_array_elems(val), get_typed_array_size(val));
+        else if (type.is(*type::PersistentQueue))
+            encode_seq(code::QUEUE, get_persistent_queue_size(val), val);
+        else if (isa(type, *type::Sequence))
+        {
+            // realized seqs are cached, so walking twice only counts them
+            Int64 count = 0;
+            for (Root s{call_multimethod1(*rt::seq, val)}; *s; s = call_multimethod1(*rt::next, *s))
+                ++count;
+            encode_seq(code::LIST, count, val);
+        }
+        else
+            throw_unsupported(val);
+    }
+};
+
+class Decoder
+{
+public:
+    Decoder(const char *data, std::size_t size) : p(data), end(data + size) { }
+
+    void header()
+    {
+        if (std::size_t(end - p) < HEADER_SIZE || std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0)
+            throw_illegal_argument("not serialized cleo data");
+        if (static_cast<unsigned char>(p[sizeof(MAGIC)]) != VERSION)
+            throw_illegal_argument("unsupported serialization version: " + std::to_string(static_cast<unsigned char>(p[sizeof(MAGIC)])));
+        cache_names = (p[sizeof(MAGIC) + 1] & CACHE_NAMES) != 0;
+        p += HEADER_SIZE;
+        if (cache_names)
+            refs = transient_array(*EMPTY_VECTOR);
+    }
+
+    bool at_end() const { return p == end; }
+
+    Force decode()
+    {
+        Nested nested{depth};
+        switch (take_code())
+        {
+            case code::NIL: return nil;
+            case code::TRUE: return TRUE;
+            case code::INT:
+            {
+                auto n = take_varint();
+                return create_int64(Int64(n >> 1) ^ -Int64(n & 1));
+            }
+            case code::FLOAT:
+            {
+                auto bits = take_u64();
+                Float64 f;
+                std::memcpy(&f, &bits, sizeof(f));
+                return create_float64(f);
+            }
+            case code::CHAR: return create_uchar(Char32(take_varint()));
+            case code::STRING:
+            {
+                auto size = take_count(1);
+                auto ptr = take(size);
+                Root s{create_string(ptr, size)};
+                if (cache_names && size <= MAX_CACHED_STRING)
+                    remember(*s);
+                return *s;
+            }
+            case code::SYMBOL: return decode_name(create_symbol);
+            case code::KEYWORD: return decode_name(create_keyword);
+            case code::REF:
+            {
+                auto index = take_varint();
+                if (!cache_names || index >= std::uint64_t(get_transient_array_size(*refs)))
+                    throw_malformed();
+                return get_transient_array_elem(*refs, std::uint32_t(index));
+            }
+            case code::LIST: return decode_list();
+            case code::ARRAY: return decode_array();
+            case code::MAP: return decode_map();
+            case code::SET: return decode_set();
+            case code::SORTED_MAP: return decode_sorted_map();
+            case code::SORTED_SET: return decode_sorted_set();
+            case code::BYTES:
+            {
+                auto size = take_count(1);
+                return create_byte_array_from_bytes(take(size), size);
+            }
+            case code::QUEUE: return decode_queue();
+            case code::INT64S:
+            {
+                auto words = take_words<Int64>();
+                return create_int64_array_from_ints(words.data(), words.size());
+            }
+            case code::FLOAT64S:
+            {
+                auto words = take_words<Float64>();
+                return create_float64_array_from_floats(words.data(), words.size());
+            }
+            default:
+                throw_malformed();
+        }
+    }
+
+private:
+    const char *p;
+    const char *end;
+    bool cache_names = false;
+    Root refs;
+    std::uint32_t depth = 0;
+
+    [[noreturn]] static void throw_malformed()
+    {
+        throw_illegal_argument("malformed serialized data");
+    }
+
+    // Bounds the recursion, so that deeply nested input fails instead of overflowing the native stack
+    class Nested
+    {
+    public:
+        explicit Nested(std::uint32_t& depth) : depth(depth)
+        {
+            if (depth == MAX_DEPTH)
+                throw_malformed();
+            ++depth;
+        }
+        Nested(const Nested& ) = delete;
+        ~Nested() { --depth; }
+    private:
+        std::uint32_t& depth;
+    };
+
+    const char *take(std::size_t n)
+    {
+        if (std::size_t(end - p) < n)
+            throw_malformed();
+        auto data = p;
+        p += n;
+        return data;
+    }
+
+    unsigned char take_code()
+    {
+        return static_cast<unsigned char>(*take(1));
+    }
+
+    std::uint64_t take_varint()
+    {
+        std::uint64_t n = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            auto b = take_code();
+            n |= std::uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return n;
+        }
+        throw_malformed();
+    }
+
+    std::uint64_t take_u64()
+    {
+        auto le = take(sizeof(std::uint64_t));
+        std::uint64_t n = 0;
+        for (std::size_t i = 0; i < sizeof(n); ++i)
+            n |= std::uint64_t(static_cast<unsigned char>(le[i])) << (i * 8);
+        return n;
+    }
+
+    template <typename Word>
+    std::vector<Word> take_words()
+    {
+        std::vector<Word> words(take_count(sizeof(std::uint64_t)));
+        for (auto& w : words)
+        {
+            auto n = take_u64();
+            std::memcpy(&w, &n, sizeof(w));
+        }
+        return words;
+    }
+
+    // Every element takes at least min_size bytes, which bounds the count
+    // before anything is allocated for it
+    std::uint32_t take_count(std::size_t min_size)
+    {
+        auto n = take_varint();
+        if (n > std::uint64_t(end - p) / min_size || n > std::numeric_limits<std::uint32_t>::max())
+            throw_malformed();
+        return std::uint32_t(n);
+    }
+
+    void remember(Value val)
+    {
+        refs = transient_array_conj(*refs, val);
+    }
+
+    Force decode_name(Value (*create)(const char *, std::uint32_t, const char *, std::uint32_t))
+    {
+        auto ns_size = take_count(1);
+        auto ns = take(ns_size);
+        auto name_size = take_count(1);
+        auto name = take(name_size);
+        auto val = create(ns, ns_size, name, name_size);
+        if (cache_names)
+            remember(val);
+        return val;
+    }
+
+    // Collections of up to STACK_SIZE elements are collected on the VM stack
+    // and created in one allocation, larger ones are built with transients
+    template <typename Build>
+    Force decode_elems(std::uint32_t size, Build build)
+    {
+        if (size <= STACK_SIZE)
+        {
+            StackGuard guard;
+            auto first = stack.size();
+            for (std::uint32_t i = 0; i < size; ++i)
+                stack_push(decode());
+            return build(stack.data() + first, size);
+        }
+        Root elems{transient_array(*EMPTY_VECTOR)};
+        for (std::uint32_t i = 0; i < size; ++i)
+        {
+            Root e{decode()};
+            elems = transient_array_conj(*elems, *e);
+        }
+        return build(get_dynamic_object_elements(*elems), size);
+    }
+
+    Force decode_list()
+    {
+        auto size = take_count(1);
+        if (size == 0)
+            return *EMPTY_LIST;
+        return decode_elems(size, create_list);
+    }
+
+    Force decode_array()
+    {
+        return decode_elems(take_count(1), create_array);
+    }
+
+    Force decode_queue()
+    {
+        return decode_elems(take_count(1), [](const Value *elems, std::uint32_t size) -> Force
+        {
+            Root q{create_persistent_queue()};
+            for (std::uint32_t i = 0; i < size; ++i)
+                q = persistent_queue_conj(*q, elems[i]);
+            return *q;
+        });
+    }
+
+    Force decode_map()
+    {
+        auto size = take_count(2);
+        if (size == 0)
+            return *EMPTY_MAP;
+        if (size <= MAX_ARRAY_MAP_SIZE)
+            return decode_elems(size * 2, [](const Value *kvs, std::uint32_t size) -> Force
+            {
+                if (!has_duplicate_keys(kvs, size))
+                    return create_array_map(kvs, size);
+                Root m{*EMPTY_MAP};
+                for (std::uint32_t i = 0; i < size; i += 2)
+                    m = map_assoc(*m, kvs[i], kvs[i + 1]);
+                return *m;
+            });
+        Root m{transient_hash_map(*EMPTY_HASH_MAP)};
+        for (std::uint32_t i = 0; i < size; ++i)
+        {
+            Root k{decode()};
+            Root v{decode()};
+            m = transient_hash_map_assoc(*m, *k, *v);
+        }
+        return transient_hash_map_persistent(*m);
+    }
+
+    Force decode_set()
+    {
+        auto size = take_count(1);
+        if (size <= MAX_ARRAY_MAP_SIZE)
+        {
+            Root s{*EMPTY_SET};
+            for (std::uint32_t i = 0; i < size; ++i)
+            {
+                Root e{decode()};
+                s = set_conj(*s, *e);
+            }
+            return *s;
+        }
+        Root s{transient_hash_set(*EMPTY_HASH_SET)};
+        for (std::uint32_t i = 0; i < size; ++i)
+        {
+            Root e{decode()};
+            s = transient_hash_set_conj(*s, *e);
+        }
+        return transient_hash_set_persistent(*s);
+    }
+
+    Force decode_sorted_map()
+    {
+        auto size = take_count(2);
+        Root m{create_persistent_tree_map(nil)};
+        m = transient_tree_map(*m);
+        for (std::uint32_t i = 0; i < size; ++i)
+        {
+            Root k{decode()};
+            Root v{decode()};
+            m = transient_tree_map_assoc(*m, *k, *v);
+        }
+        return transient_tree_map_persistent(*m);
+    }
+
+    Force decode_sorted_set()
+    {
+        auto size = take_count(1);
+        Root s{create_persistent_tree_set(nil)};
+        s = transient_tree_set(*s);
+        for (std::uint32_t i = 0; i < size; ++i)
+        {
+            Root e{decode()};
+            s = transient_tree_set_conj(*s, *e);
+        }
+        return transient_tree_set_persistent(*s);
+    }
+};
+
+std::string get_path(Value path)
+{
+    check_type("path", path, *type::UTF8String);
+    return {get_string_ptr(path), get_string_size(path)};
+}
+
+[[noreturn]] void throw_file_not_found(const std::string& path)
+{
+    Root msg{create_string("Could not open " + path + ": " + std::strerror(errno))};
+    throw_exception(new_file_not_found(*msg));
+}
+
+[[noreturn]] void throw_write_failed(const std::string& path)
+{
+    Root msg{create_string("Could not write " + path + ": " + std::strerror(errno))};
+    throw_exception(new_illegal_state(*msg));
+}
+
+}
+
+void serialize(Output& out, Value val, bool cache_names)
+{
+    Encoder encoder{out, cache_names};
+    encoder.header();
+    encoder.encode(val);
+}
+
+Force serialize(Value val)
+{
+    return serialize(val, nil);
+}
+
+Force serialize(Value val, Value cache_names)
+{
+    std::string data;
+    Output out{data};
+    serialize(out, val, bool(cache_names));
+    return create_byte_array_from_bytes(data.data(), data.size());
+}
+
+Force serialize_to_file(Value path, Value val)
+{
+    return serialize_to_file(path, val, nil);
+}
+
+Force serialize_to_file(Value path, Value val, Value cache_names)
+{
+    auto p = get_path(path);
+    auto fd = ::open(p.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw_file_not_found(p);
+    try
+    {
+        Output out{fd};
+        serialize(out, val, bool(cache_names));
+        out.flush();
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+    if (::close(fd) != 0)
+        throw_write_failed(p);
+    return nil;
+}
+
+Force deserialize(const char *data, std::size_t size)
+{
+    // decoded values stay reachable until the end, so collections are spaced
+    // out in proportion to the input, keeping their number per decode bounded
+    ScaleGCIntervalGuard scale_gc{unsigned(std::min<std::size_t>(1 + size / GC_SCALE_BYTES, std::numeric_limits<unsigned>::max()))};
+    Decoder decoder{data, size};
+    decoder.header();
+    Root val{decoder.decode()};
+    if (!decoder.at_end())
+        throw_illegal_argument("malformed serialized data: trailing bytes");
+    return *val;
+}
+
+Force deserialize(Value bytes)
+{
+    check_type("bytes", bytes, *type::ByteArray);
+    return deserialize(get_byte_array_ptr(bytes), get_byte_array_size(bytes));
+}
+
+Force deserialize_file(Value path)
+{
+    auto p = get_path(path);
+    MappedFile f{p};
+    if (!f)
+        throw_file_not_found(p);
+    return deserialize(f.data(), f.size());
+}
+
+}
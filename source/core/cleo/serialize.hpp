@@ -0,0 +1,37 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+class Output;
+
+// Compact binary encoding of nil, true, integers, floats, chars, strings,
+// symbols, keywords, lists, arrays, maps, sets, sorted maps and sets with the
+// default comparator, queues, byte arrays and Int64 and Float64 arrays. Other
+// values, e.g. functions, atoms and sorted collections with a custom
+// comparator, cannot be serialized.
+//
+// A 5-byte header ("CLB", version, flags) is followed by one tagged value.
+// Integers are zigzag varints, floats are 8 little-endian bytes, strings and
+// names are varint sizes followed by bytes, and collections are varint counts
+// followed by their elements, or by 8 little-endian bytes each for Int64 and
+// Float64 arrays. Vectors decode as arrays and other sequences as lists.
+// Decoding fails on collections nested more than 1024 levels deep.
+//
+// With cache_names, every symbol, keyword and string up to MAX_CACHED_STRING
+// bytes is numbered in order of first appearance and repeated ones are
+// written as back-references, which keeps repeated map keys small.
+const std::uint32_t MAX_CACHED_STRING = 64;
+
+void serialize(Output& out, Value val, bool cache_names);
+Force serialize(Value val);
+Force serialize(Value val, Value cache_names);
+Force serialize_to_file(Value path, Value val);
+Force serialize_to_file(Value path, Value val, Value cache_names);
+
+Force deserialize(const char *data, std::size_t size);
+Force deserialize(Value bytes);
+Force deserialize_file(Value path);
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+namespace cleo
+{
+
+// Vectorized kernels live in the namespaces scalar, sse2 and avx2 of the file
+// using them. SSE2 is always available on x86-64, the AVX2 kernels are marked
+// with CLEO_AVX2 and CLEO_SIMD picks them when the CPU supports AVX2. Elsewhere
+// only the scalar kernels exist and both macros pick them.
+
+bool cpu_has_avx2();
+extern const bool has_avx2;
+
+}
+
+#ifdef __x86_64__
+#define CLEO_AVX2 __attribute__((target("avx2")))
+#define CLEO_SSE2(fn) sse2::fn
+#define CLEO_SIMD(fn) (has_avx2 ? avx2::fn : sse2::fn)
+#else
+#define CLEO_SSE2(fn) scalar::fn
+#define CLEO_SIMD(fn) scalar::fn
+#endif
@@ -0,0 +1,87 @@
+#include "stack_seq.hpp"
+#include "array.hpp"
+#include "global.hpp"
+#include "reduce.hpp"
+
+namespace cleo
+{
+
+namespace
+{
+
+constexpr unsigned STACK_SEQ_INDEX_BITS = 24;
+constexpr ValueBits STACK_SEQ_INDEX_MASK = (ValueBits(1) << STACK_SEQ_INDEX_BITS) - 1;
+
+std::uint32_t get_stack_seq_index(Value s)
+{
+    return s.bits() & STACK_SEQ_INDEX_MASK;
+}
+
+}
+
+Value create_stack_seq(std::uint32_t index, std::uint32_t size)
+{
+    assert(index <= STACK_SEQ_INDEX_MASK && size <= STACK_SEQ_INDEX_MASK);
+    return Value{tag::STACK_SEQ | (ValueBits(size) << STACK_SEQ_INDEX_BITS) | index};
+}
+
+Value get_stack_seq_first(Value s)
+{
+    return stack[get_stack_seq_index(s)];
+}
+
+Value get_stack_seq_next(Value s)
+{
+    auto size = get_stack_seq_size(s);
+    if (size == 1)
+        return nil;
+    return create_stack_seq(get_stack_seq_index(s) + 1, size - 1);
+}
+
+std::uint32_t get_stack_seq_size(Value s)
+{
+    return (s.bits() & tag::DATA_MASK) >> STACK_SEQ_INDEX_BITS;
+}
+
+Force stack_seq_reduce(Value s, Value f, Value init)
+{
+    Root acc{init};
+    auto index = get_stack_seq_index(s);
+    auto end = index + get_stack_seq_size(s);
+    for (auto i = index; i < end; ++i)
+    {
+        Root elem{escape_stack_seq(stack[i])};
+        acc = reduce_step(f, *acc, *elem);
+        if (is_reduced(*acc))
+            return reduced_deref(*acc);
+    }
+    return *acc;
+}
+
+Force escape_stack_seq(Value val)
+{
+    if (!is_stack_seq(val))
+        return val;
+    auto index = get_stack_seq_index(val);
+    auto end = index + get_stack_seq_size(val);
+    auto& cache = stack[end];
+    if (get_value_tag(cache) == tag::INT64)
+    {
+        std::uint32_t start = get_int64_value(cache);
+        Root arr{create_array(&stack[start], end - start)};
+        for (std::uint32_t i = 0; i < end - start; ++i)
+            if (is_stack_seq(get_array_elem_unchecked(*arr, i)))
+            {
+                Root elem{escape_stack_seq(get_array_elem_unchecked(*arr, i))};
+                set_dynamic_object_element(*arr, i, *elem);
+            }
+        cache = array_seq(*arr).value();
+    }
+    auto arr = get_static_object_element(cache, 0);
+    auto start = end - get_array_size(arr);
+    if (index == start)
+        return cache;
+    return create_static_object(*type::ArraySeq, arr, Int64(index - start));
+}
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+// A seq over values lying on the VM stack, used for the rest args of variadic bytecode fns.
+// The rest args are followed by a cache slot holding the index of the first rest arg
+// or, once the seq has escaped, the heap ArraySeq over all the rest args.
+Value create_stack_seq(std::uint32_t index, std::uint32_t size);
+
+inline bool is_stack_seq(Value val)
+{
+    return (val.bits() & tag::FLIP_MASK) == tag::STACK_SEQ;
+}
+
+Value get_stack_seq_first(Value s);
+Value get_stack_seq_next(Value s);
+std::uint32_t get_stack_seq_size(Value s);
+Force stack_seq_reduce(Value s, Value f, Value init);
+Force escape_stack_seq(Value val);
+
+}
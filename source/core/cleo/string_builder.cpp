@@ -0,0 +1,68 @@
+#include "string_builder.hpp"
+#include "global.hpp"
+#include "print.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace cleo
+{
+
+namespace
+{
+std::uint32_t int_size(Int64 bsize)
+{
+    return (bsize + (sizeof(Int64) - 1)) / sizeof(Int64);
+}
+
+Int64 get_string_builder_capacity(Value sb)
+{
+    return (get_dynamic_object_int_size(sb) - 1) * Int64(sizeof(Int64));
+}
+
+}
+
+Force create_string_builder(Int64 capacity)
+{
+    return create_object(*type::StringBuilder, nullptr, 1 + int_size(std::max(capacity, Int64(32))), nullptr, 0);
+}
+
+Force string_builder_append(Value sb, const char *s, Int64 size)
+{
+    auto old_size = get_string_builder_size(sb);
+    auto new_size = old_size + size;
+    auto capacity = get_string_builder_capacity(sb);
+    if (new_size <= capacity)
+    {
+        std::memcpy(static_cast<char *>(get_dynamic_object_mut_int_ptr(sb, 1)) + old_size, s, size);
+        set_dynamic_object_int(sb, 0, new_size);
+        return sb;
+    }
+    Root t{create_string_builder(std::max(capacity * 2, new_size))};
+    auto dst = static_cast<char *>(get_dynamic_object_mut_int_ptr(*t, 1));
+    std::memcpy(dst, get_string_builder_ptr(sb), old_size);
+    std::memcpy(dst + old_size, s, size);
+    set_dynamic_object_int(*t, 0, new_size);
+    return *t;
+}
+
+Force string_builder_append(Value sb, Value val)
+{
+    check_type("sb", sb, *type::StringBuilder);
+    if (!val)
+        return sb;
+    if (get_value_tag(val) == tag::UTF8STRING)
+        return string_builder_append(sb, get_string_ptr(val), get_string_size(val));
+    Root result{force(sb)};
+    Output out{result};
+    print_str(out, val);
+    out.flush();
+    return *result;
+}
+
+Force string_builder_persistent(Value sb)
+{
+    return create_string(get_string_builder_ptr(sb), get_string_builder_size(sb));
+}
+
+}
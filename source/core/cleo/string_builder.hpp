@@ -0,0 +1,14 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+Force create_string_builder(Int64 capacity);
+inline Int64 get_string_builder_size(Value sb) { return get_dynamic_object_int(sb, 0); }
+inline const char *get_string_builder_ptr(Value sb) { return static_cast<const char *>(get_dynamic_object_int_ptr(sb, 1)); }
+Force string_builder_append(Value sb, const char *s, Int64 size);
+Force string_builder_append(Value sb, Value val);
+Force string_builder_persistent(Value sb);
+
+}
@@ -1,5 +1,9 @@
 #include "string_seq.hpp"
 #include "global.hpp"
+#include "array.hpp"
+#include "chunked_seq.hpp"
+#include "reduce.hpp"
+#include <array>
 
 namespace cleo
 {
@@ -25,4 +29,41 @@ Force string_seq_next(Value s)
     return create_static_object(*type::UTF8StringSeq, str, offset);
 }
 
+Force string_seq_chunk_first(Value s)
+{
+    auto str = get_static_object_element(s, 0);
+    auto size = get_string_size(str);
+    std::uint32_t offset = get_static_object_int(s, 1);
+    std::array<Value, CHUNK_SIZE> chars;
+    std::uint32_t n = 0;
+    for (; n < CHUNK_SIZE && offset < size; ++n, offset = get_string_next_offset(str, offset))
+        chars[n] = create_uchar(get_string_char_at_offset(str, offset));
+    return create_array(chars.data(), n);
+}
+
+Force string_seq_chunk_next(Value s)
+{
+    auto str = get_static_object_element(s, 0);
+    auto size = get_string_size(str);
+    std::uint32_t offset = get_static_object_int(s, 1);
+    for (std::uint32_t n = 0; n < CHUNK_SIZE && offset < size; ++n)
+        offset = get_string_next_offset(str, offset);
+    if (offset == size)
+        return nil;
+    return create_static_object(*type::UTF8StringSeq, str, Int64(offset));
+}
+
+Force string_reduce(Value str, Value f, Value init)
+{
+    Root acc{init};
+    auto size = get_string_size(str);
+    for (std::uint32_t offset = 0; offset < size; offset = get_string_next_offset(str, offset))
+    {
+        acc = reduce_step(f, *acc, create_uchar(get_string_char_at_offset(str, offset)));
+        if (is_reduced(*acc))
+            return reduced_deref(*acc);
+    }
+    return *acc;
+}
+
 }
@@ -7,5 +7,8 @@ namespace cleo
 Force string_seq(Value str);
 Value string_seq_first(Value s);
 Force string_seq_next(Value s);
+Force string_seq_chunk_first(Value s);
+Force string_seq_chunk_next(Value s);
+Force string_reduce(Value str, Value f, Value init);
 
 }
@@ -0,0 +1,506 @@
+#include "strings.hpp"
+#include "global.hpp"
+#include "util.hpp"
+#include "print.hpp"
+#include "array.hpp"
+#include "vector.hpp"
+#include "multimethod.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace cleo
+{
+
+// Searching, counting chars and changing case scan 32 bytes at a time with AVX2
+// when the CPU supports it, 16 bytes with SSE2 otherwise on x86-64 and one byte
+// at a time elsewhere. Substring search compares the first and the last byte of
+// the needle at every position in a block and checks the candidates with memcmp.
+//
+// Indices are char indices. They are turned into byte offsets with the char
+// index of the string and back by counting the bytes which start a UTF-8 char.
+// Case conversion of non-ASCII chars uses the simple one-to-one mappings of the
+// Latin, Greek, Cyrillic and Armenian alphabets and does not depend on the locale.
+
+namespace
+{
+
+namespace scalar
+{
+
+const char *find(const char *p, std::size_t size, const char *n, std::size_t nsize)
+{
+    if (nsize > size)
+        return nullptr;
+    auto last = p + (size - nsize);
+    for (; p <= last; ++p)
+    {
+        p = static_cast<const char *>(std::memchr(p, n[0], last - p + 1));
+        if (!p)
+            return nullptr;
+        if (std::memcmp(p + 1, n + 1, nsize - 1) == 0)
+            return p;
+    }
+    return nullptr;
+}
+
+const char *find_last(const char *p, std::size_t size, const char *n, std::size_t nsize)
+{
+    if (nsize > size)
+        return nullptr;
+    for (auto q = p + (size - nsize);; --q)
+    {
+        if (*q == n[0] && std::memcmp(q + 1, n + 1, nsize - 1) == 0)
+            return q;
+        if (q == p)
+            return nullptr;
+    }
+}
+
+std::size_t count_chars(const char *p, std::size_t size)
+{
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < size; ++i)
+        n += (std::uint8_t(p[i]) & 0xc0) != 0x80;
+    return n;
+}
+
+void flip_ascii_case(const char *p, std::size_t size, char *out, char first)
+{
+    for (std::size_t i = 0; i < size; ++i)
+        out[i] = p[i] >= first && p[i] <= first + 25 ? p[i] ^ 0x20 : p[i];
+}
+
+}
+
+#ifdef __x86_64__
+
+namespace sse2
+{
+
+const char *find(const char *p, std::size_t size, const char *n, std::size_t nsize)
+{
+    if (nsize > size)
+        return nullptr;
+    auto first = _mm_set1_epi8(n[0]);
+    auto last = _mm_set1_epi8(n[nsize - 1]);
+    auto positions = size - nsize + 1;
+    std::size_t i = 0;
+    for (; i + 16 <= positions; i += 16)
+    {
+        auto bf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        auto bl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + nsize - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(bf, first), _mm_cmpeq_epi8(bl, last)));
+        for (; mask; mask &= mask - 1)
+        {
+            auto k = __builtin_ctz(mask);
+            if (std::memcmp(p + i + k + 1, n + 1, nsize - 1) == 0)
+                return p + i + k;
+        }
+    }
+    return scalar::find(p + i, size - i, n, nsize);
+}
+
+std::size_t count_chars(const char *p, std::size_t size)
+{
+    auto last_continuation = _mm_set1_epi8(-65);
+    std::size_t n = 0, i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(b, last_continuation)));
+    }
+    return n + scalar::count_chars(p + i, size - i);
+}
+
+void flip_ascii_case(const char *p, std::size_t size, char *out, char first)
+{
+    auto lo = _mm_set1_epi8(first - 1);
+    auto hi = _mm_set1_epi8(first + 26);
+    auto bit = _mm_set1_epi8(0x20);
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        auto letters = _mm_and_si128(_mm_cmpgt_epi8(b, lo), _mm_cmpgt_epi8(hi, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_xor_si128(b, _mm_and_si128(letters, bit)));
+    }
+    scalar::flip_ascii_case(p + i, size - i, out + i, first);
+}
+
+}
+
+namespace avx2
+{
+
+CLEO_AVX2 const char *find(const char *p, std::size_t size, const char *n, std::size_t nsize)
+{
+    if (nsize > size)
+        return nullptr;
+    auto first = _mm256_set1_epi8(n[0]);
+    auto last = _mm256_set1_epi8(n[nsize - 1]);
+    auto positions = size - nsize + 1;
+    std::size_t i = 0;
+    for (; i + 32 <= positions; i += 32)
+    {
+        auto bf = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        auto bl = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i + nsize - 1));
+        unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(bf, first), _mm256_cmpeq_epi8(bl, last)));
+        for (; mask; mask &= mask - 1)
+        {
+            auto k = __builtin_ctz(mask);
+            if (std::memcmp(p + i + k + 1, n + 1, nsize - 1) == 0)
+                return p + i + k;
+        }
+    }
+    return sse2::find(p + i, size - i, n, nsize);
+}
+
+CLEO_AVX2 std::size_t count_chars(const char *p, std::size_t size)
+{
+    auto last_continuation = _mm256_set1_epi8(-65);
+    std::size_t n = 0, i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        n += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpgt_epi8(b, last_continuation)));
+    }
+    return n + sse2::count_chars(p + i, size - i);
+}
+
+CLEO_AVX2 void flip_ascii_case(const char *p, std::size_t size, char *out, char first)
+{
+    auto lo = _mm256_set1_epi8(first - 1);
+    auto hi = _mm256_set1_epi8(first + 26);
+    auto bit = _mm256_set1_epi8(0x20);
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        auto letters = _mm256_and_si256(_mm256_cmpgt_epi8(b, lo), _mm256_cmpgt_epi8(hi, b));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_xor_si256(b, _mm256_and_si256(letters, bit)));
+    }
+    sse2::flip_ascii_case(p + i, size - i, out + i, first);
+}
+
+}
+
+#endif
+
+namespace simd
+{
+
+const char *find(const char *p, std::size_t size, const char *n, std::size_t nsize) { return CLEO_SIMD(find)(p, size, n, nsize); }
+std::size_t count_chars(const char *p, std::size_t size) { return CLEO_SIMD(count_chars)(p, size); }
+void flip_ascii_case(const char *p, std::size_t size, char *out, char first) { CLEO_SIMD(flip_ascii_case)(p, size, out, first); }
+
+}
+
+bool is_ascii_string(Value s)
+{
+    return get_string_size(s) == get_string_len(s);
+}
+
+std::uint32_t count_chars(Value s, const char *p, std::size_t size)
+{
+    return is_ascii_string(s) ? size : simd::count_chars(p, size);
+}
+
+std::string get_needle(const std::string& name, Value val)
+{
+    auto tag = get_value_tag(val);
+    if (tag != tag::UTF8STRING && tag != tag::UCHAR)
+        throw_illegal_argument(name + " must be a string or a char, got: " + to_string(val));
+    std::string needle;
+    print_str(needle, val);
+    return needle;
+}
+
+bool is_whitespace(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+Force persistent_vector(Value transient)
+{
+    Root a{transient_array_persistent(transient)};
+    auto size = get_array_size(*a);
+    return size <= 32 ? *a : create_vector(get_array_elems(*a), size);
+}
+
+// Uppercase chars from first to last, or every other one when step is 2, have
+// their lowercase chars at delta
+struct CaseRange
+{
+    Char32 first, last;
+    std::int32_t delta;
+    std::uint8_t step;
+};
+
+const CaseRange CASE_RANGES[] = {
+    {0x41, 0x5a, 32, 1},
+    {0xc0, 0xd6, 32, 1},
+    {0xd8, 0xde, 32, 1},
+    {0x100, 0x12e, 1, 2},
+    {0x132, 0x136, 1, 2},
+    {0x139, 0x147, 1, 2},
+    {0x14a, 0x176, 1, 2},
+    {0x178, 0x178, -121, 1},
+    {0x179, 0x17d, 1, 2},
+    {0x1cd, 0x1db, 1, 2},
+    {0x1de, 0x1ee, 1, 2},
+    {0x1f8, 0x21e, 1, 2},
+    {0x222, 0x232, 1, 2},
+    {0x386, 0x386, 38, 1},
+    {0x388, 0x38a, 37, 1},
+    {0x38c, 0x38c, 64, 1},
+    {0x38e, 0x38f, 63, 1},
+    {0x391, 0x3a1, 32, 1},
+    {0x3a3, 0x3ab, 32, 1},
+    {0x3d8, 0x3ee, 1, 2},
+    {0x400, 0x40f, 80, 1},
+    {0x410, 0x42f, 32, 1},
+    {0x460, 0x480, 1, 2},
+    {0x48a, 0x4be, 1, 2},
+    {0x4c0, 0x4c0, 15, 1},
+    {0x4c1, 0x4cd, 1, 2},
+    {0x4d0, 0x52e, 1, 2},
+    {0x531, 0x556, 48, 1},
+    {0x1e00, 0x1e94, 1, 2},
+    {0x1ea0, 0x1efe, 1, 2},
+    {0xff21, 0xff3a, 32, 1},
+};
+
+Char32 to_lower_case(Char32 c)
+{
+    if (c == 0x130) // capital I with dot above
+        return 'i';
+    for (auto& r : CASE_RANGES)
+        if (c >= r.first && c <= r.last && (c - r.first) % r.step == 0)
+            return c + r.delta;
+    return c;
+}
+
+Char32 to_upper_case(Char32 c)
+{
+    switch (c)
+    {
+    case 0xb5: return 0x39c; // micro sign
+    case 0x131: return 'I'; // dotless i
+    case 0x17f: return 'S'; // long s
+    case 0x3c2: return 0x3a3; // final sigma
+    }
+    for (auto& r : CASE_RANGES)
+    {
+        auto u = c - r.delta;
+        if (u >= r.first && u <= r.last && (u - r.first) % r.step == 0)
+            return u;
+    }
+    return c;
+}
+
+Force convert_case(Value s, char first, Char32 (*convert)(Char32))
+{
+    check_type("s", s, *type::UTF8String);
+    auto p = get_string_ptr(s);
+    auto size = get_string_size(s);
+    std::string out;
+    if (is_ascii_string(s))
+    {
+        out.resize(size);
+        simd::flip_ascii_case(p, size, &out[0], first);
+    }
+    else
+    {
+        out.reserve(size);
+        for (std::uint32_t offset = 0; offset < size; offset = get_string_next_offset(s, offset))
+            print_str(out, create_uchar(convert(get_string_char_at_offset(s, offset))));
+    }
+    return create_string(out);
+}
+
+}
+
+Force string_index_of(Value s, Value x)
+{
+    return string_index_of(s, x, *ZERO);
+}
+
+Force string_index_of(Value s, Value x, Value from)
+{
+    check_type("s", s, *type::UTF8String);
+    check_type("from", from, type::Int64);
+    auto needle = get_needle("x", x);
+    auto start = std::max(get_int64_value(from), Int64(0));
+    if (start > get_string_len(s))
+        return nil;
+    if (needle.empty())
+        return create_int64(start);
+    auto p = get_string_ptr(s);
+    auto offset = get_string_char_offset(s, start);
+    auto found = simd::find(p + offset, get_string_size(s) - offset, needle.data(), needle.size());
+    if (!found)
+        return nil;
+    return create_int64(start + count_chars(s, p + offset, found - (p + offset)));
+}
+
+Force string_last_index_of(Value s, Value x)
+{
+    check_type("s", s, *type::UTF8String);
+    Root from{create_int64(get_string_len(s))};
+    return string_last_index_of(s, x, *from);
+}
+
+Force string_last_index_of(Value s, Value x, Value from)
+{
+    check_type("s", s, *type::UTF8String);
+    check_type("from", from, type::Int64);
+    auto needle = get_needle("x", x);
+    auto limit = std::min(get_int64_value(from), Int64(get_string_len(s)));
+    if (limit < 0)
+        return nil;
+    if (needle.empty())
+        return create_int64(limit);
+    auto p = get_string_ptr(s);
+    auto size = std::min(std::size_t(get_string_size(s)), get_string_char_offset(s, limit) + needle.size());
+    auto found = scalar::find_last(p, size, needle.data(), needle.size());
+    if (!found)
+        return nil;
+    return create_int64(count_chars(s, p, found - p));
+}
+
+Value string_includes(Value s, Value x)
+{
+    check_type("s", s, *type::UTF8String);
+    auto needle = get_needle("x", x);
+    return needle.empty() || simd::find(get_string_ptr(s), get_string_size(s), needle.data(), needle.size()) ? TRUE : nil;
+}
+
+Force string_split(Value s, Value sep)
+{
+    check_type("s", s, *type::UTF8String);
+    auto needle = get_needle("sep", sep);
+    if (needle.empty())
+        throw_illegal_argument("sep must not be empty");
+    struct Piece
+    {
+        std::uint32_t start, end, start_offset, end_offset;
+    };
+    std::vector<Piece> pieces;
+    auto p = get_string_ptr(s);
+    auto size = get_string_size(s);
+    auto needle_len = count_chars(s, needle.data(), needle.size());
+    std::uint32_t offset = 0, index = 0;
+    while (auto found = simd::find(p + offset, size - offset, needle.data(), needle.size()))
+    {
+        std::uint32_t end_offset = found - p;
+        auto end = index + count_chars(s, p + offset, end_offset - offset);
+        pieces.push_back({index, end, offset, end_offset});
+        offset = end_offset + needle.size();
+        index = end + needle_len;
+    }
+    pieces.push_back({index, get_string_len(s), offset, size});
+    if (pieces.size() > 1)
+        while (!pieces.empty() && pieces.back().start == pieces.back().end)
+            pieces.pop_back();
+
+    Root v{transient_array(*EMPTY_VECTOR)};
+    Root piece;
+    for (auto& pc : pieces)
+    {
+        piece = create_substring(s, pc.start, pc.end, pc.start_offset, pc.end_offset);
+        v = transient_array_conj(*v, *piece);
+    }
+    return persistent_vector(*v);
+}
+
+Force string_replace(Value s, Value match, Value replacement)
+{
+    check_type("s", s, *type::UTF8String);
+    auto needle = get_needle("match", match);
+    auto with = get_needle("replacement", replacement);
+    if (needle.empty())
+        throw_illegal_argument("match must not be empty");
+    auto p = get_string_ptr(s);
+    std::size_t size = get_string_size(s);
+    auto found = simd::find(p, size, needle.data(), needle.size());
+    if (!found)
+        return s;
+    std::string out;
+    out.reserve(size);
+    std::size_t offset = 0;
+    for (; found; found = simd::find(p + offset, size - offset, needle.data(), needle.size()))
+    {
+        out.append(p + offset, found - (p + offset));
+        out += with;
+        offset = found - p + needle.size();
+    }
+    out.append(p + offset, size - offset);
+    return create_string(out);
+}
+
+Force string_join(Value coll)
+{
+    return string_join(nil, coll);
+}
+
+Force string_join(Value sep, Value coll)
+{
+    std::string separator;
+    if (sep)
+        print_str(separator, sep);
+    std::string out;
+    bool first_elem = true;
+    auto append = [&](Value e)
+    {
+        if (first_elem)
+            first_elem = false;
+        else
+            out += separator;
+        if (e)
+            print_str(out, e);
+    };
+    if (get_value_type(coll).is(*type::Array))
+    {
+        auto size = get_array_size(coll);
+        for (decltype(size) i = 0; i != size; ++i)
+            append(get_array_elem(coll, i));
+    }
+    else
+    {
+        for (Root s{call_multimethod1(*rt::seq, coll)}; *s; s = call_multimethod1(*rt::next, *s))
+        {
+            Root e{call_multimethod1(*rt::first, *s)};
+            append(*e);
+        }
+    }
+    return create_string(out);
+}
+
+Force string_trim(Value s)
+{
+    check_type("s", s, *type::UTF8String);
+    auto p = get_string_ptr(s);
+    auto size = get_string_size(s);
+    std::uint32_t start = 0;
+    while (start < size && is_whitespace(p[start]))
+        ++start;
+    auto end = size;
+    while (end > start && is_whitespace(p[end - 1]))
+        --end;
+    // whitespace is ASCII, so trimmed bytes are trimmed chars
+    return create_substring(s, start, get_string_len(s) - (size - end), start, end);
+}
+
+Force string_lower_case(Value s)
+{
+    return convert_case(s, 'A', to_lower_case);
+}
+
+Force string_upper_case(Value s)
+{
+    return convert_case(s, 'a', to_upper_case);
+}
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+Force string_index_of(Value s, Value x);
+Force string_index_of(Value s, Value x, Value from);
+Force string_last_index_of(Value s, Value x);
+Force string_last_index_of(Value s, Value x, Value from);
+Value string_includes(Value s, Value x);
+Force string_split(Value s, Value sep);
+Force string_replace(Value s, Value match, Value replacement);
+Force string_join(Value coll);
+Force string_join(Value sep, Value coll);
+Force string_trim(Value s);
+Force string_lower_case(Value s);
+Force string_upper_case(Value s);
+
+}
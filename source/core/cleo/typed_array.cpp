@@ -0,0 +1,920 @@
+#include "typed_array.hpp"
+#include "global.hpp"
+#include "util.hpp"
+#include "chunked_seq.hpp"
+#include "array.hpp"
+#include "reduce.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace cleo
+{
+
+// Int64Array, Float64Array:
+//   [size | elem0 elem1 ...]
+// TransientInt64Array, TransientFloat64Array:
+//   [size | elem0 elem1 ... unused capacity ...]
+// TypedArraySeq:
+//   [array index]
+//
+// The bulk kernels use AVX2 when the CPU supports it, SSE2 otherwise on x86-64
+// and plain loops elsewhere. There are no 64-bit integer multiplications before
+// AVX-512 and no 64-bit integer comparisons in SSE2, so those kernels stay scalar.
+// Integer arithmetic throws ArithmeticException on overflow like +. The SIMD sums
+// add in lanes, so they redo the sum sequentially when a lane overflows.
+
+namespace
+{
+
+namespace scalar
+{
+
+Int64 checked_add(Int64 x, Int64 y)
+{
+    Int64 r;
+    if (__builtin_add_overflow(x, y, &r))
+        throw_integer_overflow();
+    return r;
+}
+
+Int64 checked_mul(Int64 x, Int64 y)
+{
+    Int64 r;
+    if (__builtin_mul_overflow(x, y, &r))
+        throw_integer_overflow();
+    return r;
+}
+
+Int64 sum_int64(const Int64 *p, Int64 n)
+{
+    Int64 s = 0;
+    for (Int64 i = 0; i < n; ++i)
+        s = checked_add(s, p[i]);
+    return s;
+}
+
+// Sums the SIMD lanes and the remaining elements, returns false on overflow
+bool try_sum_int64(const Int64 *lanes, Int64 lane_count, const Int64 *p, Int64 n, Int64& s)
+{
+    s = 0;
+    for (Int64 i = 0; i < lane_count; ++i)
+        if (__builtin_add_overflow(s, lanes[i], &s))
+            return false;
+    for (Int64 i = 0; i < n; ++i)
+        if (__builtin_add_overflow(s, p[i], &s))
+            return false;
+    return true;
+}
+
+Int64 min_int64(const Int64 *p, Int64 n)
+{
+    return *std::min_element(p, p + n);
+}
+
+Int64 max_int64(const Int64 *p, Int64 n)
+{
+    return *std::max_element(p, p + n);
+}
+
+Int64 dot_int64(const Int64 *a, const Int64 *b, Int64 n)
+{
+    Int64 s = 0;
+    for (Int64 i = 0; i < n; ++i)
+        s = checked_add(s, checked_mul(a[i], b[i]));
+    return s;
+}
+
+void add_int64(const Int64 *a, const Int64 *b, Int64 *out, Int64 n)
+{
+    for (Int64 i = 0; i < n; ++i)
+        out[i] = checked_add(a[i], b[i]);
+}
+
+void mul_int64(const Int64 *a, const Int64 *b, Int64 *out, Int64 n)
+{
+    for (Int64 i = 0; i < n; ++i)
+        out[i] = checked_mul(a[i], b[i]);
+}
+
+void scale_int64(const Int64 *a, Int64 x, Int64 *out, Int64 n)
+{
+    for (Int64 i = 0; i < n; ++i)
+        out[i] = checked_mul(a[i], x);
+}
+
+void prefix_sum_int64(const Int64 *a, Int64 *out, Int64 n)
+{
+    Int64 s = 0;
+    for (Int64 i = 0; i < n; ++i)
+        out[i] = s = checked_add(s, a[i]);
+}
+
+Float64 sum_float64(const Float64 *p, Int64 n)
+{
+    Float64 s = 0;
+    for (Int64 i = 0; i < n; ++i)
+        s += p[i];
+    return s;
+}
+
+Float64 min_float64(const Float64 *p, Int64 n)
+{
+    return *std::min_element(p, p + n);
+}
+
+Float64 max_float64(const Float64 *p, Int64 n)
+{
+    return *std::max_element(p, p + n);
+}
+
+Float64 dot_float64(const Float64 *a, const Float64 *b, Int64 n)
+{
+    Float64 s = 0;
+    for (Int64 i = 0; i < n; ++i)
+        s += a[i] * b[i];
+    return s;
+}
+
+void add_float64(const Float64 *a, const Float64 *b, Float64 *out, Int64 n)
+{
+    for (Int64 i = 0; i < n; ++i)
+        out[i] = a[i] + b[i];
+}
+
+void mul_float64(const Float64 *a, const Float64 *b, Float64 *out, Int64 n)
+{
+    for (Int64 i = 0; i < n; ++i)
+        out[i] = a[i] * b[i];
+}
+
+void scale_float64(const Float64 *a, Float64 x, Float64 *out, Int64 n)
+{
+    for (Int64 i = 0; i < n; ++i)
+        out[i] = a[i] * x;
+}
+
+}
+
+#ifdef __x86_64__
+
+namespace sse2
+{
+
+using scalar::min_int64;
+using scalar::max_int64;
+
+// The sign bit of each lane is set when x + y = r overflowed
+__m128i add_overflow_int64(__m128i x, __m128i y, __m128i r)
+{
+    return _mm_and_si128(_mm_xor_si128(x, r), _mm_xor_si128(y, r));
+}
+
+bool any_sign_int64(__m128i v)
+{
+    return _mm_movemask_pd(_mm_castsi128_pd(v)) != 0;
+}
+
+Int64 sum_int64(const Int64 *p, Int64 n)
+{
+    __m128i acc = _mm_setzero_si128(), overflow = _mm_setzero_si128();
+    Int64 i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        auto s = _mm_add_epi64(acc, x);
+        overflow = _mm_or_si128(overflow, add_overflow_int64(acc, x, s));
+        acc = s;
+    }
+    alignas(16) Int64 lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+    Int64 s;
+    if (!any_sign_int64(overflow) && scalar::try_sum_int64(lanes, 2, p + i, n - i, s))
+        return s;
+    return scalar::sum_int64(p, n);
+}
+
+void add_int64(const Int64 *a, const Int64 *b, Int64 *out, Int64 n)
+{
+    __m128i overflow = _mm_setzero_si128();
+    Int64 i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        auto y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        auto r = _mm_add_epi64(x, y);
+        overflow = _mm_or_si128(overflow, add_overflow_int64(x, y, r));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), r);
+    }
+    if (any_sign_int64(overflow))
+        throw_integer_overflow();
+    scalar::add_int64(a + i, b + i, out + i, n - i);
+}
+
+Float64 sum_float64(const Float64 *p, Int64 n)
+{
+    __m128d acc = _mm_setzero_pd();
+    Int64 i = 0;
+    for (; i + 2 <= n; i += 2)
+        acc = _mm_add_pd(acc, _mm_loadu_pd(p + i));
+    alignas(16) Float64 lanes[2];
+    _mm_store_pd(lanes, acc);
+    return lanes[0] + lanes[1] + scalar::sum_float64(p + i, n - i);
+}
+
+Float64 min_float64(const Float64 *p, Int64 n)
+{
+    if (n < 2)
+        return scalar::min_float64(p, n);
+    __m128d m = _mm_loadu_pd(p);
+    Int64 i = 2;
+    for (; i + 2 <= n; i += 2)
+        m = _mm_min_pd(m, _mm_loadu_pd(p + i));
+    alignas(16) Float64 lanes[2];
+    _mm_store_pd(lanes, m);
+    auto r = std::min(lanes[0], lanes[1]);
+    return i < n ? std::min(r, scalar::min_float64(p + i, n - i)) : r;
+}
+
+Float64 max_float64(const Float64 *p, Int64 n)
+{
+    if (n < 2)
+        return scalar::max_float64(p, n);
+    __m128d m = _mm_loadu_pd(p);
+    Int64 i = 2;
+    for (; i + 2 <= n; i += 2)
+        m = _mm_max_pd(m, _mm_loadu_pd(p + i));
+    alignas(16) Float64 lanes[2];
+    _mm_store_pd(lanes, m);
+    auto r = std::max(lanes[0], lanes[1]);
+    return i < n ? std::max(r, scalar::max_float64(p + i, n - i)) : r;
+}
+
+Float64 dot_float64(const Float64 *a, const Float64 *b, Int64 n)
+{
+    __m128d acc = _mm_setzero_pd();
+    Int64 i = 0;
+    for (; i + 2 <= n; i += 2)
+        acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    alignas(16) Float64 lanes[2];
+    _mm_store_pd(lanes, acc);
+    return lanes[0] + lanes[1] + scalar::dot_float64(a + i, b + i, n - i);
+}
+
+void add_float64(const Float64 *a, const Float64 *b, Float64 *out, Int64 n)
+{
+    Int64 i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    scalar::add_float64(a + i, b + i, out + i, n - i);
+}
+
+void mul_float64(const Float64 *a, const Float64 *b, Float64 *out, Int64 n)
+{
+    Int64 i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    scalar::mul_float64(a + i, b + i, out + i, n - i);
+}
+
+void scale_float64(const Float64 *a, Float64 x, Float64 *out, Int64 n)
+{
+    auto xs = _mm_set1_pd(x);
+    Int64 i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), xs));
+    scalar::scale_float64(a + i, x, out + i, n - i);
+}
+
+}
+
+namespace avx2
+{
+
+CLEO_AVX2 __m256i add_overflow_int64(__m256i x, __m256i y, __m256i r)
+{
+    return _mm256_and_si256(_mm256_xor_si256(x, r), _mm256_xor_si256(y, r));
+}
+
+CLEO_AVX2 bool any_sign_int64(__m256i v)
+{
+    return _mm256_movemask_pd(_mm256_castsi256_pd(v)) != 0;
+}
+
+CLEO_AVX2 Int64 sum_int64(const Int64 *p, Int64 n)
+{
+    __m256i acc = _mm256_setzero_si256(), overflow = _mm256_setzero_si256();
+    Int64 i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        auto s = _mm256_add_epi64(acc, x);
+        overflow = _mm256_or_si256(overflow, add_overflow_int64(acc, x, s));
+        acc = s;
+    }
+    alignas(32) Int64 lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+    Int64 s;
+    if (!any_sign_int64(overflow) && scalar::try_sum_int64(lanes, 4, p + i, n - i, s))
+        return s;
+    return scalar::sum_int64(p, n);
+}
+
+CLEO_AVX2 Int64 min_int64(const Int64 *p, Int64 n)
+{
+    if (n < 4)
+        return scalar::min_int64(p, n);
+    __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    Int64 i = 4;
+    for (; i + 4 <= n; i += 4)
+    {
+        auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        m = _mm256_blendv_epi8(m, x, _mm256_cmpgt_epi64(m, x));
+    }
+    alignas(32) Int64 lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), m);
+    auto r = scalar::min_int64(lanes, 4);
+    return i < n ? std::min(r, scalar::min_int64(p + i, n - i)) : r;
+}
+
+CLEO_AVX2 Int64 max_int64(const Int64 *p, Int64 n)
+{
+    if (n < 4)
+        return scalar::max_int64(p, n);
+    __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    Int64 i = 4;
+    for (; i + 4 <= n; i += 4)
+    {
+        auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        m = _mm256_blendv_epi8(m, x, _mm256_cmpgt_epi64(x, m));
+    }
+    alignas(32) Int64 lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), m);
+    auto r = scalar::max_int64(lanes, 4);
+    return i < n ? std::max(r, scalar::max_int64(p + i, n - i)) : r;
+}
+
+CLEO_AVX2 void add_int64(const Int64 *a, const Int64 *b, Int64 *out, Int64 n)
+{
+    __m256i overflow = _mm256_setzero_si256();
+    Int64 i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        auto r = _mm256_add_epi64(x, y);
+        overflow = _mm256_or_si256(overflow, add_overflow_int64(x, y, r));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), r);
+    }
+    if (any_sign_int64(overflow))
+        throw_integer_overflow();
+    scalar::add_int64(a + i, b + i, out + i, n - i);
+}
+
+CLEO_AVX2 Float64 sum_float64(const Float64 *p, Int64 n)
+{
+    __m256d acc = _mm256_setzero_pd();
+    Int64 i = 0;
+    for (; i + 4 <= n; i += 4)
+        acc = _mm256_add_pd(acc, _mm256_loadu_pd(p + i));
+    alignas(32) Float64 lanes[4];
+    _mm256_store_pd(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalar::sum_float64(p + i, n - i);
+}
+
+CLEO_AVX2 Float64 min_float64(const Float64 *p, Int64 n)
+{
+    if (n < 4)
+        return scalar::min_float64(p, n);
+    __m256d m = _mm256_loadu_pd(p);
+    Int64 i = 4;
+    for (; i + 4 <= n; i += 4)
+        m = _mm256_min_pd(m, _mm256_loadu_pd(p + i));
+    alignas(32) Float64 lanes[4];
+    _mm256_store_pd(lanes, m);
+    auto r = scalar::min_float64(lanes, 4);
+    return i < n ? std::min(r, scalar::min_float64(p + i, n - i)) : r;
+}
+
+CLEO_AVX2 Float64 max_float64(const Float64 *p, Int64 n)
+{
+    if (n < 4)
+        return scalar::max_float64(p, n);
+    __m256d m = _mm256_loadu_pd(p);
+    Int64 i = 4;
+    for (; i + 4 <= n; i += 4)
+        m = _mm256_max_pd(m, _mm256_loadu_pd(p + i));
+    alignas(32) Float64 lanes[4];
+    _mm256_store_pd(lanes, m);
+    auto r = scalar::max_float64(lanes, 4);
+    return i < n ? std::max(r, scalar::max_float64(p + i, n - i)) : r;
+}
+
+CLEO_AVX2 Float64 dot_float64(const Float64 *a, const Float64 *b, Int64 n)
+{
+    __m256d acc = _mm256_setzero_pd();
+    Int64 i = 0;
+    for (; i + 4 <= n; i += 4)
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    alignas(32) Float64 lanes[4];
+    _mm256_store_pd(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalar::dot_float64(a + i, b + i, n - i);
+}
+
+CLEO_AVX2 void add_float64(const Float64 *a, const Float64 *b, Float64 *out, Int64 n)
+{
+    Int64 i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    scalar::add_float64(a + i, b + i, out + i, n - i);
+}
+
+CLEO_AVX2 void mul_float64(const Float64 *a, const Float64 *b, Float64 *out, Int64 n)
+{
+    Int64 i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    scalar::mul_float64(a + i, b + i, out + i, n - i);
+}
+
+CLEO_AVX2 void scale_float64(const Float64 *a, Float64 x, Float64 *out, Int64 n)
+{
+    auto xs = _mm256_set1_pd(x);
+    Int64 i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), xs));
+    scalar::scale_float64(a + i, x, out + i, n - i);
+}
+
+}
+
+#endif
+
+namespace simd
+{
+
+Int64 sum_int64(const Int64 *p, Int64 n) { return CLEO_SIMD(sum_int64)(p, n); }
+Int64 min_int64(const Int64 *p, Int64 n) { return CLEO_SIMD(min_int64)(p, n); }
+Int64 max_int64(const Int64 *p, Int64 n) { return CLEO_SIMD(max_int64)(p, n); }
+void add_int64(const Int64 *a, const Int64 *b, Int64 *out, Int64 n) { CLEO_SIMD(add_int64)(a, b, out, n); }
+Float64 sum_float64(const Float64 *p, Int64 n) { return CLEO_SIMD(sum_float64)(p, n); }
+Float64 min_float64(const Float64 *p, Int64 n) { return CLEO_SIMD(min_float64)(p, n); }
+Float64 max_float64(const Float64 *p, Int64 n) { return CLEO_SIMD(max_float64)(p, n); }
+Float64 dot_float64(const Float64 *a, const Float64 *b, Int64 n) { return CLEO_SIMD(dot_float64)(a, b, n); }
+void add_float64(const Float64 *a, const Float64 *b, Float64 *out, Int64 n) { CLEO_SIMD(add_float64)(a, b, out, n); }
+void mul_float64(const Float64 *a, const Float64 *b, Float64 *out, Int64 n) { CLEO_SIMD(mul_float64)(a, b, out, n); }
+void scale_float64(const Float64 *a, Float64 x, Float64 *out, Int64 n) { CLEO_SIMD(scale_float64)(a, x, out, n); }
+
+}
+
+bool is_int64_array_type(Value type)
+{
+    return type.is(*type::Int64Array) || type.is(*type::TransientInt64Array);
+}
+
+bool is_int64_array(Value v)
+{
+    return is_int64_array_type(get_value_type(v));
+}
+
+Int64 *get_int64_elems(Value v)
+{
+    return static_cast<Int64 *>(get_dynamic_object_mut_int_ptr(v, 1));
+}
+
+Float64 *get_float64_elems(Value v)
+{
+    return static_cast<Float64 *>(get_dynamic_object_mut_int_ptr(v, 1));
+}
+
+Force create_typed_array(Value type, Int64 size, Int64 capacity)
+{
+    Root a{create_object(type, nullptr, 1 + capacity, nullptr, 0)};
+    set_dynamic_object_int(*a, 0, size);
+    return *a;
+}
+
+Force create_typed_array(Value type, Int64 size)
+{
+    return create_typed_array(type, size, size);
+}
+
+Int64 check_int64(Value val)
+{
+    if (get_value_tag(val) != tag::INT64)
+        throw_illegal_argument("Can only put Int64's in an Int64Array");
+    return get_int64_value(val);
+}
+
+Float64 check_float64(Value val)
+{
+    if (get_value_tag(val) == tag::INT64)
+        return get_int64_value(val);
+    if (get_value_tag(val) != tag::FLOAT64)
+        throw_illegal_argument("Can only put numbers in a Float64Array");
+    return get_float64_value(val);
+}
+
+void set_elem(Value v, Int64 index, Value e)
+{
+    if (is_int64_array(v))
+        get_int64_elems(v)[index] = check_int64(e);
+    else
+        get_float64_elems(v)[index] = check_float64(e);
+}
+
+bool check_typed_array(Value v)
+{
+    auto type = get_value_type(v);
+    if (type.is(*type::Int64Array))
+        return true;
+    if (type.is(*type::Float64Array))
+        return false;
+    throw_illegal_argument("Expected an Int64Array or a Float64Array, got: " + to_string(type));
+}
+
+bool check_same_typed_arrays(Value l, Value r)
+{
+    auto is_int = check_typed_array(l);
+    if (check_typed_array(r) != is_int)
+        throw_illegal_argument("Typed arrays must have the same element type");
+    if (get_typed_array_size(l) != get_typed_array_size(r))
+        throw_illegal_argument("Typed arrays must have the same size");
+    return is_int;
+}
+
+Force copy_typed_array(Value type, Value v, Int64 size, Int64 capacity)
+{
+    Root a{create_typed_array(type, size, capacity)};
+    std::memcpy(get_dynamic_object_mut_int_ptr(*a, 1), get_dynamic_object_int_ptr(v, 1), std::min(size, get_typed_array_size(v)) * sizeof(Int64));
+    return *a;
+}
+
+Value get_persistent_type(Value v)
+{
+    return is_int64_array(v) ? *type::Int64Array : *type::Float64Array;
+}
+
+Value get_transient_type(Value v)
+{
+    return is_int64_array(v) ? *type::TransientInt64Array : *type::TransientFloat64Array;
+}
+
+Force get_elem_unchecked(Value v, Int64 index)
+{
+    if (is_int64_array(v))
+        return create_int64(get_int64_array_elems(v)[index]);
+    return create_float64(get_float64_array_elems(v)[index]);
+}
+
+Force index_array(Value v, Value index, bool throw_if_invalid)
+{
+    if (get_value_tag(index) != tag::INT64)
+    {
+        if (throw_if_invalid)
+            throw_illegal_argument("Key must be integer");
+        return nil;
+    }
+    auto i = get_int64_value(index);
+    if (i < 0 || i >= get_typed_array_size(v))
+    {
+        if (throw_if_invalid)
+            throw_index_out_of_bounds();
+        return nil;
+    }
+    return get_elem_unchecked(v, i);
+}
+
+void throw_empty_array()
+{
+    Root msg{create_string("Can't pop an empty array")};
+    throw_exception(new_illegal_state(*msg));
+}
+
+template <typename T>
+std::uint32_t hash_elems(const T *elems, Int64 size)
+{
+    std::uint32_t h = 0;
+    for (Int64 i = 0; i < size; ++i)
+        h = h * 31 + std::uint32_t(std::hash<T>{}(elems[i]));
+    return h * 31 + size;
+}
+
+bool is_less_with_nans_last(Float64 l, Float64 r)
+{
+    return !std::isnan(l) && (std::isnan(r) || l < r);
+}
+
+}
+
+Force create_int64_array(const Value *elems, Int64 size)
+{
+    Root a{create_typed_array(*type::Int64Array, size)};
+    auto dst = get_int64_elems(*a);
+    for (Int64 i = 0; i < size; ++i)
+        dst[i] = check_int64(elems[i]);
+    return *a;
+}
+
+Force create_float64_array(const Value *elems, Int64 size)
+{
+    Root a{create_typed_array(*type::Float64Array, size)};
+    auto dst = get_float64_elems(*a);
+    for (Int64 i = 0; i < size; ++i)
+        dst[i] = check_float64(elems[i]);
+    return *a;
+}
+
+Force create_int64_array_from_ints(const Int64 *elems, Int64 size)
+{
+    Root a{create_typed_array(*type::Int64Array, size)};
+    std::copy(elems, elems + size, get_int64_elems(*a));
+    return *a;
+}
+
+Force create_float64_array_from_floats(const Float64 *elems, Int64 size)
+{
+    Root a{create_typed_array(*type::Float64Array, size)};
+    std::copy(elems, elems + size, get_float64_elems(*a));
+    return *a;
+}
+
+Force get_typed_array_elem(Value v, Int64 index)
+{
+    if (index < 0 || index >= get_typed_array_size(v))
+        return nil;
+    return get_elem_unchecked(v, index);
+}
+
+Force typed_array_get(Value v, Value index)
+{
+    return index_array(v, index, false);
+}
+
+Force typed_array_call(Value v, Value index)
+{
+    return index_array(v, index, true);
+}
+
+Force typed_array_seq(Value v)
+{
+    if (get_typed_array_size(v) == 0)
+        return nil;
+    return create_static_object(*type::TypedArraySeq, v, 0);
+}
+
+Force get_typed_array_seq_first(Value s)
+{
+    return get_elem_unchecked(get_static_object_element(s, 0), get_static_object_int(s, 1));
+}
+
+Force get_typed_array_seq_next(Value s)
+{
+    auto v = get_static_object_element(s, 0);
+    auto i = get_static_object_int(s, 1) + 1;
+    if (get_typed_array_size(v) == i)
+        return nil;
+    return create_static_object(*type::TypedArraySeq, v, i);
+}
+
+Force get_typed_array_seq_chunk_first(Value s)
+{
+    auto v = get_static_object_element(s, 0);
+    auto i = get_static_object_int(s, 1);
+    auto size = std::min(get_typed_array_size(v) - i, Int64(CHUNK_SIZE));
+    Root chunk{create_array(nullptr, size)};
+    Root e;
+    for (Int64 j = 0; j < size; ++j)
+    {
+        e = get_elem_unchecked(v, i + j);
+        set_dynamic_object_element(*chunk, j, *e);
+    }
+    return *chunk;
+}
+
+Force get_typed_array_seq_chunk_next(Value s)
+{
+    auto v = get_static_object_element(s, 0);
+    auto i = get_static_object_int(s, 1) + CHUNK_SIZE;
+    if (get_typed_array_size(v) <= i)
+        return nil;
+    return create_static_object(*type::TypedArraySeq, v, i);
+}
+
+Force typed_array_conj(Value v, Value e)
+{
+    auto size = get_typed_array_size(v);
+    Root a{copy_typed_array(get_value_type(v), v, size + 1, size + 1)};
+    set_elem(*a, size, e);
+    return *a;
+}
+
+Force typed_array_pop(Value v)
+{
+    auto size = get_typed_array_size(v);
+    if (size == 0)
+        throw_empty_array();
+    return copy_typed_array(get_value_type(v), v, size - 1, size - 1);
+}
+
+Force typed_array_hash(Value v)
+{
+    auto size = get_typed_array_size(v);
+    if (is_int64_array(v))
+        return create_int64(hash_elems(get_int64_array_elems(v), size));
+    return create_int64(hash_elems(get_float64_array_elems(v), size));
+}
+
+Force typed_array_reduce(Value v, Value f, Value init)
+{
+    Root acc{init};
+    Root e;
+    auto size = get_typed_array_size(v);
+    for (Int64 i = 0; i < size; ++i)
+    {
+        e = get_elem_unchecked(v, i);
+        acc = reduce_step(f, *acc, *e);
+        if (is_reduced(*acc))
+            return reduced_deref(*acc);
+    }
+    return *acc;
+}
+
+Force typed_array_sum(Value v)
+{
+    auto is_int = check_typed_array(v);
+    auto size = get_typed_array_size(v);
+    if (is_int)
+        return create_int64(simd::sum_int64(get_int64_array_elems(v), size));
+    return create_float64(simd::sum_float64(get_float64_array_elems(v), size));
+}
+
+Force typed_array_min(Value v)
+{
+    auto is_int = check_typed_array(v);
+    auto size = get_typed_array_size(v);
+    if (size == 0)
+        return nil;
+    if (is_int)
+        return create_int64(simd::min_int64(get_int64_array_elems(v), size));
+    return create_float64(simd::min_float64(get_float64_array_elems(v), size));
+}
+
+Force typed_array_max(Value v)
+{
+    auto is_int = check_typed_array(v);
+    auto size = get_typed_array_size(v);
+    if (size == 0)
+        return nil;
+    if (is_int)
+        return create_int64(simd::max_int64(get_int64_array_elems(v), size));
+    return create_float64(simd::max_float64(get_float64_array_elems(v), size));
+}
+
+Force typed_array_dot(Value l, Value r)
+{
+    auto is_int = check_same_typed_arrays(l, r);
+    auto size = get_typed_array_size(l);
+    if (is_int)
+        return create_int64(scalar::dot_int64(get_int64_array_elems(l), get_int64_array_elems(r), size));
+    return create_float64(simd::dot_float64(get_float64_array_elems(l), get_float64_array_elems(r), size));
+}
+
+Force typed_array_add(Value l, Value r)
+{
+    auto is_int = check_same_typed_arrays(l, r);
+    auto size = get_typed_array_size(l);
+    Root a{create_typed_array(get_value_type(l), size)};
+    if (is_int)
+        simd::add_int64(get_int64_array_elems(l), get_int64_array_elems(r), get_int64_elems(*a), size);
+    else
+        simd::add_float64(get_float64_array_elems(l), get_float64_array_elems(r), get_float64_elems(*a), size);
+    return *a;
+}
+
+Force typed_array_mul(Value l, Value r)
+{
+    auto is_int = check_same_typed_arrays(l, r);
+    auto size = get_typed_array_size(l);
+    Root a{create_typed_array(get_value_type(l), size)};
+    if (is_int)
+        scalar::mul_int64(get_int64_array_elems(l), get_int64_array_elems(r), get_int64_elems(*a), size);
+    else
+        simd::mul_float64(get_float64_array_elems(l), get_float64_array_elems(r), get_float64_elems(*a), size);
+    return *a;
+}
+
+Force typed_array_scale(Value v, Value x)
+{
+    auto is_int = check_typed_array(v);
+    auto size = get_typed_array_size(v);
+    auto factor_int = is_int ? check_int64(x) : 0;
+    auto factor_float = is_int ? 0 : check_float64(x);
+    Root a{create_typed_array(get_value_type(v), size)};
+    if (is_int)
+        scalar::scale_int64(get_int64_array_elems(v), factor_int, get_int64_elems(*a), size);
+    else
+        simd::scale_float64(get_float64_array_elems(v), factor_float, get_float64_elems(*a), size);
+    return *a;
+}
+
+Force typed_array_prefix_sum(Value v)
+{
+    auto is_int = check_typed_array(v);
+    auto size = get_typed_array_size(v);
+    Root a{create_typed_array(get_value_type(v), size)};
+    if (is_int)
+        scalar::prefix_sum_int64(get_int64_array_elems(v), get_int64_elems(*a), size);
+    else
+    {
+        auto src = get_float64_array_elems(v);
+        auto dst = get_float64_elems(*a);
+        Float64 s = 0;
+        for (Int64 i = 0; i < size; ++i)
+            dst[i] = s += src[i];
+    }
+    return *a;
+}
+
+Force typed_array_sort(Value v)
+{
+    auto is_int = check_typed_array(v);
+    auto size = get_typed_array_size(v);
+    Root a{copy_typed_array(get_value_type(v), v, size, size)};
+    if (is_int)
+    {
+        auto elems = get_int64_elems(*a);
+        std::sort(elems, elems + size);
+    }
+    else
+    {
+        auto elems = get_float64_elems(*a);
+        std::sort(elems, elems + size, is_less_with_nans_last);
+    }
+    return *a;
+}
+
+Force transient_typed_array(Value v)
+{
+    auto size = get_typed_array_size(v);
+    auto capacity = (size < 16 ? 32 : (size * 2));
+    return copy_typed_array(get_transient_type(v), v, size, capacity);
+}
+
+Force transient_typed_array_get(Value v, Value index)
+{
+    return index_array(v, index, false);
+}
+
+Force transient_typed_array_call(Value v, Value index)
+{
+    return index_array(v, index, true);
+}
+
+Force transient_typed_array_conj(Value v, Value e)
+{
+    auto capacity = Int64(get_dynamic_object_int_size(v)) - 1;
+    auto size = get_transient_typed_array_size(v);
+    if (size < capacity)
+    {
+        set_elem(v, size, e);
+        set_dynamic_object_int(v, 0, size + 1);
+        return v;
+    }
+    Root t{copy_typed_array(get_value_type(v), v, size + 1, capacity * 2)};
+    set_elem(*t, size, e);
+    return *t;
+}
+
+Force transient_typed_array_pop(Value v)
+{
+    auto size = get_transient_typed_array_size(v);
+    if (size == 0)
+        throw_empty_array();
+    set_dynamic_object_int(v, 0, size - 1);
+    return v;
+}
+
+Force transient_typed_array_assoc(Value v, Value index, Value e)
+{
+    if (get_value_tag(index) != tag::INT64)
+        return nil;
+    auto i = get_int64_value(index);
+    auto size = get_transient_typed_array_size(v);
+    if (i < 0 || i > size)
+        throw_index_out_of_bounds();
+    if (i == size)
+        return transient_typed_array_conj(v, e);
+    set_elem(v, i, e);
+    return v;
+}
+
+Force transient_typed_array_persistent(Value v)
+{
+    set_object_type(v, get_persistent_type(v));
+    return v;
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+Force create_int64_array(const Value *elems, Int64 size);
+Force create_float64_array(const Value *elems, Int64 size);
+Force create_int64_array_from_ints(const Int64 *elems, Int64 size);
+Force create_float64_array_from_floats(const Float64 *elems, Int64 size);
+inline Int64 get_typed_array_size(Value v) { return get_dynamic_object_int(v, 0); }
+inline const Int64 *get_int64_array_elems(Value v) { return static_cast<const Int64 *>(get_dynamic_object_int_ptr(v, 1)); }
+inline const Float64 *get_float64_array_elems(Value v) { return static_cast<const Float64 *>(get_dynamic_object_int_ptr(v, 1)); }
+Force get_typed_array_elem(Value v, Int64 index);
+Force typed_array_get(Value v, Value index);
+Force typed_array_call(Value v, Value index);
+Force typed_array_seq(Value v);
+Force get_typed_array_seq_first(Value s);
+Force get_typed_array_seq_next(Value s);
+Force get_typed_array_seq_chunk_first(Value s);
+Force get_typed_array_seq_chunk_next(Value s);
+Force typed_array_conj(Value v, Value e);
+Force typed_array_pop(Value v);
+Force typed_array_hash(Value v);
+Force typed_array_reduce(Value v, Value f, Value init);
+
+Force typed_array_sum(Value v);
+Force typed_array_min(Value v);
+Force typed_array_max(Value v);
+Force typed_array_dot(Value l, Value r);
+Force typed_array_add(Value l, Value r);
+Force typed_array_mul(Value l, Value r);
+Force typed_array_scale(Value v, Value x);
+Force typed_array_prefix_sum(Value v);
+Force typed_array_sort(Value v);
+
+Force transient_typed_array(Value v);
+inline Int64 get_transient_typed_array_size(Value v) { return get_dynamic_object_int(v, 0); }
+Force transient_typed_array_get(Value v, Value index);
+Force transient_typed_array_call(Value v, Value index);
+Force transient_typed_array_conj(Value v, Value e);
+Force transient_typed_array_pop(Value v);
+Force transient_typed_array_assoc(Value v, Value index, Value e);
+Force transient_typed_array_persistent(Value v);
+
+}
@@ -7,6 +7,7 @@
 #include "persistent_hash_set.hpp"
 #include "array_map.hpp"
 #include "array_set.hpp"
+#include "simd.hpp"
 
 namespace cleo
 {
@@ -96,6 +97,18 @@ void throw_illegal_state(const std::string& msg)
     throw_exception(new_compilation_error(*s));
 }
 
+bool cpu_has_avx2()
+{
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+const bool has_avx2 = cpu_has_avx2();
+
 Int64 count(Value val)
 {
     Root n{call_multimethod1(*rt::count, val)};
@@ -120,25 +133,37 @@ bool map_contains(Value m, Value k)
     throw_illegal_argument("invalid map type: " + to_string(type));
 }
 
+Force array_map_to_transient_hash_map(Value m)
+{
+    Root tm{transient_hash_map(*EMPTY_HASH_MAP)};
+    auto size = get_array_map_size(m);
+    for (decltype(size) i = 0; i != size; ++i)
+        tm = transient_hash_map_assoc(*tm, get_array_map_key(m, i), get_array_map_val(m, i));
+    return *tm;
+}
+
+Force array_set_to_transient_hash_set(Value s)
+{
+    Root ts{transient_hash_set(*EMPTY_HASH_SET)};
+    auto size = get_array_set_size(s);
+    for (decltype(size) i = 0; i != size; ++i)
+        ts = transient_hash_set_conj(*ts, get_array_set_elem(s, i));
+    return *ts;
+}
+
 namespace
 {
 
 Force array_map_to_persistent_hash_map(Value m)
 {
-    Root pm{*EMPTY_HASH_MAP};
-    auto size = get_array_map_size(m);
-    for (decltype(size) i = 0; i != size; ++i)
-        pm = persistent_hash_map_assoc(*pm, get_array_map_key(m, i), get_array_map_val(m, i));
-    return *pm;
+    Root tm{array_map_to_transient_hash_map(m)};
+    return transient_hash_map_persistent(*tm);
 }
 
 Force array_set_to_persistent_hash_set(Value s)
 {
-    Root ps{*EMPTY_HASH_SET};
-    auto size = get_array_set_size(s);
-    for (decltype(size) i = 0; i != size; ++i)
-        ps = persistent_hash_set_conj(*ps, get_array_set_elem(s, i));
-    return *ps;
+    Root ts{array_set_to_transient_hash_set(s)};
+    return transient_hash_set_persistent(*ts);
 }
 
 }
@@ -152,7 +177,7 @@ Force map_assoc(Value m, Value k, Value v)
         return persistent_hash_map_assoc(m, k, v);
     if (type.is(*type::ArrayMap))
     {
-        if (get_array_map_size(m) >= 16)
+        if (get_array_map_size(m) >= MAX_ARRAY_MAP_SIZE)
         {
             Root pm{array_map_to_persistent_hash_map(m)};
             return persistent_hash_map_assoc(*pm, k, v);
@@ -93,6 +93,19 @@ Force create_native_function1or2()
     }, deref_name<name>());
 }
 
+template <Force f1(Value), Force f2(Value, Value), const Value *name>
+Force create_native_function1or2()
+{
+    return create_native_function([](const Value *args, std::uint8_t num_args) -> Force
+    {
+        if (num_args == 1)
+            return f1(args[0]);
+        if (num_args == 2)
+            return f2(args[0], args[1]);
+        throw_arity_error(deref_name<name>(), num_args);
+    }, deref_name<name>());
+}
+
 template <Force f(Value), const Value *name>
 Force create_native_new1()
 {
@@ -223,6 +236,7 @@ Int64 count(Value val);
 bool is_map(Value val);
 bool map_contains(Value m, Value k);
 Force map_assoc(Value m, Value k, Value v);
+Force array_map_to_transient_hash_map(Value m);
 Value map_get(Value m, Value k);
 Int64 map_count(Value m);
 Force map_merge(Value m1, Value m2);
@@ -232,6 +246,7 @@ Force map_seq_next(Value s);
 
 bool is_set(Value val);
 Force set_conj(Value s, Value k);
+Force array_set_to_transient_hash_set(Value s);
 bool set_contains(Value s, Value k);
 Int64 set_count(Value s);
 
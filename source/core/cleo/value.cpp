@@ -4,6 +4,9 @@
 #include <cstring>
 #include <algorithm>
 #include <cmath>
+#ifdef __x86_64__
+#include <emmintrin.h>
+#endif
 
 namespace cleo
 {
@@ -14,14 +17,44 @@ struct NativeFunctionWithName
     NativeFunction ptr;
 };
 
+// A string is ASCII when size == len. Other strings are followed by an index
+// of byte offsets of every STRING_INDEX_STEP-th char, so indexed access only
+// walks a few code points.
 struct String
 {
     std::uint32_t size;
     std::uint32_t len;
     std::uint32_t hashVal;
+    std::uint32_t isSlice;
     char firstChar;
 };
 
+// A substring sharing the bytes of its parent, which is never a slice.
+// Slices are not zero-terminated.
+struct StringSlice
+{
+    std::uint32_t size;
+    std::uint32_t len;
+    std::uint32_t hashVal;
+    std::uint32_t isSlice;
+    Value parent;
+    std::uint32_t offset;
+    std::uint32_t charOffset;
+};
+
+constexpr std::uint32_t STRING_INDEX_STEP = 64;
+constexpr std::uint32_t STRING_SLICE_MIN_SIZE = 32;
+// Substrings are copied when they cover less than 1/STRING_SLICE_MAX_WASTE of their parent,
+// so a small slice never pins a much larger string.
+constexpr std::uint32_t STRING_SLICE_MAX_WASTE = 8;
+// Short strings are read in place from the Value bits, which needs a little-endian layout.
+// Keeping the last payload byte zero keeps them zero-terminated.
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+constexpr std::uint32_t SHORT_STRING_MAX_SIZE = 5;
+#else
+constexpr std::uint32_t SHORT_STRING_MAX_SIZE = 0;
+#endif
+
 struct Symbol
 {
     Value ns, name;
@@ -108,19 +141,25 @@ auto valid_utf8_code_point_length(const char* str, const char *endp)
     return invalid();
 }
 
-std::pair<std::uint32_t, bool> valid_utf8_string_size(const char* str, std::uint32_t size)
+struct UTF8StringSize
 {
-    std::uint32_t valid_size = 0;
+    std::uint32_t size, len;
+    bool valid;
+};
+
+UTF8StringSize valid_utf8_string_size(const char* str, std::uint32_t size)
+{
+    UTF8StringSize ss{0, 0, true};
     auto endp = str + size;
-    bool valid = true;
     while (str != endp)
     {
         auto cpl = valid_utf8_code_point_length(str, endp);
-        valid_size += cpl.len;
+        ss.size += cpl.len;
+        ++ss.len;
         str += cpl.str_len;
-        valid = valid && cpl.valid;
+        ss.valid = ss.valid && cpl.valid;
     }
-    return {valid_size, valid};
+    return ss;
 }
 
 void fix_utf8_string(const char* str, std::uint32_t size, char *out)
@@ -144,28 +183,97 @@ void fix_utf8_string(const char* str, std::uint32_t size, char *out)
     }
 }
 
-std::uint32_t get_utf8_string_len(const char* str, std::uint32_t size)
+bool is_ascii(const char *str, std::uint32_t size)
+{
+    std::uint32_t i = 0;
+#ifdef __x86_64__
+    for (; i + 16 <= size; i += 16)
+        if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(str + i))))
+            return false;
+#endif
+    for (; i < size; ++i)
+        if (str[i] & 0x80)
+            return false;
+    return true;
+}
+
+std::uint32_t get_string_index_size(std::uint32_t len)
+{
+    return len ? (len - 1) / STRING_INDEX_STEP : 0;
+}
+
+std::uint32_t get_string_index_pos(std::uint32_t size)
+{
+    auto pos = offsetof(String, firstChar) + size + 1;
+    return (pos + alignof(std::uint32_t) - 1) & ~(alignof(std::uint32_t) - 1);
+}
+
+const std::uint32_t *get_string_index(const String *s)
+{
+    return reinterpret_cast<const std::uint32_t *>(reinterpret_cast<const char *>(s) + get_string_index_pos(s->size));
+}
+
+void build_string_index(const char *str, std::uint32_t size, std::uint32_t *index)
 {
-    auto endp = str + size;
     std::uint32_t n = 0;
-    for (; str != endp; ++str)
-        n += ((*str & 0xc0) != 0x80);
-    return n;
+    for (std::uint32_t i = 0; i < size; ++i)
+    {
+        if ((str[i] & 0xc0) == 0x80)
+            continue;
+        if (n != 0 && n % STRING_INDEX_STEP == 0)
+            *index++ = i;
+        ++n;
+    }
+}
+
+bool fits_short_string(const char *str, std::uint32_t size)
+{
+    return
+        std::memchr(str, 0, size) == nullptr &&
+        (is_ascii(str, size) || valid_utf8_string_size(str, size).valid);
+}
+
+Value create_short_string(const char *str, std::uint32_t size)
+{
+    ValueBits bits = 0;
+    for (std::uint32_t i = 0; i < size; ++i)
+        bits |= ValueBits(std::uint8_t(str[i])) << (8 * i);
+    return tag_data(bits, tag::SHORT_STRING);
+}
+
+std::uint32_t get_short_string_size(Value val)
+{
+    auto bits = val.bits() & tag::DATA_MASK;
+    return bits ? (71 - __builtin_clzll(bits)) / 8 : 0;
 }
 
 template <typename Alloc>
 Force create_string(const char* str, std::uint32_t size, Alloc alloc)
 {
-    auto valid_size = valid_utf8_string_size(str, size);
-    auto val = static_cast<String *>(alloc(offsetof(String, firstChar) + valid_size.first + 1));
-    val->size = valid_size.first;
+    if (is_ascii(str, size))
+    {
+        auto val = static_cast<String *>(alloc(offsetof(String, firstChar) + size + 1));
+        val->size = size;
+        val->len = size;
+        val->hashVal = 0;
+        val->isSlice = 0;
+        std::memcpy(&val->firstChar, str, size);
+        (&val->firstChar)[size] = 0;
+        return tag_ptr(val, tag::UTF8STRING);
+    }
+    auto ss = valid_utf8_string_size(str, size);
+    auto index_pos = get_string_index_pos(ss.size);
+    auto val = static_cast<String *>(alloc(index_pos + get_string_index_size(ss.len) * sizeof(std::uint32_t)));
+    val->size = ss.size;
+    val->len = ss.len;
     val->hashVal = 0;
-    if (valid_size.second)
+    val->isSlice = 0;
+    if (ss.valid)
         std::memcpy(&val->firstChar, str, size);
     else
         fix_utf8_string(str, size, &val->firstChar);
-    (&val->firstChar)[valid_size.first] = 0;
-    val->len = get_utf8_string_len(&val->firstChar, val->size);
+    (&val->firstChar)[ss.size] = 0;
+    build_string_index(&val->firstChar, ss.size, reinterpret_cast<std::uint32_t *>(reinterpret_cast<char *>(val) + index_pos));
     return tag_ptr(val, tag::UTF8STRING);
 }
 
@@ -196,25 +304,32 @@ Value get_native_function_name(Value fn)
     return get_ptr<NativeFunctionWithName>(fn)->name;
 }
 
-Value create_symbol(const std::string& ns, const std::string& name)
+Value create_symbol(const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size)
 {
-    auto& entry = symbols[ns][name];
-    if (entry)
-        return entry;
+    auto found = symbols.find(ns, ns_size, name, name_size);
+    if (found)
+        return found;
     Root ns_root, name_root;
-    if (!ns.empty())
-        ns_root = create_string(ns, mem_palloc);
-    name_root = create_string(name, mem_palloc);
+    if (ns_size)
+        ns_root = create_string(ns, ns_size, mem_palloc);
+    name_root = create_string(name, name_size, mem_palloc);
     auto val = palloc<Symbol>();
     val->ns = *ns_root;
     val->name = *name_root;
     val->hashVal = 0;
-    return entry = tag_ptr(val, tag::SYMBOL);
+    auto symbol = tag_ptr(val, tag::SYMBOL);
+    symbols.insert(ns, ns_size, name, name_size, symbol);
+    return symbol;
+}
+
+Value create_symbol(const std::string& ns, const std::string& name)
+{
+    return create_symbol(ns.data(), ns.size(), name.data(), name.size());
 }
 
 Value create_symbol(const std::string& name)
 {
-    return create_symbol({}, name);
+    return create_symbol("", 0, name.data(), name.size());
 }
 
 Value get_symbol_namespace(Value s)
@@ -237,25 +352,32 @@ void set_symbol_hash(Value val, std::uint32_t h)
     get_ptr<Symbol>(val)->hashVal = h;
 }
 
-Value create_keyword(const std::string& ns, const std::string& name)
+Value create_keyword(const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size)
 {
-    auto& entry = keywords[ns][name];
-    if (entry)
-        return entry;
+    auto found = keywords.find(ns, ns_size, name, name_size);
+    if (found)
+        return found;
     Root ns_root, name_root;
-    if (!ns.empty())
-        ns_root = create_string(ns, mem_palloc);
-    name_root = create_string(name, mem_palloc);
+    if (ns_size)
+        ns_root = create_string(ns, ns_size, mem_palloc);
+    name_root = create_string(name, name_size, mem_palloc);
     auto val = palloc<Keyword>();
     val->ns = *ns_root;
     val->name = *name_root;
     val->hashVal = 0;
-    return entry = tag_ptr(val, tag::KEYWORD);
+    auto keyword = tag_ptr(val, tag::KEYWORD);
+    keywords.insert(ns, ns_size, name, name_size, keyword);
+    return keyword;
+}
+
+Value create_keyword(const std::string& ns, const std::string& name)
+{
+    return create_keyword(ns.data(), ns.size(), name.data(), name.size());
 }
 
 Value create_keyword(const std::string& name)
 {
-    return create_keyword({}, name);
+    return create_keyword("", 0, name.data(), name.size());
 }
 
 Value get_keyword_namespace(Value s)
@@ -322,21 +444,84 @@ Float64 get_float64_value(Value val)
 
 Force create_string(const char* str, std::uint32_t size)
 {
+    if (size <= SHORT_STRING_MAX_SIZE && fits_short_string(str, size))
+        return create_short_string(str, size);
     return create_string(str, size, mem_alloc);
 }
 
-const char *get_string_ptr(Value val)
+Force create_substring(Value val, std::uint32_t start, std::uint32_t end)
+{
+    assert(start <= end && end <= get_string_len(val));
+    if (start == 0 && end == get_string_len(val))
+        return val;
+    return create_substring(val, start, end, get_string_char_offset(val, start), get_string_char_offset(val, end));
+}
+
+Force create_substring(Value val, std::uint32_t start, std::uint32_t end, std::uint32_t start_offset, std::uint32_t end_offset)
 {
-    return &get_ptr<String>(val)->firstChar;
+    assert(start <= end && end <= get_string_len(val));
+    assert(start_offset <= end_offset && end_offset <= get_string_size(val));
+    if (start == 0 && end == get_string_len(val))
+        return val;
+    auto offset = start_offset;
+    auto size = end_offset - start_offset;
+    if (is_string_slice(val))
+    {
+        auto parent = get_ptr<StringSlice>(val);
+        offset += parent->offset;
+        start += parent->charOffset;
+        end += parent->charOffset;
+        val = parent->parent;
+    }
+    Root parent{val};
+    if (size < STRING_SLICE_MIN_SIZE || get_string_size(*parent) > STRING_SLICE_MAX_WASTE * size)
+        return create_string(get_string_ptr(*parent) + offset, size);
+    auto slice = alloc<StringSlice>();
+    slice->size = size;
+    slice->len = end - start;
+    slice->hashVal = 0;
+    slice->isSlice = 1;
+    slice->parent = *parent;
+    slice->offset = offset;
+    slice->charOffset = start;
+    return tag_ptr(slice, tag::UTF8STRING);
+}
+
+bool is_string_slice(Value val)
+{
+    return !is_short_string(val) && get_ptr<String>(val)->isSlice;
+}
+
+Value get_string_slice_parent(Value val)
+{
+    return get_ptr<StringSlice>(val)->parent;
+}
+
+StringPtr get_string_ptr(Value val)
+{
+    if (is_short_string(val))
+        return StringPtr{val.bits() & tag::DATA_MASK};
+    auto s = get_ptr<String>(val);
+    if (!s->isSlice)
+        return StringPtr{&s->firstChar};
+    auto slice = get_ptr<StringSlice>(val);
+    return StringPtr{&get_ptr<String>(slice->parent)->firstChar + slice->offset};
 }
 
 std::uint32_t get_string_size(Value val)
 {
+    if (is_short_string(val))
+        return get_short_string_size(val);
     return get_ptr<String>(val)->size;
 }
 
 std::uint32_t get_string_len(Value val)
 {
+    if (is_short_string(val))
+    {
+        auto p = get_string_ptr(val);
+        return std::count_if(p.data(), p.data() + get_short_string_size(val), [](char c) { return (c & 0xc0) != 0x80; });
+    }
     return get_ptr<String>(val)->len;
 }
 
@@ -348,8 +533,26 @@ Char32 get_string_char(Value val, std::uint32_t index)
 Char32 get_string_char_offset(Value val, std::uint32_t index)
 {
     assert(index <= get_string_len(val));
-    auto offset = 0;
-    for (; index; --index)
+    if (is_short_string(val))
+    {
+        std::uint32_t offset = 0;
+        for (; index; --index)
+            offset = get_string_next_offset(val, offset);
+        return offset;
+    }
+    auto s = get_ptr<String>(val);
+    if (s->size == s->len)
+        return index;
+    if (index == s->len)
+        return s->size;
+    if (s->isSlice)
+    {
+        auto slice = get_ptr<StringSlice>(val);
+        return get_string_char_offset(slice->parent, slice->charOffset + index) - slice->offset;
+    }
+    auto entry = index / STRING_INDEX_STEP;
+    std::uint32_t offset = entry ? get_string_index(s)[entry - 1] : 0;
+    for (index %= STRING_INDEX_STEP; index; --index)
         offset = get_string_next_offset(val, offset);
     return offset;
 }
@@ -357,7 +560,8 @@ Char32 get_string_char_offset(Value val, std::uint32_t index)
 Char32 get_string_char_at_offset(Value val, std::uint32_t offset)
 {
     assert(offset < get_string_size(val));
-    auto p = get_string_ptr(val) + offset;
+    auto s = get_string_ptr(val);
+    auto p = s + offset;
     if ((*p & 0x80) == 0)
         return *p;
     if ((*p & 0x20) == 0)
@@ -376,12 +580,13 @@ std::uint32_t get_string_next_offset(Value val, std::uint32_t offset)
 
 std::uint32_t get_string_hash(Value val)
 {
-    return get_ptr<String>(val)->hashVal;
+    return is_short_string(val) ? 0 : get_ptr<String>(val)->hashVal;
 }
 
 void set_string_hash(Value val, std::uint32_t h)
 {
-    get_ptr<String>(val)->hashVal = h;
+    if (!is_short_string(val))
+        get_ptr<String>(val)->hashVal = h;
 }
 
 namespace
@@ -590,7 +795,6 @@ std::uint32_t get_dynamic_object_int_size(Value obj)
 
 void set_dynamic_object_size(Value obj, std::uint32_t size)
 {
-    assert(size <= get_dynamic_object_size(obj));
     assert(is_object_dynamic(obj));
     get_ptr<DynamicObject>(obj)->valCount = size;
 }
@@ -111,7 +111,9 @@ struct DynamicObject
 // Float64 QNaN: 00000000 00000111 00000000 00000000 00000000 00000000 00000000 00000000
 // No SNaNs
 // Int48         00000000 00001101 |----------------  48 integer bits  -------- -------|
-// Pointer:      00000000 0000|tag||------- --------  48 pointer bits  -------- -------| (tag != 0111) && (tag != 1101)
+// StackSeq      00000000 00001010 |------- 24 size bits ------||---- 24 index bits ----|
+// ShortString   00000000 00001011 00000000 |------- up to 5 non-zero UTF-8 bytes -------| (byte 0 is the lowest)
+// Pointer:      00000000 0000|tag||------- --------  48 pointer bits  -------- -------| (tag != 0111) && (tag != 1101) && (tag != 1010) && (tag != 1011)
 // nil:          00000000 00000000 00000000 00000000 00000000 00000000 00000000 00000000
 
 namespace tag
@@ -126,6 +128,8 @@ constexpr Tag UTF8STRING = ValueBits(6) << 48;
 constexpr Tag FLOAT64 = ValueBits(7) << 48;
 constexpr Tag UCHAR = ValueBits(8) << 48;
 constexpr Tag PROTOCOL = ValueBits(9) << 48;
+constexpr Tag STACK_SEQ = ValueBits(10) << 48;
+constexpr Tag SHORT_STRING = ValueBits(11) << 48;
 
 constexpr Tag INT48 = ValueBits(13) << 48;
 
@@ -162,6 +166,8 @@ inline Tag get_value_tag(Value val)
     auto tag = val.bits() & tag::TAG_MASK;
     if (tag == tag::INT48)
         return tag::INT64;
+    if (tag == tag::SHORT_STRING)
+        return tag::UTF8STRING;
     return tag;
 }
 
@@ -173,7 +179,7 @@ inline Int64 get_sign_extended_value_data(Value val)
 inline void *get_value_ptr(Value val)
 {
     assert(is_value_ptr(val));
-#ifdef __APPLE__
+#if defined(__APPLE__) || defined(__x86_64__)
     static_assert(std::int64_t(-4) >> 2 == -1, "needs arithmetic left shift");
     return reinterpret_cast<void *>(std::uintptr_t(std::uint64_t(get_sign_extended_value_data(val))));
 #else
@@ -198,6 +204,7 @@ Value get_native_function_name(Value fn);
 
 Value create_symbol(const std::string& ns, const std::string& name);
 Value create_symbol(const std::string& name);
+Value create_symbol(const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size);
 Value get_symbol_namespace(Value s);
 Value get_symbol_name(Value s);
 std::uint32_t get_symbol_hash(Value val);
@@ -205,6 +212,7 @@ void set_symbol_hash(Value val, std::uint32_t h);
 
 Value create_keyword(const std::string& ns, const std::string& name);
 Value create_keyword(const std::string& name);
+Value create_keyword(const char *ns, std::uint32_t ns_size, const char *name, std::uint32_t name_size);
 Value get_keyword_namespace(Value s);
 Value get_keyword_name(Value s);
 std::uint32_t get_keyword_hash(Value val);
@@ -230,7 +238,29 @@ Float64 get_float64_value(Value val);
 
 Force create_string(const char* str, std::uint32_t size);
 inline Force create_string(const std::string& str) { return create_string(str.c_str(), str.length()); }
-const char *get_string_ptr(Value val);
+Force create_substring(Value val, std::uint32_t start, std::uint32_t end);
+// For callers which already know the byte offsets of the chars at start and end
+Force create_substring(Value val, std::uint32_t start, std::uint32_t end, std::uint32_t start_offset, std::uint32_t end_offset);
+inline bool is_short_string(Value val) { return (val.bits() & tag::FLIP_MASK) == tag::SHORT_STRING; }
+bool is_string_slice(Value val);
+Value get_string_slice_parent(Value val);
+// Pointer to the bytes of a string. Short strings live in the Value itself, so their bytes are
+// copied here and the pointer stays valid as long as the StringPtr which produced it.
+class StringPtr
+{
+public:
+    explicit StringPtr(const char *ptr) : ptr(ptr) { }
+    explicit StringPtr(ValueBits bits) : bits(bits) { }
+
+    const char *data() const { return ptr ? ptr : reinterpret_cast<const char *>(&bits); }
+    operator const char *() const { return data(); }
+
+private:
+    const char *ptr = nullptr;
+    ValueBits bits = 0;
+};
+
+StringPtr get_string_ptr(Value val);
 std::uint32_t get_string_size(Value val);
 std::uint32_t get_string_len(Value val);
 Char32 get_string_char(Value val, std::uint32_t index);
@@ -348,6 +378,13 @@ inline Value get_dynamic_object_element(Value obj, std::uint32_t index)
     return Value{(&ptr->firstVal)[ptr->intCount + index]};
 }
 
+inline const Value *get_dynamic_object_elements(Value obj)
+{
+    assert(is_object_dynamic(obj));
+    auto ptr = get_ptr<DynamicObject>(obj);
+    return reinterpret_cast<const Value *>(&ptr->firstVal + ptr->intCount);
+}
+
 inline Value get_static_object_element(Value obj, std::uint32_t index)
 {
     assert(!is_object_dynamic(obj));
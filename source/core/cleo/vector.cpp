@@ -0,0 +1,535 @@
+#include "vector.hpp"
+#include "array.hpp"
+#include "global.hpp"
+#include "util.hpp"
+#include "hash.hpp"
+#include "reduce.hpp"
+#include <array>
+
+namespace cleo
+{
+
+// Vector:
+//   [size shift hash | root tail]
+//   root: nil or a VectorNode, tail: nil or a VectorNode with the last 1..32 elements
+//   hash: memoized hash of the elements or 0 if not computed yet
+// TransientVector:
+//   [size shift edit | root tail]
+//   edit: 0 after persistent!
+//   tail: a VectorNode with 32 slots, owned by the transient and updated in place
+// VectorNode:
+//   inner: [child0 ... child31]
+//   leaf:  [elem0 ... elem31]
+// VectorSeq:
+//   [vector leaf index]
+
+namespace
+{
+
+constexpr Int64 BITS = 5;
+constexpr Int64 WIDTH = Int64(1) << BITS;
+constexpr Int64 MASK = WIDTH - 1;
+
+Int64 get_tail_offset(Int64 size)
+{
+    return size < WIDTH ? 0 : ((size - 1) >> BITS) << BITS;
+}
+
+Int64 get_vector_shift(Value v)
+{
+    return get_dynamic_object_int(v, 1);
+}
+
+Value get_vector_root(Value v)
+{
+    return get_dynamic_object_element(v, 0);
+}
+
+Value get_vector_tail(Value v)
+{
+    return get_dynamic_object_element(v, 1);
+}
+
+Force create_vector(Int64 size, Int64 shift, Value root, Value tail)
+{
+    std::array<Int64, 3> ints{{size, shift, 0}};
+    std::array<Value, 2> elems{{root, tail}};
+    return create_object(*type::Vector, ints.data(), ints.size(), elems.data(), elems.size());
+}
+
+Force create_empty_vector()
+{
+    return create_vector(0, BITS, nil, nil);
+}
+
+Force create_node(const Value *elems, std::uint32_t size)
+{
+    return create_object(*type::VectorNode, elems, size);
+}
+
+Force create_empty_node()
+{
+    return create_node(nullptr, WIDTH);
+}
+
+Force copy_node(Value node, std::uint32_t size)
+{
+    Root copy{create_node(nullptr, size)};
+    auto n = std::min(size, get_dynamic_object_size(node));
+    for (decltype(n) i = 0; i < n; ++i)
+        set_dynamic_object_element(*copy, i, get_dynamic_object_element(node, i));
+    return *copy;
+}
+
+Force copy_node(Value node)
+{
+    return copy_node(node, WIDTH);
+}
+
+Value get_node_child(Value node, Int64 index)
+{
+    return node ? get_dynamic_object_element(node, index & MASK) : nil;
+}
+
+Value get_leaf(Int64 size, Int64 shift, Value root, Value tail, Int64 index)
+{
+    if (index >= get_tail_offset(size))
+        return tail;
+    auto node = root;
+    for (auto level = shift; level > 0; level -= BITS)
+        node = get_dynamic_object_element(node, (index >> level) & MASK);
+    return node;
+}
+
+Force new_path(Int64 level, Value node)
+{
+    if (level == 0)
+        return node;
+    Root child{new_path(level - BITS, node)};
+    Root path{create_empty_node()};
+    set_dynamic_object_element(*path, 0, *child);
+    return *path;
+}
+
+Force push_tail(Int64 size, Int64 level, Value parent, Value tail)
+{
+    auto index = ((size - 1) >> level) & MASK;
+    Root node{copy_node(parent)};
+    Root child;
+    if (level == BITS)
+        child = tail;
+    else if (auto old_child = get_node_child(*node, index))
+        child = push_tail(size, level - BITS, old_child, tail);
+    else
+        child = new_path(level - BITS, tail);
+    set_dynamic_object_element(*node, index, *child);
+    return *node;
+}
+
+Force pop_tail(Int64 size, Int64 level, Value node)
+{
+    auto index = ((size - 2) >> level) & MASK;
+    if (level > BITS)
+    {
+        Root child{pop_tail(size, level - BITS, get_node_child(node, index))};
+        if (!*child && index == 0)
+            return nil;
+        Root popped{copy_node(node)};
+        set_dynamic_object_element(*popped, index, *child);
+        return *popped;
+    }
+    if (index == 0)
+        return nil;
+    Root popped{copy_node(node)};
+    set_dynamic_object_element(*popped, index, nil);
+    return *popped;
+}
+
+Force assoc_node(Int64 level, Value node, Int64 index, Value e)
+{
+    Root assoced{copy_node(node)};
+    if (level == 0)
+    {
+        set_dynamic_object_element(*assoced, index & MASK, e);
+        return *assoced;
+    }
+    auto child_index = (index >> level) & MASK;
+    Root child{assoc_node(level - BITS, get_node_child(node, child_index), index, e)};
+    set_dynamic_object_element(*assoced, child_index, *child);
+    return *assoced;
+}
+
+struct PushedTail
+{
+    Root root;
+    Int64 shift;
+};
+
+void push_full_tail(Int64 size, Int64 shift, Value root, Value tail, PushedTail& pushed)
+{
+    if ((size >> BITS) > (Int64(1) << shift))
+    {
+        Root path{new_path(shift, tail)};
+        pushed.root = create_empty_node();
+        set_dynamic_object_element(*pushed.root, 0, root);
+        set_dynamic_object_element(*pushed.root, 1, *path);
+        pushed.shift = shift + BITS;
+        return;
+    }
+    pushed.root = push_tail(size, shift, root, tail);
+    pushed.shift = shift;
+}
+
+Int64 last_edit = 0;
+
+void check_transient_vector_edit(Value v)
+{
+    if (get_dynamic_object_int(v, 2) == 0)
+    {
+        Root msg{create_string("Transient used after persistent! call")};
+        throw_exception(new_illegal_state(*msg));
+    }
+}
+
+void pop_leaf_into_tail(Int64 size, Int64 shift, Value root, PushedTail& popped)
+{
+    popped.root = pop_tail(size, shift, root);
+    popped.shift = shift;
+    if (shift > BITS && !get_node_child(*popped.root, 1))
+    {
+        popped.root = get_node_child(*popped.root, 0);
+        popped.shift = shift - BITS;
+    }
+}
+
+}
+
+Force create_vector(const Value *elems, std::uint32_t size)
+{
+    Root v{create_empty_vector()};
+    v = transient_vector(*v);
+    for (decltype(size) i = 0; i < size; ++i)
+        v = transient_vector_conj(*v, elems[i]);
+    return transient_vector_persistent(*v);
+}
+
+Value get_vector_elem(Value v, Int64 index)
+{
+    auto size = get_vector_size(v);
+    if (index < 0 || index >= size)
+        return nil;
+    return get_dynamic_object_element(get_vector_leaf(v, index), index & MASK);
+}
+
+Value get_vector_leaf(Value v, Int64 index)
+{
+    return get_leaf(get_vector_size(v), get_vector_shift(v), get_vector_root(v), get_vector_tail(v), index);
+}
+
+Force vector_conj(Value v, Value e)
+{
+    auto size = get_vector_size(v);
+    auto shift = get_vector_shift(v);
+    auto tail = get_vector_tail(v);
+    auto tail_size = size - get_tail_offset(size);
+    if (tail_size < WIDTH)
+    {
+        Root new_tail{copy_node(tail, tail_size + 1)};
+        set_dynamic_object_element(*new_tail, tail_size, e);
+        return create_vector(size + 1, shift, get_vector_root(v), *new_tail);
+    }
+    PushedTail pushed;
+    push_full_tail(size, shift, get_vector_root(v), tail, pushed);
+    Root new_tail{create_node(&e, 1)};
+    return create_vector(size + 1, pushed.shift, *pushed.root, *new_tail);
+}
+
+Force vector_pop(Value v)
+{
+    auto size = get_vector_size(v);
+    if (size == 0)
+    {
+        Root msg{create_string("Can't pop an empty vector")};
+        throw_exception(new_illegal_state(*msg));
+    }
+    if (size == 1)
+        return *EMPTY_VECTOR;
+    auto shift = get_vector_shift(v);
+    auto root = get_vector_root(v);
+    auto tail_size = size - get_tail_offset(size);
+    if (tail_size > 1)
+    {
+        Root new_tail{copy_node(get_vector_tail(v), tail_size - 1)};
+        return create_vector(size - 1, shift, root, *new_tail);
+    }
+    auto new_tail = get_vector_leaf(v, size - 2);
+    PushedTail popped;
+    pop_leaf_into_tail(size, shift, root, popped);
+    return create_vector(size - 1, popped.shift, *popped.root, new_tail);
+}
+
+Force vector_assoc_elem(Value v, Int64 index, Value e)
+{
+    auto size = get_vector_size(v);
+    if (index < 0 || index > size)
+        throw_index_out_of_bounds();
+    if (index == size)
+        return vector_conj(v, e);
+    auto shift = get_vector_shift(v);
+    auto root = get_vector_root(v);
+    auto tail = get_vector_tail(v);
+    if (index >= get_tail_offset(size))
+    {
+        Root new_tail{copy_node(tail, get_dynamic_object_size(tail))};
+        set_dynamic_object_element(*new_tail, index & MASK, e);
+        return create_vector(size, shift, root, *new_tail);
+    }
+    Root new_root{assoc_node(shift, root, index, e)};
+    return create_vector(size, shift, *new_root, tail);
+}
+
+Force vector_hash(Value v)
+{
+    std::uint32_t h = get_dynamic_object_int(v, 2);
+    if (h != 0)
+        return create_int64(h);
+    auto size = get_vector_size(v);
+    for (Int64 i = 0; i < size; i += WIDTH)
+    {
+        auto leaf = get_vector_leaf(v, i);
+        for (Int64 j = 0, n = std::min(WIDTH, size - i); j < n; ++j)
+            h = h * 31 + std::uint32_t(hash_value(get_dynamic_object_element(leaf, j)));
+    }
+    h = h * 31 + size;
+    set_dynamic_object_int(v, 2, h);
+    return create_int64(h);
+}
+
+Force vector_reduce(Value v, Value f, Value init)
+{
+    Root acc{init};
+    auto size = get_vector_size(v);
+    for (Int64 i = 0; i < size; i += WIDTH)
+    {
+        auto leaf = get_vector_leaf(v, i);
+        for (Int64 j = 0, n = std::min(WIDTH, size - i); j < n; ++j)
+        {
+            acc = reduce_step(f, *acc, get_dynamic_object_element(leaf, j));
+            if (is_reduced(*acc))
+                return reduced_deref(*acc);
+        }
+    }
+    return *acc;
+}
+
+Force vector_seq(Value v)
+{
+    if (get_vector_size(v) == 0)
+        return nil;
+    return create_static_object(*type::VectorSeq, v, get_vector_leaf(v, 0), Int64(0));
+}
+
+Value get_vector_seq_first(Value s)
+{
+    return get_dynamic_object_element(get_static_object_element(s, 1), get_static_object_int(s, 2) & MASK);
+}
+
+Force get_vector_seq_next(Value s)
+{
+    auto v = get_static_object_element(s, 0);
+    auto index = get_static_object_int(s, 2) + 1;
+    if (index == get_vector_size(v))
+        return nil;
+    auto leaf = (index & MASK) ? get_static_object_element(s, 1) : get_vector_leaf(v, index);
+    return create_static_object(*type::VectorSeq, v, leaf, index);
+}
+
+Force get_vector_seq_chunk_first(Value s)
+{
+    auto v = get_static_object_element(s, 0);
+    auto leaf = get_static_object_element(s, 1);
+    auto index = get_static_object_int(s, 2);
+    auto offset = index & MASK;
+    auto size = std::min(WIDTH - offset, get_vector_size(v) - index);
+    return create_array(get_dynamic_object_elements(leaf) + offset, size);
+}
+
+Force get_vector_seq_chunk_next(Value s)
+{
+    auto v = get_static_object_element(s, 0);
+    auto index = (get_static_object_int(s, 2) | MASK) + 1;
+    if (index >= get_vector_size(v))
+        return nil;
+    return create_static_object(*type::VectorSeq, v, get_vector_leaf(v, index), index);
+}
+
+Force stack_push_vector_seq(Value s, std::uint32_t n)
+{
+    auto v = get_static_object_element(s, 0);
+    auto size = get_vector_size(v);
+    auto index = get_static_object_int(s, 2);
+    while (n > 0 && index < size)
+    {
+        auto leaf = get_vector_leaf(v, index);
+        auto offset = index & MASK;
+        auto pushed = std::min(std::min(WIDTH - offset, size - index), Int64(n));
+        auto elems = get_dynamic_object_elements(leaf) + offset;
+        stack_push(elems, elems + pushed);
+        index += pushed;
+        n -= pushed;
+    }
+    if (index == size)
+        return nil;
+    return create_static_object(*type::VectorSeq, v, get_vector_leaf(v, index), index);
+}
+
+Force vector_to_array(Value v)
+{
+    if (!get_value_type(v).is(*type::Vector))
+        return v;
+    auto size = get_vector_size(v);
+    Root a{create_array(nullptr, size)};
+    for (Int64 i = 0; i < size; i += WIDTH)
+    {
+        auto leaf = get_vector_leaf(v, i);
+        for (Int64 j = 0, n = std::min(WIDTH, size - i); j < n; ++j)
+            set_dynamic_object_element(*a, i + j, get_dynamic_object_element(leaf, j));
+    }
+    return *a;
+}
+
+Force array_vector_conj(Value v, Value e)
+{
+    auto size = get_array_size(v);
+    if (size < WIDTH)
+        return array_conj(v, e);
+    Root pv{create_vector(get_array_elems(v), size)};
+    return vector_conj(*pv, e);
+}
+
+Force array_vector_pop(Value v)
+{
+    auto size = get_array_size(v);
+    if (size <= WIDTH)
+        return array_pop(v);
+    Root pv{create_vector(get_array_elems(v), size)};
+    return vector_pop(*pv);
+}
+
+Force array_vector_assoc_elem(Value v, Int64 index, Value e)
+{
+    Int64 size = get_array_size(v);
+    if (index < 0 || index > size)
+        throw_index_out_of_bounds();
+    if (index == size)
+        return array_vector_conj(v, e);
+    if (size > WIDTH)
+    {
+        Root pv{create_vector(get_array_elems(v), size)};
+        return vector_assoc_elem(*pv, index, e);
+    }
+    Root a{create_array(get_array_elems(v), size)};
+    set_dynamic_object_element(*a, index, e);
+    return *a;
+}
+
+Force transient_vector(Value v)
+{
+    std::array<Int64, 3> ints{{get_vector_size(v), get_vector_shift(v), ++last_edit}};
+    Root tail{copy_node(get_vector_tail(v))};
+    std::array<Value, 2> elems{{get_vector_root(v), *tail}};
+    return create_object(*type::TransientVector, ints.data(), ints.size(), elems.data(), elems.size());
+}
+
+Value get_transient_vector_elem(Value v, Int64 index)
+{
+    check_transient_vector_edit(v);
+    auto size = get_transient_vector_size(v);
+    if (index < 0 || index >= size)
+        return nil;
+    auto leaf = get_leaf(size, get_vector_shift(v), get_vector_root(v), get_vector_tail(v), index);
+    return get_dynamic_object_element(leaf, index & MASK);
+}
+
+Force transient_vector_conj(Value v, Value e)
+{
+    check_transient_vector_edit(v);
+    auto size = get_transient_vector_size(v);
+    auto tail_size = size - get_tail_offset(size);
+    if (tail_size < WIDTH)
+    {
+        set_dynamic_object_element(get_vector_tail(v), tail_size, e);
+        set_dynamic_object_int(v, 0, size + 1);
+        return v;
+    }
+    PushedTail pushed;
+    push_full_tail(size, get_vector_shift(v), get_vector_root(v), get_vector_tail(v), pushed);
+    Root new_tail{create_empty_node()};
+    set_dynamic_object_element(*new_tail, 0, e);
+    set_dynamic_object_element(v, 0, *pushed.root);
+    set_dynamic_object_element(v, 1, *new_tail);
+    set_dynamic_object_int(v, 0, size + 1);
+    set_dynamic_object_int(v, 1, pushed.shift);
+    return v;
+}
+
+Force transient_vector_pop(Value v)
+{
+    check_transient_vector_edit(v);
+    auto size = get_transient_vector_size(v);
+    if (size == 0)
+    {
+        Root msg{create_string("Can't pop an empty vector")};
+        throw_exception(new_illegal_state(*msg));
+    }
+    auto tail = get_vector_tail(v);
+    auto tail_size = size - get_tail_offset(size);
+    if (tail_size > 1 || size == 1)
+    {
+        set_dynamic_object_element(tail, tail_size - 1, nil); // GC
+        set_dynamic_object_int(v, 0, size - 1);
+        return v;
+    }
+    auto shift = get_vector_shift(v);
+    auto root = get_vector_root(v);
+    Root new_tail{copy_node(get_leaf(size, shift, root, tail, size - 2))};
+    PushedTail popped;
+    pop_leaf_into_tail(size, shift, root, popped);
+    set_dynamic_object_element(v, 0, *popped.root);
+    set_dynamic_object_element(v, 1, *new_tail);
+    set_dynamic_object_int(v, 0, size - 1);
+    set_dynamic_object_int(v, 1, popped.shift);
+    return v;
+}
+
+Force transient_vector_assoc_elem(Value v, Int64 index, Value e)
+{
+    check_transient_vector_edit(v);
+    auto size = get_transient_vector_size(v);
+    if (index < 0 || index > size)
+        throw_index_out_of_bounds();
+    if (index == size)
+        return transient_vector_conj(v, e);
+    if (index >= get_tail_offset(size))
+    {
+        set_dynamic_object_element(get_vector_tail(v), index & MASK, e);
+        return v;
+    }
+    Root new_root{assoc_node(get_vector_shift(v), get_vector_root(v), index, e)};
+    set_dynamic_object_element(v, 0, *new_root);
+    return v;
+}
+
+Force transient_vector_persistent(Value v)
+{
+    check_transient_vector_edit(v);
+    set_dynamic_object_int(v, 2, 0);
+    auto size = get_transient_vector_size(v);
+    auto tail_size = size - get_tail_offset(size);
+    Root tail;
+    if (tail_size > 0)
+        tail = copy_node(get_vector_tail(v), tail_size);
+    return create_vector(size, get_vector_shift(v), get_vector_root(v), *tail);
+}
+
+}
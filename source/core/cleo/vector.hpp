@@ -0,0 +1,36 @@
+#pragma once
+#include "value.hpp"
+
+namespace cleo
+{
+
+Force create_vector(const Value *elems, std::uint32_t size);
+inline Int64 get_vector_size(Value v) { return get_dynamic_object_int(v, 0); }
+Value get_vector_elem(Value v, Int64 index);
+Value get_vector_leaf(Value v, Int64 index);
+Force vector_conj(Value v, Value e);
+Force vector_pop(Value v);
+Force vector_assoc_elem(Value v, Int64 index, Value e);
+Force vector_hash(Value v);
+Force vector_reduce(Value v, Value f, Value init);
+Force vector_seq(Value v);
+Value get_vector_seq_first(Value s);
+Force get_vector_seq_next(Value s);
+Force get_vector_seq_chunk_first(Value s);
+Force get_vector_seq_chunk_next(Value s);
+Force stack_push_vector_seq(Value s, std::uint32_t n);
+Force vector_to_array(Value v);
+
+Force array_vector_conj(Value v, Value e);
+Force array_vector_pop(Value v);
+Force array_vector_assoc_elem(Value v, Int64 index, Value e);
+
+Force transient_vector(Value v);
+inline Int64 get_transient_vector_size(Value v) { return get_dynamic_object_int(v, 0); }
+Value get_transient_vector_elem(Value v, Int64 index);
+Force transient_vector_conj(Value v, Value e);
+Force transient_vector_pop(Value v);
+Force transient_vector_assoc_elem(Value v, Int64 index, Value e);
+Force transient_vector_persistent(Value v);
+
+}
@@ -10,6 +10,9 @@
 #include "cons.hpp"
 #include "util.hpp"
 #include "profiler.hpp"
+#include "stack_seq.hpp"
+#include "vm_stats.hpp"
+#include <algorithm>
 
 namespace cleo
 {
@@ -44,6 +47,18 @@ std::pair<Value, Int64> find_bytecode_fn_body(Value fn, std::uint8_t arity)
     return body;
 }
 
+bool keeps_stack_seqs(Value fn)
+{
+    return fn.is(*rt::first) || fn.is(*rt::next) || fn.is(*rt::seq) || fn.is(*rt::count);
+}
+
+void escape_stack_seqs(Value *elems, std::uint32_t n)
+{
+    for (std::uint32_t i = 0; i < n; ++i)
+        if (is_stack_seq(elems[i]))
+            elems[i] = escape_stack_seq(elems[i]).value();
+}
+
 Int64 get_max_arity(Value fn)
 {
     auto n = get_bytecode_fn_size(fn);
@@ -76,12 +91,17 @@ void call_bytecode_fn(std::uint32_t n)
     StackGuard guard(n - 1);
     if (arity < 0)
     {
-        auto rest = ~arity + 1;
+        std::uint32_t rest = ~arity + 1;
         if (rest < n)
         {
-            elems[rest] = create_array(elems + rest, n - rest).value();
-            stack_pop(n - rest - 1);
-            stack.back() = array_seq(stack.back()).value();
+            // [fn fixed... rest...] -> [fn rest... cache fn fixed... seq]
+            auto size = n - rest;
+            stack_push(nil, 3);
+            std::rotate(elems + 1, elems + rest, elems + n);
+            std::move_backward(elems + 1 + size, elems + n, elems + n + 2);
+            elems[1 + size] = create_int48(elems + 1 - stack.data());
+            elems[2 + size] = fn;
+            elems[n + 2] = create_stack_seq(elems + 1 - stack.data(), size);
         }
         else
             stack_push(nil);
@@ -99,7 +119,6 @@ void apply_bytecode_fn(std::uint32_t n)
     auto max_arity = get_max_arity(fn);
 
     Root s{stack.back()};
-    s = call_multimethod1(*rt::seq, *s);
     stack_pop();
 
     if (max_arity < 0)
@@ -108,6 +127,7 @@ void apply_bytecode_fn(std::uint32_t n)
 
         if (fixed_len > va_arity)
         {
+            s = call_multimethod1(*rt::seq, *s);
             if (*s)
                 while (fixed_len > va_arity)
                 {
@@ -124,12 +144,9 @@ void apply_bytecode_fn(std::uint32_t n)
             }
         }
 
-        auto len = fixed_len;
-        for (; len < va_arity && *s; s = call_multimethod1(*rt::next, *s))
-        {
-            stack_push(call_multimethod1(*rt::first, *s));
-            ++len;
-        }
+        auto fixed_size = stack.size();
+        s = stack_push_seq(*s, va_arity - fixed_len);
+        auto len = fixed_len + std::uint32_t(stack.size() - fixed_size);
         if (len == va_arity && *s)
         {
             stack_push(*s);
@@ -145,12 +162,9 @@ void apply_bytecode_fn(std::uint32_t n)
     }
     else
     {
-        auto len = fixed_len;
-        for (; len < max_arity && *s; s = call_multimethod1(*rt::next, *s))
-        {
-            stack_push(call_multimethod1(*rt::first, *s));
-            ++len;
-        }
+        auto fixed_size = stack.size();
+        s = stack_push_seq(*s, std::max<Int64>(max_arity - fixed_len, 0));
+        auto len = fixed_len + std::uint32_t(stack.size() - fixed_size);
         if (*s)
             throw_call_error("Too many args (" + std::to_string(len + 1) + " or more) passed to: " + to_string(get_bytecode_fn_name(fn)));
 
@@ -163,7 +177,11 @@ void apply_bytecode_fn(std::uint32_t n)
 
 }
 
-void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t locals_size, Value exception_table, const Byte *bytecode, std::uint32_t size)
+namespace
+{
+
+template <bool count_stats>
+void eval_bytecode_impl(Value constants, Value vars, Value closed, std::uint32_t locals_size, Value exception_table, const Byte *bytecode, std::uint32_t size, std::uint64_t *hits)
 {
     auto p = bytecode;
     auto endp = p + size;
@@ -195,8 +213,47 @@ void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t loca
             return maybe_throw_exception(p, *ex);
         };
 
+    auto call_n = [=](const Byte *p, std::uint32_t n) -> const Byte *
+        {
+            auto& first = stack[stack.size() - n];
+            try
+            {
+                if (get_value_type(first).is(*type::BytecodeFn))
+                    call_bytecode_fn(n);
+                else
+                {
+                    if (first.is(*rt::coll_reduce) && n > 1)
+                        escape_stack_seqs(&first + 2, n - 2);
+                    else if (!keeps_stack_seqs(first))
+                        escape_stack_seqs(&first + 1, n - 1);
+                    first = call(&first, n).value();
+                    stack_pop(n - 1);
+                }
+                return nullptr;
+            }
+            catch (cleo::Exception const& )
+            {
+                auto handler = find_exception_handler(p, *current_exception);
+                if (handler.offset < 0)
+                    throw;
+                Root ex{catch_exception()};
+                return handle_exception(handler, p, *ex);
+            }
+        };
+
+    int prev_oc = -1;
+
     while (p != endp)
     {
+        if (count_stats)
+        {
+            auto oc = std::uint8_t(*p);
+            ++stats::opcodes[oc];
+            if (prev_oc >= 0)
+                ++stats::opcode_pairs[prev_oc << 8 | oc];
+            ++hits[p - bytecode];
+            prev_oc = oc;
+        }
         switch (*p)
         {
         case LDC:
@@ -207,6 +264,16 @@ void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t loca
             stack_push(stack[stack_base + read_i16(p + 1)]);
             p += 3;
             break;
+        case LDLL:
+            stack_push(stack[stack_base + read_i16(p + 1)]);
+            stack_push(stack[stack_base + read_i16(p + 4)]);
+            p += 6;
+            break;
+        case LDVL:
+            stack_push(get_var_root_value(get_array_elem_unchecked(vars, read_u16(p + 1))));
+            stack_push(stack[stack_base + read_i16(p + 4)]);
+            p += 6;
+            break;
         case LDDV:
             stack_push(get_var_value(get_array_elem_unchecked(vars, read_u16(p + 1))));
             p += 3;
@@ -262,6 +329,7 @@ void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t loca
         case STVV:
         {
             auto var = stack[stack.size() - 2];
+            stack.back() = escape_stack_seq(stack.back()).value();
             set_var_root_value(var, stack.back());
             stack_pop();
             ++p;
@@ -270,6 +338,7 @@ void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t loca
         case STVM:
         {
             auto var = stack[stack.size() - 2];
+            stack.back() = escape_stack_seq(stack.back()).value();
             set_var_meta(var, stack.back());
             stack_pop();
             ++p;
@@ -278,9 +347,10 @@ void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t loca
         case STVB:
         {
             auto var = stack[stack.size() - 2];
-            auto val = stack.back();
             try
             {
+                stack.back() = escape_stack_seq(stack.back()).value();
+                auto val = stack.back();
                 set_var_value(var, val);
                 stack[stack.size() - 2] = val;
                 stack_pop();
@@ -317,27 +387,43 @@ void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t loca
             break;
         case CALL:
         {
-            auto n = std::uint8_t(p[1]) + 1;
-            auto& first = stack[stack.size() - n];
-            try
-            {
-                if (get_value_type(first).is(*type::BytecodeFn))
-                    call_bytecode_fn(n);
-                else
-                {
-                    first = call(&first, n).value();
-                    stack_pop(n - 1);
-                }
-                p += 2;
-            }
-            catch (cleo::Exception const& )
+            auto handler = call_n(p, std::uint8_t(p[1]) + 1);
+            p = handler ? handler : p + 2;
+            break;
+        }
+        case LCALL:
+        {
+            stack_push(stack[stack_base + read_i16(p + 1)]);
+            auto handler = call_n(p, std::uint8_t(p[4]) + 1);
+            p = handler ? handler : p + 5;
+            break;
+        }
+        case LLCALL:
+        {
+            stack_push(stack[stack_base + read_i16(p + 1)]);
+            stack_push(stack[stack_base + read_i16(p + 4)]);
+            auto handler = call_n(p, std::uint8_t(p[7]) + 1);
+            p = handler ? handler : p + 8;
+            break;
+        }
+        case VLCALL:
+        {
+            stack_push(get_var_root_value(get_array_elem_unchecked(vars, read_u16(p + 1))));
+            stack_push(stack[stack_base + read_i16(p + 4)]);
+            auto handler = call_n(p, std::uint8_t(p[7]) + 1);
+            p = handler ? handler : p + 8;
+            break;
+        }
+        case CALLSTL:
+        {
+            if (auto handler = call_n(p, std::uint8_t(p[1]) + 1))
             {
-                auto handler = find_exception_handler(p, *current_exception);
-                if (handler.offset < 0)
-                    throw;
-                Root ex{catch_exception()};
-                p = handle_exception(handler, p, *ex);
+                p = handler;
+                break;
             }
+            stack[stack_base + read_i16(p + 3)] = stack.back();
+            stack_pop();
+            p += 5;
             break;
         }
         case APPLY:
@@ -346,6 +432,7 @@ void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t loca
             auto& first = stack[stack.size() - n];
             try
             {
+                escape_stack_seqs(&first + 1, n - 1);
                 if (get_value_type(first).is(*type::BytecodeFn))
                     apply_bytecode_fn(n);
                 else
@@ -375,6 +462,7 @@ void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t loca
             {
                 auto fn = stack[stack.size() - n - 1];
                 auto vals = &stack[stack.size() - n];
+                escape_stack_seqs(vals, n);
                 Root vals_array{create_array(vals, n)};
                 stack[stack.size() - n - 1] = bytecode_fn_set_closed_vals(fn, *vals_array).value();
                 stack_pop(n);
@@ -384,6 +472,7 @@ void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t loca
         }
         case THROW:
         {
+            stack.back() = escape_stack_seq(stack.back()).value();
             p = maybe_throw_exception(p, stack.back());
             break;
         }
@@ -433,6 +522,21 @@ void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t loca
             break;
         }
     }
+    if (stack.size() > stack_base + locals_size)
+        stack.back() = escape_stack_seq(stack.back()).value();
+}
+
+}
+
+void eval_bytecode(Value constants, Value vars, Value closed, std::uint32_t locals_size, Value exception_table, const Byte *bytecode, std::uint32_t size)
+{
+    if (stats::enabled)
+    {
+        auto body = stats::get_body_counters(bytecode, size);
+        eval_bytecode_impl<true>(constants, vars, closed, locals_size, exception_table, bytecode, size, body->hits.data());
+    }
+    else
+        eval_bytecode_impl<false>(constants, vars, closed, locals_size, exception_table, bytecode, size, nullptr);
 }
 
 }
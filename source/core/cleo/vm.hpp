@@ -22,6 +22,10 @@ constexpr Byte LDV = 0x13;
 constexpr Byte LDDF = 0x14;
 constexpr Byte LDSF = 0x15;
 constexpr Byte LDCV = 0x16;
+// superinstructions replace the opcode of the first instruction in a sequence,
+// the operands and opcodes of the rest of the sequence stay in place
+constexpr Byte LDLL = 0x17;
+constexpr Byte LDVL = 0x18;
 
 constexpr Byte STL = 0x20;
 constexpr Byte STVV = 0x21;
@@ -36,6 +40,10 @@ constexpr Byte BNNIL = 0x32;
 
 constexpr Byte CALL = 0x40;
 constexpr Byte APPLY = 0x41;
+constexpr Byte LCALL = 0x42;
+constexpr Byte LLCALL = 0x43;
+constexpr Byte VLCALL = 0x44;
+constexpr Byte CALLSTL = 0x45;
 
 constexpr Byte THROW = 0x48;
 
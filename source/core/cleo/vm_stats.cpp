@@ -0,0 +1,158 @@
+#include "vm_stats.hpp"
+#include "global.hpp"
+#include "array.hpp"
+#include "bytecode_fn.hpp"
+#include "util.hpp"
+#include <algorithm>
+
+namespace cleo
+{
+namespace vm
+{
+namespace stats
+{
+
+bool enabled = false;
+std::array<std::uint64_t, 256> opcodes{};
+std::array<std::uint64_t, 256 * 256> opcode_pairs{};
+std::unordered_map<const Byte *, std::shared_ptr<BodyHits>> bodies;
+
+namespace
+{
+
+Force counts_map(const std::uint64_t *counts, std::size_t size)
+{
+    Root m{*EMPTY_MAP}, k, v;
+    for (std::size_t i = 0; i < size; ++i)
+        if (counts[i])
+        {
+            k = create_int64(i);
+            v = create_int64(counts[i]);
+            m = map_assoc(*m, *k, *v);
+        }
+    return *m;
+}
+
+}
+
+std::shared_ptr<BodyHits> get_body_counters(const Byte *bytecode, std::uint32_t size)
+{
+    auto& body = bodies[bytecode];
+    if (!body || body->hits.size() != size)
+    {
+        body = std::make_shared<BodyHits>();
+        body->fn_name = prof::callstack_size ? prof::callstack[prof::callstack_size - 1] : nil;
+        body->hits.assign(size, 0);
+    }
+    return body;
+}
+
+const char *get_opcode_name(Byte oc)
+{
+    switch (oc)
+    {
+    case CNIL: return "CNIL";
+    case POP: return "POP";
+    case LDC: return "LDC";
+    case LDL: return "LDL";
+    case LDDV: return "LDDV";
+    case LDV: return "LDV";
+    case LDDF: return "LDDF";
+    case LDSF: return "LDSF";
+    case LDCV: return "LDCV";
+    case LDLL: return "LDLL";
+    case LDVL: return "LDVL";
+    case STL: return "STL";
+    case STVV: return "STVV";
+    case STVM: return "STVM";
+    case STVB: return "STVB";
+    case STDF: return "STDF";
+    case STSF: return "STSF";
+    case BR: return "BR";
+    case BNIL: return "BNIL";
+    case BNNIL: return "BNNIL";
+    case CALL: return "CALL";
+    case APPLY: return "APPLY";
+    case LCALL: return "LCALL";
+    case LLCALL: return "LLCALL";
+    case VLCALL: return "VLCALL";
+    case CALLSTL: return "CALLSTL";
+    case THROW: return "THROW";
+    case IFN: return "IFN";
+    case UBXI64: return "UBXI64";
+    case BXI64: return "BXI64";
+    case ADDI64: return "ADDI64";
+    case NOT: return "NOT";
+    case NOP: return "NOP";
+    default: return nullptr;
+    }
+}
+
+Value start()
+{
+    opcodes.fill(0);
+    opcode_pairs.fill(0);
+    // bodies freed since the last run may have had their addresses reused
+    bodies.clear();
+    enabled = true;
+    return nil;
+}
+
+Value stop()
+{
+    enabled = false;
+    return nil;
+}
+
+Force get()
+{
+    Root ops{*EMPTY_MAP}, n;
+    for (std::size_t i = 0; i < opcodes.size(); ++i)
+        if (opcodes[i])
+        {
+            n = create_int64(opcodes[i]);
+            ops = map_assoc(*ops, create_symbol(get_opcode_name(Byte(i))), *n);
+        }
+
+    Root pairs{*EMPTY_MAP}, pair;
+    for (std::size_t i = 0; i < opcode_pairs.size(); ++i)
+        if (opcode_pairs[i])
+        {
+            std::array<Value, 2> names{{create_symbol(get_opcode_name(Byte(i >> 8))), create_symbol(get_opcode_name(Byte(i & 0xff)))}};
+            pair = create_array(names.data(), names.size());
+            n = create_int64(opcode_pairs[i]);
+            pairs = map_assoc(*pairs, *pair, *n);
+        }
+
+    Root dbodies{transient_array(*EMPTY_VECTOR)}, dbody, hits;
+    for (auto& body : bodies)
+    {
+        auto& counts = body.second->hits;
+        if (std::none_of(counts.begin(), counts.end(), [](auto n) { return n != 0; }))
+            continue;
+        hits = counts_map(counts.data(), counts.size());
+        dbody = *EMPTY_MAP;
+        dbody = map_assoc(*dbody, create_keyword("fn"), body.second->fn_name);
+        dbody = map_assoc(*dbody, create_keyword("hits"), *hits);
+        dbodies = transient_array_conj(*dbodies, *dbody);
+    }
+    dbodies = transient_array_persistent(*dbodies);
+
+    Root s{*EMPTY_MAP};
+    s = map_assoc(*s, create_keyword("opcodes"), *ops);
+    s = map_assoc(*s, create_keyword("pairs"), *pairs);
+    s = map_assoc(*s, create_keyword("bodies"), *dbodies);
+    return *s;
+}
+
+Force get_body_hits(Value body)
+{
+    auto it = bodies.find(get_bytecode_fn_body_bytes(body));
+    if (it == bodies.end() || it->second->hits.size() != std::size_t(get_bytecode_fn_body_bytes_size(body)))
+        return nil;
+    return counts_map(it->second->hits.data(), it->second->hits.size());
+}
+
+}
+}
+}
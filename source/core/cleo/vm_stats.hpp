@@ -0,0 +1,36 @@
+#pragma once
+#include "vm.hpp"
+#include <array>
+#include <unordered_map>
+#include <memory>
+
+namespace cleo
+{
+namespace vm
+{
+namespace stats
+{
+
+struct BodyHits
+{
+    Value fn_name;
+    std::vector<std::uint64_t> hits;
+};
+
+extern bool enabled;
+extern std::array<std::uint64_t, 256> opcodes;
+extern std::array<std::uint64_t, 256 * 256> opcode_pairs;
+// cleared by start(), frames being counted share ownership of their entries
+extern std::unordered_map<const Byte *, std::shared_ptr<BodyHits>> bodies;
+
+std::shared_ptr<BodyHits> get_body_counters(const Byte *bytecode, std::uint32_t size);
+const char *get_opcode_name(Byte oc);
+
+Value start();
+Value stop();
+Force get();
+Force get_body_hits(Value body);
+
+}
+}
+}
@@ -73,6 +73,40 @@ TEST_F(array_test, seq_should_return_a_sequence_of_the_vector_elements)
     ASSERT_TRUE(Root(get_array_seq_next(*seq))->is_nil());
 }
 
+TEST_F(array_test, chunked_seq_should_return_blocks_of_32_elements)
+{
+    std::vector<Value> elems;
+    Roots relems(70);
+    for (Int64 i = 0; i < 70; ++i)
+    {
+        relems.set(i, create_int64(i));
+        elems.push_back(relems[i]);
+    }
+    Root small{create_array(elems.data(), 20)};
+    Root s{array_seq(*small)};
+    Root chunk{get_array_seq_chunk_first(*s)};
+    EXPECT_EQ_REFS(*small, *chunk);
+    EXPECT_EQ_REFS(nil, *Root(get_array_seq_chunk_next(*s)));
+
+    Root v{create_array(elems.data(), elems.size())};
+    Int64 i = 0;
+    for (s = array_seq(*v); *s; s = get_array_seq_chunk_next(*s))
+    {
+        chunk = get_array_seq_chunk_first(*s);
+        ASSERT_EQ_REFS(*type::Array, get_value_type(*chunk));
+        ASSERT_EQ(i < 64 ? 32u : 6u, get_array_size(*chunk));
+        for (std::uint32_t j = 0; j < get_array_size(*chunk); ++j, ++i)
+            ASSERT_EQ(i, get_int64_value(get_array_elem(*chunk, j)));
+    }
+    EXPECT_EQ(70, i);
+
+    s = array_seq(*v);
+    s = get_array_seq_next(*s);
+    chunk = get_array_seq_chunk_first(*s);
+    ASSERT_EQ(32u, get_array_size(*chunk));
+    EXPECT_EQ(1, get_int64_value(get_array_elem(*chunk, 0)));
+}
+
 TEST_F(array_test, should_conj_elements_at_the_end_of_the_vector)
 {
     Root vec0{create_array(nullptr, 0)};
@@ -392,5 +392,40 @@ TEST_F(equality_test, should_compare_types)
     EXPECT_FALSE(bool(are_equal(type::Int64, *type::Type)));
 }
 
+TEST_F(equality_test, compare_values_should_order_scalars)
+{
+    Root i1{create_int64(1)}, i2{create_int64(2)}, f{create_float64(1.5)};
+    EXPECT_EQ(-1, compare_values(*i1, *i2));
+    EXPECT_EQ(1, compare_values(*i2, *i1));
+    EXPECT_EQ(0, compare_values(*i1, *i1));
+    EXPECT_EQ(-1, compare_values(*i1, *f));
+    EXPECT_EQ(1, compare_values(*i2, *f));
+    EXPECT_EQ(-1, compare_values(nil, *i1));
+    EXPECT_EQ(1, compare_values(*i1, nil));
+
+    Root ab{create_string("ab")}, abc{create_string("abc")}, b{create_string("b")};
+    EXPECT_EQ(-1, compare_values(*ab, *abc));
+    EXPECT_EQ(-1, compare_values(*abc, *b));
+    EXPECT_EQ(1, compare_values(*b, *ab));
+    Root ab2{create_string("ab")};
+    EXPECT_EQ(0, compare_values(*ab, *ab2));
+
+    EXPECT_EQ(-1, compare_values(create_uchar('a'), create_uchar('b')));
+    EXPECT_EQ(-1, compare_values(create_keyword("a"), create_keyword("b")));
+    EXPECT_EQ(-1, compare_values(create_keyword("b"), create_keyword("a", "a")));
+    EXPECT_EQ(1, compare_values(create_symbol("x", "a"), create_symbol("w", "b")));
+
+    try
+    {
+        compare_values(*i1, *ab);
+        FAIL() << "compare_values should fail for an int and a string";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        ASSERT_EQ_REFS(*type::IllegalArgument, get_value_type(*e));
+    }
+}
+
 }
 }
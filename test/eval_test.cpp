@@ -10,6 +10,7 @@
 #include <cleo/memory.hpp>
 #include <cleo/reader.hpp>
 #include <cleo/util.hpp>
+#include <cleo/cons.hpp>
 #include <gtest/gtest.h>
 #include <array>
 #include "util.hpp"
@@ -848,6 +849,41 @@ TEST_F(eval_test, apply_should_not_reevaluate_params)
     ASSERT_EQ_VALS(*ex, *val);
 }
 
+TEST_F(eval_test, apply_should_push_elements_of_arrays_lists_and_seqs)
+{
+    Root fn{create_native_function([](const Value *args, std::uint8_t num_args) { return create_list(args, num_args); })};
+    Root coll{array(3, 2, 1)};
+    std::array<Value, 3> args{{*fn, *TWO, *coll}};
+    Root val{apply(args.data(), args.size())};
+    Root ex{list(2, 3, 2, 1)};
+    EXPECT_EQ_VALS(*ex, *val);
+
+    coll = array_seq(*coll);
+    coll = get_array_seq_next(*coll);
+    args[2] = *coll;
+    val = apply(args.data(), args.size());
+    ex = list(2, 2, 1);
+    EXPECT_EQ_VALS(*ex, *val);
+
+    coll = list(5, 6, 7);
+    args[2] = *coll;
+    val = apply(args.data(), args.size());
+    ex = list(2, 5, 6, 7);
+    EXPECT_EQ_VALS(*ex, *val);
+
+    coll = create_cons(*THREE, *coll);
+    coll = create_cons(*ONE, *coll);
+    args[2] = *coll;
+    val = apply(args.data(), args.size());
+    ex = list(2, 1, 3, 5, 6, 7);
+    EXPECT_EQ_VALS(*ex, *val);
+
+    args[2] = *EMPTY_VECTOR;
+    val = apply(args.data(), args.size());
+    ex = list(2);
+    EXPECT_EQ_VALS(*ex, *val);
+}
+
 
 }
 }
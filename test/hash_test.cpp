@@ -1,4 +1,8 @@
 #include <cleo/hash.hpp>
+#include <cleo/array.hpp>
+#include <cleo/array_map.hpp>
+#include <cleo/array_set.hpp>
+#include <cleo/equality.hpp>
 #include <gtest/gtest.h>
 #include "util.hpp"
 
@@ -50,5 +54,45 @@ TEST_F(hash_test, should_hash_values)
     EXPECT_EQ(std::uint32_t(std::hash<std::string>{}("hamster")), hash(*val));
 }
 
+
+TEST_F(hash_test, should_memoize_collection_hashes)
+{
+    Root a{array(1, 2, 3)};
+    Root m{amap(1, 2)};
+    Root st{aset(1, 2)};
+    EXPECT_EQ(0u, get_array_hash(*a)) << "should not reuse the transient size as a hash";
+    EXPECT_EQ(0u, get_array_map_hash(*m));
+    EXPECT_EQ(0u, get_array_set_hash(*st));
+
+    auto ah = hash(*a);
+    EXPECT_EQ(std::uint32_t(ah), get_array_hash(*a));
+    EXPECT_EQ(ah, hash(*a));
+    auto mh = hash(*m);
+    EXPECT_EQ(std::uint32_t(mh), get_array_map_hash(*m));
+    EXPECT_EQ(mh, hash(*m));
+    auto sh = hash(*st);
+    EXPECT_EQ(std::uint32_t(sh), get_array_set_hash(*st));
+    EXPECT_EQ(sh, hash(*st));
+}
+
+TEST_F(hash_test, memoized_hashes_should_short_circuit_equality)
+{
+    Root a1{array(1, 2, 3)};
+    Root a2{array(1, 2, 4)};
+    Root a3{array(1, 2, 3)};
+    hash(*a1);
+    hash(*a2);
+    EXPECT_FALSE(bool(are_equal(*a1, *a2)));
+    EXPECT_TRUE(bool(are_equal(*a1, *a3)));
+    hash(*a3);
+    EXPECT_TRUE(bool(are_equal(*a1, *a3)));
+
+    Root m1{amap(1, 2)};
+    Root m2{amap(1, 3)};
+    hash(*m1);
+    hash(*m2);
+    EXPECT_FALSE(bool(are_equal(*m1, *m2)));
+}
+
 }
 }
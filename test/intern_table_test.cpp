@@ -0,0 +1,92 @@
+#include <cleo/intern_table.hpp>
+#include <cleo/global.hpp>
+#include <gtest/gtest.h>
+#include "util.hpp"
+
+namespace cleo
+{
+namespace test
+{
+
+struct intern_table_test : Test
+{
+    intern_table_test() : Test("cleo.intern-table.test") { }
+
+    static Value find(const InternTable& t, const std::string& ns, const std::string& name)
+    {
+        return t.find(ns.data(), ns.size(), name.data(), name.size());
+    }
+
+    static void insert(InternTable& t, const std::string& ns, const std::string& name, Value val)
+    {
+        t.insert(ns.data(), ns.size(), name.data(), name.size(), val);
+    }
+};
+
+TEST_F(intern_table_test, should_find_inserted_keys)
+{
+    InternTable t;
+    EXPECT_EQ_REFS(nil, find(t, "", "abc"));
+    insert(t, "", "abc", create_int48(1));
+    insert(t, "x", "abc", create_int48(2));
+    insert(t, "xa", "bc", create_int48(3));
+    insert(t, "", "xabc", create_int48(4));
+    EXPECT_EQ(4u, t.size());
+    EXPECT_EQ_REFS(create_int48(1), find(t, "", "abc"));
+    EXPECT_EQ_REFS(create_int48(2), find(t, "x", "abc"));
+    EXPECT_EQ_REFS(create_int48(3), find(t, "xa", "bc"));
+    EXPECT_EQ_REFS(create_int48(4), find(t, "", "xabc"));
+    EXPECT_EQ_REFS(nil, find(t, "", "ab"));
+    EXPECT_EQ_REFS(nil, find(t, "x", "ab"));
+    EXPECT_EQ_REFS(nil, find(t, "y", "abc"));
+}
+
+TEST_F(intern_table_test, should_keep_keys_when_growing)
+{
+    InternTable t;
+    const int n = 5000;
+    for (int i = 0; i < n; ++i)
+        insert(t, "ns" + std::to_string(i % 7), "name-" + std::to_string(i), create_int48(i));
+    EXPECT_EQ(std::size_t(n), t.size());
+    for (int i = 0; i < n; ++i)
+        ASSERT_EQ_REFS(create_int48(i), find(t, "ns" + std::to_string(i % 7), "name-" + std::to_string(i)));
+    EXPECT_EQ_REFS(nil, find(t, "ns1", "name-0"));
+}
+
+TEST_F(intern_table_test, should_compare_keys_past_whole_words)
+{
+    InternTable t;
+    insert(t, "", std::string("abcdefgh\0", 9), create_int48(1));
+    insert(t, "", "abcdefgh", create_int48(2));
+    insert(t, "abcdefghijklmnopq", "rstuvwxyz0123456789", create_int48(3));
+    EXPECT_EQ_REFS(create_int48(1), find(t, "", std::string("abcdefgh\0", 9)));
+    EXPECT_EQ_REFS(create_int48(2), find(t, "", "abcdefgh"));
+    EXPECT_EQ_REFS(create_int48(3), find(t, "abcdefghijklmnopq", "rstuvwxyz0123456789"));
+    EXPECT_EQ_REFS(nil, find(t, "abcdefghijklmnopq", "rstuvwxyz012345678"));
+}
+
+TEST_F(intern_table_test, should_accept_null_empty_keys)
+{
+    InternTable t;
+    t.insert(nullptr, 0, "abc", 3, create_int48(1));
+    t.insert(nullptr, 0, nullptr, 0, create_int48(2));
+    EXPECT_EQ_REFS(create_int48(1), t.find(nullptr, 0, "abc", 3));
+    EXPECT_EQ_REFS(create_int48(1), find(t, "", "abc"));
+    EXPECT_EQ_REFS(create_int48(2), t.find(nullptr, 0, nullptr, 0));
+    EXPECT_EQ_REFS(create_int48(2), find(t, "", ""));
+}
+
+TEST_F(intern_table_test, symbols_and_keywords_should_be_interned_by_namespace_and_name)
+{
+    EXPECT_EQ_REFS(create_symbol("a.b", "c"), create_symbol(std::string("a.b"), std::string("c")));
+    EXPECT_EQ_REFS(create_symbol("a.b", "c"), create_symbol("a.b", 3, "c", 1));
+    EXPECT_EQ_REFS(create_symbol("c"), create_symbol(nullptr, 0, "c", 1));
+    EXPECT_EQ_REFS(create_symbol("c"), create_symbol("", "c"));
+    EXPECT_FALSE(create_symbol("a.b", "c").is(create_symbol("a.bc")));
+    EXPECT_EQ_REFS(create_keyword("a.b", "c"), create_keyword("a.b", 3, "c", 1));
+    EXPECT_EQ_REFS(create_keyword("c"), create_keyword(nullptr, 0, "c", 1));
+    EXPECT_FALSE(create_keyword("c").is(create_symbol("c")));
+}
+
+}
+}
@@ -209,6 +209,10 @@ struct persistent_hash_map_test : Test
     void check_node_invariant(Value node)
     {
         ASSERT_GE(branch_size(node), 2 * node_arity(node) + payload_arity(node));
+        if (get_value_type(node).is(*type::PersistentHashMapArrayNode))
+        {
+            ASSERT_EQ(branch_size(node), Int64(std::uint32_t(get_dynamic_object_int(node, 2))));
+        }
 
         if (get_value_type(node).is(*type::PersistentHashMapArrayNode))
         {
@@ -238,6 +242,50 @@ struct persistent_hash_map_test : Test
         return *m;
     }
 
+    void test_transient(const std::vector<std::pair<std::string, int>>& kvs, std::size_t split)
+    {
+        std::vector<std::pair<std::string, int>> head{kvs.begin(), kvs.begin() + split};
+        Root original{create_map(head)};
+        Root expected{create_map(kvs)};
+        Root tm{transient_hash_map(*original)};
+        for (std::size_t i = split; i < kvs.size(); ++i)
+        {
+            Root k{create_key(kvs[i].first)};
+            Root v{create_int64(kvs[i].second)};
+            Root ret{transient_hash_map_assoc(*tm, *k, *v)};
+            ASSERT_EQ_REFS(*tm, *ret);
+            ASSERT_EQ_VALS(*v, transient_hash_map_get(*tm, *k));
+        }
+        ASSERT_EQ(get_persistent_hash_map_size(*expected), get_transient_hash_map_size(*tm));
+        Root pm{transient_hash_map_persistent(*tm)};
+        check_optimal_structure(*pm);
+        EXPECT_EQ_REFS(TRUE, are_persistent_hash_maps_equal(*expected, *pm)) << "split: " << split;
+        Root original_copy{create_map(head)};
+        EXPECT_EQ_REFS(TRUE, are_persistent_hash_maps_equal(*original_copy, *original)) << "split: " << split;
+
+        tm = transient_hash_map(*pm);
+        for (std::size_t i = 0; i < split; ++i)
+        {
+            Root k{create_key(kvs[i].first)};
+            expected = persistent_hash_map_dissoc(*expected, *k);
+            Root ret{transient_hash_map_dissoc(*tm, *k)};
+            ASSERT_EQ_REFS(*tm, *ret);
+            ASSERT_EQ_REFS(nil, transient_hash_map_contains(*tm, *k));
+        }
+        ASSERT_EQ(get_persistent_hash_map_size(*expected), get_transient_hash_map_size(*tm));
+        Root dm{transient_hash_map_persistent(*tm)};
+        check_optimal_structure(*dm);
+        EXPECT_EQ_REFS(TRUE, are_persistent_hash_maps_equal(*expected, *dm)) << "split: " << split;
+        Root pm_copy{create_map(kvs)};
+        EXPECT_EQ_REFS(TRUE, are_persistent_hash_maps_equal(*pm_copy, *pm)) << "split: " << split;
+    }
+
+    void test_transient(const std::vector<std::pair<std::string, int>>& kvs)
+    {
+        for (std::size_t split = 0; split <= kvs.size(); ++split)
+            ASSERT_NO_FATAL_FAILURE(test_transient(kvs, split));
+    }
+
     void test_equality(std::vector<std::vector<std::pair<std::string, int>>> kvss)
     {
         Roots maps{kvss.size()};
@@ -249,13 +297,28 @@ struct persistent_hash_map_test : Test
         for (auto& kvs : sorted_kvss)
             std::sort(begin(kvs), end(kvs));
 
-        for (decltype(kvss.size()) i = 0; i != kvss.size(); ++i)
-            for (decltype(kvss.size()) j = 0; j != kvss.size(); ++j)
-            {
-                auto expected = sorted_kvss[i] == sorted_kvss[j] ? TRUE : nil;
-
-                EXPECT_EQ_REFS(expected, are_persistent_hash_maps_equal(maps[i], maps[j])) << "left: " << testing::PrintToString(kvss[i]) << " right: " << testing::PrintToString(kvss[j]);
-            }
+        for (int hashed = 0; hashed < 2; ++hashed)
+        {
+            if (hashed)
+                for (decltype(kvss.size()) i = 0; i != kvss.size(); ++i)
+                {
+                    Root h{persistent_hash_map_hash(maps[i])};
+                }
+
+            for (decltype(kvss.size()) i = 0; i != kvss.size(); ++i)
+                for (decltype(kvss.size()) j = 0; j != kvss.size(); ++j)
+                {
+                    auto expected = sorted_kvss[i] == sorted_kvss[j] ? TRUE : nil;
+
+                    EXPECT_EQ_REFS(expected, are_persistent_hash_maps_equal(maps[i], maps[j])) << "left: " << testing::PrintToString(kvss[i]) << " right: " << testing::PrintToString(kvss[j]);
+                    if (expected)
+                    {
+                        Root left_hash{persistent_hash_map_hash(maps[i])};
+                        Root right_hash{persistent_hash_map_hash(maps[j])};
+                        EXPECT_EQ_VALS(*left_hash, *right_hash) << "left: " << testing::PrintToString(kvss[i]) << " right: " << testing::PrintToString(kvss[j]);
+                    }
+                }
+        }
     }
 
     void check_sequence(std::vector<std::pair<std::string, int>> kvs)
@@ -278,6 +341,32 @@ struct persistent_hash_map_test : Test
             s = get_persistent_hash_map_seq_next(*s);
         }
         ASSERT_EQ_REFS(nil, *s) << testing::PrintToString(kvs);
+        check_chunked_sequence(kvs);
+    }
+
+    void check_chunked_sequence(const std::vector<std::pair<std::string, int>>& kvs)
+    {
+        Root m{create_map(kvs)};
+        for (std::size_t start = 0; start < kvs.size(); ++start)
+        {
+            Root s{persistent_hash_map_seq(*m)};
+            for (std::size_t i = 0; i < start; ++i)
+                s = get_persistent_hash_map_seq_next(*s);
+            auto i = start;
+            for (; *s; s = get_persistent_hash_map_seq_chunk_next(*s))
+            {
+                Root chunk{get_persistent_hash_map_seq_chunk_first(*s)};
+                ASSERT_EQ(std::min<std::size_t>(32, kvs.size() - i), get_array_size(*chunk)) << testing::PrintToString(kvs);
+                for (std::uint32_t j = 0; j < get_array_size(*chunk); ++j, ++i)
+                {
+                    Root k{create_key(kvs[i].first)};
+                    Root v{create_int64(kvs[i].second)};
+                    Root expected{array(*k, *v)};
+                    ASSERT_EQ_VALS(*expected, get_array_elem(*chunk, j)) << testing::PrintToString(kvs);
+                }
+            }
+            ASSERT_EQ(kvs.size(), i) << testing::PrintToString(kvs);
+        }
     }
 };
 
@@ -1684,5 +1773,135 @@ TEST_F(persistent_hash_map_test, sequence)
     });
 }
 
+TEST_F(persistent_hash_map_test, chunked_sequence_should_match_sequence)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    Root m{create_persistent_hash_map()};
+    Root k;
+    for (Int64 i = 0; i < 1000; ++i)
+    {
+        k = create_int64(i * 7919);
+        m = persistent_hash_map_assoc(*m, *k, *k);
+    }
+    std::vector<Int64> expected;
+    for (Root s{persistent_hash_map_seq(*m)}; *s; s = get_persistent_hash_map_seq_next(*s))
+        expected.push_back(get_int64_value(get_array_elem(get_persistent_hash_map_seq_first(*s), 0)));
+    ASSERT_EQ(1000u, expected.size());
+
+    for (std::size_t start : {0, 1, 31, 32, 500, 999})
+    {
+        Root s{persistent_hash_map_seq(*m)};
+        for (std::size_t i = 0; i < start; ++i)
+            s = get_persistent_hash_map_seq_next(*s);
+        auto i = start;
+        for (; *s; s = get_persistent_hash_map_seq_chunk_next(*s))
+        {
+            Root chunk{get_persistent_hash_map_seq_chunk_first(*s)};
+            ASSERT_EQ(std::min<std::size_t>(32, expected.size() - i), get_array_size(*chunk));
+            for (std::uint32_t j = 0; j < get_array_size(*chunk); ++j, ++i)
+            {
+                auto entry = get_array_elem(*chunk, j);
+                ASSERT_EQ(expected[i], get_int64_value(get_array_elem(entry, 0))) << "start: " << start;
+                ASSERT_EQ(expected[i], get_int64_value(get_array_elem(entry, 1))) << "start: " << start;
+            }
+        }
+        ASSERT_EQ(expected.size(), i);
+    }
+}
+
+TEST_F(persistent_hash_map_test, transient_assoc_and_dissoc)
+{
+    test_transient({});
+    test_transient({{"7-a", 3}});
+    test_transient({
+        {"7-a", 3},
+        {"7-b", 4},
+        {"7-a", 5},
+    });
+    test_transient({
+        {"2-a", 30},
+        {"3-a", 40},
+        {"4-a", 50},
+        {"1-a", 20},
+        {"1-b", 21},
+        {"1-c", 22},
+        {"0-a", 10},
+        {"0-b", 11},
+        {"0-c", 12},
+        {"110-a", 140},
+        {"210-a", 150},
+        {"000-a", 160},
+        {"100-a", 170},
+        {"200-a", 180},
+        {"3-a", 41},
+    });
+    test_transient({
+        {"21-a", 10},
+        {"21-b", 20},
+        {"21-c", 30},
+        {"11-a", 40},
+        {"11-b", 50},
+        {"11-c", 60},
+        {"01-a", 70},
+        {"01-b", 80},
+        {"01-c", 90},
+        {"20-a", 100},
+        {"20-b", 110},
+        {"20-c", 120},
+        {"10-a", 130},
+        {"10-b", 140},
+        {"10-c", 150},
+        {"00-a", 160},
+        {"00-b", 170},
+        {"00-c", 180},
+    });
+}
+
+TEST_F(persistent_hash_map_test, transient_should_update_its_own_nodes_in_place)
+{
+    Root original{create_map({{"1-a", 10}, {"2-a", 20}})};
+    Root tm{transient_hash_map(*original)};
+    Root k{create_key("3-a")}, v{create_int64(30)};
+    transient_hash_map_assoc(*tm, *k, *v);
+    auto root = get_dynamic_object_element(*tm, 0);
+    ASSERT_EQ_REFS(*type::PersistentHashMapArrayNode, get_value_type(root));
+    for (auto key : {"0-a", "4-a", "1-b", "5-a"})
+    {
+        k = create_key(key);
+        transient_hash_map_assoc(*tm, *k, *v);
+        ASSERT_EQ_REFS(root, get_dynamic_object_element(*tm, 0)) << key;
+    }
+    for (auto key : {"0-a", "1-b", "4-a"})
+    {
+        k = create_key(key);
+        transient_hash_map_dissoc(*tm, *k);
+        ASSERT_EQ_REFS(root, get_dynamic_object_element(*tm, 0)) << key;
+    }
+
+    Root pm{transient_hash_map_persistent(*tm)};
+    check_optimal_structure(*pm);
+    Root expected{create_map({{"1-a", 10}, {"2-a", 20}, {"3-a", 30}, {"5-a", 30}})};
+    EXPECT_EQ_REFS(TRUE, are_persistent_hash_maps_equal(*expected, *pm));
+    Root original_copy{create_map({{"1-a", 10}, {"2-a", 20}})};
+    EXPECT_EQ_REFS(TRUE, are_persistent_hash_maps_equal(*original_copy, *original));
+}
+
+TEST_F(persistent_hash_map_test, transient_should_fail_after_persistent)
+{
+    Root tm{transient_hash_map(*EMPTY_HASH_MAP)};
+    Root m{transient_hash_map_persistent(*tm)};
+    Root k{create_key("1")};
+    try
+    {
+        transient_hash_map_assoc(*tm, *k, *k);
+        FAIL() << "assoc! should fail after persistent!";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        ASSERT_EQ_REFS(*type::IllegalState, get_value_type(*e));
+    }
+}
+
 }
 }
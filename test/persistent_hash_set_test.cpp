@@ -206,6 +206,10 @@ struct persistent_hash_set_test : Test
     void check_node_invariant(Value node)
     {
         ASSERT_GE(branch_size(node), 2 * node_arity(node) + payload_arity(node));
+        if (get_value_type(node).is(*type::PersistentHashSetArrayNode))
+        {
+            ASSERT_EQ(branch_size(node), Int64(std::uint32_t(get_dynamic_object_int(node, 2))));
+        }
 
         if (get_value_type(node).is(*type::PersistentHashSetArrayNode))
         {
@@ -234,6 +238,49 @@ struct persistent_hash_set_test : Test
         return *m;
     }
 
+    void test_transient(const std::vector<std::string>& ks, std::size_t split)
+    {
+        std::vector<std::string> head{ks.begin(), ks.begin() + split};
+        Root original{create_set(head)};
+        Root expected{create_set(ks)};
+        Root ts{transient_hash_set(*original)};
+        for (std::size_t i = split; i < ks.size(); ++i)
+        {
+            Root k{create_key(ks[i])};
+            Root ret{transient_hash_set_conj(*ts, *k)};
+            ASSERT_EQ_REFS(*ts, *ret);
+            ASSERT_EQ_REFS(TRUE, transient_hash_set_contains(*ts, *k));
+        }
+        ASSERT_EQ(get_persistent_hash_set_size(*expected), get_transient_hash_set_size(*ts));
+        Root ps{transient_hash_set_persistent(*ts)};
+        check_optimal_structure(*ps);
+        EXPECT_EQ_REFS(TRUE, are_persistent_hash_sets_equal(*expected, *ps)) << "split: " << split;
+        Root original_copy{create_set(head)};
+        EXPECT_EQ_REFS(TRUE, are_persistent_hash_sets_equal(*original_copy, *original)) << "split: " << split;
+
+        ts = transient_hash_set(*ps);
+        for (std::size_t i = 0; i < split; ++i)
+        {
+            Root k{create_key(ks[i])};
+            expected = persistent_hash_set_disj(*expected, *k);
+            Root ret{transient_hash_set_disj(*ts, *k)};
+            ASSERT_EQ_REFS(*ts, *ret);
+            ASSERT_EQ_REFS(nil, transient_hash_set_contains(*ts, *k));
+        }
+        ASSERT_EQ(get_persistent_hash_set_size(*expected), get_transient_hash_set_size(*ts));
+        Root ds{transient_hash_set_persistent(*ts)};
+        check_optimal_structure(*ds);
+        EXPECT_EQ_REFS(TRUE, are_persistent_hash_sets_equal(*expected, *ds)) << "split: " << split;
+        Root ps_copy{create_set(ks)};
+        EXPECT_EQ_REFS(TRUE, are_persistent_hash_sets_equal(*ps_copy, *ps)) << "split: " << split;
+    }
+
+    void test_transient(const std::vector<std::string>& ks)
+    {
+        for (std::size_t split = 0; split <= ks.size(); ++split)
+            ASSERT_NO_FATAL_FAILURE(test_transient(ks, split));
+    }
+
     void test_equality(std::vector<std::vector<std::string>> kss)
     {
         Roots sets{kss.size()};
@@ -245,13 +292,28 @@ struct persistent_hash_set_test : Test
         for (auto& ks : sorted_kss)
             std::sort(begin(ks), end(ks));
 
-        for (decltype(kss.size()) i = 0; i != kss.size(); ++i)
-            for (decltype(kss.size()) j = 0; j != kss.size(); ++j)
-            {
-                auto expected = sorted_kss[i] == sorted_kss[j] ? TRUE : nil;
-
-                EXPECT_EQ_REFS(expected, are_persistent_hash_sets_equal(sets[i], sets[j])) << "left: " << testing::PrintToString(kss[i]) << " right: " << testing::PrintToString(kss[j]);
-            }
+        for (int hashed = 0; hashed < 2; ++hashed)
+        {
+            if (hashed)
+                for (decltype(kss.size()) i = 0; i != kss.size(); ++i)
+                {
+                    Root h{persistent_hash_set_hash(sets[i])};
+                }
+
+            for (decltype(kss.size()) i = 0; i != kss.size(); ++i)
+                for (decltype(kss.size()) j = 0; j != kss.size(); ++j)
+                {
+                    auto expected = sorted_kss[i] == sorted_kss[j] ? TRUE : nil;
+
+                    EXPECT_EQ_REFS(expected, are_persistent_hash_sets_equal(sets[i], sets[j])) << "left: " << testing::PrintToString(kss[i]) << " right: " << testing::PrintToString(kss[j]);
+                    if (expected)
+                    {
+                        Root left_hash{persistent_hash_set_hash(sets[i])};
+                        Root right_hash{persistent_hash_set_hash(sets[j])};
+                        EXPECT_EQ_VALS(*left_hash, *right_hash) << "left: " << testing::PrintToString(kss[i]) << " right: " << testing::PrintToString(kss[j]);
+                    }
+                }
+        }
     }
 
     void check_sequence(std::vector<std::string> ks)
@@ -271,6 +333,30 @@ struct persistent_hash_set_test : Test
             s = get_persistent_hash_set_seq_next(*s);
         }
         ASSERT_EQ_REFS(nil, *s) << testing::PrintToString(ks);
+        check_chunked_sequence(ks);
+    }
+
+    void check_chunked_sequence(const std::vector<std::string>& ks)
+    {
+        Root m{create_set(ks)};
+        for (std::size_t start = 0; start < ks.size(); ++start)
+        {
+            Root s{persistent_hash_set_seq(*m)};
+            for (std::size_t i = 0; i < start; ++i)
+                s = get_persistent_hash_set_seq_next(*s);
+            auto i = start;
+            for (; *s; s = get_persistent_hash_set_seq_chunk_next(*s))
+            {
+                Root chunk{get_persistent_hash_set_seq_chunk_first(*s)};
+                ASSERT_EQ(std::min<std::size_t>(32, ks.size() - i), get_array_size(*chunk)) << testing::PrintToString(ks);
+                for (std::uint32_t j = 0; j < get_array_size(*chunk); ++j, ++i)
+                {
+                    Root k{create_key(ks[i])};
+                    ASSERT_EQ_VALS(*k, get_array_elem(*chunk, j)) << testing::PrintToString(ks);
+                }
+            }
+            ASSERT_EQ(ks.size(), i) << testing::PrintToString(ks);
+        }
     }
 };
 
@@ -1490,5 +1576,67 @@ TEST_F(persistent_hash_set_test, sequence)
     });
 }
 
+TEST_F(persistent_hash_set_test, chunked_sequence_should_match_sequence)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    Root m{create_persistent_hash_set()};
+    Root k;
+    for (Int64 i = 0; i < 1000; ++i)
+    {
+        k = create_int64(i * 7919);
+        m = persistent_hash_set_conj(*m, *k);
+    }
+    std::vector<Int64> expected;
+    for (Root s{persistent_hash_set_seq(*m)}; *s; s = get_persistent_hash_set_seq_next(*s))
+        expected.push_back(get_int64_value(get_persistent_hash_set_seq_first(*s)));
+    ASSERT_EQ(1000u, expected.size());
+
+    for (std::size_t start : {0, 1, 31, 32, 500, 999})
+    {
+        Root s{persistent_hash_set_seq(*m)};
+        for (std::size_t i = 0; i < start; ++i)
+            s = get_persistent_hash_set_seq_next(*s);
+        auto i = start;
+        for (; *s; s = get_persistent_hash_set_seq_chunk_next(*s))
+        {
+            Root chunk{get_persistent_hash_set_seq_chunk_first(*s)};
+            ASSERT_EQ(std::min<std::size_t>(32, expected.size() - i), get_array_size(*chunk));
+            for (std::uint32_t j = 0; j < get_array_size(*chunk); ++j, ++i)
+                ASSERT_EQ(expected[i], get_int64_value(get_array_elem(*chunk, j))) << "start: " << start;
+        }
+        ASSERT_EQ(expected.size(), i);
+    }
+}
+
+TEST_F(persistent_hash_set_test, transient_conj_and_disj)
+{
+    test_transient({});
+    test_transient({"7-a"});
+    test_transient({"7-a", "7-b", "7-a"});
+    test_transient({
+        "2-a", "3-a", "4-a", "1-a", "1-b", "1-c", "0-a", "0-b", "0-c",
+        "110-a", "210-a", "000-a", "100-a", "200-a", "3-a"});
+    test_transient({
+        "21-a", "21-b", "21-c", "11-a", "11-b", "11-c", "01-a", "01-b", "01-c",
+        "20-a", "20-b", "20-c", "10-a", "10-b", "10-c", "00-a", "00-b", "00-c"});
+}
+
+TEST_F(persistent_hash_set_test, transient_should_fail_after_persistent)
+{
+    Root ts{transient_hash_set(*EMPTY_HASH_SET)};
+    Root s{transient_hash_set_persistent(*ts)};
+    Root k{create_key("1")};
+    try
+    {
+        transient_hash_set_conj(*ts, *k);
+        FAIL() << "conj! should fail after persistent!";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        ASSERT_EQ_REFS(*type::IllegalState, get_value_type(*e));
+    }
+}
+
 }
 }
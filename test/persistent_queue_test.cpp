@@ -0,0 +1,79 @@
+#include <cleo/persistent_queue.hpp>
+#include <cleo/global.hpp>
+#include <gtest/gtest.h>
+#include "util.hpp"
+
+namespace cleo
+{
+namespace test
+{
+
+struct persistent_queue_test : Test
+{
+    persistent_queue_test() : Test("cleo.persistent-queue.test") { }
+
+    static void expect_elems(Value q, Int64 first, Int64 count)
+    {
+        ASSERT_EQ(count, get_persistent_queue_size(q));
+        Root s{persistent_queue_seq(q)};
+        for (Int64 i = 0; i < count; ++i, s = get_persistent_queue_seq_next(*s))
+        {
+            ASSERT_FALSE(s->is_nil()) << "index: " << i;
+            Root e{get_persistent_queue_seq_first(*s)};
+            ASSERT_EQ(first + i, get_int64_value(*e)) << "index: " << i;
+        }
+        EXPECT_TRUE(s->is_nil());
+    }
+};
+
+TEST_F(persistent_queue_test, should_create_an_empty_queue)
+{
+    Root q{create_persistent_queue()};
+    ASSERT_EQ_REFS(*type::PersistentQueue, get_value_type(*q));
+    EXPECT_EQ(0, get_persistent_queue_size(*q));
+    EXPECT_TRUE(Root(persistent_queue_peek(*q))->is_nil());
+    EXPECT_TRUE(Root(persistent_queue_seq(*q))->is_nil());
+    Root popped{persistent_queue_pop(*q)};
+    EXPECT_EQ_REFS(*q, *popped);
+}
+
+TEST_F(persistent_queue_test, should_pop_elements_in_conj_order)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    const Int64 size = 1000;
+    Root q{create_persistent_queue()};
+    Root e;
+    for (Int64 i = 0; i < size; ++i)
+    {
+        e = create_int64(i);
+        q = persistent_queue_conj(*q, *e);
+        ASSERT_EQ(i + 1, get_persistent_queue_size(*q));
+        ASSERT_EQ(0, get_int64_value(*Root(persistent_queue_peek(*q))));
+    }
+    expect_elems(*q, 0, size);
+
+    Root original{*q};
+    for (Int64 i = 0; i < size / 2; ++i)
+    {
+        ASSERT_EQ(i, get_int64_value(*Root(persistent_queue_peek(*q))));
+        q = persistent_queue_pop(*q);
+    }
+    expect_elems(*q, size / 2, size / 2);
+    expect_elems(*original, 0, size);
+
+    for (Int64 i = size; i < size + 100; ++i)
+    {
+        e = create_int64(i);
+        q = persistent_queue_conj(*q, *e);
+    }
+    for (Int64 i = size / 2; i < size + 100; ++i)
+    {
+        ASSERT_EQ(i, get_int64_value(*Root(persistent_queue_peek(*q))));
+        q = persistent_queue_pop(*q);
+    }
+    EXPECT_EQ(0, get_persistent_queue_size(*q));
+    EXPECT_TRUE(Root(persistent_queue_seq(*q))->is_nil());
+}
+
+}
+}
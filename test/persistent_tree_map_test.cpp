@@ -0,0 +1,309 @@
+#include <cleo/persistent_tree_map.hpp>
+#include <cleo/persistent_hash_map.hpp>
+#include <cleo/reduce.hpp>
+#include <cleo/global.hpp>
+#include <gtest/gtest.h>
+#include "util.hpp"
+
+namespace cleo
+{
+namespace test
+{
+
+struct persistent_tree_map_test : Test
+{
+    persistent_tree_map_test() : Test("cleo.persistent-tree-map.test") { }
+
+    static Int64 scrambled(Int64 i, Int64 size)
+    {
+        return i * 7919 % size;
+    }
+
+    static Force create_scrambled_map(Int64 size)
+    {
+        Root m{create_persistent_tree_map(nil)};
+        Root k, v;
+        for (Int64 i = 0; i < size; ++i)
+        {
+            k = create_int64(scrambled(i, size));
+            v = create_int64(-scrambled(i, size));
+            m = persistent_tree_map_assoc(*m, *k, *v);
+        }
+        return *m;
+    }
+
+    static void expect_keys(Value s, Int64 first, Int64 step, Int64 count)
+    {
+        Root seq{s};
+        for (Int64 i = 0; i < count; ++i, seq = get_persistent_tree_seq_next(*seq))
+        {
+            ASSERT_FALSE(seq->is_nil()) << "index: " << i;
+            Root kv{get_persistent_tree_seq_first(*seq)};
+            ASSERT_EQ(first + i * step, get_int64_value(get_array_elem(*kv, 0))) << "index: " << i;
+            ASSERT_EQ(-(first + i * step), get_int64_value(get_array_elem(*kv, 1))) << "index: " << i;
+        }
+        EXPECT_TRUE(seq->is_nil());
+    }
+};
+
+TEST_F(persistent_tree_map_test, should_create_an_empty_map)
+{
+    Root m{create_persistent_tree_map(nil)};
+    ASSERT_EQ_REFS(*type::PersistentTreeMap, get_value_type(*m));
+    EXPECT_EQ(0, get_persistent_tree_map_size(*m));
+    EXPECT_TRUE(get_persistent_tree_map_comparator(*m).is_nil());
+    Root k{create_int64(1)};
+    EXPECT_TRUE(persistent_tree_map_get(*m, *k).is_nil());
+    EXPECT_TRUE(persistent_tree_map_contains(*m, *k).is_nil());
+    EXPECT_TRUE(Root(persistent_tree_map_seq(*m))->is_nil());
+    EXPECT_TRUE(Root(persistent_tree_map_rseq(*m))->is_nil());
+    Root same{persistent_tree_map_dissoc(*m, *k)};
+    EXPECT_EQ_REFS(*m, *same);
+}
+
+TEST_F(persistent_tree_map_test, should_assoc_keys_in_order)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    const Int64 size = 5000;
+    Root m{create_persistent_tree_map(nil)};
+    Root snapshot, k, v;
+    for (Int64 i = 0; i < size; ++i)
+    {
+        k = create_int64(scrambled(i, size));
+        v = create_int64(-scrambled(i, size));
+        m = persistent_tree_map_assoc(*m, *k, *v);
+        ASSERT_EQ(i + 1, get_persistent_tree_map_size(*m));
+        ASSERT_EQ_VALS(*v, persistent_tree_map_get(*m, *k));
+        if (i == 99)
+            snapshot = *m;
+    }
+    for (Int64 i = 0; i < size; ++i)
+    {
+        k = create_int64(i);
+        ASSERT_EQ(-i, get_int64_value(persistent_tree_map_get(*m, *k)));
+        ASSERT_EQ_REFS(TRUE, persistent_tree_map_contains(*m, *k));
+    }
+    k = create_int64(size);
+    EXPECT_TRUE(persistent_tree_map_contains(*m, *k).is_nil());
+    EXPECT_EQ_VALS(*k, persistent_tree_map_get(*m, *k, *k));
+    expect_keys(*Root(persistent_tree_map_seq(*m)), 0, 1, size);
+    expect_keys(*Root(persistent_tree_map_rseq(*m)), size - 1, -1, size);
+    EXPECT_EQ(100, get_persistent_tree_map_size(*snapshot));
+
+    k = create_int64(7);
+    Root same{persistent_tree_map_assoc(*m, *k, persistent_tree_map_get(*m, *k))};
+    EXPECT_EQ_REFS(*m, *same);
+    v = create_int64(70);
+    Root m2{persistent_tree_map_assoc(*m, *k, *v)};
+    EXPECT_EQ(size, get_persistent_tree_map_size(*m2));
+    EXPECT_EQ_VALS(*v, persistent_tree_map_get(*m2, *k));
+    EXPECT_EQ(-7, get_int64_value(persistent_tree_map_get(*m, *k)));
+}
+
+TEST_F(persistent_tree_map_test, should_dissoc_keys)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    const Int64 size = 5000;
+    Root original{create_scrambled_map(size)};
+    Root m{*original};
+    Root k;
+    for (Int64 i = 0; i < size; ++i)
+    {
+        auto key = scrambled(i, size);
+        if (key % 2 == 0)
+            continue;
+        k = create_int64(key);
+        m = persistent_tree_map_dissoc(*m, *k);
+        ASSERT_TRUE(persistent_tree_map_contains(*m, *k).is_nil());
+    }
+    ASSERT_EQ(size / 2, get_persistent_tree_map_size(*m));
+    expect_keys(*Root(persistent_tree_map_seq(*m)), 0, 2, size / 2);
+    expect_keys(*Root(persistent_tree_map_seq(*original)), 0, 1, size);
+
+    k = create_int64(1);
+    Root same{persistent_tree_map_dissoc(*m, *k)};
+    EXPECT_EQ_REFS(*m, *same);
+
+    for (Int64 i = 0; i < size; i += 2)
+    {
+        k = create_int64(i);
+        m = persistent_tree_map_dissoc(*m, *k);
+    }
+    EXPECT_EQ(0, get_persistent_tree_map_size(*m));
+    EXPECT_TRUE(Root(persistent_tree_map_seq(*m))->is_nil());
+}
+
+TEST_F(persistent_tree_map_test, seq_from_should_start_at_the_nearest_key)
+{
+    Root m{create_persistent_tree_map(nil)};
+    Root k, v;
+    for (Int64 i = 0; i < 100; i += 10)
+    {
+        k = create_int64(i);
+        v = create_int64(-i);
+        m = persistent_tree_map_assoc(*m, *k, *v);
+    }
+    k = create_int64(30);
+    expect_keys(*Root(persistent_tree_map_seq_from(*m, *k, TRUE)), 30, 10, 7);
+    expect_keys(*Root(persistent_tree_map_seq_from(*m, *k, nil)), 30, -10, 4);
+    k = create_int64(35);
+    expect_keys(*Root(persistent_tree_map_seq_from(*m, *k, TRUE)), 40, 10, 6);
+    expect_keys(*Root(persistent_tree_map_seq_from(*m, *k, nil)), 30, -10, 4);
+    k = create_int64(-5);
+    expect_keys(*Root(persistent_tree_map_seq_from(*m, *k, TRUE)), 0, 10, 10);
+    EXPECT_TRUE(Root(persistent_tree_map_seq_from(*m, *k, nil))->is_nil());
+    k = create_int64(95);
+    EXPECT_TRUE(Root(persistent_tree_map_seq_from(*m, *k, TRUE))->is_nil());
+    expect_keys(*Root(persistent_tree_map_seq_from(*m, *k, nil)), 90, -10, 10);
+}
+
+TEST_F(persistent_tree_map_test, should_use_the_comparator)
+{
+    Root greater{create_native_function([](const Value *args, std::uint8_t)
+    {
+        return force(get_int64_value(args[0]) > get_int64_value(args[1]) ? TRUE : nil);
+    })};
+    Root reverse_compare{create_native_function([](const Value *args, std::uint8_t)
+    {
+        return create_int64(get_int64_value(args[1]) - get_int64_value(args[0]));
+    })};
+    for (auto comparator : {*greater, *reverse_compare})
+    {
+        Root m{create_persistent_tree_map(comparator)};
+        Root k, v;
+        for (Int64 i = 0; i < 50; ++i)
+        {
+            k = create_int64(scrambled(i, 50));
+            v = create_int64(-scrambled(i, 50));
+            m = persistent_tree_map_assoc(*m, *k, *v);
+        }
+        EXPECT_EQ_REFS(comparator, get_persistent_tree_map_comparator(*m));
+        ASSERT_EQ(50, get_persistent_tree_map_size(*m));
+        expect_keys(*Root(persistent_tree_map_seq(*m)), 49, -1, 50);
+        k = create_int64(20);
+        expect_keys(*Root(persistent_tree_map_seq_from(*m, *k, TRUE)), 20, -1, 21);
+        EXPECT_EQ(-20, get_int64_value(persistent_tree_map_get(*m, *k)));
+        Root one{create_int64(1)}, two{create_int64(2)};
+        EXPECT_EQ(1, persistent_tree_map_compare(*m, *one, *two));
+        EXPECT_EQ(0, persistent_tree_map_compare(*m, *one, *one));
+    }
+}
+
+TEST_F(persistent_tree_map_test, should_reduce_entries_in_order)
+{
+    Root conj_fn{create_native_function([](const Value *args, std::uint8_t) { return array_conj(args[0], args[1]); })};
+    Root m{create_scrambled_map(100)};
+    Root r{persistent_tree_map_reduce(*m, *conj_fn, *EMPTY_VECTOR)};
+    ASSERT_EQ(100u, get_array_size(*r));
+    for (Int64 i = 0; i < 100; ++i)
+        ASSERT_EQ(i, get_int64_value(get_array_elem(get_array_elem(*r, i), 0)));
+
+    r = persistent_tree_map_key_reduce(*m, *conj_fn, *EMPTY_VECTOR);
+    ASSERT_EQ(100u, get_array_size(*r));
+    EXPECT_EQ(99, get_int64_value(get_array_elem(*r, 99)));
+
+    Root stop_fn{create_native_function([](const Value *args, std::uint8_t)
+    {
+        Root acc{array_conj(args[0], args[1])};
+        if (get_array_size(*acc) == 10)
+            return create_reduced(*acc);
+        return force(*acc);
+    })};
+    r = persistent_tree_map_key_reduce(*m, *stop_fn, *EMPTY_VECTOR);
+    ASSERT_EQ(10u, get_array_size(*r));
+    EXPECT_EQ(9, get_int64_value(get_array_elem(*r, 9)));
+}
+
+TEST_F(persistent_tree_map_test, should_traverse_leaves_in_chunks)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    const Int64 size = 2000;
+    Root m{create_scrambled_map(size)};
+    for (auto ascending : {true, false})
+    {
+        Root seq{ascending ? persistent_tree_map_key_seq(*m, true) : persistent_tree_map_key_seq(*m, false)};
+        Int64 expected = ascending ? 0 : size - 1;
+        for (; !seq->is_nil(); seq = get_persistent_tree_seq_chunk_next(*seq))
+        {
+            Root chunk{get_persistent_tree_seq_chunk_first(*seq)};
+            ASSERT_NE(0u, get_array_size(*chunk));
+            for (std::uint32_t i = 0; i < get_array_size(*chunk); ++i, expected += ascending ? 1 : -1)
+                ASSERT_EQ(expected, get_int64_value(get_array_elem(*chunk, i)));
+        }
+        EXPECT_EQ(ascending ? size : -1, expected);
+    }
+
+    Root k{create_int64(1000)};
+    Root seq{persistent_tree_map_seq_from(*m, *k, TRUE)};
+    Root chunk{get_persistent_tree_seq_chunk_first(*seq)};
+    Root kv{get_array_elem(*chunk, 0)};
+    EXPECT_EQ(1000, get_int64_value(get_array_elem(*kv, 0)));
+    EXPECT_EQ(-1000, get_int64_value(get_array_elem(*kv, 1)));
+}
+
+TEST_F(persistent_tree_map_test, hash_should_match_hash_map_hash)
+{
+    Root m{create_scrambled_map(100)};
+    Root hm{create_persistent_hash_map()};
+    Root k, v;
+    for (Int64 i = 0; i < 100; ++i)
+    {
+        k = create_int64(i);
+        v = create_int64(-i);
+        hm = persistent_hash_map_assoc(*hm, *k, *v);
+    }
+    Root h{persistent_tree_map_hash(*m)};
+    Root hh{persistent_hash_map_hash(*hm)};
+    EXPECT_EQ_VALS(*hh, *h);
+}
+
+struct transient_tree_map_test : persistent_tree_map_test { };
+
+TEST_F(transient_tree_map_test, should_assoc_and_dissoc_in_place)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    const Int64 size = 5000;
+    Root original{create_scrambled_map(100)};
+    Root t{transient_tree_map(*original)};
+    Root k, v;
+    for (Int64 i = 0; i < size; ++i)
+    {
+        k = create_int64(scrambled(i, size));
+        v = create_int64(-scrambled(i, size));
+        Root assoced{transient_tree_map_assoc(*t, *k, *v)};
+        ASSERT_EQ_REFS(*t, *assoced);
+    }
+    ASSERT_EQ(size, get_transient_tree_map_size(*t));
+    for (Int64 i = 1; i < size; i += 2)
+    {
+        k = create_int64(i);
+        Root dissoced{transient_tree_map_dissoc(*t, *k)};
+        ASSERT_EQ_REFS(*t, *dissoced);
+    }
+    ASSERT_EQ(size / 2, get_transient_tree_map_size(*t));
+    k = create_int64(4);
+    EXPECT_EQ(-4, get_int64_value(transient_tree_map_get(*t, *k)));
+    EXPECT_EQ_REFS(TRUE, transient_tree_map_contains(*t, *k));
+    k = create_int64(5);
+    EXPECT_TRUE(transient_tree_map_contains(*t, *k).is_nil());
+
+    Root m{transient_tree_map_persistent(*t)};
+    ASSERT_EQ_REFS(*type::PersistentTreeMap, get_value_type(*m));
+    ASSERT_EQ(size / 2, get_persistent_tree_map_size(*m));
+    expect_keys(*Root(persistent_tree_map_seq(*m)), 0, 2, size / 2);
+    expect_keys(*Root(persistent_tree_map_seq(*original)), 0, 1, 100);
+
+    try
+    {
+        transient_tree_map_assoc(*t, *k, *k);
+        FAIL() << "transient_tree_map_assoc should fail after persistent!";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        ASSERT_EQ_REFS(*type::IllegalState, get_value_type(*e));
+    }
+}
+
+}
+}
@@ -0,0 +1,115 @@
+#include <cleo/persistent_tree_set.hpp>
+#include <cleo/persistent_tree_map.hpp>
+#include <cleo/persistent_hash_set.hpp>
+#include <cleo/global.hpp>
+#include <gtest/gtest.h>
+#include "util.hpp"
+
+namespace cleo
+{
+namespace test
+{
+
+struct persistent_tree_set_test : Test
+{
+    persistent_tree_set_test() : Test("cleo.persistent-tree-set.test") { }
+
+    static Force create_scrambled_set(Int64 size)
+    {
+        Root s{create_persistent_tree_set(nil)};
+        Root k;
+        for (Int64 i = 0; i < size; ++i)
+        {
+            k = create_int64(i * 7919 % size);
+            s = persistent_tree_set_conj(*s, *k);
+        }
+        return *s;
+    }
+
+    static void expect_elems(Value s, Int64 first, Int64 step, Int64 count)
+    {
+        Root seq{s};
+        for (Int64 i = 0; i < count; ++i, seq = get_persistent_tree_seq_next(*seq))
+        {
+            ASSERT_FALSE(seq->is_nil()) << "index: " << i;
+            Root e{get_persistent_tree_seq_first(*seq)};
+            ASSERT_EQ(first + i * step, get_int64_value(*e)) << "index: " << i;
+        }
+        EXPECT_TRUE(seq->is_nil());
+    }
+};
+
+TEST_F(persistent_tree_set_test, should_conj_and_disj_elements_in_order)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    const Int64 size = 500;
+    Root s{create_scrambled_set(size)};
+    ASSERT_EQ_REFS(*type::PersistentTreeSet, get_value_type(*s));
+    ASSERT_EQ(size, get_persistent_tree_set_size(*s));
+    expect_elems(*Root(persistent_tree_set_seq(*s)), 0, 1, size);
+    expect_elems(*Root(persistent_tree_set_rseq(*s)), size - 1, -1, size);
+
+    Root k{create_int64(7)};
+    EXPECT_EQ_VALS(*k, persistent_tree_set_get(*s, *k));
+    EXPECT_EQ_REFS(TRUE, persistent_tree_set_contains(*s, *k));
+    Root same{persistent_tree_set_conj(*s, *k)};
+    EXPECT_EQ_REFS(*s, *same);
+
+    Root d{persistent_tree_set_disj(*s, *k)};
+    EXPECT_EQ(size - 1, get_persistent_tree_set_size(*d));
+    EXPECT_TRUE(persistent_tree_set_contains(*d, *k).is_nil());
+    EXPECT_TRUE(persistent_tree_set_get(*d, *k).is_nil());
+    EXPECT_EQ_VALS(*k, persistent_tree_set_get(*d, *k, *k));
+    EXPECT_EQ_REFS(TRUE, persistent_tree_set_contains(*s, *k));
+    same = persistent_tree_set_disj(*d, *k);
+    EXPECT_EQ_REFS(*d, *same);
+
+    k = create_int64(100);
+    expect_elems(*Root(persistent_tree_set_seq_from(*s, *k, TRUE)), 100, 1, size - 100);
+    expect_elems(*Root(persistent_tree_set_seq_from(*s, *k, nil)), 100, -1, 101);
+}
+
+TEST_F(persistent_tree_set_test, hash_should_match_hash_set_hash)
+{
+    Root s{create_scrambled_set(100)};
+    Root hs{create_persistent_hash_set()};
+    Root k;
+    for (Int64 i = 0; i < 100; ++i)
+    {
+        k = create_int64(i);
+        hs = persistent_hash_set_conj(*hs, *k);
+    }
+    Root h{persistent_tree_set_hash(*s)};
+    Root hh{persistent_hash_set_hash(*hs)};
+    EXPECT_EQ_VALS(*hh, *h);
+    EXPECT_EQ_VALS(*hs, *s);
+    EXPECT_EQ_VALS(*s, *hs);
+}
+
+TEST_F(persistent_tree_set_test, transient_should_conj_in_place)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    Root original{create_scrambled_set(10)};
+    Root t{transient_tree_set(*original)};
+    Root k;
+    for (Int64 i = 0; i < 300; ++i)
+    {
+        k = create_int64(i * 7919 % 300);
+        Root conjed{transient_tree_set_conj(*t, *k)};
+        ASSERT_EQ_REFS(*t, *conjed);
+    }
+    ASSERT_EQ(300, get_transient_tree_set_size(*t));
+    k = create_int64(0);
+    t = transient_tree_set_disj(*t, *k);
+    EXPECT_TRUE(transient_tree_set_contains(*t, *k).is_nil());
+    k = create_int64(1);
+    EXPECT_EQ_VALS(*k, transient_tree_set_get(*t, *k));
+
+    Root s{transient_tree_set_persistent(*t)};
+    ASSERT_EQ_REFS(*type::PersistentTreeSet, get_value_type(*s));
+    expect_elems(*Root(persistent_tree_set_seq(*s)), 1, 1, 299);
+    expect_elems(*Root(persistent_tree_set_seq(*original)), 0, 1, 10);
+}
+
+}
+}
@@ -1,5 +1,11 @@
 #include <cleo/print.hpp>
 #include <cleo/global.hpp>
+#include <cleo/array.hpp>
+#include <cleo/byte_array.hpp>
+#include <cleo/multimethod.hpp>
+#include <cleo/string_builder.hpp>
+#include <cleo/vector.hpp>
+#include <cstdio>
 #include <gmock/gmock.h>
 #include "util.hpp"
 
@@ -181,6 +187,21 @@ TEST_F(pr_str_test, should_print_vectors)
     EXPECT_EQ("[1 [2 [3]]]", str(pr_str(*val)));
 }
 
+TEST_F(pr_str_test, should_print_persistent_and_byte_vectors)
+{
+    std::vector<Value> elems;
+    std::string expected = "[";
+    for (Int64 i = 0; i < 40; ++i)
+    {
+        elems.push_back(create_int48(i));
+        expected += (i ? " " : "") + std::to_string(i);
+    }
+    Root val{create_vector(elems.data(), elems.size())};
+    EXPECT_EQ(expected + "]", str(pr_str(*val)));
+    val = create_byte_array(elems.data(), 3);
+    EXPECT_EQ("[0 1 2]", str(pr_str(*val)));
+}
+
 TEST_F(pr_str_test, should_print_array_maps)
 {
     Root val{amap()};
@@ -515,5 +536,89 @@ TEST_F(print_str_test, should_print_sequences)
     EXPECT_EQ("(1 (2 (3)))", str(print_str(*val)));
 }
 
+struct print_output_test : Test
+{
+    print_output_test() : Test("cleo.print-output.test") { }
+
+    static Force create_large_vector()
+    {
+        Root v{transient_array(*EMPTY_VECTOR)};
+        Root s{create_string("abc\ndef")};
+        for (Int64 i = 0; i < 20000; ++i)
+        {
+            Root n{create_int64(i)};
+            v = transient_array_conj(*v, *n);
+            v = transient_array_conj(*v, *s);
+        }
+        return transient_array_persistent(*v);
+    }
+
+    static Force pr_str_custom(Value)
+    {
+        return create_string("#custom");
+    }
+};
+
+TEST_F(print_output_test, should_write_to_a_file_descriptor)
+{
+    Root v{create_large_vector()};
+    std::string expected;
+    pr_str(expected, *v);
+    ASSERT_GT(expected.size(), 65536u * 2);
+
+    auto f = std::tmpfile();
+    ASSERT_TRUE(f != nullptr);
+    Output out{fileno(f)};
+    out += "v: ";
+    pr_str(out, *v);
+    out.flush();
+
+    std::string actual(expected.size() + 3, '\0');
+    std::rewind(f);
+    EXPECT_EQ(actual.size(), std::fread(&actual[0], 1, actual.size() + 1, f));
+    std::fclose(f);
+    EXPECT_EQ("v: " + expected, actual);
+}
+
+TEST_F(print_output_test, should_not_write_output_which_is_not_flushed)
+{
+    auto f = std::tmpfile();
+    ASSERT_TRUE(f != nullptr);
+    {
+        Output out{fileno(f)};
+        out += "discarded";
+    }
+    char buf[16];
+    std::rewind(f);
+    EXPECT_EQ(0u, std::fread(buf, 1, sizeof(buf), f));
+    std::fclose(f);
+}
+
+TEST_F(print_output_test, should_append_to_a_string_builder)
+{
+    Root v{create_large_vector()};
+    std::string expected;
+    print_str(expected, *v);
+
+    Root sb{create_string_builder(0)};
+    sb = string_builder_append(*sb, "v: ", 3);
+    Output out{sb};
+    print_str(out, *v);
+    out.flush();
+    EXPECT_EQ("v: " + expected, std::string(get_string_builder_ptr(*sb), get_string_builder_size(*sb)));
+}
+
+TEST_F(print_output_test, should_print_objects_with_methods_defined_outside_of_the_printer)
+{
+    Root t{create_dynamic_object_type("somewhere", "custom")};
+    Root fn{create_native_function1<pr_str_custom, &PR_STR_OBJ>()};
+    define_method(PR_STR_OBJ, *t, *fn);
+    Root obj{create_object0(*t)};
+    Root v{array(*obj, *obj)};
+    std::string out;
+    pr_str(out, *v);
+    EXPECT_EQ("[#custom #custom]", out);
+}
+
 }
 }
@@ -2,8 +2,15 @@
 #include <cleo/equality.hpp>
 #include <cleo/multimethod.hpp>
 #include <cleo/var.hpp>
+#include <cleo/util.hpp>
+#include <cleo/array.hpp>
+#include <cleo/list.hpp>
 #include <gtest/gtest.h>
 #include "util.hpp"
+#include <fstream>
+#include <cstdio>
+#include <unistd.h>
+#include <fcntl.h>
 
 namespace cleo
 {
@@ -21,6 +28,21 @@ struct reader_test : Test
         return read(stream);
     }
 
+    struct TempFile
+    {
+        std::string path;
+
+        explicit TempFile(const std::string& content)
+        {
+            char name[] = "/tmp/cleo_reader_test_XXXXXX";
+            int fd = ::mkstemp(name);
+            ::close(fd);
+            path = name;
+            std::ofstream(path) << content;
+        }
+        ~TempFile() { std::remove(path.c_str()); }
+    };
+
     static void assert_read_error(Value exType, const std::string& msg, Int64 line, Int64 col, const std::string& source)
     {
         try
@@ -595,6 +617,43 @@ TEST_F(reader_test, should_fail_when_a_value_in_a_map_is_missing)
     assert_read_error("map literal must contain an even number of forms", "{1 3 4}", 1, 1);
 }
 
+TEST_F(reader_test, should_keep_the_last_value_of_duplicate_map_keys)
+{
+    Root ex, val;
+    ex = amap(1, 3, 2, 4); val = read_str("{1 2 2 4 1 3}");
+    EXPECT_EQ_VALS(*ex, *val);
+}
+
+TEST_F(reader_test, should_parse_maps_larger_than_array_maps)
+{
+    std::string s = "{";
+    for (int i = 0; i < 40; ++i)
+        s += std::to_string(i) + " " + std::to_string(i * 10) + " ";
+    s += "}";
+    Root val{read_str(s)};
+    EXPECT_EQ_VALS(*type::PersistentHashMap, get_value_type(*val));
+    for (int i = 0; i < 40; ++i)
+        EXPECT_EQ_VALS(create_int48(i * 10), map_get(*val, create_int48(i)));
+}
+
+TEST_F(reader_test, should_parse_collections_larger_than_the_spill_size)
+{
+    const std::uint32_t n = 10000;
+    std::string s = "[";
+    for (std::uint32_t i = 0; i < n; ++i)
+        s += std::to_string(i) + " ";
+    s += "]";
+    Root val{read_str(s)};
+    ASSERT_EQ(n, get_array_size(*val));
+    for (std::uint32_t i = 0; i < n; ++i)
+        ASSERT_EQ_VALS(create_int48(i), get_array_elem(*val, i));
+    s[0] = '(';
+    s.back() = ')';
+    val = read_str(s);
+    ASSERT_EQ(n, get_list_size(*val));
+    EXPECT_EQ_VALS(create_int48(0), get_list_first(*val));
+}
+
 TEST_F(reader_test, should_parse_an_empty_set)
 {
     Root ex, val;
@@ -960,5 +1019,110 @@ TEST_F(reader_test, should_skip_comments)
     EXPECT_EQ_VALS(*ex, *val);
 }
 
+TEST_F(reader_test, read_should_stream_forms_from_a_file_across_buffer_refills)
+{
+    std::string content;
+    const int n = 3000;
+    for (int i = 0; i < n; ++i)
+        content += "(abc :key \"str\" " + std::to_string(i) + ")\n";
+    TempFile file{content};
+    Root path{create_string(file.path)};
+    Root reader{create_reader(*path)};
+    Root val, ex;
+    for (int i = 0; i < n; ++i)
+    {
+        val = read_next(*reader, nil);
+        ex = read_str("(abc :key \"str\" " + std::to_string(i) + ")");
+        ASSERT_EQ_VALS(*ex, *val) << i;
+    }
+    val = read_next(*reader, *reader);
+    EXPECT_TRUE(reader->is(*val));
+    val = read_next(*reader, nil);
+    EXPECT_EQ_REFS(nil, *val);
+}
+
+TEST_F(reader_test, close_should_release_the_file_and_end_the_input)
+{
+    TempFile file{"1 2 3"};
+    Root path{create_string(file.path)};
+    Root reader{create_reader(*path)};
+    Root val{read_next(*reader, nil)};
+    EXPECT_EQ_VALS(create_int48(1), *val);
+    auto fd = get_dynamic_object_int(*reader, 0);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ_REFS(nil, close_reader(*reader));
+    EXPECT_EQ(-1, get_dynamic_object_int(*reader, 0));
+    EXPECT_EQ(-1, ::fcntl(int(fd), F_GETFD));
+    val = read_next(*reader, *reader);
+    EXPECT_TRUE(reader->is(*val));
+    EXPECT_EQ_REFS(nil, close_reader(*reader));
+}
+
+TEST_F(reader_test, read_should_grow_the_buffer_for_forms_larger_than_it)
+{
+    std::string big(200000, 'x');
+    TempFile file{"[1 \"" + big + "\"] 2"};
+    Root path{create_string(file.path)};
+    Root reader{create_reader(*path)};
+    Root val, ex;
+    val = read_next(*reader, nil);
+    ex = read_str("[1 \"" + big + "\"]");
+    EXPECT_EQ_VALS(*ex, *val);
+    val = read_next(*reader, nil);
+    EXPECT_EQ_VALS(create_int48(2), *val);
+    val = read_next(*reader, nil);
+    EXPECT_EQ_REFS(nil, *val);
+}
+
+TEST_F(reader_test, read_should_report_positions_in_files)
+{
+    TempFile file{"1\n  (2\n"};
+    Root path{create_string(file.path)};
+    Root reader{create_reader(*path)};
+    Root val{read_next(*reader, nil)};
+    try
+    {
+        val = read_next(*reader, nil);
+        FAIL() << "expected an exception";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        ASSERT_TRUE(get_value_type(*e).is(*type::UnexpectedEndOfInput));
+        EXPECT_EQ(3, read_error_line(*e));
+        EXPECT_EQ(1, read_error_column(*e));
+    }
+}
+
+TEST_F(reader_test, should_read_string_slices_across_collections)
+{
+    std::string text = "[:aaaa :bbbb :cccc [\"dddd\" \"eeee\"] {:ffff 1}]";
+    Root slice;
+    {
+        Root parent{create_string(text + std::string(100, ' '))};
+        slice = create_substring(*parent, 0, text.size());
+    }
+    ASSERT_TRUE(is_string_slice(*slice));
+    ReaderStream stream{*slice};
+    Root val{read(stream)};
+    Root expected{read_str(text)};
+    EXPECT_EQ_VALS(*expected, *val);
+}
+
+TEST_F(reader_test, create_reader_should_fail_for_missing_files)
+{
+    Root path{create_string("/nonexistent/cleo/file.cleo")};
+    try
+    {
+        Root reader{create_reader(*path)};
+        FAIL() << "expected an exception";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        EXPECT_TRUE(get_value_type(*e).is(*type::FileNotFound));
+    }
+}
+
 }
 }
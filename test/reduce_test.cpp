@@ -0,0 +1,193 @@
+#include <cleo/reduce.hpp>
+#include <cleo/array.hpp>
+#include <cleo/vector.hpp>
+#include <cleo/byte_array.hpp>
+#include <cleo/list.hpp>
+#include <cleo/array_map.hpp>
+#include <cleo/array_set.hpp>
+#include <cleo/persistent_hash_map.hpp>
+#include <cleo/persistent_hash_set.hpp>
+#include <cleo/string_seq.hpp>
+#include <cleo/global.hpp>
+#include <gtest/gtest.h>
+#include "util.hpp"
+
+namespace cleo
+{
+namespace test
+{
+
+struct reduce_test : Test
+{
+    Root conj_fn, conj_until_3_fn;
+
+    reduce_test() : Test("cleo.reduce.test")
+    {
+        conj_fn = create_native_function([](const Value *args, std::uint8_t) { return array_conj(args[0], args[1]); });
+        conj_until_3_fn = create_native_function([](const Value *args, std::uint8_t)
+        {
+            Root acc{array_conj(args[0], args[1])};
+            if (get_value_tag(args[1]) == tag::INT64 && get_int64_value(args[1]) == 3)
+                return create_reduced(*acc);
+            return force(*acc);
+        });
+    }
+};
+
+TEST_F(reduce_test, should_reduce_arrays_in_order)
+{
+    Root a{array()};
+    Root r{array_reduce(*a, *conj_fn, *EMPTY_VECTOR)};
+    EXPECT_EQ_VALS(*EMPTY_VECTOR, *r);
+
+    a = array(1, 2, 3, 4, 5);
+    r = array_reduce(*a, *conj_fn, *EMPTY_VECTOR);
+    EXPECT_EQ_VALS(*a, *r);
+
+    r = array_reduce(*a, *conj_until_3_fn, *EMPTY_VECTOR);
+    Root ex{array(1, 2, 3)};
+    EXPECT_EQ_VALS(*ex, *r);
+}
+
+TEST_F(reduce_test, should_reduce_vectors_in_order)
+{
+    const Int64 size = 1100;
+    Root v{create_vector(nullptr, 0)};
+    Root e;
+    for (Int64 i = 0; i < size; ++i)
+    {
+        e = create_int64(i);
+        v = vector_conj(*v, *e);
+    }
+    Root r{vector_reduce(*v, *conj_fn, *EMPTY_VECTOR)};
+    ASSERT_EQ(size, get_array_size(*r));
+    for (Int64 i = 0; i < size; ++i)
+        ASSERT_EQ(i, get_int64_value(get_array_elem(*r, i)));
+
+    r = vector_reduce(*v, *conj_until_3_fn, *EMPTY_VECTOR);
+    Root ex{array(0, 1, 2, 3)};
+    EXPECT_EQ_VALS(*ex, *r);
+}
+
+TEST_F(reduce_test, should_reduce_byte_arrays_in_order)
+{
+    Root e0{create_int64(1)}, e1{create_int64(3)}, e2{create_int64(7)};
+    std::array<Value, 3> elems{{*e0, *e1, *e2}};
+    Root a{create_byte_array(elems.data(), elems.size())};
+    Root r{byte_array_reduce(*a, *conj_fn, *EMPTY_VECTOR)};
+    Root ex{array(1, 3, 7)};
+    EXPECT_EQ_VALS(*ex, *r);
+
+    r = byte_array_reduce(*a, *conj_until_3_fn, *EMPTY_VECTOR);
+    ex = array(1, 3);
+    EXPECT_EQ_VALS(*ex, *r);
+}
+
+TEST_F(reduce_test, should_reduce_lists_in_order)
+{
+    Root l{list()};
+    Root r{list_reduce(*l, *conj_fn, *EMPTY_VECTOR)};
+    EXPECT_EQ_VALS(*EMPTY_VECTOR, *r);
+
+    l = list(5, 3, 1);
+    r = list_reduce(*l, *conj_fn, *EMPTY_VECTOR);
+    Root ex{array(5, 3, 1)};
+    EXPECT_EQ_VALS(*ex, *r);
+
+    r = list_reduce(*l, *conj_until_3_fn, *EMPTY_VECTOR);
+    ex = array(5, 3);
+    EXPECT_EQ_VALS(*ex, *r);
+}
+
+TEST_F(reduce_test, should_reduce_strings_to_chars)
+{
+    Root s{create_string("")};
+    Root r{string_reduce(*s, *conj_fn, *EMPTY_VECTOR)};
+    EXPECT_EQ_VALS(*EMPTY_VECTOR, *r);
+
+    s = create_string("a\xc4\x85z");
+    r = string_reduce(*s, *conj_fn, *EMPTY_VECTOR);
+    Root a{create_uchar('a')}, b{create_uchar(0x105)}, c{create_uchar('z')};
+    Root ex{array(*a, *b, *c)};
+    EXPECT_EQ_VALS(*ex, *r);
+}
+
+TEST_F(reduce_test, should_reduce_array_maps_and_sets_in_seq_order)
+{
+    Root m{amap(1, 10, 2, 20, 3, 30)};
+    Root r{array_map_reduce(*m, *conj_fn, *EMPTY_VECTOR)};
+    ASSERT_EQ(3u, get_array_size(*r));
+    std::uint32_t i = 0;
+    for (Root s{array_map_seq(*m)}; *s; s = get_array_map_seq_next(*s), ++i)
+        EXPECT_EQ_VALS(get_array_map_seq_first(*s), get_array_elem(*r, i));
+
+    Root set{aset(1, 2, 3, 4)};
+    r = array_set_reduce(*set, *conj_fn, *EMPTY_VECTOR);
+    ASSERT_EQ(4u, get_array_size(*r));
+    i = 0;
+    for (Root s{array_set_seq(*set)}; *s; s = get_array_set_seq_next(*s), ++i)
+        EXPECT_EQ_VALS(get_array_set_seq_first(*s), get_array_elem(*r, i));
+
+    r = array_set_reduce(*set, *conj_until_3_fn, *EMPTY_VECTOR);
+    EXPECT_EQ(3, get_int64_value(get_array_elem(*r, get_array_size(*r) - 1)));
+}
+
+TEST_F(reduce_test, should_reduce_hash_maps_and_sets_in_seq_order)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    Root m{create_persistent_hash_map()};
+    Root set{create_persistent_hash_set()};
+    Root r{persistent_hash_map_reduce(*m, *conj_fn, *EMPTY_VECTOR)};
+    EXPECT_EQ_VALS(*EMPTY_VECTOR, *r);
+    r = persistent_hash_set_reduce(*set, *conj_fn, *EMPTY_VECTOR);
+    EXPECT_EQ_VALS(*EMPTY_VECTOR, *r);
+
+    Root k, v;
+    for (Int64 n : {1, 2, 1000})
+    {
+        for (Int64 i = get_persistent_hash_map_size(*m); i < n; ++i)
+        {
+            k = create_int64(i * 7919);
+            v = create_int64(-i);
+            m = persistent_hash_map_assoc(*m, *k, *v);
+            set = persistent_hash_set_conj(*set, *k);
+        }
+
+        r = persistent_hash_map_reduce(*m, *conj_fn, *EMPTY_VECTOR);
+        ASSERT_EQ(std::uint32_t(n), get_array_size(*r));
+        std::uint32_t i = 0;
+        for (Root s{persistent_hash_map_seq(*m)}; *s; s = get_persistent_hash_map_seq_next(*s), ++i)
+            ASSERT_EQ_VALS(get_persistent_hash_map_seq_first(*s), get_array_elem(*r, i));
+
+        r = persistent_hash_set_reduce(*set, *conj_fn, *EMPTY_VECTOR);
+        ASSERT_EQ(std::uint32_t(n), get_array_size(*r));
+        i = 0;
+        for (Root s{persistent_hash_set_seq(*set)}; *s; s = get_persistent_hash_set_seq_next(*s), ++i)
+            ASSERT_EQ_VALS(get_persistent_hash_set_seq_first(*s), get_array_elem(*r, i));
+    }
+
+    k = create_int64(3 * 7919);
+    Root stop_fn{create_native_function([](const Value *args, std::uint8_t)
+    {
+        Root acc{array_conj(args[0], args[1])};
+        if (get_int64_value(args[1]) == 3 * 7919)
+            return create_reduced(*acc);
+        return force(*acc);
+    })};
+    r = persistent_hash_set_reduce(*set, *stop_fn, *EMPTY_VECTOR);
+    EXPECT_EQ_VALS(*k, get_array_elem(*r, get_array_size(*r) - 1));
+    EXPECT_GT(1000u, get_array_size(*r));
+}
+
+TEST_F(reduce_test, reduced_should_wrap_a_value)
+{
+    Root v{create_int64(7)};
+    Root r{create_reduced(*v)};
+    EXPECT_EQ_REFS(*type::Reduced, get_value_type(*r));
+    EXPECT_EQ_REFS(TRUE, is_reduced(*r));
+    EXPECT_EQ_REFS(nil, is_reduced(*v));
+    EXPECT_EQ_VALS(*v, reduced_deref(*r));
+}
+
+}
+}
@@ -0,0 +1,305 @@
+#include <cleo/serialize.hpp>
+#include <cleo/reader.hpp>
+#include <cleo/byte_array.hpp>
+#include <cleo/typed_array.hpp>
+#include <cleo/persistent_queue.hpp>
+#include <cleo/persistent_tree_map.hpp>
+#include <cleo/persistent_tree_set.hpp>
+#include <cleo/vector.hpp>
+#include <cleo/error.hpp>
+#include <cleo/equality.hpp>
+#include <gtest/gtest.h>
+#include "util.hpp"
+#include <limits>
+#include <cstdio>
+#include <unistd.h>
+
+namespace cleo
+{
+namespace test
+{
+
+struct serialize_test : Test
+{
+    serialize_test() : Test("cleo.serialize.test") { }
+
+    static Force read_str(const std::string& s)
+    {
+        Root text{create_string(s)};
+        return read(*text);
+    }
+
+    static Force roundtrip(Value val, Value cache_names = nil)
+    {
+        Root bytes{serialize(val, cache_names)};
+        return deserialize(*bytes);
+    }
+
+    static void expect_roundtrip(const std::string& source)
+    {
+        Root val{read_str(source)};
+        for (auto cache : {nil, TRUE})
+        {
+            Root result{roundtrip(*val, cache)};
+            EXPECT_EQ_VALS(*val, *result);
+            EXPECT_EQ_REFS(get_value_type(*val), get_value_type(*result));
+        }
+    }
+
+    static void expect_illegal_argument(const std::string& data)
+    {
+        try
+        {
+            Root result{deserialize(data.data(), data.size())};
+            FAIL() << "expected an exception; got " << to_string(*result);
+        }
+        catch (Exception const& )
+        {
+            Root e{catch_exception()};
+            EXPECT_EQ_REFS(*type::IllegalArgument, get_value_type(*e));
+        }
+    }
+};
+
+TEST_F(serialize_test, should_roundtrip_scalars)
+{
+    expect_roundtrip("nil");
+    expect_roundtrip("true");
+    expect_roundtrip("0");
+    expect_roundtrip("-17");
+    expect_roundtrip("140737488355327");
+    expect_roundtrip("-9223372036854775808");
+    expect_roundtrip("9223372036854775807");
+    expect_roundtrip("1.5");
+    expect_roundtrip("-2.5e300");
+    expect_roundtrip("\\a");
+    expect_roundtrip("\\u00e9");
+    expect_roundtrip("\"\"");
+    expect_roundtrip("\"abc\"");
+    expect_roundtrip("\"a longer string with \\u00e9 in it\"");
+    expect_roundtrip("sym");
+    expect_roundtrip("some.ns/sym");
+    expect_roundtrip(":kw");
+    expect_roundtrip(":some.ns/kw");
+}
+
+TEST_F(serialize_test, should_roundtrip_collections)
+{
+    expect_roundtrip("()");
+    expect_roundtrip("(1 (2 \"x\") :a)");
+    expect_roundtrip("[]");
+    expect_roundtrip("[1 [2 [3]] {:a #{4}}]");
+    expect_roundtrip("{}");
+    expect_roundtrip("{:a 1 \"b\" [2] c {:d nil}}");
+    expect_roundtrip("#{}");
+    expect_roundtrip("#{1 :two \"three\" [4]}");
+
+    std::string big_map = "{", big_set = "#{";
+    for (int i = 0; i < 40; ++i)
+    {
+        big_map += ":k" + std::to_string(i) + " " + std::to_string(i) + " ";
+        big_set += std::to_string(i) + " ";
+    }
+    expect_roundtrip(big_map + "}");
+    expect_roundtrip(big_set + "}");
+}
+
+TEST_F(serialize_test, should_roundtrip_byte_arrays_and_vectors)
+{
+    std::vector<Value> elems;
+    for (Int64 i = 0; i < 100; ++i)
+        elems.push_back(create_int48(i));
+    Root bytes{create_byte_array(elems.data(), elems.size())};
+    Root result{roundtrip(*bytes)};
+    EXPECT_EQ_REFS(*type::ByteArray, get_value_type(*result));
+    EXPECT_EQ_VALS(*bytes, *result);
+
+    Root v{create_vector(elems.data(), elems.size())};
+    result = roundtrip(*v);
+    EXPECT_EQ_REFS(*type::Array, get_value_type(*result));
+    EXPECT_EQ_VALS(*v, *result);
+}
+
+TEST_F(serialize_test, should_roundtrip_queues_and_typed_arrays)
+{
+    Root q{create_persistent_queue()};
+    for (Int64 i = 0; i < 40; ++i)
+        q = persistent_queue_conj(*q, create_int48(i));
+    q = persistent_queue_pop(*q);
+    Root result{roundtrip(*q)};
+    EXPECT_EQ_REFS(*type::PersistentQueue, get_value_type(*result));
+    EXPECT_EQ_VALS(*q, *result);
+
+    std::vector<Value> ints, floats;
+    for (Int64 i : {Int64(0), Int64(-1), std::numeric_limits<Int64>::min(), std::numeric_limits<Int64>::max()})
+        ints.push_back(create_int64(i).value());
+    Root ia{create_int64_array(ints.data(), ints.size())};
+    result = roundtrip(*ia);
+    EXPECT_EQ_REFS(*type::Int64Array, get_value_type(*result));
+    EXPECT_EQ_VALS(*ia, *result);
+
+    for (Float64 f : {0.0, -2.5, 1e300, std::numeric_limits<Float64>::infinity()})
+        floats.push_back(create_float64(f).value());
+    Root fa{create_float64_array(floats.data(), floats.size())};
+    result = roundtrip(*fa);
+    EXPECT_EQ_REFS(*type::Float64Array, get_value_type(*result));
+    EXPECT_EQ_VALS(*fa, *result);
+}
+
+TEST_F(serialize_test, should_roundtrip_sorted_maps_and_sets)
+{
+    Root m{create_persistent_tree_map(nil)};
+    Root s{create_persistent_tree_set(nil)};
+    Root k, v;
+    for (Int64 i = 0; i < 100; ++i)
+    {
+        k = create_int64((i * 37) % 100);
+        v = create_int64(i);
+        m = persistent_tree_map_assoc(*m, *k, *v);
+        s = persistent_tree_set_conj(*s, *k);
+    }
+    Root result{roundtrip(*m)};
+    EXPECT_EQ_REFS(*type::PersistentTreeMap, get_value_type(*result));
+    EXPECT_EQ_VALS(*m, *result);
+    Root seq{persistent_tree_map_seq(*result)};
+    Root kv{get_persistent_tree_seq_first(*seq)};
+    EXPECT_EQ(0, get_int64_value(get_array_elem(*kv, 0)));
+
+    result = roundtrip(*s);
+    EXPECT_EQ_REFS(*type::PersistentTreeSet, get_value_type(*result));
+    EXPECT_EQ_VALS(*s, *result);
+}
+
+TEST_F(serialize_test, should_not_serialize_sorted_collections_with_custom_comparators)
+{
+    Root m{create_persistent_tree_map(*rt::map_assoc)};
+    try
+    {
+        Root bytes{serialize(*m)};
+        FAIL() << "expected an exception";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        EXPECT_EQ_REFS(*type::IllegalArgument, get_value_type(*e));
+    }
+}
+
+TEST_F(serialize_test, should_fail_on_deeply_nested_data)
+{
+    Root val{read_str("[[[[1]]]]")};
+    Root bytes{serialize(*val)};
+    std::string data(get_byte_array_ptr(*bytes), get_byte_array_size(*bytes));
+    std::string header = data.substr(0, 5), nested;
+    for (int i = 0; i < 100000; ++i)
+        nested += data.substr(5, 2);
+    expect_illegal_argument(header + nested + char(0));
+    nested.resize(2 * 1000);
+    std::string data_1000 = header + nested + char(0);
+    Root result{deserialize(data_1000.data(), data_1000.size())};
+    EXPECT_EQ_REFS(*type::Array, get_value_type(*result));
+}
+
+TEST_F(serialize_test, should_restore_the_gc_interval)
+{
+    std::string source = "[";
+    for (int i = 0; i < 2000; ++i)
+        source += "{:id " + std::to_string(i) + " :name \"user\"} ";
+    Root val{read_str(source + "]")};
+    Root bytes{serialize(*val)};
+    auto frequency = gc_frequency;
+    Root result{deserialize(*bytes)};
+    EXPECT_EQ_VALS(*val, *result);
+    EXPECT_EQ(frequency, gc_frequency);
+    EXPECT_LE(gc_counter, frequency);
+}
+
+TEST_F(serialize_test, should_write_back_references_for_repeated_names)
+{
+    std::string source = "[";
+    for (int i = 0; i < 50; ++i)
+        source += "{:user/id " + std::to_string(i) + " :user/role :admin \"name\" user} ";
+    Root val{read_str(source + "]")};
+    Root plain{serialize(*val)};
+    Root cached{serialize(*val, TRUE)};
+    EXPECT_LT(get_byte_array_size(*cached) * 3, get_byte_array_size(*plain));
+    Root result{deserialize(*cached)};
+    EXPECT_EQ_VALS(*val, *result);
+}
+
+TEST_F(serialize_test, should_not_cache_long_strings)
+{
+    std::string s(MAX_CACHED_STRING + 1, 'x');
+    Root val{read_str("[\"" + s + "\" \"" + s + "\" \"" + s.substr(1) + "\" \"" + s.substr(1) + "\"]")};
+    Root cached{serialize(*val, TRUE)};
+    EXPECT_GT(get_byte_array_size(*cached), Int64(s.size() * 3));
+    Root result{deserialize(*cached)};
+    EXPECT_EQ_VALS(*val, *result);
+}
+
+TEST_F(serialize_test, should_roundtrip_through_files)
+{
+    char name[] = "/tmp/cleo_serialize_test_XXXXXX";
+    ::close(::mkstemp(name));
+    Root path{create_string(name)};
+    std::string source = "[";
+    for (int i = 0; i < 10000; ++i)
+        source += "{:id " + std::to_string(i) + " :name \"user-" + std::to_string(i) + "\" :score 1.5} ";
+    Root val{read_str(source + "]")};
+    Root ret{serialize_to_file(*path, *val, TRUE)};
+    EXPECT_TRUE(ret->is_nil());
+    Root result{deserialize_file(*path)};
+    EXPECT_EQ_VALS(*val, *result);
+    std::remove(name);
+}
+
+TEST_F(serialize_test, should_fail_on_missing_files)
+{
+    Root path{create_string("/tmp/cleo_serialize_test_missing/file")};
+    try
+    {
+        Root result{deserialize_file(*path)};
+        FAIL() << "expected an exception";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        EXPECT_EQ_REFS(*type::FileNotFound, get_value_type(*e));
+    }
+}
+
+TEST_F(serialize_test, should_fail_on_write_errors)
+{
+    if (::access("/dev/full", W_OK) != 0)
+        return;
+    Root path{create_string("/dev/full")};
+    Root val{read_str("[1 2 3]")};
+    try
+    {
+        serialize_to_file(*path, *val);
+        FAIL() << "expected an exception";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        EXPECT_EQ_REFS(*type::IllegalState, get_value_type(*e));
+    }
+}
+
+TEST_F(serialize_test, should_fail_on_malformed_data)
+{
+    Root val{read_str("[1 \"abc\" {:a [2.5]}]")};
+    Root bytes{serialize(*val)};
+    std::string data(get_byte_array_ptr(*bytes), get_byte_array_size(*bytes));
+
+    expect_illegal_argument("");
+    expect_illegal_argument("XYZ" + data.substr(3));
+    expect_illegal_argument(data.substr(0, 3) + char(99) + data.substr(4));
+    for (std::size_t n = 5; n < data.size(); ++n)
+        expect_illegal_argument(data.substr(0, n));
+    expect_illegal_argument(data + '\0');
+    expect_illegal_argument(data.substr(0, 5) + char(200));
+}
+
+}
+}
@@ -0,0 +1,72 @@
+#include <cleo/string_builder.hpp>
+#include <cleo/global.hpp>
+#include <gtest/gtest.h>
+#include "util.hpp"
+
+namespace cleo
+{
+namespace test
+{
+
+struct string_builder_test : Test
+{
+    string_builder_test() : Test("cleo.string-builder.test") { }
+
+    static std::string str(Value sb)
+    {
+        return std::string(get_string_builder_ptr(sb), get_string_builder_size(sb));
+    }
+};
+
+TEST_F(string_builder_test, should_create_an_empty_builder)
+{
+    Root sb{create_string_builder(0)};
+    EXPECT_EQ(0, get_string_builder_size(*sb));
+    Root s{string_builder_persistent(*sb)};
+    ASSERT_EQ(tag::UTF8STRING, get_value_tag(*s));
+    EXPECT_EQ(0u, get_string_size(*s));
+}
+
+TEST_F(string_builder_test, should_append_values)
+{
+    Root sb{create_string_builder(0)};
+    Root val;
+    val = create_string("abc");
+    sb = string_builder_append(*sb, *val);
+    sb = string_builder_append(*sb, nil);
+    val = create_uchar(0x3c0);
+    sb = string_builder_append(*sb, *val);
+    val = create_int64(-17);
+    sb = string_builder_append(*sb, *val);
+    val = create_float64(2.0);
+    sb = string_builder_append(*sb, *val);
+    val = create_keyword("k");
+    sb = string_builder_append(*sb, *val);
+    val = array(std::string("x"), 1);
+    sb = string_builder_append(*sb, *val);
+    EXPECT_EQ("abc\xcf\x80-172.0:k[x 1]", str(*sb));
+}
+
+TEST_F(string_builder_test, should_grow)
+{
+    Root sb{create_string_builder(0)};
+    Root val{create_string("0123456789")};
+    std::string expected;
+    for (int i = 0; i < 100; ++i)
+    {
+        sb = string_builder_append(*sb, *val);
+        expected += "0123456789";
+    }
+    EXPECT_EQ(expected, str(*sb));
+    Root s{string_builder_persistent(*sb)};
+    EXPECT_EQ(expected, std::string(get_string_ptr(*s), get_string_size(*s)));
+}
+
+TEST_F(string_builder_test, should_fail_when_appending_to_other_types)
+{
+    Root val{create_string("abc")};
+    EXPECT_THROW(string_builder_append(*val, *val), Exception);
+}
+
+}
+}
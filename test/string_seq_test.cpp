@@ -1,4 +1,6 @@
 #include <cleo/string_seq.hpp>
+#include <cleo/array.hpp>
+#include <cleo/global.hpp>
 #include <gtest/gtest.h>
 #include "util.hpp"
 
@@ -47,5 +49,25 @@ TEST_F(string_seq_test, seq_should_create_a_sequence_of_chracters)
     ASSERT_TRUE(s->is_nil());
 }
 
+TEST_F(string_seq_test, chunked_seq_should_return_blocks_of_32_characters)
+{
+    std::string text;
+    for (int i = 0; i < 20; ++i)
+        text += "a\xc2\x80";
+    Root str{create_string(text)};
+    Root s{string_seq(*str)};
+    Root chunk{string_seq_chunk_first(*s)};
+    ASSERT_EQ_REFS(*type::Array, get_value_type(*chunk));
+    ASSERT_EQ(32u, get_array_size(*chunk));
+    for (std::uint32_t i = 0; i < 32; ++i)
+        EXPECT_EQ(create_uchar(i % 2 ? 0x80 : 'a'), get_array_elem(*chunk, i));
+    s = string_seq_chunk_next(*s);
+    ASSERT_FALSE(s->is_nil());
+    chunk = string_seq_chunk_first(*s);
+    ASSERT_EQ(8u, get_array_size(*chunk));
+    EXPECT_EQ(create_uchar('a'), get_array_elem(*chunk, 0));
+    EXPECT_EQ_REFS(nil, *Root(string_seq_chunk_next(*s)));
+}
+
 }
 }
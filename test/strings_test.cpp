@@ -0,0 +1,202 @@
+#include <cleo/strings.hpp>
+#include <cleo/array.hpp>
+#include <cleo/multimethod.hpp>
+#include <cleo/global.hpp>
+#include <gtest/gtest.h>
+#include "util.hpp"
+
+namespace cleo
+{
+namespace test
+{
+
+struct strings_test : Test
+{
+    strings_test() : Test("cleo.strings.test") { }
+
+    static std::string str(Value s)
+    {
+        return std::string(get_string_ptr(s), get_string_size(s));
+    }
+
+    static std::string str(Force f)
+    {
+        Root s{f};
+        return str(*s);
+    }
+
+    static Value index(Int64 i)
+    {
+        Root n{create_int64(i)};
+        return *n;
+    }
+
+    static std::string repeat(const std::string& s, int n)
+    {
+        std::string r;
+        for (int i = 0; i < n; ++i)
+            r += s;
+        return r;
+    }
+};
+
+TEST_F(strings_test, index_of_should_find_chars_and_substrings)
+{
+    auto text = repeat("abcdefgh", 20) + "xyz" + repeat("abcdefgh", 20);
+    Root s{create_string(text)};
+    Root x, from, i;
+    x = create_string("xyz");
+    i = string_index_of(*s, *x);
+    EXPECT_EQ_VALS(index(160), *i);
+    x = create_uchar('z');
+    i = string_index_of(*s, *x);
+    EXPECT_EQ_VALS(index(162), *i);
+    x = create_string("hx");
+    i = string_index_of(*s, *x);
+    EXPECT_EQ_VALS(index(159), *i);
+    x = create_string("abc");
+    from = create_int64(1);
+    i = string_index_of(*s, *x, *from);
+    EXPECT_EQ_VALS(index(8), *i);
+    from = create_int64(161);
+    i = string_index_of(*s, *x, *from);
+    EXPECT_EQ_VALS(index(163), *i);
+    x = create_string("xyzz");
+    i = string_index_of(*s, *x);
+    EXPECT_EQ_VALS(nil, *i);
+    x = create_string("");
+    i = string_index_of(*s, *x, *from);
+    EXPECT_EQ_VALS(*from, *i);
+}
+
+TEST_F(strings_test, index_of_should_return_char_indices)
+{
+    auto text = repeat("\xc3\xa9" "a", 40) + "\xcf\x80" "bc";
+    Root s{create_string(text)};
+    Root x, from, i;
+    x = create_string("bc");
+    i = string_index_of(*s, *x);
+    EXPECT_EQ_VALS(index(81), *i);
+    x = create_uchar(0x3c0);
+    i = string_index_of(*s, *x);
+    EXPECT_EQ_VALS(index(80), *i);
+    x = create_uchar(0xe9);
+    from = create_int64(31);
+    i = string_index_of(*s, *x, *from);
+    EXPECT_EQ_VALS(index(32), *i);
+    i = string_last_index_of(*s, *x);
+    EXPECT_EQ_VALS(index(78), *i);
+    i = string_last_index_of(*s, *x, *from);
+    EXPECT_EQ_VALS(index(30), *i);
+}
+
+TEST_F(strings_test, last_index_of_should_find_the_last_occurrence)
+{
+    Root s{create_string("abcabcabc")};
+    Root x, from, i;
+    x = create_string("bc");
+    i = string_last_index_of(*s, *x);
+    EXPECT_EQ_VALS(index(7), *i);
+    from = create_int64(6);
+    i = string_last_index_of(*s, *x, *from);
+    EXPECT_EQ_VALS(index(4), *i);
+    from = create_int64(0);
+    i = string_last_index_of(*s, *x, *from);
+    EXPECT_EQ_VALS(nil, *i);
+    EXPECT_EQ_VALS(TRUE, string_includes(*s, *x));
+    x = create_string("cb");
+    EXPECT_EQ_VALS(nil, string_includes(*s, *x));
+}
+
+TEST_F(strings_test, split_should_drop_trailing_empty_strings)
+{
+    Root s, sep, v, ex;
+    s = create_string("a,b,,c,,");
+    sep = create_uchar(',');
+    v = string_split(*s, *sep);
+    ex = array(std::string("a"), std::string("b"), std::string(""), std::string("c"));
+    EXPECT_EQ_VALS(*ex, *v);
+    s = create_string("");
+    v = string_split(*s, *sep);
+    ex = array(std::string(""));
+    EXPECT_EQ_VALS(*ex, *v);
+    s = create_string(",,");
+    v = string_split(*s, *sep);
+    ex = array();
+    EXPECT_EQ_VALS(*ex, *v);
+    s = create_string("a::b");
+    sep = create_string("::");
+    v = string_split(*s, *sep);
+    ex = array(std::string("a"), std::string("b"));
+    EXPECT_EQ_VALS(*ex, *v);
+}
+
+TEST_F(strings_test, split_should_share_the_parent_string)
+{
+    auto piece = repeat("\xc3\xa9", 20);
+    Root s{create_string(repeat(piece + " ", 4))};
+    Root sep{create_uchar(' ')};
+    Root v{string_split(*s, *sep)};
+    Root e, n;
+    for (Int64 i = 0; i < 4; ++i)
+    {
+        n = create_int64(i);
+        e = call_multimethod2(*rt::get, *v, *n);
+        ASSERT_TRUE(is_string_slice(*e));
+        EXPECT_EQ(20u, get_string_len(*e));
+        EXPECT_EQ(piece, str(*e));
+    }
+}
+
+TEST_F(strings_test, replace_should_replace_all_occurrences)
+{
+    Root s{create_string(repeat("one two ", 10))};
+    Root match{create_string("two")};
+    Root replacement{create_uchar(0x3c0)};
+    EXPECT_EQ(repeat("one \xcf\x80 ", 10), str(string_replace(*s, *match, *replacement)));
+    match = create_string("three");
+    Root r{string_replace(*s, *match, *replacement)};
+    EXPECT_EQ_REFS(*s, *r);
+}
+
+TEST_F(strings_test, join_should_concatenate_elements)
+{
+    Root coll{array(std::string("a"), 1, nil, std::string("b"))};
+    Root sep{create_string(", ")};
+    EXPECT_EQ("a1b", str(string_join(*coll)));
+    EXPECT_EQ("a, 1, , b", str(string_join(*sep, *coll)));
+    coll = list(1, 2, 3);
+    sep = create_uchar('-');
+    EXPECT_EQ("1-2-3", str(string_join(*sep, *coll)));
+    EXPECT_EQ("", str(string_join(*sep, nil)));
+}
+
+TEST_F(strings_test, trim_should_remove_whitespace)
+{
+    Root s{create_string(" \t\n \xc3\xa9 a b\r\n")};
+    EXPECT_EQ("\xc3\xa9 a b", str(string_trim(*s)));
+    Root t{string_trim(*s)};
+    EXPECT_EQ(5u, get_string_len(*t));
+    s = create_string("abc");
+    t = string_trim(*s);
+    EXPECT_EQ_REFS(*s, *t);
+    s = create_string(" \t ");
+    EXPECT_EQ("", str(string_trim(*s)));
+}
+
+TEST_F(strings_test, should_change_case)
+{
+    auto text = repeat("Hello, World! [@`{~] ", 5);
+    Root s{create_string(text)};
+    EXPECT_EQ(repeat("hello, world! [@`{~] ", 5), str(string_lower_case(*s)));
+    EXPECT_EQ(repeat("HELLO, WORLD! [@`{~] ", 5), str(string_upper_case(*s)));
+    s = create_string("Caf\xc3\xa9 Z");
+    EXPECT_EQ("caf\xc3\xa9 z", str(string_lower_case(*s)));
+    s = create_string("\xc3\x89T\xc3\x89 \xce\xa3\xce\x9f\xce\xa6\xce\x99\xce\x91 \xd0\x9c\xd0\x98\xd0\xa0 \xc5\xbd");
+    EXPECT_EQ("\xc3\xa9t\xc3\xa9 \xcf\x83\xce\xbf\xcf\x86\xce\xb9\xce\xb1 \xd0\xbc\xd0\xb8\xd1\x80 \xc5\xbe", str(string_lower_case(*s)));
+    s = create_string("\xc3\xa9t\xc3\xa9 \xcf\x83\xce\xbf\xcf\x86\xce\xb9\xce\xb1\xcf\x82 \xd1\x91\xd0\xb6 \xc3\xbf \xc3\x9f");
+    EXPECT_EQ("\xc3\x89T\xc3\x89 \xce\xa3\xce\x9f\xce\xa6\xce\x99\xce\x91\xce\xa3 \xd0\x81\xd0\x96 \xc5\xb8 \xc3\x9f", str(string_upper_case(*s)));
+}
+
+}
+}
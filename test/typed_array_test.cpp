@@ -0,0 +1,264 @@
+#include <cleo/typed_array.hpp>
+#include <cleo/global.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "util.hpp"
+
+namespace cleo
+{
+namespace test
+{
+
+struct typed_array_test : Test
+{
+    typed_array_test() : Test("cleo.typed-array.test") { }
+
+    static Force create_int64_array(const std::vector<Int64>& elems)
+    {
+        Root a{cleo::create_int64_array(nullptr, 0)};
+        Root e;
+        for (auto x : elems)
+        {
+            e = create_int64(x);
+            a = typed_array_conj(*a, *e);
+        }
+        return *a;
+    }
+
+    static Force create_float64_array(const std::vector<Float64>& elems)
+    {
+        Root a{cleo::create_float64_array(nullptr, 0)};
+        Root e;
+        for (auto x : elems)
+        {
+            e = create_float64(x);
+            a = typed_array_conj(*a, *e);
+        }
+        return *a;
+    }
+
+    static void expect_int64_elems(const std::vector<Int64>& expected, Value a)
+    {
+        ASSERT_EQ(Int64(expected.size()), get_typed_array_size(a));
+        for (std::size_t i = 0; i < expected.size(); ++i)
+            EXPECT_EQ(expected[i], get_int64_array_elems(a)[i]) << "index: " << i;
+    }
+
+    static void expect_float64_elems(const std::vector<Float64>& expected, Value a)
+    {
+        ASSERT_EQ(Int64(expected.size()), get_typed_array_size(a));
+        for (std::size_t i = 0; i < expected.size(); ++i)
+            EXPECT_DOUBLE_EQ(expected[i], get_float64_array_elems(a)[i]) << "index: " << i;
+    }
+};
+
+TEST_F(typed_array_test, should_create_arrays_from_elements)
+{
+    Root e0{create_int64(7)}, e1{create_int64(-3)}, f{create_float64(2.5)};
+    std::array<Value, 2> ints{{*e0, *e1}};
+    Root a{cleo::create_int64_array(ints.data(), ints.size())};
+    ASSERT_EQ_REFS(*type::Int64Array, get_value_type(*a));
+    expect_int64_elems({7, -3}, *a);
+    EXPECT_EQ_VALS(*e1, *Root(get_typed_array_elem(*a, 1)));
+    EXPECT_TRUE(Root(get_typed_array_elem(*a, 2))->is_nil());
+    EXPECT_TRUE(Root(get_typed_array_elem(*a, -1))->is_nil());
+
+    std::array<Value, 2> nums{{*e0, *f}};
+    a = cleo::create_float64_array(nums.data(), nums.size());
+    ASSERT_EQ_REFS(*type::Float64Array, get_value_type(*a));
+    expect_float64_elems({7.0, 2.5}, *a);
+
+    EXPECT_THROW(cleo::create_int64_array(nums.data(), nums.size()), Exception);
+}
+
+TEST_F(typed_array_test, should_conj_pop_and_iterate_in_chunks)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    std::vector<Int64> elems;
+    for (Int64 i = 0; i < 100; ++i)
+        elems.push_back(i * 3);
+    Root a{create_int64_array(elems)};
+    expect_int64_elems(elems, *a);
+
+    Int64 count = 0;
+    for (Root s{typed_array_seq(*a)}; *s; s = get_typed_array_seq_chunk_next(*s))
+    {
+        Root chunk{get_typed_array_seq_chunk_first(*s)};
+        for (Int64 i = 0; i < Int64(get_array_size(*chunk)); ++i, ++count)
+            ASSERT_EQ(elems[count], get_int64_value(get_array_elem(*chunk, i)));
+    }
+    EXPECT_EQ(100, count);
+
+    Root popped{typed_array_pop(*a)};
+    elems.pop_back();
+    expect_int64_elems(elems, *popped);
+    EXPECT_EQ(100, get_typed_array_size(*a));
+}
+
+TEST_F(typed_array_test, kernels_should_match_scalar_results)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    for (Int64 size : {0, 1, 3, 4, 5, 17, 64, 1001})
+    {
+        std::vector<Int64> l, r;
+        std::vector<Float64> fl, fr;
+        for (Int64 i = 0; i < size; ++i)
+        {
+            l.push_back((i * 7919) % 1000 - 500);
+            r.push_back((i * 104729) % 100 - 50);
+            fl.push_back(l.back() * 0.5);
+            fr.push_back(r.back() * 0.25);
+        }
+        Root il{create_int64_array(l)}, ir{create_int64_array(r)};
+        Root dl{create_float64_array(fl)}, dr{create_float64_array(fr)};
+
+        Int64 isum = 0, idot = 0;
+        Float64 fsum = 0, fdot = 0;
+        for (Int64 i = 0; i < size; ++i)
+        {
+            isum += l[i];
+            idot += l[i] * r[i];
+            fsum += fl[i];
+            fdot += fl[i] * fr[i];
+        }
+        EXPECT_EQ(isum, get_int64_value(*Root(typed_array_sum(*il)))) << "size: " << size;
+        EXPECT_EQ(idot, get_int64_value(*Root(typed_array_dot(*il, *ir)))) << "size: " << size;
+        EXPECT_DOUBLE_EQ(fsum, get_float64_value(*Root(typed_array_sum(*dl)))) << "size: " << size;
+        EXPECT_DOUBLE_EQ(fdot, get_float64_value(*Root(typed_array_dot(*dl, *dr)))) << "size: " << size;
+
+        if (size == 0)
+        {
+            EXPECT_TRUE(Root(typed_array_min(*il))->is_nil());
+            EXPECT_TRUE(Root(typed_array_max(*dl))->is_nil());
+        }
+        else
+        {
+            EXPECT_EQ(*std::min_element(l.begin(), l.end()), get_int64_value(*Root(typed_array_min(*il)))) << "size: " << size;
+            EXPECT_EQ(*std::max_element(l.begin(), l.end()), get_int64_value(*Root(typed_array_max(*il)))) << "size: " << size;
+            EXPECT_EQ(*std::min_element(fl.begin(), fl.end()), get_float64_value(*Root(typed_array_min(*dl)))) << "size: " << size;
+            EXPECT_EQ(*std::max_element(fl.begin(), fl.end()), get_float64_value(*Root(typed_array_max(*dl)))) << "size: " << size;
+        }
+
+        std::vector<Int64> isums(size), iprods(size), iscaled(size), iprefix(size);
+        std::vector<Float64> fsums(size), fprods(size), fscaled(size), fprefix(size);
+        for (Int64 i = 0; i < size; ++i)
+        {
+            isums[i] = l[i] + r[i];
+            iprods[i] = l[i] * r[i];
+            iscaled[i] = l[i] * -3;
+            iprefix[i] = l[i] + (i > 0 ? iprefix[i - 1] : 0);
+            fsums[i] = fl[i] + fr[i];
+            fprods[i] = fl[i] * fr[i];
+            fscaled[i] = fl[i] * 1.5;
+            fprefix[i] = fl[i] + (i > 0 ? fprefix[i - 1] : 0);
+        }
+        Root x{create_int64(-3)}, y{create_float64(1.5)};
+        expect_int64_elems(isums, *Root(typed_array_add(*il, *ir)));
+        expect_int64_elems(iprods, *Root(typed_array_mul(*il, *ir)));
+        expect_int64_elems(iscaled, *Root(typed_array_scale(*il, *x)));
+        expect_int64_elems(iprefix, *Root(typed_array_prefix_sum(*il)));
+        expect_float64_elems(fsums, *Root(typed_array_add(*dl, *dr)));
+        expect_float64_elems(fprods, *Root(typed_array_mul(*dl, *dr)));
+        expect_float64_elems(fscaled, *Root(typed_array_scale(*dl, *y)));
+        expect_float64_elems(fprefix, *Root(typed_array_prefix_sum(*dl)));
+
+        std::sort(l.begin(), l.end());
+        std::sort(fl.begin(), fl.end());
+        expect_int64_elems(l, *Root(typed_array_sort(*il)));
+        expect_float64_elems(fl, *Root(typed_array_sort(*dl)));
+    }
+}
+
+TEST_F(typed_array_test, int64_kernels_should_throw_on_overflow)
+{
+    auto expect_overflow = [](auto f)
+    {
+        try
+        {
+            Root r{f()};
+            FAIL() << "expected an exception";
+        }
+        catch (Exception const& )
+        {
+            Root e{catch_exception()};
+            EXPECT_EQ_REFS(*type::ArithmeticException, get_value_type(*e));
+        }
+    };
+    const auto max = std::numeric_limits<Int64>::max(), min = std::numeric_limits<Int64>::min();
+    Root tail{create_int64_array({max, 1})};
+    Root lane{create_int64_array({max, 0, 0, 0, 1, 0, 0, 0, 0})};
+    Root lanes{create_int64_array({max, max, max, max, max, max, max, max})};
+    Root neg{create_int64_array({min, 0, 0, 0, -1, 0, 0, 0})};
+    Root ones{create_int64_array({1, 1, 1, 1, 1, 1, 1, 1, 1})};
+    Root x{create_int64(2)};
+    expect_overflow([&] { return typed_array_sum(*tail); });
+    expect_overflow([&] { return typed_array_sum(*lane); });
+    expect_overflow([&] { return typed_array_sum(*lanes); });
+    expect_overflow([&] { return typed_array_sum(*neg); });
+    expect_overflow([&] { return typed_array_add(*lane, *ones); });
+    expect_overflow([&] { return typed_array_add(*ones, *lane); });
+    expect_overflow([&] { return typed_array_add(*neg, *neg); });
+    expect_overflow([&] { return typed_array_mul(*lane, *lane); });
+    expect_overflow([&] { return typed_array_scale(*lane, *x); });
+    expect_overflow([&] { return typed_array_dot(*lane, *ones); });
+    expect_overflow([&] { return typed_array_prefix_sum(*tail); });
+
+    Root in_range{create_int64_array({max, -1, -1, -1, 1, 0, 0, 0})};
+    EXPECT_EQ(max - 2, get_int64_value(*Root(typed_array_sum(*in_range))));
+}
+
+TEST_F(typed_array_test, kernels_should_reject_mismatched_arrays)
+{
+    Root i1{create_int64_array({1})}, i2{create_int64_array({1, 2})}, f1{create_float64_array({1})};
+    Root x{create_float64(1.5)};
+    EXPECT_THROW(typed_array_add(*i1, *i2), Exception);
+    EXPECT_THROW(typed_array_dot(*i1, *f1), Exception);
+    EXPECT_THROW(typed_array_scale(*i1, *x), Exception);
+    EXPECT_THROW(typed_array_sum(nil), Exception);
+}
+
+TEST_F(typed_array_test, sort_should_put_nans_last)
+{
+    Root a{create_float64_array({3, std::nan(""), -1, 2})};
+    Root sorted{typed_array_sort(*a)};
+    auto elems = get_float64_array_elems(*sorted);
+    EXPECT_EQ(-1, elems[0]);
+    EXPECT_EQ(2, elems[1]);
+    EXPECT_EQ(3, elems[2]);
+    EXPECT_TRUE(std::isnan(elems[3]));
+}
+
+TEST_F(typed_array_test, transient_should_grow_and_become_persistent)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    Root a{create_float64_array({1, 2})};
+    Root t{transient_typed_array(*a)};
+    ASSERT_EQ_REFS(*type::TransientFloat64Array, get_value_type(*t));
+    Root e;
+    std::vector<Float64> expected{1, 2};
+    for (Int64 i = 0; i < 100; ++i)
+    {
+        e = create_int64(i);
+        t = transient_typed_array_conj(*t, *e);
+        expected.push_back(i);
+    }
+    Root index{create_int64(0)};
+    e = create_float64(-1);
+    t = transient_typed_array_assoc(*t, *index, *e);
+    expected[0] = -1;
+    t = transient_typed_array_pop(*t);
+    expected.pop_back();
+    ASSERT_EQ(Int64(expected.size()), get_transient_typed_array_size(*t));
+
+    t = transient_typed_array_persistent(*t);
+    ASSERT_EQ_REFS(*type::Float64Array, get_value_type(*t));
+    expect_float64_elems(expected, *t);
+    expect_float64_elems({1, 2}, *a);
+}
+
+}
+}
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <array>
 #include <cmath>
+#include <vector>
 #include <gtest/gtest.h>
 #include "util.hpp"
 
@@ -294,6 +295,85 @@ TEST_F(value_test, should_provide_code_points_at_given_indices)
     EXPECT_EQ(0x10ffffu, get_string_char(*val, 10));
 }
 
+TEST_F(value_test, should_provide_char_offsets_in_long_strings)
+{
+    std::string str;
+    std::vector<std::uint32_t> offsets;
+    for (int i = 0; i < 1000; ++i)
+    {
+        offsets.push_back(str.size());
+        str += (i % 3 == 0) ? "\xe5\x9e\x9e" : (i % 3 == 1) ? "a" : "\xc2\x80";
+    }
+    Root val{create_string(str)};
+    ASSERT_EQ(1000u, get_string_len(*val));
+    for (std::uint32_t i = 0; i < offsets.size(); ++i)
+        ASSERT_EQ(offsets[i], get_string_char_offset(*val, i)) << "index: " << i;
+    EXPECT_EQ(str.size(), get_string_char_offset(*val, 1000));
+
+    std::string ascii(1000, 'x');
+    ascii[999] = 'y';
+    val = create_string(ascii);
+    ASSERT_EQ(1000u, get_string_len(*val));
+    EXPECT_EQ(500u, get_string_char_offset(*val, 500));
+    EXPECT_EQ(Char32('y'), get_string_char(*val, 999));
+}
+
+TEST_F(value_test, substrings_should_share_the_parent_string)
+{
+    std::string str;
+    for (int i = 0; i < 100; ++i)
+        str += (i % 2) ? "\xe5\x9e\x9e" : "ab";
+    Root parent{create_string(str)};
+    Root sub{create_substring(*parent, 10, 60)};
+    ASSERT_TRUE(is_string_slice(*sub));
+    EXPECT_EQ_REFS(*parent, get_string_slice_parent(*sub));
+    EXPECT_EQ(50u, get_string_len(*sub));
+    EXPECT_EQ(get_string_ptr(*parent) + get_string_char_offset(*parent, 10), get_string_ptr(*sub));
+    EXPECT_EQ(get_string_char(*parent, 11), get_string_char(*sub, 1));
+    EXPECT_EQ(get_string_char(*parent, 59), get_string_char(*sub, 49));
+    Root expected{create_string(str.substr(get_string_char_offset(*parent, 10), get_string_size(*sub)))};
+    EXPECT_EQ_VALS(*expected, *sub);
+
+    Root subsub{create_substring(*sub, 5, 45)};
+    ASSERT_TRUE(is_string_slice(*subsub));
+    EXPECT_EQ_REFS(*parent, get_string_slice_parent(*subsub));
+    EXPECT_EQ(get_string_char(*parent, 15), get_string_char(*subsub, 0));
+    EXPECT_EQ(get_string_char(*parent, 54), get_string_char(*subsub, 39));
+
+    Root small{create_substring(*parent, 10, 12)};
+    EXPECT_FALSE(is_string_slice(*small));
+    EXPECT_EQ_REFS(*parent, *Root(create_substring(*parent, 0, get_string_len(*parent))));
+}
+
+TEST_F(value_test, small_substrings_of_large_strings_should_be_copied)
+{
+    Root parent{create_string(std::string(1000, 'x') + std::string(100, 'y'))};
+    Root sub{create_substring(*parent, 1000, 1100)};
+    EXPECT_FALSE(is_string_slice(*sub));
+    EXPECT_EQ(std::string(100, 'y'), std::string(get_string_ptr(*sub), get_string_size(*sub)));
+    Root kept{create_substring(*parent, 100, 400)};
+    ASSERT_TRUE(is_string_slice(*kept));
+    EXPECT_EQ_REFS(*parent, get_string_slice_parent(*kept));
+    Root kept_sub{create_substring(*kept, 0, 100)};
+    EXPECT_FALSE(is_string_slice(*kept_sub));
+    EXPECT_EQ(std::string(100, 'x'), std::string(get_string_ptr(*kept_sub), get_string_size(*kept_sub)));
+}
+
+TEST_F(value_test, slices_should_keep_their_parents_alive)
+{
+    Root kept;
+    {
+        Root parent{create_string(std::string(100, 'x') + std::string(300, 'z'))};
+        kept = create_substring(*parent, 100, 400);
+    }
+    ASSERT_TRUE(is_string_slice(*kept));
+    auto ptr = get_string_ptr(*kept);
+    for (int i = 0; i < 100; ++i)
+        Root garbage{create_string(std::string(400, 'w'))};
+    gc();
+    EXPECT_EQ(std::string(300, 'z'), std::string(ptr.data(), get_string_size(*kept)));
+}
+
 TEST_F(value_test, should_provide_string_length)
 {
     Root val{create_string("\x73\x63\x53\x43\x33\x23\x13\x03")};
@@ -308,11 +388,45 @@ TEST_F(value_test, should_provide_string_length)
 
 TEST_F(value_test, should_create_a_new_instance_for_each_string)
 {
-    Root val{create_string("abc")};
-    Root val2{create_string("abc")};
+    Root val{create_string("abcdef")};
+    Root val2{create_string("abcdef")};
     ASSERT_FALSE(val->is(*val2));
 }
 
+TEST_F(value_test, should_store_short_strings_in_values)
+{
+    auto allocations = get_mem_allocations();
+    Root val{create_string("ab\xc2\xa0")};
+    Root val2{create_string("ab\xc2\xa0")};
+    Root empty{create_string("")};
+    EXPECT_EQ(allocations, get_mem_allocations());
+    ASSERT_TRUE(is_short_string(*val));
+    ASSERT_EQ(tag::UTF8STRING, get_value_tag(*val));
+    ASSERT_EQ_REFS(*type::UTF8String, get_value_type(*val));
+    EXPECT_TRUE(val->is(*val2));
+    EXPECT_EQ(4u, get_string_size(*val));
+    EXPECT_EQ(3u, get_string_len(*val));
+    EXPECT_STREQ("ab\xc2\xa0", get_string_ptr(*val));
+    EXPECT_EQ(0xa0u, get_string_char(*val, 2));
+    EXPECT_EQ(0u, get_string_size(*empty));
+    EXPECT_STREQ("", get_string_ptr(*empty));
+
+    EXPECT_FALSE(is_short_string(*Root(create_string("abcdef"))));
+    EXPECT_FALSE(is_short_string(*Root(create_string(std::string("a\0b", 3)))));
+    EXPECT_FALSE(is_short_string(*Root(create_string("\xff"))));
+}
+
+TEST_F(value_test, short_string_ptr_should_outlive_the_value)
+{
+    auto p = get_string_ptr(*Root(create_string("abc")));
+    auto q = get_string_ptr(*Root(create_string("xyz")));
+    EXPECT_STREQ("abc", p);
+    EXPECT_STREQ("xyz", q);
+    auto copy = p;
+    EXPECT_STREQ("abc", copy);
+    EXPECT_NE(p.data(), copy.data());
+}
+
 TEST_F(value_test, should_store_object_values)
 {
     Root type{create_dynamic_object_type("org", "xxx")};
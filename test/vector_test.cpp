@@ -0,0 +1,312 @@
+#include <cleo/vector.hpp>
+#include <cleo/global.hpp>
+#include <cleo/error.hpp>
+#include <gtest/gtest.h>
+#include <array>
+#include "util.hpp"
+
+namespace cleo
+{
+namespace test
+{
+
+struct vector_test : Test
+{
+    vector_test() : Test("cleo.vector.test") { }
+
+    static Force create_range(Int64 size)
+    {
+        Root v{create_vector(nullptr, 0)};
+        Root e;
+        for (Int64 i = 0; i < size; ++i)
+        {
+            e = create_int64(i);
+            v = vector_conj(*v, *e);
+        }
+        return *v;
+    }
+
+    static void expect_range(Value v, Int64 size)
+    {
+        ASSERT_EQ(size, get_vector_size(v));
+        for (Int64 i = 0; i < size; ++i)
+            ASSERT_EQ(i, get_int64_value(get_vector_elem(v, i)));
+        EXPECT_TRUE(get_vector_elem(v, size).is_nil());
+        EXPECT_TRUE(get_vector_elem(v, -1).is_nil());
+    }
+};
+
+TEST_F(vector_test, should_create_an_empty_vector)
+{
+    Root v{create_vector(nullptr, 0)};
+    ASSERT_EQ_REFS(*type::Vector, get_value_type(*v));
+    ASSERT_EQ(0, get_vector_size(*v));
+    ASSERT_TRUE(get_vector_elem(*v, 0).is_nil());
+    ASSERT_TRUE(Root(vector_seq(*v))->is_nil());
+}
+
+TEST_F(vector_test, should_create_a_vector_from_elements)
+{
+    std::vector<Value> elems;
+    Roots relems(100);
+    for (Int64 i = 0; i < 100; ++i)
+    {
+        relems.set(i, create_int64(i));
+        elems.push_back(relems[i]);
+    }
+    Root v{create_vector(elems.data(), elems.size())};
+    expect_range(*v, 100);
+}
+
+TEST_F(vector_test, should_conj_elements_at_the_end_of_the_vector)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    const Int64 size = 33 * 1024 + 100;
+    Root v{create_vector(nullptr, 0)};
+    Root snapshot;
+    Root e;
+    for (Int64 i = 0; i < size; ++i)
+    {
+        e = create_int64(i);
+        v = vector_conj(*v, *e);
+        ASSERT_EQ(i + 1, get_vector_size(*v));
+        ASSERT_EQ_VALS(*e, get_vector_elem(*v, i));
+        if (i == 1055)
+            snapshot = *v;
+    }
+    expect_range(*v, size);
+    expect_range(*snapshot, 1056);
+}
+
+TEST_F(vector_test, should_pop_elements_from_the_end_of_the_vector)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    const Int64 size = 33 * 1024 + 100;
+    Root full{create_range(size)};
+    Root v{*full};
+    for (Int64 i = size - 1; i > 0; --i)
+    {
+        v = vector_pop(*v);
+        ASSERT_EQ(i, get_vector_size(*v));
+        ASSERT_EQ(i - 1, get_int64_value(get_vector_elem(*v, i - 1)));
+        ASSERT_TRUE(get_vector_elem(*v, i).is_nil());
+        if (i == 1057)
+            expect_range(*v, i);
+    }
+    v = vector_pop(*v);
+    EXPECT_EQ_REFS(*EMPTY_VECTOR, *v);
+    expect_range(*full, size);
+
+    try
+    {
+        Root empty{create_vector(nullptr, 0)};
+        vector_pop(*empty);
+        FAIL() << "vector_pop should fail for an empty vector";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        ASSERT_EQ_REFS(*type::IllegalState, get_value_type(*e));
+    }
+}
+
+TEST_F(vector_test, should_assoc_elements)
+{
+    const Int64 size = 2000;
+    Root original{create_range(size)};
+    Root v{*original};
+    Root e;
+    for (Int64 i = 0; i < size; i += 7)
+    {
+        e = create_int64(-i);
+        v = vector_assoc_elem(*v, i, *e);
+    }
+    ASSERT_EQ(size, get_vector_size(*v));
+    for (Int64 i = 0; i < size; ++i)
+        ASSERT_EQ(i % 7 ? i : -i, get_int64_value(get_vector_elem(*v, i)));
+    expect_range(*original, size);
+
+    e = create_int64(size);
+    v = vector_assoc_elem(*original, size, *e);
+    expect_range(*v, size + 1);
+
+    try
+    {
+        vector_assoc_elem(*original, size + 1, *e);
+        FAIL() << "vector_assoc_elem should fail for an index out of bounds";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        ASSERT_EQ_REFS(*type::IndexOutOfBounds, get_value_type(*e));
+    }
+}
+
+TEST_F(vector_test, seq_should_return_a_sequence_of_the_vector_elements)
+{
+    const Int64 size = 1100;
+    Root v{create_range(size)};
+    Int64 i = 0;
+    for (Root s{vector_seq(*v)}; *s; s = get_vector_seq_next(*s), ++i)
+        ASSERT_EQ(i, get_int64_value(get_vector_seq_first(*s)));
+    ASSERT_EQ(size, i);
+}
+
+TEST_F(vector_test, chunked_seq_should_return_the_rest_of_each_leaf)
+{
+    const Int64 size = 1100;
+    Root v{create_range(size)};
+    Int64 i = 0;
+    Root chunk;
+    for (Root s{vector_seq(*v)}; *s; s = get_vector_seq_chunk_next(*s))
+    {
+        chunk = get_vector_seq_chunk_first(*s);
+        ASSERT_EQ_REFS(*type::Array, get_value_type(*chunk));
+        ASSERT_EQ(i < 1088 ? 32u : 12u, get_array_size(*chunk));
+        for (std::uint32_t j = 0; j < get_array_size(*chunk); ++j, ++i)
+            ASSERT_EQ(i, get_int64_value(get_array_elem(*chunk, j)));
+    }
+    EXPECT_EQ(size, i);
+
+    Root s{vector_seq(*v)};
+    for (int k = 0; k < 5; ++k)
+        s = get_vector_seq_next(*s);
+    chunk = get_vector_seq_chunk_first(*s);
+    ASSERT_EQ(27u, get_array_size(*chunk));
+    EXPECT_EQ(5, get_int64_value(get_array_elem(*chunk, 0)));
+    s = get_vector_seq_chunk_next(*s);
+    EXPECT_EQ(32, get_int64_value(get_vector_seq_first(*s)));
+}
+
+TEST_F(vector_test, should_convert_to_an_array)
+{
+    Root v{create_range(100)};
+    Root a{vector_to_array(*v)};
+    ASSERT_EQ_REFS(*type::Array, get_value_type(*a));
+    ASSERT_EQ(100u, get_array_size(*a));
+    for (Int64 i = 0; i < 100; ++i)
+        ASSERT_EQ(i, get_int64_value(get_array_elem(*a, i)));
+    Root same{vector_to_array(*a)};
+    EXPECT_EQ_REFS(*a, *same);
+}
+
+TEST_F(vector_test, hash_should_match_array_hash)
+{
+    Root v{create_range(100)};
+    Root a{vector_to_array(*v)};
+    Root vh{vector_hash(*v)};
+    Root ah{array_hash(*a)};
+    EXPECT_EQ_VALS(*ah, *vh);
+}
+
+TEST_F(vector_test, array_vector_conj_should_promote_arrays_past_32_elements)
+{
+    Root v{*EMPTY_VECTOR};
+    Root e;
+    for (Int64 i = 0; i < 32; ++i)
+    {
+        e = create_int64(i);
+        v = array_vector_conj(*v, *e);
+    }
+    ASSERT_EQ_REFS(*type::Array, get_value_type(*v));
+    e = create_int64(32);
+    v = array_vector_conj(*v, *e);
+    ASSERT_EQ_REFS(*type::Vector, get_value_type(*v));
+    expect_range(*v, 33);
+}
+
+TEST_F(vector_test, array_vector_assoc_elem_should_promote_large_arrays)
+{
+    Root small{vector_test::create_range(10)};
+    small = vector_to_array(*small);
+    Root e{create_int64(-1)};
+    Root v{array_vector_assoc_elem(*small, 3, *e)};
+    ASSERT_EQ_REFS(*type::Array, get_value_type(*v));
+    EXPECT_EQ_VALS(*e, get_array_elem(*v, 3));
+    EXPECT_EQ(3, get_int64_value(get_array_elem(*small, 3)));
+
+    Root large{vector_test::create_range(100)};
+    large = vector_to_array(*large);
+    v = array_vector_assoc_elem(*large, 70, *e);
+    ASSERT_EQ_REFS(*type::Vector, get_value_type(*v));
+    EXPECT_EQ_VALS(*e, get_vector_elem(*v, 70));
+    EXPECT_EQ(70, get_int64_value(get_array_elem(*large, 70)));
+
+    v = array_vector_pop(*large);
+    ASSERT_EQ_REFS(*type::Vector, get_value_type(*v));
+    expect_range(*v, 99);
+}
+
+struct transient_vector_test : Test
+{
+    transient_vector_test() : Test("cleo.transient-vector.test") { }
+};
+
+TEST_F(transient_vector_test, should_conj_assoc_and_pop_elements_in_place)
+{
+    Override<decltype(gc_frequency)> ovf{gc_frequency, 4096};
+    const Int64 size = 33 * 1024 + 100;
+    Root original{vector_test::create_range(100)};
+    Root t{transient_vector(*original)};
+    Root e;
+    for (Int64 i = 100; i < size; ++i)
+    {
+        e = create_int64(i);
+        Root conjed{transient_vector_conj(*t, *e)};
+        ASSERT_EQ_REFS(*t, *conjed);
+    }
+    ASSERT_EQ(size, get_transient_vector_size(*t));
+    for (Int64 i = 0; i < size; ++i)
+        ASSERT_EQ(i, get_int64_value(get_transient_vector_elem(*t, i)));
+
+    e = create_int64(-1);
+    t = transient_vector_assoc_elem(*t, 5, *e);
+    t = transient_vector_assoc_elem(*t, size - 1, *e);
+    EXPECT_EQ_VALS(*e, get_transient_vector_elem(*t, 5));
+    EXPECT_EQ_VALS(*e, get_transient_vector_elem(*t, size - 1));
+
+    for (Int64 i = size - 1; i >= 40; --i)
+        t = transient_vector_pop(*t);
+    ASSERT_EQ(40, get_transient_vector_size(*t));
+
+    Root v{transient_vector_persistent(*t)};
+    ASSERT_EQ_REFS(*type::Vector, get_value_type(*v));
+    ASSERT_EQ(40, get_vector_size(*v));
+    for (Int64 i = 0; i < 40; ++i)
+        ASSERT_EQ(i == 5 ? -1 : i, get_int64_value(get_vector_elem(*v, i)));
+
+    ASSERT_EQ(100, get_vector_size(*original));
+    for (Int64 i = 0; i < 100; ++i)
+        ASSERT_EQ(i, get_int64_value(get_vector_elem(*original, i)));
+}
+
+TEST_F(transient_vector_test, should_fail_after_persistent)
+{
+    Root original{vector_test::create_range(40)};
+    Root t{transient_vector(*original)};
+    Root v{transient_vector_persistent(*t)};
+    try
+    {
+        transient_vector_conj(*t, nil);
+        FAIL() << "conj! should fail after persistent!";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        ASSERT_EQ_REFS(*type::IllegalState, get_value_type(*e));
+    }
+    try
+    {
+        transient_vector_assoc_elem(*t, 0, nil);
+        FAIL() << "assoc! should fail after persistent!";
+    }
+    catch (Exception const& )
+    {
+        Root e{catch_exception()};
+        ASSERT_EQ_REFS(*type::IllegalState, get_value_type(*e));
+    }
+    ASSERT_EQ(40, get_vector_size(*v));
+}
+
+}
+}
@@ -0,0 +1,80 @@
+#include <cleo/vm_stats.hpp>
+#include <cleo/bytecode_fn.hpp>
+#include <gtest/gtest.h>
+#include "util.hpp"
+
+namespace cleo
+{
+namespace vm
+{
+namespace test
+{
+using namespace cleo::test;
+
+struct vm_stats_test : Test
+{
+    vm_stats_test() : Test("cleo.vm-stats.test") { }
+
+    ~vm_stats_test()
+    {
+        stats::stop();
+    }
+
+    template <std::size_t N>
+    void eval_bytecode(const std::array<Byte, N>& bc)
+    {
+        vm::eval_bytecode(nil, nil, nil, 0, nil, bc.data(), bc.size());
+    }
+};
+
+TEST_F(vm_stats_test, should_count_opcodes_pairs_and_offsets_only_when_enabled)
+{
+    const std::array<Byte, 4> bc{{CNIL, CNIL, POP, POP}};
+    eval_bytecode(bc);
+    stats::start();
+    eval_bytecode(bc);
+    eval_bytecode(bc);
+    stats::stop();
+    eval_bytecode(bc);
+
+    EXPECT_EQ(4u, stats::opcodes[std::uint8_t(CNIL)]);
+    EXPECT_EQ(4u, stats::opcodes[std::uint8_t(POP)]);
+    EXPECT_EQ(0u, stats::opcodes[std::uint8_t(LDC)]);
+    EXPECT_EQ(2u, stats::opcode_pairs[std::uint8_t(CNIL) << 8 | std::uint8_t(CNIL)]);
+    EXPECT_EQ(2u, stats::opcode_pairs[std::uint8_t(CNIL) << 8 | std::uint8_t(POP)]);
+    EXPECT_EQ(2u, stats::opcode_pairs[std::uint8_t(POP) << 8 | std::uint8_t(POP)]);
+    EXPECT_EQ(0u, stats::opcode_pairs[std::uint8_t(POP) << 8 | std::uint8_t(CNIL)]);
+    auto& hits = stats::get_body_counters(bc.data(), bc.size())->hits;
+    EXPECT_EQ(2u, hits[0]);
+    EXPECT_EQ(2u, hits[1]);
+    EXPECT_EQ(2u, hits[2]);
+    EXPECT_EQ(2u, hits[3]);
+
+    stats::start();
+    EXPECT_EQ(0u, stats::opcodes[std::uint8_t(CNIL)]);
+    EXPECT_EQ(0u, stats::opcode_pairs[std::uint8_t(CNIL) << 8 | std::uint8_t(POP)]);
+    EXPECT_TRUE(stats::bodies.empty());
+    EXPECT_EQ(0u, stats::get_body_counters(bc.data(), bc.size())->hits[0]);
+}
+
+TEST_F(vm_stats_test, get_should_return_nonzero_counts)
+{
+    const std::array<Byte, 3> bc{{CNIL, CNIL, POP}};
+    stats::start();
+    eval_bytecode(bc);
+    stats::stop();
+
+    Root s{stats::get()};
+    Root ex{phmap(create_symbol("CNIL"), 2, create_symbol("POP"), 1)};
+    EXPECT_EQ_VALS(*ex, map_get(*s, create_keyword("opcodes")));
+    ex = phmap(arrayv(create_symbol("CNIL"), create_symbol("CNIL")), 1, arrayv(create_symbol("CNIL"), create_symbol("POP")), 1);
+    EXPECT_EQ_VALS(*ex, map_get(*s, create_keyword("pairs")));
+    ex = phmap(0, 1, 1, 1, 2, 1);
+    auto bodies = map_get(*s, create_keyword("bodies"));
+    ASSERT_EQ(1u, get_array_size(bodies));
+    EXPECT_EQ_VALS(*ex, map_get(get_array_elem(bodies, 0), create_keyword("hits")));
+}
+
+}
+}
+}
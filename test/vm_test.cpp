@@ -3,6 +3,8 @@
 #include <cleo/compile.hpp>
 #include <cleo/reader.hpp>
 #include <cleo/error.hpp>
+#include <cleo/memory.hpp>
+#include <cleo/cons.hpp>
 #include <gtest/gtest.h>
 #include "util.hpp"
 
@@ -411,6 +413,46 @@ TEST_F(vm_test, ldv)
     EXPECT_EQ_VALS(*THREE, stack[0]);
 }
 
+TEST_F(vm_test, ldll)
+{
+    Root x{i64(17)}, y{i64(35)}, a{i64(7)};
+    stack_push(*a);
+    stack_push(*x);
+    stack_push(nil, 1024);
+    stack_push(*y);
+    const std::array<Byte, 12> bc{{
+        LDLL, 1, 4, LDL, Byte(-1), Byte(-1),
+        LDLL, 0, 0, LDL, 1, 4}};
+    eval_bytecode(nil, nil, 1026, bc);
+
+    ASSERT_EQ(1031u, stack.size());
+    EXPECT_EQ_VALS(*y, stack[1030]);
+    EXPECT_EQ_VALS(*x, stack[1029]);
+    EXPECT_EQ_VALS(*a, stack[1028]);
+    EXPECT_EQ_VALS(*y, stack[1027]);
+}
+
+TEST_F(vm_test, ldvl)
+{
+    in_ns(create_symbol("vm.ldvl.test"));
+    auto v1 = define(create_symbol("vm.ldvl.test", "a"), *THREE);
+    auto v2 = define(create_symbol("vm.ldvl.test", "b"), *TWO);
+    Root vars{create_vars({{255, v1}, {65535, v2}})};
+    Root x{i64(17)};
+    stack_push(*x);
+    stack_push(nil);
+    const std::array<Byte, 12> bc{{
+        LDVL, Byte(-1), 0, LDL, 0, 0,
+        LDVL, Byte(-1), Byte(-1), LDL, Byte(-1), Byte(-1)}};
+    eval_bytecode(nil, *vars, 1, bc);
+
+    ASSERT_EQ(6u, stack.size());
+    EXPECT_EQ_VALS(*x, stack[5]);
+    EXPECT_EQ_VALS(*TWO, stack[4]);
+    EXPECT_EQ_VALS(nil, stack[3]);
+    EXPECT_EQ_VALS(*THREE, stack[2]);
+}
+
 TEST_F(vm_test, br)
 {
     Root constants{create_constants({{0, 10}, {1, 20}})};
@@ -565,6 +607,93 @@ TEST_F(vm_test, call)
     EXPECT_EQ_VALS(*ex, stack[0]);
 }
 
+TEST_F(vm_test, lcall)
+{
+    Root x{i64(7)};
+    Root constants{array(*rt::first)};
+    Root v{array(*x, 8)};
+    stack_push(*v);
+    const std::array<Byte, 8> bc{{LDC, 0, 0, LCALL, Byte(-1), Byte(-1), CALL, 1}};
+    eval_bytecode(*constants, nil, 0, bc);
+
+    ASSERT_EQ(2u, stack.size());
+    EXPECT_EQ_VALS(*x, stack[1]);
+}
+
+TEST_F(vm_test, llcall)
+{
+    Root constants{array(*rt::assoc)};
+    Root m{phmap(10, 20)}, k{i64(30)}, val{i64(40)};
+    stack_push(*m);
+    stack_push(*k);
+    stack_push(*val);
+    const std::array<Byte, 14> bc{{LDC, 0, 0, LDL, Byte(-3), Byte(-1), LLCALL, Byte(-2), Byte(-1), LDL, Byte(-1), Byte(-1), CALL, 3}};
+    eval_bytecode(*constants, nil, 0, bc);
+
+    Root ex{phmap(10, 20, 30, 40)};
+    ASSERT_EQ(4u, stack.size());
+    EXPECT_EQ_VALS(*ex, stack[3]);
+}
+
+TEST_F(vm_test, vlcall)
+{
+    in_ns(create_symbol("vm.vlcall.test"));
+    auto f = define(create_symbol("vm.vlcall.test", "f"), *rt::first);
+    Root vars{create_vars({{257, f}})};
+    Root x{i64(7)};
+    Root v{array(*x, 8)};
+    stack_push(*v);
+    const std::array<Byte, 8> bc{{VLCALL, 1, 1, LDL, Byte(-1), Byte(-1), CALL, 1}};
+    eval_bytecode(nil, *vars, 0, bc);
+
+    ASSERT_EQ(2u, stack.size());
+    EXPECT_EQ_VALS(*x, stack[1]);
+}
+
+TEST_F(vm_test, callstl)
+{
+    Root x{i64(7)};
+    Root constants{array(arrayv(*x, 8), *rt::first)};
+    stack_push(nil);
+    stack_push(nil, 1024);
+    const std::array<Byte, 11> bc{{LDC, 1, 0, LDC, 0, 0, CALLSTL, 1, STL, 0, 4}};
+    eval_bytecode(*constants, nil, 1025, bc);
+
+    ASSERT_EQ(1025u, stack.size());
+    EXPECT_EQ_VALS(*x, stack[1024]);
+    EXPECT_EQ_VALS(nil, stack[0]);
+}
+
+TEST_F(vm_test, catching_exceptions_from_fused_calls)
+{
+    Root constants{array(*rt::first)};
+    const std::array<Byte, 12> bc1{{CNIL, LDC, 0, 0, LCALL, Byte(-1), Byte(-1), CALL, 1, CNIL, CNIL, CNIL}};
+    const std::array<Int64, 4> et1{{4, 9, 11, 0}};
+    const std::array<Value, 1> types{{*type::IllegalArgument}};
+    stack_push(*TWO);
+    stack_push(*THREE);
+    eval_bytecode(*constants, nil, 1, et1, types, bc1);
+
+    ASSERT_EQ(4u, stack.size());
+    EXPECT_EQ_VALS(nil, stack[3]);
+    EXPECT_EQ_REFS(*type::IllegalArgument, get_value_type(stack[2]));
+    EXPECT_EQ_VALS(*THREE, stack[1]);
+    EXPECT_EQ_VALS(*TWO, stack[0]);
+    stack.clear();
+
+    const std::array<Byte, 14> bc2{{CNIL, LDC, 0, 0, LDL, Byte(-1), Byte(-1), CALLSTL, 1, STL, 0, 0, CNIL, CNIL}};
+    const std::array<Int64, 4> et2{{7, 12, 13, 0}};
+    stack_push(*TWO);
+    stack_push(*THREE);
+    eval_bytecode(*constants, nil, 1, et2, types, bc2);
+
+    ASSERT_EQ(4u, stack.size());
+    EXPECT_EQ_VALS(nil, stack[3]);
+    EXPECT_EQ_REFS(*type::IllegalArgument, get_value_type(stack[2]));
+    EXPECT_EQ_VALS(*THREE, stack[1]);
+    EXPECT_EQ_VALS(*TWO, stack[0]);
+}
+
 TEST_F(vm_test, bytecode_fn_call)
 {
     Root fn{compile_fn("(fn* f ([] 1) ([x] x) ([x y] [f x y]) ([x y z & xs] [f x y z xs]))")};
@@ -625,6 +754,55 @@ TEST_F(vm_test, bytecode_fn_call)
     EXPECT_EQ_REFS(*type::ArraySeq, get_value_type(get_array_elem(stack[0], 4)));
 }
 
+TEST_F(vm_test, bytecode_fn_call_should_keep_rest_args_on_the_stack)
+{
+    Root fn{compile_fn("(fn* [x & xs] (first (next xs)))")};
+    std::array<Byte, 2> bc{{CALL, 3}};
+
+    stack_push(*fn);
+    stack_push(i64(10));
+    stack_push(i64(20));
+    stack_push(i64(30));
+    eval_bytecode(nil, nil, 0, bc);
+
+    Root ex{i64(30)};
+    ASSERT_EQ(1u, stack.size());
+    EXPECT_EQ_VALS(*ex, stack[0]);
+    stack.clear();
+
+    stack_push(*fn);
+    stack_push(i64(10));
+    stack_push(i64(20));
+    stack_push(i64(30));
+    auto num_allocations = allocations.size();
+    eval_bytecode(nil, nil, 0, bc);
+
+    EXPECT_EQ(num_allocations, allocations.size());
+    ASSERT_EQ(1u, stack.size());
+    EXPECT_EQ_VALS(*ex, stack[0]);
+}
+
+TEST_F(vm_test, bytecode_fn_call_should_copy_escaping_rest_args_to_the_heap)
+{
+    Root fn{compile_fn("(fn* [& xs] [xs (next xs) (count xs) ((fn* [& ys] ys) 5 (next xs))])")};
+
+    stack_push(*fn);
+    stack_push(i64(10));
+    stack_push(i64(20));
+    stack_push(i64(30));
+    std::array<Byte, 2> bc{{CALL, 3}};
+    eval_bytecode(nil, nil, 0, bc);
+
+    Root ex{array(arrayv(10, 20, 30), arrayv(20, 30), 3, arrayv(5, arrayv(20, 30)))};
+    ASSERT_EQ(1u, stack.size());
+    EXPECT_EQ_VALS(*ex, stack[0]);
+    EXPECT_EQ_REFS(*type::ArraySeq, get_value_type(get_array_elem(stack[0], 0)));
+    EXPECT_EQ_REFS(*type::ArraySeq, get_value_type(get_array_elem(stack[0], 1)));
+    auto nested = get_array_elem(stack[0], 3);
+    EXPECT_EQ_REFS(*type::ArraySeq, get_value_type(nested));
+    EXPECT_EQ_REFS(*type::ArraySeq, get_value_type(get_array_seq_first(get_array_seq_next(nested).value())));
+}
+
 TEST_F(vm_test, apply)
 {
     Root x{i64(7)};
@@ -761,6 +939,24 @@ TEST_F(vm_test, bytecode_fn_apply)
     expect_apply_call_error(arrayv(*fn0, arrayv(10)), "Too many args (1 or more) passed to: no");
 }
 
+TEST_F(vm_test, bytecode_fn_apply_should_push_elements_of_lists_and_seqs)
+{
+    Root fn{compile_fn("(fn* f ([x y] [f x y]) ([x y z & xs] [f x y z xs]))")};
+    Root l{list(10, 20, 30, 40)};
+    EXPECT_NO_FATAL_FAILURE(test_apply(arrayv(*fn, listv(10, 20)), arrayv(*fn, 10, 20)));
+    EXPECT_NO_FATAL_FAILURE(test_apply(arrayv(*fn, *l), arrayv(*fn, 10, 20, 30, listv(40))));
+    EXPECT_NO_FATAL_FAILURE(test_apply(arrayv(*fn, 5, *l), arrayv(*fn, 5, 10, 20, listv(30, 40))));
+
+    Root c{create_cons(*ONE, *l)};
+    EXPECT_NO_FATAL_FAILURE(test_apply(arrayv(*fn, *c), arrayv(*fn, 1, 10, 20, listv(30, 40))));
+
+    Root s{array(10, 20, 30, 40, 50)};
+    s = array_seq(*s);
+    s = get_array_seq_next(*s);
+    EXPECT_NO_FATAL_FAILURE(test_apply(arrayv(*fn, *s), arrayv(*fn, 20, 30, 40, arrayv(50))));
+    EXPECT_NO_FATAL_FAILURE(test_apply(arrayv(*fn, 1, *s), arrayv(*fn, 1, 20, 30, arrayv(40, 50))));
+}
+
 TEST_F(vm_test, cnil)
 {
     stack_push(*THREE);